@@ -0,0 +1,863 @@
+// library inclusions
+#include "v3math.h"
+#include "v3simd.h"
+#include "v3mat.h"
+#include "v3quat.h"
+#include <float.h>
+#include <stdlib.h>
+#include <time.h>
+
+// accuracy and speed of every float function variant: each scalar function,
+// and each batch function on every instruction set this cpu supports
+//
+// every variant runs over classes of random and adversarial inputs and is
+// compared element by element with a double precision reference of the same
+// contract (zero length vectors give the documented zero results). errors are
+// in float ulps of max(|reference|, scale), where the scale is the magnitude
+// the rounding error of a correct float algorithm is proportional to: the
+// absolute products for dot, cross and reflect, whose cancellation is the
+// input's conditioning and not the kernel's fault, the input length for
+// rotate, and pi for angles, whose error is absolute
+//
+// every function has a budget on its max ulp error; the program exits with
+// status 1 when a variant exceeds it, so make accuracy fails the build
+
+// vectors per input class, default and --quick
+#define DEFAULT_COUNT (1 << 15)
+#define QUICK_COUNT (1 << 12)
+
+// timing: minimum duration and number of timed repetitions
+#define MIN_REP_SECONDS 1e-3
+#define TIMING_REPS 5
+
+// inputs beyond these lengths leave the float range in |a|^2 or |a| |b|
+#define MAX_LENGTH 1e18
+#define MIN_LENGTH 1e-18
+
+// lengths closer than this to V3_EPSILON, relatively, may land on either side
+// of the zero length test once rounded; the contract cannot say which
+#define EPSILON_BAND 1e-4
+
+// the fused angle tiers need |a| |b| below this, see v3_angle_batch
+#define FUSED_MAX_PRODUCT 1e19
+
+// keeps results alive so the compiler cannot drop the timed work
+static volatile float sink = 0.0f;
+
+// kinds of input pairs a and b
+typedef enum
+{
+    INPUT_RANDOM,       // components uniform in [-1, 1]
+    INPUT_MAGNITUDE,    // random directions with lengths from 2^-60 to 2^60
+    INPUT_DENORMAL,     // about half the components denormal
+    INPUT_PARALLEL,     // b along a or against it, perturbed by 2^-6 to 2^-24
+    INPUT_ORTHOGONAL,   // b perpendicular to a up to rounding, cancelling a . b
+    INPUT_NEAR_ZERO,    // lengths from 1e-8 to 1e-4, either side of V3_EPSILON
+    INPUT_COUNT
+} input_class;
+
+static const char *input_names[INPUT_COUNT] = {"random", "magnitude", "denormal", "parallel", "orthogonal",
+                                               "near_zero"};
+
+// one pass of a variant over count pairs; single results go to dst.x
+typedef void (*accuracy_fn)(v3_soa dst, v3_soa a, v3_soa b, size_t count);
+
+// double reference of one element: results to ref, and the scale each result's
+// error is measured against to scale
+typedef void (*reference_fn)(double *ref, double *scale, const float *a, const float *b);
+
+// whether a pair lies inside the documented domain of the function
+typedef bool (*domain_fn)(const float *a, const float *b);
+
+// a function variant: name, api form, whether the batch dispatches to the isa
+// kernels, results per element, whether b must be a unit normal, and the max
+// ulp error it is allowed
+typedef struct
+{
+    const char *name;
+    const char *form;
+    bool dispatched;
+    int results;
+    bool unit_b;
+    accuracy_fn fn;
+    reference_fn reference;
+    domain_fn domain;
+    double budget;
+} accuracy_case;
+
+// measured errors of one variant over every class
+typedef struct
+{
+    double max_ulp;
+    double sum_ulp;
+    size_t checked;
+    size_t skipped;
+    double class_max[INPUT_COUNT];
+    double ns_per_op;
+} accuracy_result;
+
+// command line options
+typedef struct
+{
+    const char *json_path;
+    const char *filter;
+    size_t count;
+} accuracy_options;
+
+// input pairs of one class and their results
+typedef struct
+{
+    size_t count;
+    v3_soa a;
+    v3_soa b;
+    v3_soa unit;        // b normalized in double, for reflect
+    v3_soa dst;
+} accuracy_data;
+
+// fixed operands of transform and rotate
+static v3_mat3 accuracy_matrix = {{0.8f, -2.5f, 1e-3f, 3.0f, 0.25f, -1.5f, -1e3f, 7.0f, 0.5f}};
+static v3_quat accuracy_quat;
+
+// json output file, NULL unless --json is given
+static FILE *json_file = NULL;
+static bool json_first = true;
+
+// wall clock time in seconds
+static double now_seconds()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// next pseudo-random value in [0, 1)
+static double next_uniform(uint64_t *seed)
+{
+    *seed = *seed * 6364136223846793005ull + 1442695040888963407ull;
+    return (double)(*seed >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// next pseudo-random component in [-1, 1]
+static double next_component(uint64_t *seed)
+{
+    return next_uniform(seed) * 2.0 - 1.0;
+}
+
+// random unit direction in double, rejecting points outside the unit ball
+static void next_direction(double *v, uint64_t *seed)
+{
+    double len2;
+    do
+    {
+        v[0] = next_component(seed);
+        v[1] = next_component(seed);
+        v[2] = next_component(seed);
+        len2 = v[0] * v[0] + v[1] * v[1] + v[2] * v[2];
+    } while (len2 > 1.0 || len2 < 1e-6);
+
+    double inv = 1.0 / sqrt(len2);
+    v[0] *= inv;
+    v[1] *= inv;
+    v[2] *= inv;
+}
+
+// random denormal float with a random sign
+static float next_denormal(uint64_t *seed)
+{
+    float d = (float)ldexp(next_uniform(seed), -126);
+    return (next_uniform(seed) < 0.5) ? -d : d;
+}
+
+static double length_of(const float *a)
+{
+    return sqrt((double)a[0] * a[0] + (double)a[1] * a[1] + (double)a[2] * a[2]);
+}
+
+static double dot_of(const float *a, const float *b)
+{
+    return (double)a[0] * b[0] + (double)a[1] * b[1] + (double)a[2] * b[2];
+}
+
+static double abs_dot_of(const float *a, const float *b)
+{
+    return fabs((double)a[0] * b[0]) + fabs((double)a[1] * b[1]) + fabs((double)a[2] * b[2]);
+}
+
+// fill one input pair of a class
+static void generate_pair(float *a, float *b, input_class kind, uint64_t *seed)
+{
+    double u[3], v[3];
+    switch (kind)
+    {
+    case INPUT_RANDOM:
+        for (int k = 0; k < 3; k++)
+        {
+            a[k] = (float)next_component(seed);
+            b[k] = (float)next_component(seed);
+        }
+        return;
+
+    case INPUT_MAGNITUDE:
+    {
+        double la = ldexp(1.0, (int)(next_uniform(seed) * 121.0) - 60);
+        double lb = ldexp(1.0, (int)(next_uniform(seed) * 121.0) - 60);
+        next_direction(u, seed);
+        next_direction(v, seed);
+        for (int k = 0; k < 3; k++)
+        {
+            a[k] = (float)(u[k] * la);
+            b[k] = (float)(v[k] * lb);
+        }
+        return;
+    }
+
+    case INPUT_DENORMAL:
+        for (int k = 0; k < 3; k++)
+        {
+            a[k] = (next_uniform(seed) < 0.5) ? next_denormal(seed) : (float)next_component(seed);
+            b[k] = (next_uniform(seed) < 0.5) ? next_denormal(seed) : (float)next_component(seed);
+        }
+        return;
+
+    case INPUT_PARALLEL:
+    {
+        // b = s a + s |a| e r for a random direction r
+        double s = ldexp(1.0, (int)(next_uniform(seed) * 9.0) - 4);
+        s = (next_uniform(seed) < 0.5) ? -s : s;
+        double e = ldexp(1.0, -6 - (int)(next_uniform(seed) * 19.0));
+        next_direction(u, seed);
+        next_direction(v, seed);
+        for (int k = 0; k < 3; k++)
+        {
+            a[k] = (float)u[k];
+            b[k] = (float)(s * (u[k] + e * v[k]));
+        }
+        return;
+    }
+
+    case INPUT_ORTHOGONAL:
+    {
+        // b = v - (v . u) u, rounded to float
+        next_direction(u, seed);
+        next_direction(v, seed);
+        double d = u[0] * v[0] + u[1] * v[1] + u[2] * v[2];
+        double s = ldexp(1.0, (int)(next_uniform(seed) * 9.0) - 4);
+        for (int k = 0; k < 3; k++)
+        {
+            a[k] = (float)u[k];
+            b[k] = (float)(s * (v[k] - d * u[k]));
+        }
+        return;
+    }
+
+    case INPUT_NEAR_ZERO:
+    {
+        double la = pow(10.0, -8.0 + 4.0 * next_uniform(seed));
+        double lb = pow(10.0, -8.0 + 4.0 * next_uniform(seed));
+        next_direction(u, seed);
+        next_direction(v, seed);
+        for (int k = 0; k < 3; k++)
+        {
+            a[k] = (float)(u[k] * la);
+            b[k] = (float)(v[k] * lb);
+        }
+        return;
+    }
+
+    case INPUT_COUNT:
+        break;
+    }
+}
+
+static v3_soa alloc_soa(size_t count)
+{
+    v3_soa v;
+    v.x = (float *)malloc(count * sizeof(float));
+    v.y = (float *)malloc(count * sizeof(float));
+    v.z = (float *)malloc(count * sizeof(float));
+    return v;
+}
+
+static void free_soa(v3_soa v)
+{
+    free(v.x);
+    free(v.y);
+    free(v.z);
+}
+
+// allocate and fill the inputs of one class; the seed depends only on the class
+static accuracy_data alloc_data(input_class kind, size_t count)
+{
+    accuracy_data d;
+    d.count = count;
+    d.a = alloc_soa(count);
+    d.b = alloc_soa(count);
+    d.unit = alloc_soa(count);
+    d.dst = alloc_soa(count);
+
+    uint64_t seed = 0x9e3779b97f4a7c15ull * (uint64_t)(kind + 1);
+    for (size_t i = 0; i < count; i++)
+    {
+        float a[3], b[3];
+        generate_pair(a, b, kind, &seed);
+        d.a.x[i] = a[0];
+        d.a.y[i] = a[1];
+        d.a.z[i] = a[2];
+        d.b.x[i] = b[0];
+        d.b.y[i] = b[1];
+        d.b.z[i] = b[2];
+
+        // reflect assumes a unit normal; a zero b reflects across +z
+        double len = length_of(b);
+        double inv = (len > 0.0) ? 1.0 / len : 0.0;
+        d.unit.x[i] = (len > 0.0) ? (float)(b[0] * inv) : 0.0f;
+        d.unit.y[i] = (len > 0.0) ? (float)(b[1] * inv) : 0.0f;
+        d.unit.z[i] = (len > 0.0) ? (float)(b[2] * inv) : 1.0f;
+    }
+    return d;
+}
+
+static void free_data(accuracy_data *d)
+{
+    free_soa(d->a);
+    free_soa(d->b);
+    free_soa(d->unit);
+    free_soa(d->dst);
+}
+
+// domains
+
+static bool domain_any(const float *, const float *)
+{
+    return true;
+}
+
+// |a|^2 neither overflows nor loses the result to underflow
+static bool domain_length(const float *a, const float *)
+{
+    double len = length_of(a);
+    return len == 0.0 || (len >= MIN_LENGTH && len < MAX_LENGTH);
+}
+
+// |a| on one clear side of the zero length threshold
+static bool domain_threshold(const float *a, const float *)
+{
+    double len = length_of(a);
+    return len < MAX_LENGTH && fabs(len - V3_EPSILON) > EPSILON_BAND * V3_EPSILON;
+}
+
+static bool domain_angle(const float *a, const float *b)
+{
+    return domain_threshold(a, b) && domain_threshold(b, a) && length_of(a) * length_of(b) < MAX_LENGTH * MAX_LENGTH;
+}
+
+static bool domain_fused_angle(const float *a, const float *b)
+{
+    return domain_angle(a, b) && length_of(a) * length_of(b) < FUSED_MAX_PRODUCT;
+}
+
+// references
+
+// ref = a . b
+static void reference_dot(double *ref, double *scale, const float *a, const float *b)
+{
+    ref[0] = dot_of(a, b);
+    scale[0] = abs_dot_of(a, b);
+}
+
+// ref = a x b
+static void reference_cross(double *ref, double *scale, const float *a, const float *b)
+{
+    for (int k = 0; k < 3; k++)
+    {
+        int p = (k + 1) % 3, q = (k + 2) % 3;
+        ref[k] = (double)a[p] * b[q] - (double)a[q] * b[p];
+        scale[k] = fabs((double)a[p] * b[q]) + fabs((double)a[q] * b[p]);
+    }
+}
+
+// ref = |a|
+static void reference_length(double *ref, double *scale, const float *a, const float *)
+{
+    ref[0] = length_of(a);
+    scale[0] = 0.0;
+}
+
+// ref = 1 / |a|, 0 below V3_EPSILON
+static void reference_inv_length(double *ref, double *scale, const float *a, const float *)
+{
+    double len = length_of(a);
+    ref[0] = (len < V3_EPSILON) ? 0.0 : 1.0 / len;
+    scale[0] = 0.0;
+}
+
+// ref = a / |a|, 0 below V3_EPSILON
+static void reference_normalize(double *ref, double *scale, const float *a, const float *)
+{
+    double len = length_of(a);
+    double inv = (len < V3_EPSILON) ? 0.0 : 1.0 / len;
+    for (int k = 0; k < 3; k++)
+    {
+        ref[k] = a[k] * inv;
+        scale[k] = 0.0;
+    }
+}
+
+// ref = v - 2 (v . n) n
+static void reference_reflect(double *ref, double *scale, const float *v, const float *n)
+{
+    double d = dot_of(v, n);
+    double abs_d = abs_dot_of(v, n);
+    for (int k = 0; k < 3; k++)
+    {
+        ref[k] = v[k] - 2.0 * d * n[k];
+        scale[k] = fabs((double)v[k]) + 2.0 * abs_d * fabs((double)n[k]);
+    }
+}
+
+// ref = angle from atan2(|a x b|, a . b), which stays accurate near 0 and pi
+static void reference_angle(double *ref, double *scale, const float *a, const float *b)
+{
+    double c[3], unused[3];
+    reference_cross(c, unused, a, b);
+    double sine = sqrt(c[0] * c[0] + c[1] * c[1] + c[2] * c[2]);
+    bool zero = length_of(a) < V3_EPSILON || length_of(b) < V3_EPSILON;
+    ref[0] = zero ? 0.0 : atan2(sine, dot_of(a, b));
+    scale[0] = M_PI;
+}
+
+// ref = cosine of the angle, 1 for zero length
+static void reference_cosine(double *ref, double *scale, const float *a, const float *b)
+{
+    double la = length_of(a), lb = length_of(b);
+    bool zero = la < V3_EPSILON || lb < V3_EPSILON;
+    ref[0] = zero ? 1.0 : dot_of(a, b) / (la * lb);
+    scale[0] = 1.0;
+}
+
+// ref = m a
+static void reference_transform(double *ref, double *scale, const float *a, const float *)
+{
+    for (int r = 0; r < 3; r++)
+    {
+        const float *row = &accuracy_matrix.m[r * 3];
+        ref[r] = (double)row[0] * a[0] + (double)row[1] * a[1] + (double)row[2] * a[2];
+        scale[r] = fabs((double)row[0] * a[0]) + fabs((double)row[1] * a[1]) + fabs((double)row[2] * a[2]);
+    }
+}
+
+// ref = q a q*, as v + w t + q x t with t = 2 q x v, for the float q
+static void reference_rotate(double *ref, double *scale, const float *a, const float *)
+{
+    double q[3] = {accuracy_quat.x, accuracy_quat.y, accuracy_quat.z};
+    double t[3], u[3];
+    for (int k = 0; k < 3; k++)
+    {
+        int p = (k + 1) % 3, r = (k + 2) % 3;
+        t[k] = 2.0 * (q[p] * a[r] - q[r] * a[p]);
+    }
+    for (int k = 0; k < 3; k++)
+    {
+        int p = (k + 1) % 3, r = (k + 2) % 3;
+        u[k] = q[p] * t[r] - q[r] * t[p];
+    }
+    double len = length_of(a);
+    for (int k = 0; k < 3; k++)
+    {
+        ref[k] = a[k] + accuracy_quat.w * t[k] + u[k];
+        scale[k] = len;
+    }
+}
+
+// variants over the scalar api, one element at a time
+
+static void scalar_dot_product(v3_soa dst, v3_soa a, v3_soa b, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        float va[3] = {a.x[i], a.y[i], a.z[i]};
+        float vb[3] = {b.x[i], b.y[i], b.z[i]};
+        dst.x[i] = v3_dot_product(va, vb);
+    }
+}
+
+static void scalar_cross_product(v3_soa dst, v3_soa a, v3_soa b, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        float va[3] = {a.x[i], a.y[i], a.z[i]};
+        float vb[3] = {b.x[i], b.y[i], b.z[i]};
+        float r[3];
+        v3_cross_product(r, va, vb);
+        dst.x[i] = r[0];
+        dst.y[i] = r[1];
+        dst.z[i] = r[2];
+    }
+}
+
+static void scalar_length(v3_soa dst, v3_soa a, v3_soa, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        float va[3] = {a.x[i], a.y[i], a.z[i]};
+        dst.x[i] = v3_length(va);
+    }
+}
+
+static void scalar_inv_length(v3_soa dst, v3_soa a, v3_soa, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        float va[3] = {a.x[i], a.y[i], a.z[i]};
+        dst.x[i] = v3_inv_length(va);
+    }
+}
+
+static void scalar_normalize(v3_soa dst, v3_soa a, v3_soa, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        float va[3] = {a.x[i], a.y[i], a.z[i]};
+        float r[3];
+        v3_normalize(r, va);
+        dst.x[i] = r[0];
+        dst.y[i] = r[1];
+        dst.z[i] = r[2];
+    }
+}
+
+static void scalar_normalize_fast(v3_soa dst, v3_soa a, v3_soa, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        float va[3] = {a.x[i], a.y[i], a.z[i]};
+        float r[3];
+        v3_normalize_fast(r, va);
+        dst.x[i] = r[0];
+        dst.y[i] = r[1];
+        dst.z[i] = r[2];
+    }
+}
+
+static void scalar_reflect(v3_soa dst, v3_soa v, v3_soa n, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        float vv[3] = {v.x[i], v.y[i], v.z[i]};
+        float vn[3] = {n.x[i], n.y[i], n.z[i]};
+        float r[3];
+        v3_reflect(r, vv, vn);
+        dst.x[i] = r[0];
+        dst.y[i] = r[1];
+        dst.z[i] = r[2];
+    }
+}
+
+static void scalar_angle(v3_soa dst, v3_soa a, v3_soa b, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        float va[3] = {a.x[i], a.y[i], a.z[i]};
+        float vb[3] = {b.x[i], b.y[i], b.z[i]};
+        dst.x[i] = v3_angle(va, vb);
+    }
+}
+
+static void scalar_angle_quick(v3_soa dst, v3_soa a, v3_soa b, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        float va[3] = {a.x[i], a.y[i], a.z[i]};
+        float vb[3] = {b.x[i], b.y[i], b.z[i]};
+        dst.x[i] = v3_angle_quick(va, vb);
+    }
+}
+
+// variants over the batch api
+
+static void batch_dot_product(v3_soa dst, v3_soa a, v3_soa b, size_t count) { v3_dot_product_batch(dst.x, a, b, count); }
+static void batch_cross_product(v3_soa dst, v3_soa a, v3_soa b, size_t count) { v3_cross_product_batch(dst, a, b, count); }
+static void batch_length(v3_soa dst, v3_soa a, v3_soa, size_t count) { v3_length_batch(dst.x, a, count); }
+static void batch_inv_length(v3_soa dst, v3_soa a, v3_soa, size_t count) { v3_inv_length_batch(dst.x, a, count); }
+static void batch_normalize(v3_soa dst, v3_soa a, v3_soa, size_t count) { v3_normalize_batch(dst, a, count); }
+static void batch_normalize_fast(v3_soa dst, v3_soa a, v3_soa, size_t count) { v3_normalize_fast_batch(dst, a, NULL, count); }
+static void batch_reflect(v3_soa dst, v3_soa v, v3_soa n, size_t count) { v3_reflect_batch(dst, v, n, count); }
+static void batch_angle_exact(v3_soa dst, v3_soa a, v3_soa b, size_t count) { v3_angle_batch(dst.x, a, b, count, V3_ANGLE_EXACT); }
+static void batch_angle_poly(v3_soa dst, v3_soa a, v3_soa b, size_t count) { v3_angle_batch(dst.x, a, b, count, V3_ANGLE_POLY); }
+static void batch_angle_cosine(v3_soa dst, v3_soa a, v3_soa b, size_t count) { v3_angle_batch(dst.x, a, b, count, V3_ANGLE_COSINE); }
+static void batch_transform(v3_soa dst, v3_soa a, v3_soa, size_t count) { v3_mat3_transform_batch(dst, &accuracy_matrix, a, count); }
+static void batch_rotate(v3_soa dst, v3_soa a, v3_soa, size_t count) { v3_quat_rotate_batch(dst, &accuracy_quat, a, count); }
+
+// every variant and its max ulp budget, set a little above the worst error
+// measured on every instruction set
+static const accuracy_case accuracy_cases[] = {
+    {"v3_dot_product", "scalar", false, 1, false, scalar_dot_product, reference_dot, domain_any, 2.0},
+    {"v3_cross_product", "scalar", false, 3, false, scalar_cross_product, reference_cross, domain_any, 1.5},
+    {"v3_length", "scalar", false, 1, false, scalar_length, reference_length, domain_length, 2.0},
+    {"v3_inv_length", "scalar", false, 1, false, scalar_inv_length, reference_inv_length, domain_threshold, 5.0},
+    {"v3_normalize", "scalar", false, 3, false, scalar_normalize, reference_normalize, domain_threshold, 3.0},
+    {"v3_normalize_fast", "scalar", false, 3, false, scalar_normalize_fast, reference_normalize, domain_threshold, 5.0},
+    {"v3_reflect", "scalar", false, 3, true, scalar_reflect, reference_reflect, domain_any, 4.0},
+    {"v3_angle", "scalar", false, 1, false, scalar_angle, reference_angle, domain_angle, 4096.0},
+    {"v3_angle_quick", "scalar", false, 1, false, scalar_angle_quick, reference_cosine, domain_angle, 4.0},
+    {"v3_dot_product", "batch", true, 1, false, batch_dot_product, reference_dot, domain_any, 2.0},
+    {"v3_cross_product", "batch", true, 3, false, batch_cross_product, reference_cross, domain_any, 1.5},
+    {"v3_length", "batch", false, 1, false, batch_length, reference_length, domain_length, 2.0},
+    {"v3_inv_length", "batch", true, 1, false, batch_inv_length, reference_inv_length, domain_threshold, 5.0},
+    {"v3_normalize", "batch", true, 3, false, batch_normalize, reference_normalize, domain_threshold, 3.0},
+    {"v3_normalize_fast", "batch", true, 3, false, batch_normalize_fast, reference_normalize, domain_threshold, 5.0},
+    {"v3_reflect", "batch", true, 3, true, batch_reflect, reference_reflect, domain_any, 4.0},
+    {"v3_angle exact", "batch", false, 1, false, batch_angle_exact, reference_angle, domain_angle, 4096.0},
+    {"v3_angle poly", "batch", true, 1, false, batch_angle_poly, reference_angle, domain_fused_angle, 4096.0},
+    {"v3_angle cosine", "batch", true, 1, false, batch_angle_cosine, reference_cosine, domain_fused_angle, 4.0},
+    {"v3_mat3_transform", "batch", true, 3, false, batch_transform, reference_transform, domain_any, 2.5},
+    {"v3_quat_rotate", "batch", true, 3, false, batch_rotate, reference_rotate, domain_any, 4.0}
+};
+
+// spacing of floats at |x|, the denormal spacing below FLT_MIN
+static double float_ulp(double x)
+{
+    x = fabs(x);
+    if (x < FLT_MIN)
+    {
+        return ldexp(1.0, -149);
+    }
+    if (x > FLT_MAX)
+    {
+        x = FLT_MAX;
+    }
+    int exponent;
+    frexp(x, &exponent);
+    return ldexp(1.0, exponent - 24);
+}
+
+// error of one result in ulps of max(|ref|, scale); non-finite results of a
+// finite reference are infinitely wrong
+static double ulp_error(float result, double ref, double scale)
+{
+    if (!isfinite(result))
+    {
+        return isfinite(ref) ? INFINITY : 0.0;
+    }
+    double magnitude = (fabs(ref) > scale) ? fabs(ref) : scale;
+    return fabs((double)result - ref) / float_ulp(magnitude);
+}
+
+// run a variant over every class and compare it with the reference
+static accuracy_result measure(const accuracy_case *c, accuracy_data *data)
+{
+    accuracy_result r;
+    memset(&r, 0, sizeof(r));
+
+    for (int kind = 0; kind < INPUT_COUNT; kind++)
+    {
+        accuracy_data *d = &data[kind];
+        v3_soa b = c->unit_b ? d->unit : d->b;
+        c->fn(d->dst, d->a, b, d->count);
+
+        for (size_t i = 0; i < d->count; i++)
+        {
+            float va[3] = {d->a.x[i], d->a.y[i], d->a.z[i]};
+            float vb[3] = {b.x[i], b.y[i], b.z[i]};
+            if (!c->domain(va, vb))
+            {
+                r.skipped++;
+                continue;
+            }
+
+            double ref[3], scale[3];
+            float result[3] = {d->dst.x[i], d->dst.y[i], d->dst.z[i]};
+            c->reference(ref, scale, va, vb);
+            for (int k = 0; k < c->results; k++)
+            {
+                double e = ulp_error(result[k], ref[k], scale[k]);
+                r.sum_ulp += e;
+                r.max_ulp = (e > r.max_ulp) ? e : r.max_ulp;
+                r.class_max[kind] = (e > r.class_max[kind]) ? e : r.class_max[kind];
+            }
+            r.checked++;
+        }
+    }
+    return r;
+}
+
+static int compare_doubles(const void *a, const void *b)
+{
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// median ns per element over the random class; calibrating the passes doubles as the warmup
+static double time_case(const accuracy_case *c, accuracy_data *d)
+{
+    v3_soa b = c->unit_b ? d->unit : d->b;
+    size_t passes = 1;
+    for (;;)
+    {
+        double start = now_seconds();
+        for (size_t p = 0; p < passes; p++)
+        {
+            c->fn(d->dst, d->a, b, d->count);
+        }
+        if (now_seconds() - start >= MIN_REP_SECONDS || passes >= ((size_t)1 << 20))
+        {
+            break;
+        }
+        passes *= 2;
+    }
+
+    double ns[TIMING_REPS];
+    for (int r = 0; r < TIMING_REPS; r++)
+    {
+        double start = now_seconds();
+        for (size_t p = 0; p < passes; p++)
+        {
+            c->fn(d->dst, d->a, b, d->count);
+        }
+        ns[r] = (now_seconds() - start) * 1e9 / ((double)passes * (double)d->count);
+    }
+    sink = d->dst.x[d->count / 2];
+
+    qsort(ns, TIMING_REPS, sizeof(double), compare_doubles);
+    return ns[TIMING_REPS / 2];
+}
+
+// print one row and its json record; returns whether it is within budget
+static bool report(const accuracy_case *c, const char *isa, const accuracy_result *r)
+{
+    int worst = 0;
+    for (int kind = 1; kind < INPUT_COUNT; kind++)
+    {
+        worst = (r->class_max[kind] > r->class_max[worst]) ? kind : worst;
+    }
+    double mean = (r->checked > 0) ? r->sum_ulp / (double)(r->checked * c->results) : 0.0;
+    bool within = r->max_ulp <= c->budget;
+
+    printf("  %-20s %-6s %-7s %9.2f %9.3f  %-10s %8.3f ns %7.1f  %s\n", c->name, c->form, isa, r->max_ulp, mean,
+           input_names[worst], r->ns_per_op, c->budget, within ? "ok" : "OVER BUDGET");
+
+    if (json_file != NULL)
+    {
+        fprintf(json_file, "%s\n    {\"name\": \"%s\", \"form\": \"%s\", \"isa\": \"%s\", \"max_ulp\": %.4f, \"mean_ulp\": %.6f, "
+                "\"budget_ulp\": %.1f, \"checked\": %zu, \"skipped\": %zu, \"ns_per_op\": %.4f, \"max_ulp_by_inputs\": {",
+                json_first ? "" : ",", c->name, c->form, isa, r->max_ulp, mean, c->budget, r->checked, r->skipped,
+                r->ns_per_op);
+        for (int kind = 0; kind < INPUT_COUNT; kind++)
+        {
+            fprintf(json_file, "%s\"%s\": %.4f", (kind == 0) ? "" : ", ", input_names[kind], r->class_max[kind]);
+        }
+        fprintf(json_file, "}, \"within_budget\": %s}", within ? "true" : "false");
+        json_first = false;
+    }
+    return within;
+}
+
+// measure a variant, on every supported instruction set when it dispatches
+// returns the number of rows over budget
+static int run_case(const accuracy_case *c, accuracy_data *data)
+{
+    int over = 0;
+    v3_isa original = v3_get_isa();
+    for (int isa = 0; isa < V3_ISA_COUNT; isa++)
+    {
+        if (c->dispatched ? !v3_set_isa((v3_isa)isa) : isa > 0)
+        {
+            continue;
+        }
+        accuracy_result r = measure(c, data);
+        r.ns_per_op = time_case(c, &data[INPUT_RANDOM]);
+        if (!report(c, c->dispatched ? v3_isa_name((v3_isa)isa) : "-", &r))
+        {
+            over++;
+        }
+    }
+    v3_set_isa(original);
+    return over;
+}
+
+static int usage(const char *program)
+{
+    fprintf(stderr, "Usage: %s [--json FILE] [--filter TEXT] [--quick]\n", program);
+    return 1;
+}
+
+int main(int argc, char **argv)
+{
+    accuracy_options options = {NULL, NULL, DEFAULT_COUNT};
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+        {
+            options.json_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+        {
+            options.filter = argv[++i];
+        }
+        else if (strcmp(argv[i], "--quick") == 0)
+        {
+            options.count = QUICK_COUNT;
+        }
+        else
+        {
+            return usage(argv[0]);
+        }
+    }
+
+    if (options.json_path != NULL)
+    {
+        json_file = fopen(options.json_path, "w");
+        if (json_file == NULL)
+        {
+            fprintf(stderr, "Error: Cannot open %s for writing\n", options.json_path);
+            return 1;
+        }
+        fprintf(json_file, "{\n  \"count_per_inputs\": %zu,\n  \"results\": [", options.count);
+    }
+
+    float axis[3] = {1.0f, 2.0f, -2.0f};
+    v3_quat_from_axis_angle(&accuracy_quat, axis, 0.7f);
+
+    accuracy_data data[INPUT_COUNT];
+    for (int kind = 0; kind < INPUT_COUNT; kind++)
+    {
+        data[kind] = alloc_data((input_class)kind, options.count);
+    }
+
+    printf("3D Vector Math Library Accuracy\n");
+    printf("%zu vectors of each input class: max and mean ulp error, the inputs of the max, ns/op on random "
+           "inputs, max ulp budget\n", options.count);
+
+    int over = 0;
+    size_t case_count = sizeof(accuracy_cases) / sizeof(accuracy_cases[0]);
+    for (size_t i = 0; i < case_count; i++)
+    {
+        const accuracy_case *c = &accuracy_cases[i];
+        if (options.filter == NULL || strstr(c->name, options.filter) != NULL)
+        {
+            over += run_case(c, data);
+        }
+    }
+
+    for (int kind = 0; kind < INPUT_COUNT; kind++)
+    {
+        free_data(&data[kind]);
+    }
+
+    if (json_file != NULL)
+    {
+        fprintf(json_file, "\n  ]\n}\n");
+        fclose(json_file);
+        printf("\nresults written to %s\n", options.json_path);
+    }
+
+    if (over > 0)
+    {
+        printf("\n%d variants over budget\n", over);
+        return 1;
+    }
+    printf("\nall variants within budget\n");
+    return 0;
+}
@@ -0,0 +1,184 @@
+// library inclusions
+#include "v3arena.h"
+#include <pthread.h>
+#include <stdlib.h>
+
+// block header, padded so the data after it starts aligned
+struct v3_arena_block
+{
+    v3_arena_block *next;
+    size_t size;                // data bytes after the header
+} __attribute__((aligned(V3_ARENA_ALIGN)));
+
+static_assert(sizeof(v3_arena_block) % V3_ARENA_ALIGN == 0, "block data must start aligned");
+
+// each thread's arena, registered with thread_key on first use so it is freed at thread exit
+static __thread v3_arena thread_arena;
+static __thread bool thread_arena_ready = false;
+static pthread_key_t thread_key;
+static pthread_once_t thread_key_once = PTHREAD_ONCE_INIT;
+
+static size_t align_up(size_t n)
+{
+    return (n + V3_ARENA_ALIGN - 1) & ~(size_t)(V3_ARENA_ALIGN - 1);
+}
+
+static unsigned char *block_data(v3_arena_block *block)
+{
+    return (unsigned char *)(block + 1);
+}
+
+// make block current with used bytes taken
+static void enter(v3_arena *arena, v3_arena_block *block, size_t used)
+{
+    arena->current = block;
+    arena->base = (block != NULL) ? block_data(block) : NULL;
+    arena->capacity = (block != NULL) ? block->size : 0;
+    arena->used = used;
+}
+
+// empty arena
+void v3_arena_init(v3_arena *arena, size_t block_size)
+{
+    assert(arena != NULL);
+
+    arena->first = NULL;
+    arena->block_size = block_size;
+    enter(arena, NULL, 0);
+}
+
+// move on to a kept block or a new one; bytes is already aligned
+void *v3_arena_alloc_block(v3_arena *arena, size_t bytes)
+{
+    assert(arena != NULL);
+
+    v3_arena_block *next = (arena->current != NULL) ? arena->current->next : arena->first;
+    while (next != NULL && bytes > next->size)
+    {
+        // too small for this request, skipped until the next reset
+        enter(arena, next, next->size);
+        next = next->next;
+    }
+
+    if (next == NULL)
+    {
+        size_t block_size = (arena->block_size != 0) ? align_up(arena->block_size) : V3_ARENA_BLOCK;
+        size_t size = (bytes > block_size) ? bytes : block_size;
+        next = (v3_arena_block *)aligned_alloc(V3_ARENA_ALIGN, sizeof(v3_arena_block) + size);
+        if (next == NULL)
+        {
+            return NULL;
+        }
+        next->next = NULL;
+        next->size = size;
+        if (arena->current != NULL)
+        {
+            arena->current->next = next;
+        }
+        else
+        {
+            arena->first = next;
+        }
+    }
+
+    enter(arena, next, bytes);
+    return block_data(next);
+}
+
+// three padded arrays in one allocation
+bool v3_arena_alloc_soa(v3_arena *arena, v3_soa *dst, size_t count)
+{
+    assert(dst != NULL);
+
+    size_t stride = align_up(count * sizeof(float)) / sizeof(float);
+    float *x = (float *)v3_arena_alloc(arena, 3 * stride * sizeof(float));
+    if (x == NULL)
+    {
+        return false;
+    }
+
+    dst->x = x;
+    dst->y = x + stride;
+    dst->z = x + 2 * stride;
+    return true;
+}
+
+float *v3_arena_alloc_aos(v3_arena *arena, size_t count)
+{
+    return (float *)v3_arena_alloc(arena, count * 3 * sizeof(float));
+}
+
+v3_arena_mark v3_arena_mark_position(const v3_arena *arena)
+{
+    assert(arena != NULL);
+
+    v3_arena_mark mark = {arena->current, arena->used};
+    return mark;
+}
+
+void v3_arena_restore(v3_arena *arena, v3_arena_mark mark)
+{
+    assert(arena != NULL);
+
+    enter(arena, mark.block, mark.used);
+}
+
+void v3_arena_reset(v3_arena *arena)
+{
+    assert(arena != NULL);
+
+    enter(arena, NULL, 0);
+}
+
+// free the kept blocks
+void v3_arena_trim(v3_arena *arena)
+{
+    assert(arena != NULL);
+
+    v3_arena_block *block = (arena->current != NULL) ? arena->current->next : arena->first;
+    while (block != NULL)
+    {
+        v3_arena_block *next = block->next;
+        free(block);
+        block = next;
+    }
+
+    if (arena->current != NULL)
+    {
+        arena->current->next = NULL;
+    }
+    else
+    {
+        arena->first = NULL;
+    }
+}
+
+void v3_arena_free(v3_arena *arena)
+{
+    assert(arena != NULL);
+
+    v3_arena_reset(arena);
+    v3_arena_trim(arena);
+}
+
+static void free_thread_arena(void *arena)
+{
+    v3_arena_free((v3_arena *)arena);
+}
+
+static void create_thread_key(void)
+{
+    pthread_key_create(&thread_key, free_thread_arena);
+}
+
+v3_arena *v3_thread_arena(void)
+{
+    if (!thread_arena_ready)
+    {
+        v3_arena_init(&thread_arena, 0);
+        pthread_once(&thread_key_once, create_thread_key);
+        pthread_setspecific(thread_key, &thread_arena);
+        thread_arena_ready = true;
+    }
+    return &thread_arena;
+}
@@ -0,0 +1,97 @@
+#ifndef V3ARENA_H
+#define V3ARENA_H
+
+// library inclusions
+#include "v3math.h"
+
+// 64 byte aligned bump allocator for vector buffers
+//
+// an arena hands out memory from a chain of large blocks by bumping an offset,
+// so an allocation is a few instructions and never touches the heap. nothing is
+// freed on its own: v3_arena_reset releases everything at once and keeps the
+// blocks for the next round, and v3_arena_restore rolls back only what was
+// allocated after a v3_arena_mark. the library borrows scratch space from the
+// calling thread's arena that way, between a mark and a restore, so it never
+// disturbs the caller's own allocations
+//
+// every allocation starts on a V3_ARENA_ALIGN boundary, one cache line and the
+// widest simd vector, and soa arrays are padded to it, so no two arrays share a
+// line and no kernel load is split across two lines
+
+// alignment of every allocation in bytes
+#define V3_ARENA_ALIGN 64
+
+// block size when 0 is passed to v3_arena_init, larger requests get their own block
+#define V3_ARENA_BLOCK (1u << 20)
+
+typedef struct v3_arena_block v3_arena_block;
+
+// blocks before current are full, blocks after it are kept for reuse
+typedef struct
+{
+    v3_arena_block *first;
+    v3_arena_block *current;    // block being bumped, NULL before the first allocation
+    unsigned char *base;        // data of current
+    size_t capacity;            // data bytes of current, 0 before the first allocation
+    size_t used;                // bytes taken from current
+    size_t block_size;          // 0 for V3_ARENA_BLOCK
+} v3_arena;
+
+// a position to roll back to
+typedef struct
+{
+    v3_arena_block *block;
+    size_t used;
+} v3_arena_mark;
+
+// empty arena allocating blocks of block_size bytes (0 for V3_ARENA_BLOCK)
+void v3_arena_init(v3_arena *arena, size_t block_size);
+
+// v3_arena_alloc once the current block is full
+void *v3_arena_alloc_block(v3_arena *arena, size_t bytes);
+
+// bytes aligned to V3_ARENA_ALIGN, bumped inline from the current block
+// returns: the memory, or NULL if a new block is needed and memory runs out
+static inline void *v3_arena_alloc(v3_arena *arena, size_t bytes)
+{
+    assert(arena != NULL);
+
+    bytes = (bytes + V3_ARENA_ALIGN - 1) & ~(size_t)(V3_ARENA_ALIGN - 1);
+    if (bytes > arena->capacity - arena->used)
+    {
+        return v3_arena_alloc_block(arena, bytes);
+    }
+
+    void *p = arena->base + arena->used;
+    arena->used += bytes;
+    return p;
+}
+
+// soa arrays for count vectors, each aligned and padded to V3_ARENA_ALIGN
+// returns false, leaving dst unchanged, if memory runs out
+bool v3_arena_alloc_soa(v3_arena *arena, v3_soa *dst, size_t count);
+
+// aos storage for count vectors, 3 floats each
+// returns: the memory, or NULL if memory runs out
+float *v3_arena_alloc_aos(v3_arena *arena, size_t count);
+
+// current position, for v3_arena_restore
+v3_arena_mark v3_arena_mark_position(const v3_arena *arena);
+
+// release everything allocated since mark; marks taken after it become invalid
+void v3_arena_restore(v3_arena *arena, v3_arena_mark mark);
+
+// release every allocation at once, keeping the blocks for reuse
+void v3_arena_reset(v3_arena *arena);
+
+// free the blocks past the current one, which only hold released allocations
+void v3_arena_trim(v3_arena *arena);
+
+// free every block, leaving an empty arena
+void v3_arena_free(v3_arena *arena);
+
+// the calling thread's arena, created on first use with V3_ARENA_BLOCK blocks
+// and freed when the thread exits; only the calling thread may use it
+v3_arena *v3_thread_arena(void);
+
+#endif
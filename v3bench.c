@@ -0,0 +1,1776 @@
+// library inclusions
+#include "v3math.h"
+#include "v3simd.h"
+#include "v3vec.h"
+#include "v3expr.h"
+#include "v3graph.h"
+#include "v3particle.h"
+#include "v3shade.h"
+#include "v3camera.h"
+#include "v3double.h"
+#include "v3half.h"
+#include "v3pool.h"
+#include "v3ray.h"
+#include "v3mat.h"
+#include "v3quat.h"
+#include "v3bvh.h"
+#include "v3file.h"
+#include "v3arena.h"
+#include "v3reduce.h"
+#include "v3oct.h"
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// minimum duration of one timed repetition
+#define MIN_REP_SECONDS 2e-3
+
+// upper bound on repetitions so the sample arrays stay on the stack
+#define MAX_REPS 64
+
+// queries per pass of the bvh benchmarks, and the largest set brute force runs on
+#define BVH_QUERIES 256
+#define BVH_BRUTE_MAX 100000
+
+// buffers per pass of the allocation cases
+#define ARENA_ROUNDS 1024
+
+// default and --quick repetition counts
+#define DEFAULT_REPS 9
+#define QUICK_REPS 5
+
+// keeps results alive so the compiler cannot drop the measured work
+static volatile float sink = 0.0f;
+
+// buffers shared by every benchmark case, count vectors in each layout
+typedef struct
+{
+    size_t count;
+
+    // array-of-structures inputs and output for the scalar api
+    float (*pa)[3];
+    float (*pb)[3];
+    float (*pc)[3];
+
+    // structure-of-arrays inputs and output for the batch api
+    v3_soa a;
+    v3_soa b;
+    v3_soa c;
+
+    // scalar results and validity masks
+    float *s;
+    uint8_t *mask;
+
+    // other storage formats
+    v3d_soa da;
+    v3d_soa dc;
+    v3h_soa ha;
+    v3h_soa hc;
+
+    // octahedral codes of the unit vectors b
+    v3_oct16 *ob16;
+    v3_oct8 *ob8;
+} bench_data;
+
+// one pass over d->count vectors
+typedef void (*bench_fn)(bench_data *d);
+
+// a benchmark: function name, api form, pass function and bytes read plus written per vector
+typedef struct
+{
+    const char *name;
+    const char *form;
+    bench_fn fn;
+    size_t bytes_per_op;
+} bench_case;
+
+// summary of the repetitions of one case at one working set size
+typedef struct
+{
+    double ns_median;
+    double ns_p10;
+    double ns_p90;
+    double cycles_median;
+    double gb_per_s;
+} bench_result;
+
+// working set size that lands in one level of the memory hierarchy
+typedef struct
+{
+    const char *name;
+    size_t bytes;
+} bench_level;
+
+// command line options
+typedef struct
+{
+    const char *json_path;
+    const char *filter;
+    int reps;
+    int max_threads;
+    bool quick;
+} bench_options;
+
+// json output file, NULL unless --json is given
+static FILE *json_file = NULL;
+static bool json_first = true;
+
+// wall clock time in seconds
+static double now_seconds()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// time stamp counter, or 0 off x86 where the cycle columns stay empty
+static uint64_t read_tsc()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+// next pseudo-random component in [-1, 1]
+static float next_component(uint32_t *seed)
+{
+    *seed = *seed * 1664525u + 1013904223u;
+    return (float)(*seed >> 8) / 16777216.0f * 2.0f - 1.0f;
+}
+
+// allocate a soa batch of count vectors
+static v3_soa alloc_soa(size_t count)
+{
+    v3_soa v;
+    v.x = (float *)malloc(count * sizeof(float));
+    v.y = (float *)malloc(count * sizeof(float));
+    v.z = (float *)malloc(count * sizeof(float));
+    return v;
+}
+
+static void free_soa(v3_soa v)
+{
+    free(v.x);
+    free(v.y);
+    free(v.z);
+}
+
+// allocate and fill every buffer; b holds unit normals so reflect is meaningful
+static bench_data alloc_data(size_t count)
+{
+    bench_data d;
+    d.count = count;
+    d.pa = (float (*)[3])malloc(count * sizeof(*d.pa));
+    d.pb = (float (*)[3])malloc(count * sizeof(*d.pb));
+    d.pc = (float (*)[3])malloc(count * sizeof(*d.pc));
+    d.a = alloc_soa(count);
+    d.b = alloc_soa(count);
+    d.c = alloc_soa(count);
+    d.s = (float *)malloc(count * sizeof(float));
+    d.mask = (uint8_t *)malloc(count);
+    d.da.x = (double *)malloc(count * sizeof(double));
+    d.da.y = (double *)malloc(count * sizeof(double));
+    d.da.z = (double *)malloc(count * sizeof(double));
+    d.dc.x = (double *)malloc(count * sizeof(double));
+    d.dc.y = (double *)malloc(count * sizeof(double));
+    d.dc.z = (double *)malloc(count * sizeof(double));
+    d.ha.x = (v3_half *)malloc(count * sizeof(v3_half));
+    d.ha.y = (v3_half *)malloc(count * sizeof(v3_half));
+    d.ha.z = (v3_half *)malloc(count * sizeof(v3_half));
+    d.hc.x = (v3_half *)malloc(count * sizeof(v3_half));
+    d.hc.y = (v3_half *)malloc(count * sizeof(v3_half));
+    d.hc.z = (v3_half *)malloc(count * sizeof(v3_half));
+    d.ob16 = (v3_oct16 *)malloc(count * sizeof(v3_oct16));
+    d.ob8 = (v3_oct8 *)malloc(count * sizeof(v3_oct8));
+
+    // place the pages the parallel cases stream through near the threads that use them
+    v3_first_touch(d.a.x, count, 9 * sizeof(float));
+    v3_first_touch(d.a.y, count, 9 * sizeof(float));
+    v3_first_touch(d.a.z, count, 9 * sizeof(float));
+    v3_first_touch(d.b.x, count, 9 * sizeof(float));
+    v3_first_touch(d.b.y, count, 9 * sizeof(float));
+    v3_first_touch(d.b.z, count, 9 * sizeof(float));
+    v3_first_touch(d.c.x, count, 9 * sizeof(float));
+    v3_first_touch(d.c.y, count, 9 * sizeof(float));
+    v3_first_touch(d.c.z, count, 9 * sizeof(float));
+    v3_first_touch(d.s, count, 9 * sizeof(float));
+
+    uint32_t seed = 1u;
+    for (size_t i = 0; i < count; i++)
+    {
+        d.a.x[i] = next_component(&seed);
+        d.a.y[i] = next_component(&seed);
+        d.a.z[i] = next_component(&seed);
+        d.b.x[i] = next_component(&seed);
+        d.b.y[i] = next_component(&seed);
+        d.b.z[i] = next_component(&seed);
+        d.c.x[i] = next_component(&seed);
+        d.c.y[i] = next_component(&seed);
+        d.c.z[i] = next_component(&seed);
+    }
+    v3_normalize_batch(d.b, d.b, count);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        d.pa[i][0] = d.a.x[i];
+        d.pa[i][1] = d.a.y[i];
+        d.pa[i][2] = d.a.z[i];
+        d.pb[i][0] = d.b.x[i];
+        d.pb[i][1] = d.b.y[i];
+        d.pb[i][2] = d.b.z[i];
+        d.pc[i][0] = d.c.x[i];
+        d.pc[i][1] = d.c.y[i];
+        d.pc[i][2] = d.c.z[i];
+        d.s[i] = 0.0f;
+        d.mask[i] = 0;
+    }
+
+    v3_float_to_double_batch(d.da.x, d.a.x, count);
+    v3_float_to_double_batch(d.da.y, d.a.y, count);
+    v3_float_to_double_batch(d.da.z, d.a.z, count);
+    v3_float_to_double_batch(d.dc.x, d.c.x, count);
+    v3_float_to_double_batch(d.dc.y, d.c.y, count);
+    v3_float_to_double_batch(d.dc.z, d.c.z, count);
+    v3_float_to_half_batch(d.ha.x, d.a.x, count);
+    v3_float_to_half_batch(d.ha.y, d.a.y, count);
+    v3_float_to_half_batch(d.ha.z, d.a.z, count);
+    v3_float_to_half_batch(d.hc.x, d.c.x, count);
+    v3_float_to_half_batch(d.hc.y, d.c.y, count);
+    v3_float_to_half_batch(d.hc.z, d.c.z, count);
+    v3_oct16_encode_batch(d.ob16, d.b, count);
+    v3_oct8_encode_batch(d.ob8, d.b, count);
+
+    return d;
+}
+
+static void free_data(bench_data *d)
+{
+    free(d->pa);
+    free(d->pb);
+    free(d->pc);
+    free_soa(d->a);
+    free_soa(d->b);
+    free_soa(d->c);
+    free(d->s);
+    free(d->mask);
+    free(d->da.x);
+    free(d->da.y);
+    free(d->da.z);
+    free(d->dc.x);
+    free(d->dc.y);
+    free(d->dc.z);
+    free(d->ha.x);
+    free(d->ha.y);
+    free(d->ha.z);
+    free(d->hc.x);
+    free(d->hc.y);
+    free(d->hc.z);
+    free(d->ob16);
+    free(d->ob8);
+}
+
+// scalar api, one out-of-line call per vector over float[3] arrays
+
+static void scalar_from_points(bench_data *d)
+{
+    for (size_t i = 0; i < d->count; i++) v3_from_points(d->pc[i], d->pa[i], d->pb[i]);
+}
+
+static void scalar_add(bench_data *d)
+{
+    for (size_t i = 0; i < d->count; i++) v3_add(d->pc[i], d->pa[i], d->pb[i]);
+}
+
+static void scalar_subtract(bench_data *d)
+{
+    for (size_t i = 0; i < d->count; i++) v3_subtract(d->pc[i], d->pa[i], d->pb[i]);
+}
+
+static void scalar_dot_product(bench_data *d)
+{
+    for (size_t i = 0; i < d->count; i++) d->s[i] = v3_dot_product(d->pa[i], d->pb[i]);
+}
+
+static void scalar_cross_product(bench_data *d)
+{
+    for (size_t i = 0; i < d->count; i++) v3_cross_product(d->pc[i], d->pa[i], d->pb[i]);
+}
+
+static void scalar_scale(bench_data *d)
+{
+    for (size_t i = 0; i < d->count; i++) v3_scale(d->pc[i], -1.0f);
+}
+
+static void scalar_angle(bench_data *d)
+{
+    for (size_t i = 0; i < d->count; i++) d->s[i] = v3_angle(d->pa[i], d->pb[i]);
+}
+
+static void scalar_angle_quick(bench_data *d)
+{
+    for (size_t i = 0; i < d->count; i++) d->s[i] = v3_angle_quick(d->pa[i], d->pb[i]);
+}
+
+static void scalar_reflect(bench_data *d)
+{
+    for (size_t i = 0; i < d->count; i++) v3_reflect(d->pc[i], d->pa[i], d->pb[i]);
+}
+
+static void scalar_length(bench_data *d)
+{
+    for (size_t i = 0; i < d->count; i++) d->s[i] = v3_length(d->pa[i]);
+}
+
+static void scalar_normalize(bench_data *d)
+{
+    for (size_t i = 0; i < d->count; i++) v3_normalize(d->pc[i], d->pa[i]);
+}
+
+static void scalar_equals(bench_data *d)
+{
+    for (size_t i = 0; i < d->count; i++) d->mask[i] = v3_equals(d->pa[i], d->pb[i], V3_TOLERANCE);
+}
+
+static void scalar_inv_length(bench_data *d)
+{
+    for (size_t i = 0; i < d->count; i++) d->s[i] = v3_inv_length(d->pa[i]);
+}
+
+static void scalar_normalize_fast(bench_data *d)
+{
+    for (size_t i = 0; i < d->count; i++) d->mask[i] = v3_normalize_fast(d->pc[i], d->pa[i]);
+}
+
+// batch api over structure-of-arrays buffers
+
+static void batch_from_points(bench_data *d) { v3_from_points_batch(d->c, d->a, d->b, d->count); }
+static void batch_add(bench_data *d) { v3_add_batch(d->c, d->a, d->b, d->count); }
+static void batch_add_inplace(bench_data *d) { v3_add_batch(d->c, d->c, d->b, d->count); }
+static void batch_add_restrict(bench_data *d) { v3_add_batch_restrict(d->c, d->a, d->b, d->count); }
+static void batch_subtract(bench_data *d) { v3_subtract_batch(d->c, d->a, d->b, d->count); }
+static void batch_dot_product(bench_data *d) { v3_dot_product_batch(d->s, d->a, d->b, d->count); }
+static void batch_cross_product(bench_data *d) { v3_cross_product_batch(d->c, d->a, d->b, d->count); }
+static void batch_scale(bench_data *d) { v3_scale_batch(d->c, -1.0f, d->count); }
+static void batch_reflect(bench_data *d) { v3_reflect_batch(d->c, d->a, d->b, d->count); }
+static void batch_length(bench_data *d) { v3_length_batch(d->s, d->a, d->count); }
+static void batch_normalize(bench_data *d) { v3_normalize_batch(d->c, d->a, d->count); }
+static void batch_inv_length(bench_data *d) { v3_inv_length_batch(d->s, d->a, d->count); }
+static void batch_normalize_fast(bench_data *d) { v3_normalize_fast_batch(d->c, d->a, d->mask, d->count); }
+static void batch_angle_exact(bench_data *d) { v3_angle_batch(d->s, d->a, d->b, d->count, V3_ANGLE_EXACT); }
+static void batch_angle_poly(bench_data *d) { v3_angle_batch(d->s, d->a, d->b, d->count, V3_ANGLE_POLY); }
+static void batch_angle_cosine(bench_data *d) { v3_angle_batch(d->s, d->a, d->b, d->count, V3_ANGLE_COSINE); }
+
+// from_points -> normalize -> reflect -> dot chains, the intermediate never leaves registers
+// except in the unfused form which makes one batch pass per step
+
+static const float chain_light[3] = {0.6f, 0.0f, 0.8f};
+
+static void chain_c_api(bench_data *d)
+{
+    float light[3] = {chain_light[0], chain_light[1], chain_light[2]};
+    for (size_t i = 0; i < d->count; i++)
+    {
+        float v[3];
+        v3_from_points(v, d->pa[i], d->pc[i]);
+        v3_normalize(v, v);
+        v3_reflect(v, v, d->pb[i]);
+        d->s[i] = v3_dot_product(v, light);
+    }
+}
+
+static void chain_vec3(bench_data *d)
+{
+    Vec3f light = Vec3f::load(chain_light);
+    for (size_t i = 0; i < d->count; i++)
+    {
+        Vec3f v = normalize(from_points(Vec3f::load(d->pa[i]), Vec3f::load(d->pc[i])));
+        d->s[i] = dot_product(reflect(v, Vec3f::load(d->pb[i])), light);
+    }
+}
+
+// the batch api has no dot against a constant vector, so the last step is a plain loop
+static void chain_unfused(bench_data *d)
+{
+    v3_from_points_batch(d->c, d->a, d->c, d->count);
+    v3_normalize_batch(d->c, d->c, d->count);
+    v3_reflect_batch(d->c, d->c, d->b, d->count);
+    for (size_t i = 0; i < d->count; i++)
+    {
+        d->s[i] = d->c.x[i] * chain_light[0] + d->c.y[i] * chain_light[1] + d->c.z[i] * chain_light[2];
+    }
+}
+
+static void chain_fused(bench_data *d)
+{
+    v3expr::assign(d->s, v3expr::dot(v3expr::reflect(v3expr::normalize(
+        v3expr::from_points(v3expr::soa(d->a), v3expr::soa(d->c))), v3expr::soa(d->b)),
+        v3expr::vec(Vec3f::load(chain_light))), d->count);
+}
+
+// recorded at run time, the steps run tile by tile on the batch kernels
+static void chain_graph(bench_data *d)
+{
+    v3_graph g;
+    v3_graph_init(&g);
+    int v = v3_graph_from_points(&g, v3_graph_input(&g, d->a), v3_graph_input(&g, d->c));
+    v = v3_graph_reflect(&g, v3_graph_normalize(&g, v), v3_graph_input(&g, d->b));
+    v3_graph_store_scalars(&g, v3_graph_dot_product(&g, v, v3_graph_constant(&g, chain_light)), d->s);
+    v3_graph_run(&g, d->count);
+}
+
+// storage formats
+
+static void format_normalize_double(bench_data *d) { v3d_normalize_batch(d->dc, d->da, d->count); }
+static void format_normalize_half(bench_data *d) { v3h_normalize_batch(d->hc, d->ha, d->count); }
+
+// unit normals b packed, against the float[3] v3_dot_product and v3_reflect batch cases
+static void format_oct16_encode(bench_data *d) { v3_oct16_encode_batch(d->ob16, d->b, d->count); }
+static void format_oct16_decode(bench_data *d) { v3_oct16_decode_batch(d->c, d->ob16, d->count); }
+static void format_oct16_dot(bench_data *d) { v3_oct16_dot_product_batch(d->s, d->ob16, d->a, d->count); }
+static void format_oct8_dot(bench_data *d) { v3_oct8_dot_product_batch(d->s, d->ob8, d->a, d->count); }
+static void format_oct16_reflect(bench_data *d) { v3_oct16_reflect_batch(d->c, d->a, d->ob16, d->count); }
+static void format_oct8_reflect(bench_data *d) { v3_oct8_reflect_batch(d->c, d->a, d->ob8, d->count); }
+
+static void format_float_to_half(bench_data *d)
+{
+    v3_float_to_half_batch(d->hc.x, d->a.x, d->count);
+    v3_float_to_half_batch(d->hc.y, d->a.y, d->count);
+    v3_float_to_half_batch(d->hc.z, d->a.z, d->count);
+}
+
+static void format_half_to_float(bench_data *d)
+{
+    v3_half_to_float_batch(d->c.x, d->ha.x, d->count);
+    v3_half_to_float_batch(d->c.y, d->ha.y, d->count);
+    v3_half_to_float_batch(d->c.z, d->ha.z, d->count);
+}
+
+// rays from the a origins along the b unit directions, about half of them hit each shape
+
+static float ray_v0[3] = {-4.0f, -4.0f, 1.5f};
+static float ray_v1[3] = {4.0f, -4.0f, 1.5f};
+static float ray_v2[3] = {0.0f, 4.0f, 1.5f};
+static float ray_center[3] = {0.0f, 0.0f, 3.0f};
+
+static void scalar_ray_triangle(bench_data *d)
+{
+    for (size_t i = 0; i < d->count; i++)
+    {
+        d->mask[i] = v3_ray_triangle(&d->s[i], d->pa[i], d->pb[i], ray_v0, ray_v1, ray_v2);
+    }
+}
+
+static void scalar_ray_sphere(bench_data *d)
+{
+    for (size_t i = 0; i < d->count; i++)
+    {
+        d->mask[i] = v3_ray_sphere(&d->s[i], d->pa[i], d->pb[i], ray_center, 1.5f);
+    }
+}
+
+static void batch_ray_triangle(bench_data *d) { v3_ray_triangle_batch(d->s, d->mask, d->a, d->b, d->count, ray_v0, ray_v1, ray_v2); }
+static void batch_ray_sphere(bench_data *d) { v3_ray_sphere_batch(d->s, d->mask, d->a, d->b, d->count, ray_center, 1.5f); }
+
+// mesh transforms by one affine matrix, M/s is vertices per second
+
+static v3_mat4 mesh_matrix = {{0.36f, -0.48f, 0.8f, 2.0f,
+                               0.8f, 0.6f, 0.0f, -1.0f,
+                               -0.48f, 0.64f, 0.6f, 0.5f,
+                               0.0f, 0.0f, 0.0f, 1.0f}};
+static v3_mat3 mesh_normal_matrix = {{0.36f, -0.48f, 0.8f, 0.8f, 0.6f, 0.0f, -0.48f, 0.64f, 0.6f}};
+
+// the transform written with v3_scale and v3_add, as without a matrix module
+static void scalar_transform_points(bench_data *d)
+{
+    float column[3][3] = {{mesh_matrix.m[0], mesh_matrix.m[4], mesh_matrix.m[8]},
+                          {mesh_matrix.m[1], mesh_matrix.m[5], mesh_matrix.m[9]},
+                          {mesh_matrix.m[2], mesh_matrix.m[6], mesh_matrix.m[10]}};
+    float translation[3] = {mesh_matrix.m[3], mesh_matrix.m[7], mesh_matrix.m[11]};
+
+    for (size_t i = 0; i < d->count; i++)
+    {
+        float x[3], y[3], z[3];
+        memcpy(x, column[0], sizeof(x));
+        memcpy(y, column[1], sizeof(y));
+        memcpy(z, column[2], sizeof(z));
+        v3_scale(x, d->pa[i][0]);
+        v3_scale(y, d->pa[i][1]);
+        v3_scale(z, d->pa[i][2]);
+        v3_add(d->pc[i], x, y);
+        v3_add(d->pc[i], d->pc[i], z);
+        v3_add(d->pc[i], d->pc[i], translation);
+    }
+}
+
+static void scalar_mat4_transform_point(bench_data *d)
+{
+    for (size_t i = 0; i < d->count; i++)
+    {
+        v3_mat4_transform_point(d->pc[i], &mesh_matrix, d->pa[i]);
+    }
+}
+
+static void batch_transform_points(bench_data *d) { v3_mat4_transform_points_batch(d->c, &mesh_matrix, d->a, d->count); }
+static void batch_transform_directions(bench_data *d) { v3_mat4_transform_directions_batch(d->c, &mesh_matrix, d->b, d->count); }
+static void batch_transform_normals(bench_data *d) { v3_transform_normals_batch(d->c, &mesh_normal_matrix, d->b, d->count); }
+
+// rotation about one axis, M/s is vectors per second
+
+static float rotate_axis[3] = {1.0f, 2.0f, -2.0f};
+static const float rotate_angle = 0.7f;
+
+// rodrigues' formula built by hand from the v3 calls for every vector
+// v' = v cos(a) + (k x v) sin(a) + k (k . v) (1 - cos(a))
+static void scalar_rotate_rodrigues(bench_data *d)
+{
+    for (size_t i = 0; i < d->count; i++)
+    {
+        float k[3], kxv[3], along[3];
+        v3_normalize(k, rotate_axis);
+        float c = cosf(rotate_angle);
+        float s = sinf(rotate_angle);
+        v3_cross_product(kxv, k, d->pa[i]);
+        v3_scale(kxv, s);
+        memcpy(along, k, sizeof(along));
+        v3_scale(along, v3_dot_product(k, d->pa[i]) * (1.0f - c));
+        memcpy(d->pc[i], d->pa[i], sizeof(d->pc[i]));
+        v3_scale(d->pc[i], c);
+        v3_add(d->pc[i], d->pc[i], kxv);
+        v3_add(d->pc[i], d->pc[i], along);
+    }
+}
+
+static void scalar_quat_rotate(bench_data *d)
+{
+    v3_quat q;
+    v3_quat_from_axis_angle(&q, rotate_axis, rotate_angle);
+    for (size_t i = 0; i < d->count; i++)
+    {
+        v3_quat_rotate(d->pc[i], &q, d->pa[i]);
+    }
+}
+
+static void batch_quat_rotate(bench_data *d)
+{
+    v3_quat q;
+    v3_quat_from_axis_angle(&q, rotate_axis, rotate_angle);
+    v3_quat_rotate_batch(d->c, &q, d->a, d->count);
+}
+
+// bvh queries against brute force, the bench_data passed in holds the queries
+// (origins in pa, unit directions in pb) and bvh_geometry the primitives
+
+static bench_data *bvh_geometry = NULL;
+static v3_bvh bvh_points;
+static v3_bvh bvh_mesh;
+
+static void bvh_build(bench_data *d)
+{
+    v3_bvh tree;
+    v3_bvh_build_triangles(&tree, d->a, d->b, d->c, d->count);
+    sink = tree.nodes[0].min[0];
+    v3_bvh_free(&tree);
+}
+
+static void brute_nearest(bench_data *d)
+{
+    for (size_t i = 0; i < d->count; i++)
+    {
+        float best = INFINITY;
+        for (size_t j = 0; j < bvh_geometry->count; j++)
+        {
+            float diff[3];
+            v3_from_points(diff, d->pa[i], bvh_geometry->pa[j]);
+            float distance = v3_length(diff);
+            best = (distance < best) ? distance : best;
+        }
+        d->s[i] = best;
+    }
+}
+
+static void tree_nearest(bench_data *d)
+{
+    for (size_t i = 0; i < d->count; i++)
+    {
+        size_t index;
+        v3_bvh_nearest(&bvh_points, d->pa[i], &index, &d->s[i]);
+    }
+}
+
+static void brute_intersect(bench_data *d)
+{
+    for (size_t i = 0; i < d->count; i++)
+    {
+        float best = V3_RAY_MISS;
+        for (size_t j = 0; j < bvh_geometry->count; j++)
+        {
+            float t;
+            if (v3_ray_triangle(&t, d->pa[i], d->pb[i], bvh_geometry->pa[j], bvh_geometry->pb[j],
+                                bvh_geometry->pc[j]) && t < best)
+            {
+                best = t;
+            }
+        }
+        d->s[i] = best;
+    }
+}
+
+static void tree_intersect(bench_data *d)
+{
+    for (size_t i = 0; i < d->count; i++)
+    {
+        size_t index;
+        v3_bvh_intersect(&bvh_mesh, d->pa[i], d->pb[i], &index, &d->s[i]);
+    }
+}
+
+// normalize a vector file into d->c, the file streamed through mmap or read with
+// pread into d->a as the copying baseline
+
+static v3_file *bench_file = NULL;
+
+static void normalize_chunk(void *context, v3_soa chunk, size_t begin, size_t count)
+{
+    bench_data *d = (bench_data *)context;
+    v3_soa dst = {d->c.x + begin, d->c.y + begin, d->c.z + begin};
+    v3_normalize_batch(dst, chunk, count);
+}
+
+static void file_stream(bench_data *d) { v3_file_stream(bench_file, 0, normalize_chunk, d); }
+
+static void file_pread(bench_data *d)
+{
+    const v3_file_header *header = &bench_file->header;
+    float *arrays[3] = {d->a.x, d->a.y, d->a.z};
+    for (size_t begin = 0; begin < d->count; begin += V3_FILE_CHUNK)
+    {
+        size_t n = (d->count - begin < V3_FILE_CHUNK) ? d->count - begin : V3_FILE_CHUNK;
+        for (int axis = 0; axis < 3; axis++)
+        {
+            off_t offset = (off_t)(header->data_offset + axis * header->array_stride + begin * sizeof(float));
+            if (pread(bench_file->fd, arrays[axis] + begin, n * sizeof(float), offset) != (ssize_t)(n * sizeof(float)))
+            {
+                return;
+            }
+        }
+        v3_soa src = {d->a.x + begin, d->a.y + begin, d->a.z + begin};
+        v3_soa dst = {d->c.x + begin, d->c.y + begin, d->c.z + begin};
+        v3_normalize_batch(dst, src, n);
+    }
+}
+
+// scratch buffers of scratch_count vectors taken and released d->count times,
+// the way callers wrap every batch call; each buffer escapes through
+// scratch_pointer so the compiler cannot drop a malloc and free pair
+
+static size_t scratch_count = 0;
+static void *volatile scratch_pointer = NULL;
+
+static void scratch_malloc(bench_data *d)
+{
+    for (size_t i = 0; i < d->count; i++)
+    {
+        v3_soa t = alloc_soa(scratch_count);
+        t.x[0] = t.y[0] = t.z[0] = (float)i;
+        scratch_pointer = t.x;
+        d->s[i] = t.z[0];
+        free_soa(t);
+    }
+}
+
+static void scratch_arena(bench_data *d)
+{
+    v3_arena *arena = v3_thread_arena();
+    for (size_t i = 0; i < d->count; i++)
+    {
+        v3_arena_mark mark = v3_arena_mark_position(arena);
+        v3_soa t;
+        v3_arena_alloc_soa(arena, &t, scratch_count);
+        t.x[0] = t.y[0] = t.z[0] = (float)i;
+        scratch_pointer = t.x;
+        d->s[i] = t.z[0];
+        v3_arena_restore(arena, mark);
+    }
+}
+
+// reductions; the scalar baseline is the running v3_add sum they replace
+
+static void scalar_sum(bench_data *d)
+{
+    float sum[3] = {0.0f, 0.0f, 0.0f};
+    for (size_t i = 0; i < d->count; i++) v3_add(sum, sum, d->pa[i]);
+    memcpy(d->s, sum, sizeof(sum));
+}
+
+static void reduce_sum_fast(bench_data *d) { v3_sum(d->s, d->a, d->count, V3_REDUCE_FAST); }
+static void reduce_sum_kahan(bench_data *d) { v3_sum(d->s, d->a, d->count, V3_REDUCE_KAHAN); }
+static void reduce_dot_sum(bench_data *d) { v3_dot_sum(d->s, d->a, d->b, d->count, V3_REDUCE_KAHAN); }
+static void reduce_bounds(bench_data *d) { v3_bounds(d->s, d->s + 3, d->a, d->count); }
+
+static void reduce_covariance(bench_data *d)
+{
+    v3_mat3 m;
+    v3_covariance(&m, d->a, d->count, V3_REDUCE_KAHAN);
+    d->s[0] = m.m[0];
+}
+
+// the batch api on the thread pool
+
+static void parallel_add(bench_data *d) { v3_add_batch_parallel(d->c, d->a, d->b, d->count); }
+static void parallel_dot_product(bench_data *d) { v3_dot_product_batch_parallel(d->s, d->a, d->b, d->count); }
+static void parallel_reflect(bench_data *d) { v3_reflect_batch_parallel(d->c, d->a, d->b, d->count); }
+static void parallel_normalize(bench_data *d) { v3_normalize_batch_parallel(d->c, d->a, d->count); }
+static void parallel_normalize_fast(bench_data *d) { v3_normalize_fast_batch_parallel(d->c, d->a, d->mask, d->count); }
+
+// scalar v3_normalize on the pool over the valid a vectors or over zero length
+// ones, so every call of the zero case reports an error under the policy
+// bench_errors sets; the callback does nothing, so its rows time the dispatch
+
+static float (*error_zeros)[3] = NULL;
+
+static void error_callback(v3_error_source, const char *, uint64_t, void *)
+{
+}
+
+static void errors_valid_task(void *context, size_t begin, size_t end)
+{
+    bench_data *d = (bench_data *)context;
+    for (size_t i = begin; i < end; i++)
+    {
+        v3_normalize(d->pc[i], d->pa[i]);
+    }
+}
+
+static void errors_zero_task(void *context, size_t begin, size_t end)
+{
+    bench_data *d = (bench_data *)context;
+    for (size_t i = begin; i < end; i++)
+    {
+        v3_normalize(d->pc[i], error_zeros[i]);
+    }
+}
+
+static void errors_valid(bench_data *d) { v3_parallel_for(d->count, v3_pool_grain(d->count, 24), errors_valid_task, d); }
+static void errors_zero(bench_data *d) { v3_parallel_for(d->count, v3_pool_grain(d->count, 24), errors_zero_task, d); }
+
+// particle steps; bench_particles holds the system, the bench_data passed in
+// only carries the count. particles fall in a box with a floor at y = -10 and a
+// ball at the origin, the scalar baseline steps and bounces one particle at a
+// time through the scalar api
+
+#define PARTICLE_DT (1.0f / 240.0f)
+
+static v3_particles *bench_particles = NULL;
+static const float particle_gravity[3] = {0.0f, -9.81f, 0.0f};
+static const float particle_floor[3] = {0.0f, 1.0f, 0.0f};
+static const float particle_ball[3] = {0.0f, 0.0f, 0.0f};
+
+static void particle_scalar(bench_data *)
+{
+    v3_particles *p = bench_particles;
+    float up[3] = {particle_floor[0], particle_floor[1], particle_floor[2]};
+    for (size_t i = 0; i < p->count; i++)
+    {
+        float x[3] = {p->position.x[i], p->position.y[i], p->position.z[i]};
+        float v[3] = {p->velocity.x[i], p->velocity.y[i], p->velocity.z[i]};
+        float dv[3] = {particle_gravity[0], particle_gravity[1], particle_gravity[2]};
+        v3_scale(dv, PARTICLE_DT);
+        v3_add(v, v, dv);
+        float dx[3] = {v[0], v[1], v[2]};
+        v3_scale(dx, PARTICLE_DT);
+        v3_add(x, x, dx);
+        if (x[1] < -10.0f)
+        {
+            x[1] = -10.0f;
+            if (v[1] < 0.0f)
+            {
+                v3_reflect(v, v, up);
+            }
+        }
+        p->position.x[i] = x[0];
+        p->position.y[i] = x[1];
+        p->position.z[i] = x[2];
+        p->velocity.x[i] = v[0];
+        p->velocity.y[i] = v[1];
+        p->velocity.z[i] = v[2];
+    }
+}
+
+static void particle_euler(bench_data *) { v3_particles_euler(bench_particles, particle_gravity, PARTICLE_DT); }
+static void particle_verlet(bench_data *) { v3_particles_verlet(bench_particles, particle_gravity, PARTICLE_DT); }
+
+static void particle_floor_bounce(bench_data *)
+{
+    v3_particles_euler(bench_particles, particle_gravity, PARTICLE_DT);
+    v3_particles_collide_plane(bench_particles, particle_floor, -10.0f, 1.0f);
+}
+
+static void particle_step(bench_data *)
+{
+    v3_particles_euler(bench_particles, particle_gravity, PARTICLE_DT);
+    v3_particles_collide_plane(bench_particles, particle_floor, -10.0f, 1.0f);
+    v3_particles_collide_sphere(bench_particles, particle_ball, 3.0f, 0.9f);
+}
+
+// shading of a g-buffer; bench_gbuffer and the lights are set by
+// bench_shade_sizes, the bench_data passed in carries the outputs. the scalar
+// baseline shades blinn-phong one pixel and one light at a time through the
+// scalar api
+
+#define SHADE_SHININESS 32
+#define SHADE_MAX_LIGHTS 16
+
+static const v3_gbuffer *bench_gbuffer = NULL;
+static v3_light shade_lights[SHADE_MAX_LIGHTS];
+static int shade_light_count = 0;
+
+static void shade_scalar(bench_data *d)
+{
+    const v3_gbuffer *g = bench_gbuffer;
+    for (size_t i = 0; i < g->count; i++)
+    {
+        float p[3] = {g->position.x[i], g->position.y[i], g->position.z[i]};
+        float n[3] = {g->normal.x[i], g->normal.y[i], g->normal.z[i]};
+        float v[3] = {g->view.x[i], g->view.y[i], g->view.z[i]};
+        float diffuse[3] = {0.0f, 0.0f, 0.0f};
+        float specular[3] = {0.0f, 0.0f, 0.0f};
+        v3_normalize(n, n);
+        v3_normalize(v, v);
+        for (int j = 0; j < shade_light_count; j++)
+        {
+            float l[3], h[3];
+            v3_from_points(l, p, shade_lights[j].position);
+            v3_normalize(l, l);
+            float ndl = v3_dot_product(n, l);
+            if (ndl <= 0.0f)
+            {
+                continue;
+            }
+            v3_add(h, l, v);
+            v3_normalize(h, h);
+            float s = powf(fmaxf(v3_dot_product(n, h), 0.0f), (float)SHADE_SHININESS);
+            for (int k = 0; k < 3; k++)
+            {
+                diffuse[k] += ndl * shade_lights[j].color[k];
+                specular[k] += s * shade_lights[j].color[k];
+            }
+        }
+        d->c.x[i] = diffuse[0];
+        d->c.y[i] = diffuse[1];
+        d->c.z[i] = diffuse[2];
+        d->s[i] = specular[0] + specular[1] + specular[2];
+    }
+}
+
+static void shade_lambert(bench_data *d)
+{
+    v3_shade_batch(d->c, d->b, bench_gbuffer, shade_lights, shade_light_count, SHADE_SHININESS, V3_SHADE_LAMBERT);
+}
+
+static void shade_phong(bench_data *d)
+{
+    v3_shade_batch(d->c, d->b, bench_gbuffer, shade_lights, shade_light_count, SHADE_SHININESS, V3_SHADE_PHONG);
+}
+
+static void shade_blinn_phong(bench_data *d)
+{
+    v3_shade_batch(d->c, d->b, bench_gbuffer, shade_lights, shade_light_count, SHADE_SHININESS,
+                   V3_SHADE_BLINN_PHONG);
+}
+
+// primary rays; bench_camera and the sample count are set by
+// bench_camera_sizes, the directions go to c of the bench_data passed in. the
+// scalar baseline forms each pixel center and calls v3_from_points and
+// v3_normalize on it
+
+static const v3_camera *bench_camera = NULL;
+static int camera_samples = 1;
+
+static void camera_scalar(bench_data *d)
+{
+    const v3_camera *camera = bench_camera;
+    float eye[3] = {camera->origin[0], camera->origin[1], camera->origin[2]};
+    size_t i = 0;
+    for (size_t y = 0; y < camera->height; y++)
+    {
+        for (size_t x = 0; x < camera->width; x++, i++)
+        {
+            float point[3], dir[3];
+            for (int k = 0; k < 3; k++)
+            {
+                point[k] = eye[k] + camera->corner[k] + (float)x * camera->right[k] + (float)y * camera->down[k];
+            }
+            v3_from_points(dir, eye, point);
+            v3_normalize(dir, dir);
+            d->c.x[i] = dir[0];
+            d->c.y[i] = dir[1];
+            d->c.z[i] = dir[2];
+        }
+    }
+}
+
+static void camera_rays(bench_data *d) { v3_camera_rays(d->c, NULL, bench_camera, camera_samples, false, 0u); }
+static void camera_jittered(bench_data *d) { v3_camera_rays(d->c, NULL, bench_camera, camera_samples, true, 1u); }
+
+// every benchmark, run at every working set size
+static const bench_case bench_cases[] =
+{
+    {"v3_from_points", "scalar", scalar_from_points, 36},
+    {"v3_add", "scalar", scalar_add, 36},
+    {"v3_subtract", "scalar", scalar_subtract, 36},
+    {"v3_dot_product", "scalar", scalar_dot_product, 28},
+    {"v3_cross_product", "scalar", scalar_cross_product, 36},
+    {"v3_scale", "scalar", scalar_scale, 24},
+    {"v3_angle", "scalar", scalar_angle, 28},
+    {"v3_angle_quick", "scalar", scalar_angle_quick, 28},
+    {"v3_reflect", "scalar", scalar_reflect, 36},
+    {"v3_length", "scalar", scalar_length, 16},
+    {"v3_normalize", "scalar", scalar_normalize, 24},
+    {"v3_equals", "scalar", scalar_equals, 25},
+    {"v3_inv_length", "scalar", scalar_inv_length, 16},
+    {"v3_normalize_fast", "scalar", scalar_normalize_fast, 25},
+    {"v3_from_points", "batch", batch_from_points, 36},
+    {"v3_add", "batch", batch_add, 36},
+    {"v3_add", "inplace", batch_add_inplace, 36},
+    {"v3_add", "restrict", batch_add_restrict, 36},
+    {"v3_subtract", "batch", batch_subtract, 36},
+    {"v3_dot_product", "batch", batch_dot_product, 28},
+    {"v3_cross_product", "batch", batch_cross_product, 36},
+    {"v3_scale", "batch", batch_scale, 24},
+    {"v3_reflect", "batch", batch_reflect, 36},
+    {"v3_length", "batch", batch_length, 16},
+    {"v3_normalize", "batch", batch_normalize, 24},
+    {"v3_inv_length", "batch", batch_inv_length, 16},
+    {"v3_normalize_fast", "batch", batch_normalize_fast, 25},
+    {"v3_angle exact", "batch", batch_angle_exact, 28},
+    {"v3_angle poly", "batch", batch_angle_poly, 28},
+    {"v3_angle cosine", "batch", batch_angle_cosine, 28},
+    {"v3_sum", "scalar", scalar_sum, 12},
+    {"v3_sum fast", "batch", reduce_sum_fast, 12},
+    {"v3_sum kahan", "batch", reduce_sum_kahan, 12},
+    {"v3_dot_sum kahan", "batch", reduce_dot_sum, 24},
+    {"v3_bounds", "batch", reduce_bounds, 12},
+    {"v3_covariance kahan", "batch", reduce_covariance, 24},
+    {"chain c api", "scalar", chain_c_api, 40},
+    {"chain Vec3 inline", "scalar", chain_vec3, 40},
+    {"chain unfused", "batch", chain_unfused, 112},
+    {"chain fused", "batch", chain_fused, 40},
+    {"chain graph", "batch", chain_graph, 40},
+    {"v3d_normalize", "batch", format_normalize_double, 48},
+    {"v3h_normalize", "batch", format_normalize_half, 12},
+    {"float -> half", "batch", format_float_to_half, 18},
+    {"half -> float", "batch", format_half_to_float, 18},
+    {"v3_oct16_encode", "batch", format_oct16_encode, 16},
+    {"v3_oct16_decode", "batch", format_oct16_decode, 16},
+    {"v3_dot_product", "oct16", format_oct16_dot, 20},
+    {"v3_dot_product", "oct8", format_oct8_dot, 18},
+    {"v3_reflect", "oct16", format_oct16_reflect, 28},
+    {"v3_reflect", "oct8", format_oct8_reflect, 26},
+    {"v3_ray_triangle", "scalar", scalar_ray_triangle, 29},
+    {"v3_ray_sphere", "scalar", scalar_ray_sphere, 29},
+    {"v3_ray_triangle", "packet", batch_ray_triangle, 29},
+    {"v3_ray_sphere", "packet", batch_ray_sphere, 29},
+    {"mat4 points v3_add", "scalar", scalar_transform_points, 24},
+    {"v3_mat4_points", "scalar", scalar_mat4_transform_point, 24},
+    {"v3_mat4_points", "batch", batch_transform_points, 24},
+    {"v3_mat4_directions", "batch", batch_transform_directions, 24},
+    {"v3_transform_normals", "batch", batch_transform_normals, 24},
+    {"rotate rodrigues", "scalar", scalar_rotate_rodrigues, 24},
+    {"v3_quat_rotate", "scalar", scalar_quat_rotate, 24},
+    {"v3_quat_rotate", "batch", batch_quat_rotate, 24}
+};
+
+// bvh build, ns/op is per triangle
+static const bench_case bvh_build_case = {"v3_bvh_build", "bvh", bvh_build, 36};
+
+// bvh queries, ns/op is per query
+static const bench_case bvh_query_cases[] =
+{
+    {"v3_bvh_nearest", "brute", brute_nearest, 0},
+    {"v3_bvh_nearest", "bvh", tree_nearest, 0},
+    {"v3_bvh_intersect", "brute", brute_intersect, 0},
+    {"v3_bvh_intersect", "bvh", tree_intersect, 0}
+};
+
+// vector files, the soa file read both ways and the aos file streamed
+static const bench_case file_cases[] =
+{
+    {"v3_file normalize", "pread", file_pread, 24},
+    {"v3_file normalize", "mmap", file_stream, 24},
+    {"v3_file normalize", "aos", file_stream, 24}
+};
+
+// allocation cost, ns/op is per buffer
+static const bench_case scratch_cases[] =
+{
+    {"scratch soa", "malloc", scratch_malloc, 0},
+    {"scratch soa", "arena", scratch_arena, 0}
+};
+
+// kernels on arena buffers, aligned and shifted off the cache lines by one float
+static const bench_case align_cases[] =
+{
+    {"v3_add", "align64", batch_add, 36},
+    {"v3_add", "align4", batch_add, 36},
+    {"v3_normalize", "align64", batch_normalize, 24},
+    {"v3_normalize", "align4", batch_normalize, 24}
+};
+
+// particle steps from 10K particles to 100M, ns/op and M/s are per particle-step
+static const bench_case particle_cases[] =
+{
+    {"particles euler+floor", "scalar", particle_scalar, 48},
+    {"particles euler+floor", "batch", particle_floor_bounce, 60},
+    {"particles euler", "batch", particle_euler, 48},
+    {"particles verlet", "batch", particle_verlet, 48},
+    {"particles step", "batch", particle_step, 72}
+};
+
+// shading of a 1080p g-buffer under 1, 4 and 16 lights, ns/op and M/s are per pixel
+static const bench_case shade_cases[] =
+{
+    {"shade blinn-phong", "scalar", shade_scalar, 60},
+    {"shade lambert", "batch", shade_lambert, 60},
+    {"shade phong", "batch", shade_phong, 60},
+    {"shade blinn-phong", "batch", shade_blinn_phong, 60}
+};
+
+// primary rays of a 1080p camera at 1 and 4 samples, ns/op and M/s are per ray
+static const bench_case camera_cases[] =
+{
+    {"camera rays", "scalar", camera_scalar, 12},
+    {"camera rays", "batch", camera_rays, 12},
+    {"camera rays jitter", "batch", camera_jittered, 12}
+};
+
+// error reporting under contention, valid against zero length input
+static const bench_case error_cases[] =
+{
+    {"v3_normalize errors", "valid", errors_valid, 24},
+    {"v3_normalize errors", "zero", errors_zero, 24}
+};
+
+// parallel benchmarks, run at the largest working set for 1 to N threads
+static const bench_case scaling_cases[] =
+{
+    {"v3_add", "pool", parallel_add, 36},
+    {"v3_dot_product", "pool", parallel_dot_product, 28},
+    {"v3_reflect", "pool", parallel_reflect, 36},
+    {"v3_normalize", "pool", parallel_normalize, 24},
+    {"v3_normalize_fast", "pool", parallel_normalize_fast, 25},
+    {"v3_sum kahan", "pool", reduce_sum_kahan, 12},
+    {"v3_covariance kahan", "pool", reduce_covariance, 24}
+};
+
+static int compare_doubles(const void *a, const void *b)
+{
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// nearest-rank value at fraction q of n sorted samples
+static double percentile(const double *sorted, int n, double q)
+{
+    return sorted[(int)(q * (n - 1) + 0.5)];
+}
+
+// time one case: calibrating the passes per repetition doubles as the warmup
+static bench_result run_case(const bench_case *c, bench_data *d, int reps)
+{
+    size_t passes = 1;
+    for (;;)
+    {
+        double start = now_seconds();
+        for (size_t p = 0; p < passes; p++)
+        {
+            c->fn(d);
+        }
+        if (now_seconds() - start >= MIN_REP_SECONDS || passes >= ((size_t)1 << 20))
+        {
+            break;
+        }
+        passes *= 2;
+    }
+
+    double ns[MAX_REPS];
+    double cycles[MAX_REPS];
+    double ops = (double)passes * (double)d->count;
+    for (int r = 0; r < reps; r++)
+    {
+        double start = now_seconds();
+        uint64_t start_tsc = read_tsc();
+        for (size_t p = 0; p < passes; p++)
+        {
+            c->fn(d);
+        }
+        cycles[r] = (double)(read_tsc() - start_tsc) / ops;
+        ns[r] = (now_seconds() - start) * 1e9 / ops;
+    }
+    sink = d->s[d->count / 2] + d->c.x[d->count / 2];
+
+    qsort(ns, reps, sizeof(double), compare_doubles);
+    qsort(cycles, reps, sizeof(double), compare_doubles);
+
+    bench_result result;
+    result.ns_median = percentile(ns, reps, 0.5);
+    result.ns_p10 = percentile(ns, reps, 0.1);
+    result.ns_p90 = percentile(ns, reps, 0.9);
+    result.cycles_median = percentile(cycles, reps, 0.5);
+    result.gb_per_s = (double)c->bytes_per_op / result.ns_median;
+    return result;
+}
+
+// print one result row and append it to the json output
+static void report(const bench_case *c, const bench_level *level, size_t count, int reps, int threads,
+                   bench_result r)
+{
+    printf("  %-20s %-6s %9.3f ns  [p10 %8.3f  p90 %8.3f]  %8.2f cyc  %7.2f GB/s  %8.1f M/s\n",
+           c->name, c->form, r.ns_median, r.ns_p10, r.ns_p90, r.cycles_median, r.gb_per_s, 1e3 / r.ns_median);
+
+    if (json_file == NULL)
+    {
+        return;
+    }
+
+    fprintf(json_file, "%s\n    {\"name\": \"%s\", \"form\": \"%s\", \"level\": \"%s\", "
+            "\"working_set_bytes\": %zu, \"count\": %zu, \"threads\": %d, \"reps\": %d, \"bytes_per_op\": %zu, "
+            "\"ns_per_op\": {\"median\": %.4f, \"p10\": %.4f, \"p90\": %.4f}, "
+            "\"cycles_per_op\": %.4f, \"gb_per_s\": %.4f, \"mops_per_s\": %.4f}",
+            json_first ? "" : ",", c->name, c->form, level->name, level->bytes, count, threads, reps,
+            c->bytes_per_op, r.ns_median, r.ns_p10, r.ns_p90, r.cycles_median, r.gb_per_s, 1e3 / r.ns_median);
+    json_first = false;
+}
+
+// working sets sized from the reported caches, returns how many levels to run
+static int cache_levels(bench_level *levels, bool quick)
+{
+    long l1 = sysconf(_SC_LEVEL1_DCACHE_SIZE);
+    long l2 = sysconf(_SC_LEVEL2_CACHE_SIZE);
+    long l3 = sysconf(_SC_LEVEL3_CACHE_SIZE);
+    size_t l1_bytes = (l1 > 0) ? (size_t)l1 : 32u * 1024;
+    size_t l2_bytes = (l2 > 0) ? (size_t)l2 : 1024u * 1024;
+    size_t l3_bytes = (l3 > 0) ? (size_t)l3 : 16u * 1024 * 1024;
+
+    // half of l1 and l2 leaves room for the other buffers; l3 is shared with other
+    // cores and virtual machines often report it as huge, so only a slice is used
+    size_t l3_set = l3_bytes / 4;
+    if (l3_set > 32u * 1024 * 1024) l3_set = 32u * 1024 * 1024;
+    if (l3_set < 2 * l2_bytes) l3_set = 2 * l2_bytes;
+    size_t dram_set = 8 * l3_set;
+    if (dram_set < 256u * 1024 * 1024) dram_set = 256u * 1024 * 1024;
+
+    levels[0].name = "L1";
+    levels[0].bytes = l1_bytes / 2;
+    levels[1].name = "L2";
+    levels[1].bytes = l2_bytes / 2;
+    levels[2].name = "L3";
+    levels[2].bytes = l3_set;
+    levels[3].name = "DRAM";
+    levels[3].bytes = dram_set;
+    return quick ? 3 : 4;
+}
+
+// run every case matching the filter at every working set size
+static void bench_functions(const bench_options *options)
+{
+    bench_level levels[4];
+    int level_count = cache_levels(levels, options->quick);
+    size_t case_count = sizeof(bench_cases) / sizeof(bench_cases[0]);
+
+    for (int l = 0; l < level_count; l++)
+    {
+        // sized by the three soa inputs and output most cases stream through
+        size_t count = levels[l].bytes / (3 * 3 * sizeof(float));
+        bench_data d = alloc_data(count);
+
+        printf("\n%s working set: %zu KB, %zu vectors\n", levels[l].name, levels[l].bytes / 1024, count);
+        for (size_t i = 0; i < case_count; i++)
+        {
+            const bench_case *c = &bench_cases[i];
+            if (options->filter != NULL && strstr(c->name, options->filter) == NULL)
+            {
+                continue;
+            }
+            report(c, &levels[l], count, options->reps, 1, run_case(c, &d, options->reps));
+        }
+
+        free_data(&d);
+    }
+}
+
+// run the parallel cases at the largest working set for 1, 2, 4, ... max_threads threads
+// ns/op is wall time per vector, so it falls as threads are added until memory saturates
+static void bench_scaling(const bench_options *options)
+{
+    bench_level levels[4];
+    int level = cache_levels(levels, options->quick) - 1;
+    size_t count = levels[level].bytes / (3 * 3 * sizeof(float));
+    size_t case_count = sizeof(scaling_cases) / sizeof(scaling_cases[0]);
+
+    v3_pool_set_threads(options->max_threads);
+    bench_data d = alloc_data(count);
+
+    printf("\nscaling on the %s working set: %zu KB, %zu vectors, up to %d threads\n", levels[level].name,
+           levels[level].bytes / 1024, count, options->max_threads);
+    for (int threads = 1; ; threads *= 2)
+    {
+        if (threads > options->max_threads)
+        {
+            threads = options->max_threads;
+        }
+        v3_pool_set_threads(threads);
+        printf(" %d thread%s\n", threads, threads == 1 ? "" : "s");
+        for (size_t i = 0; i < case_count; i++)
+        {
+            const bench_case *c = &scaling_cases[i];
+            if (options->filter != NULL && strstr(c->name, options->filter) == NULL)
+            {
+                continue;
+            }
+            report(c, &levels[level], count, options->reps, threads, run_case(c, &d, options->reps));
+        }
+        if (threads == options->max_threads)
+        {
+            break;
+        }
+    }
+
+    free_data(&d);
+    v3_pool_set_threads(0);
+}
+
+// scalar normalize of valid and zero length vectors on 1, 2, 4, ... max_threads
+// threads under each error policy but print; with reports that take no lock the
+// zero case stays close to the valid one as threads are added
+static void bench_errors(const bench_options *options)
+{
+    if (options->filter != NULL && strstr(error_cases[0].name, options->filter) == NULL)
+    {
+        return;
+    }
+
+    static const v3_error_policy policies[] = {V3_ERROR_SILENT, V3_ERROR_COUNT, V3_ERROR_CALLBACK};
+    static const char *policy_names[] = {"silent", "count", "callback"};
+    size_t count = options->quick ? 65536 : 1048576;
+    size_t case_count = sizeof(error_cases) / sizeof(error_cases[0]);
+    bench_level level = {"errors", count * 6 * sizeof(float)};
+    bench_data d = alloc_data(count);
+    error_zeros = (float (*)[3])calloc(count, sizeof(*error_zeros));
+
+    v3_error_policy saved = v3_get_error_policy();
+    v3_set_error_callback(error_callback, NULL);
+    for (size_t p = 0; p < sizeof(policies) / sizeof(policies[0]); p++)
+    {
+        v3_set_error_policy(policies[p]);
+        for (int threads = 1; ; threads *= 2)
+        {
+            if (threads > options->max_threads)
+            {
+                threads = options->max_threads;
+            }
+            v3_pool_set_threads(threads);
+            printf("\nerror policy %s: %zu vectors, %d thread%s\n", policy_names[p], count, threads,
+                   threads == 1 ? "" : "s");
+            for (size_t i = 0; i < case_count; i++)
+            {
+                report(&error_cases[i], &level, count, options->reps, threads,
+                       run_case(&error_cases[i], &d, options->reps));
+            }
+            if (threads == options->max_threads)
+            {
+                break;
+            }
+        }
+    }
+    v3_set_error_callback(NULL, NULL);
+    v3_set_error_policy(saved);
+    v3_pool_set_threads(0);
+
+    free(error_zeros);
+    error_zeros = NULL;
+    free_data(&d);
+}
+
+// build time and query rates against primitive count; brute force stops at
+// BVH_BRUTE_MAX primitives, where it already takes milliseconds per query
+static void bench_bvh(const bench_options *options)
+{
+    size_t case_count = sizeof(bvh_query_cases) / sizeof(bvh_query_cases[0]);
+    if (options->filter != NULL && strstr(bvh_build_case.name, options->filter) == NULL &&
+        strstr(bvh_query_cases[0].name, options->filter) == NULL &&
+        strstr(bvh_query_cases[2].name, options->filter) == NULL)
+    {
+        return;
+    }
+
+    bench_data queries = alloc_data(BVH_QUERIES);
+    size_t max_count = options->quick ? 100000 : 1000000;
+    for (size_t count = 1000; count <= max_count; count *= 10)
+    {
+        // triangles around the a points with edges shrinking as the set grows, so
+        // about half the rays from inside the cube hit one
+        bench_data geometry = alloc_data(count);
+        float edge = 2.0f / cbrtf((float)count);
+        for (size_t i = 0; i < count; i++)
+        {
+            for (int k = 0; k < 3; k++)
+            {
+                geometry.pb[i][k] = geometry.pa[i][k] + edge * geometry.pb[i][k];
+                geometry.pc[i][k] = geometry.pa[i][k] + edge * geometry.pc[i][k];
+            }
+            geometry.b.x[i] = geometry.pb[i][0];
+            geometry.b.y[i] = geometry.pb[i][1];
+            geometry.b.z[i] = geometry.pb[i][2];
+            geometry.c.x[i] = geometry.pc[i][0];
+            geometry.c.y[i] = geometry.pc[i][1];
+            geometry.c.z[i] = geometry.pc[i][2];
+        }
+        bvh_geometry = &geometry;
+        bench_level level = {"bvh", count * 9 * sizeof(float)};
+
+        printf("\nbvh over %zu primitives, %d threads\n", count, v3_pool_threads());
+        if (options->filter == NULL || strstr(bvh_build_case.name, options->filter) != NULL)
+        {
+            report(&bvh_build_case, &level, count, options->reps, v3_pool_threads(),
+                   run_case(&bvh_build_case, &geometry, options->reps));
+        }
+
+        v3_bvh_build_points(&bvh_points, geometry.a, count);
+        v3_bvh_build_triangles(&bvh_mesh, geometry.a, geometry.b, geometry.c, count);
+        for (size_t i = 0; i < case_count; i++)
+        {
+            const bench_case *c = &bvh_query_cases[i];
+            if ((options->filter != NULL && strstr(c->name, options->filter) == NULL) ||
+                (c->fn == brute_nearest && count > BVH_BRUTE_MAX) ||
+                (c->fn == brute_intersect && count > BVH_BRUTE_MAX))
+            {
+                continue;
+            }
+            report(c, &level, BVH_QUERIES, options->reps, 1, run_case(c, &queries, options->reps));
+        }
+
+        v3_bvh_free(&bvh_points);
+        v3_bvh_free(&bvh_mesh);
+        free_data(&geometry);
+    }
+
+    bvh_geometry = NULL;
+    free_data(&queries);
+}
+
+// particle-steps per second against system size, 10K to 100M particles (1M
+// with --quick); sizes that cannot be allocated end the sweep
+static void bench_particle_sizes(const bench_options *options)
+{
+    size_t case_count = sizeof(particle_cases) / sizeof(particle_cases[0]);
+    bool selected = false;
+    for (size_t i = 0; i < case_count; i++)
+    {
+        selected = selected || options->filter == NULL || strstr(particle_cases[i].name, options->filter) != NULL;
+    }
+    if (!selected)
+    {
+        return;
+    }
+
+    size_t max_count = options->quick ? 1000000 : 100000000;
+    for (size_t count = 10000; count <= max_count; count *= 10)
+    {
+        v3_particles particles;
+        if (!v3_particles_init(&particles, count))
+        {
+            fprintf(stderr, "Error: Cannot allocate %zu particles\n", count);
+            break;
+        }
+        uint32_t seed = 42u;
+        for (size_t i = 0; i < count; i++)
+        {
+            particles.position.x[i] = 10.0f * next_component(&seed);
+            particles.position.y[i] = 10.0f * next_component(&seed);
+            particles.position.z[i] = 10.0f * next_component(&seed);
+            particles.velocity.x[i] = next_component(&seed);
+            particles.velocity.y[i] = next_component(&seed);
+            particles.velocity.z[i] = next_component(&seed);
+        }
+        bench_particles = &particles;
+
+        // run_case only needs the count and somewhere to read its sink from
+        bench_data d;
+        memset(&d, 0, sizeof(d));
+        d.count = count;
+        d.c = particles.position;
+        d.s = particles.velocity.x;
+        bench_level level = {"particles", count * 6 * sizeof(float)};
+
+        printf("\nparticles: %zu, %d threads, M/s is million particle-steps per second\n", count,
+               v3_pool_threads());
+        for (size_t i = 0; i < case_count; i++)
+        {
+            const bench_case *c = &particle_cases[i];
+            if (options->filter == NULL || strstr(c->name, options->filter) != NULL)
+            {
+                report(c, &level, count, options->reps, v3_pool_threads(), run_case(c, &d, options->reps));
+            }
+        }
+
+        bench_particles = NULL;
+        v3_particles_free(&particles);
+    }
+}
+
+// pixels per second shading a 1920x1080 g-buffer (640x360 with --quick) under
+// 1, 4 and 16 point lights scattered above the scene
+static void bench_shade_sizes(const bench_options *options)
+{
+    size_t case_count = sizeof(shade_cases) / sizeof(shade_cases[0]);
+    bool selected = false;
+    for (size_t i = 0; i < case_count; i++)
+    {
+        selected = selected || options->filter == NULL || strstr(shade_cases[i].name, options->filter) != NULL;
+    }
+    if (!selected)
+    {
+        return;
+    }
+
+    // a, b and c of one data set are the positions, unit normals and views;
+    // the batch cases write c and b of the other, the scalar one c and s
+    size_t width = options->quick ? 640 : 1920;
+    size_t height = options->quick ? 360 : 1080;
+    size_t count = width * height;
+    bench_data g_data = alloc_data(count);
+    bench_data d = alloc_data(count);
+    v3_gbuffer g = {g_data.a, g_data.b, g_data.c, count};
+    for (size_t i = 0; i < count; i++)
+    {
+        g.position.x[i] *= 10.0f;
+        g.position.y[i] *= 10.0f;
+        g.position.z[i] *= 10.0f;
+    }
+    uint32_t seed = 7u;
+    for (int j = 0; j < SHADE_MAX_LIGHTS; j++)
+    {
+        shade_lights[j].position[0] = 20.0f * next_component(&seed);
+        shade_lights[j].position[1] = 15.0f + 5.0f * next_component(&seed);
+        shade_lights[j].position[2] = 20.0f * next_component(&seed);
+        for (int k = 0; k < 3; k++)
+        {
+            shade_lights[j].color[k] = 0.5f + 0.5f * next_component(&seed);
+        }
+    }
+    bench_gbuffer = &g;
+    bench_level level = {"gbuffer", count * 15 * sizeof(float)};
+
+    static const int light_counts[] = {1, 4, 16};
+    for (size_t l = 0; l < sizeof(light_counts) / sizeof(light_counts[0]); l++)
+    {
+        shade_light_count = light_counts[l];
+        printf("\nshading: %zux%zu pixels, %d light%s, %d threads, M/s is million pixels per second\n", width,
+               height, shade_light_count, shade_light_count == 1 ? "" : "s", v3_pool_threads());
+        for (size_t i = 0; i < case_count; i++)
+        {
+            const bench_case *c = &shade_cases[i];
+            if (options->filter == NULL || strstr(c->name, options->filter) != NULL)
+            {
+                report(c, &level, count, options->reps, v3_pool_threads(), run_case(c, &d, options->reps));
+            }
+        }
+    }
+
+    bench_gbuffer = NULL;
+    free_data(&g_data);
+    free_data(&d);
+}
+
+// rays per second for a 1920x1080 camera (640x360 with --quick) at 1 and 4
+// samples per pixel; the scalar chain has no samples and runs at 1
+static void bench_camera_sizes(const bench_options *options)
+{
+    size_t case_count = sizeof(camera_cases) / sizeof(camera_cases[0]);
+    bool selected = false;
+    for (size_t i = 0; i < case_count; i++)
+    {
+        selected = selected || options->filter == NULL || strstr(camera_cases[i].name, options->filter) != NULL;
+    }
+    if (!selected)
+    {
+        return;
+    }
+
+    static const float eye[3] = {0.0f, 2.0f, 10.0f};
+    static const float target[3] = {0.0f, 0.0f, 0.0f};
+    static const float up[3] = {0.0f, 1.0f, 0.0f};
+    size_t width = options->quick ? 640 : 1920;
+    size_t height = options->quick ? 360 : 1080;
+    v3_camera camera;
+    v3_camera_look_at(&camera, eye, target, up, 1.0f, width, height);
+    bench_camera = &camera;
+
+    // run_case only needs the count, the directions and a sink
+    size_t max_rays = v3_camera_ray_count(&camera, 4);
+    v3_soa dirs = alloc_soa(max_rays);
+    bench_data d;
+    memset(&d, 0, sizeof(d));
+    d.c = dirs;
+    d.s = dirs.x;
+
+    static const int sample_counts[] = {1, 4};
+    for (size_t n = 0; n < sizeof(sample_counts) / sizeof(sample_counts[0]); n++)
+    {
+        camera_samples = sample_counts[n];
+        d.count = v3_camera_ray_count(&camera, camera_samples);
+        bench_level level = {"rays", d.count * 3 * sizeof(float)};
+        printf("\ncamera: %zux%zu pixels, %d sample%s, %d threads, M/s is million rays per second\n", width, height,
+               camera_samples, camera_samples == 1 ? "" : "s", v3_pool_threads());
+        for (size_t i = 0; i < case_count; i++)
+        {
+            const bench_case *c = &camera_cases[i];
+            if ((options->filter != NULL && strstr(c->name, options->filter) == NULL) ||
+                (c->fn == camera_scalar && camera_samples > 1))
+            {
+                continue;
+            }
+            report(c, &level, d.count, options->reps, v3_pool_threads(), run_case(c, &d, options->reps));
+        }
+    }
+
+    bench_camera = NULL;
+    free_soa(dirs);
+}
+
+// normalize a file the size of the largest working set, written to the temp
+// directory first so its pages are in the page cache: this measures the read
+// path (mapping and readahead against pread copies), not the disk
+static void bench_files(const bench_options *options)
+{
+    if (options->filter != NULL && strstr(file_cases[0].name, options->filter) == NULL)
+    {
+        return;
+    }
+
+    bench_level levels[4];
+    int level = cache_levels(levels, options->quick) - 1;
+    size_t count = levels[level].bytes / (3 * 3 * sizeof(float));
+    bench_data d = alloc_data(count);
+
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/v3bench_%d.v3", (int)getpid());
+    printf("\nfile on the %s working set: %zu KB, %zu vectors\n", levels[level].name, levels[level].bytes / 1024,
+           count);
+
+    size_t case_count = sizeof(file_cases) / sizeof(file_cases[0]);
+    for (size_t i = 0; i < case_count; i++)
+    {
+        const bench_case *c = &file_cases[i];
+        v3_file_layout layout = (strcmp(c->form, "aos") == 0) ? V3_FILE_AOS : V3_FILE_SOA;
+        v3_file file;
+        if (!v3_file_create(&file, path, layout, count))
+        {
+            fprintf(stderr, "Error: Cannot create %s: %s\n", path, strerror(errno));
+            break;
+        }
+        if (layout == V3_FILE_SOA)
+        {
+            v3_soa data = v3_file_soa(&file);
+            memcpy(data.x, d.a.x, count * sizeof(float));
+            memcpy(data.y, d.a.y, count * sizeof(float));
+            memcpy(data.z, d.a.z, count * sizeof(float));
+        }
+        else
+        {
+            memcpy(v3_file_aos(&file), d.pa, count * 3 * sizeof(float));
+        }
+        v3_file_close(&file);
+
+        if (!v3_file_open(&file, path, false))
+        {
+            fprintf(stderr, "Error: Cannot open %s: %s\n", path, strerror(errno));
+            break;
+        }
+        bench_file = &file;
+        report(c, &levels[level], count, options->reps, 1, run_case(c, &d, options->reps));
+        bench_file = NULL;
+        v3_file_close(&file);
+    }
+
+    remove(path);
+    free_data(&d);
+}
+
+// allocation cost of scratch buffers, then kernel throughput on cache line
+// aligned arrays against the same arrays one float off alignment, where every
+// simd load of 32 or 64 bytes straddles two lines
+static void bench_arena(const bench_options *options)
+{
+    if (options->filter != NULL && strstr(scratch_cases[0].name, options->filter) == NULL &&
+        strstr(align_cases[0].name, options->filter) == NULL && strstr(align_cases[2].name, options->filter) == NULL)
+    {
+        return;
+    }
+
+    // small buffers come from malloc's per-thread cache, large ones from its locked main heap
+    bench_data rounds = alloc_data(ARENA_ROUNDS);
+    for (scratch_count = 256; scratch_count <= 65536; scratch_count *= 256)
+    {
+        bench_level scratch_level = {"arena", scratch_count * 3 * sizeof(float)};
+        printf("\nscratch buffers of %zu vectors\n", scratch_count);
+        for (size_t i = 0; i < sizeof(scratch_cases) / sizeof(scratch_cases[0]); i++)
+        {
+            const bench_case *c = &scratch_cases[i];
+            if (options->filter == NULL || strstr(c->name, options->filter) != NULL)
+            {
+                report(c, &scratch_level, ARENA_ROUNDS, options->reps, 1, run_case(c, &rounds, options->reps));
+            }
+        }
+    }
+    free_data(&rounds);
+
+    bench_level levels[4];
+    cache_levels(levels, options->quick);
+    for (int l = 0; l < 2; l++)
+    {
+        size_t count = levels[l].bytes / (3 * 3 * sizeof(float));
+        bench_data d = alloc_data(count);
+        v3_arena arena;
+        v3_arena_init(&arena, 0);
+
+        // one spare float per array to shift into
+        v3_soa a, b, c;
+        bool allocated = v3_arena_alloc_soa(&arena, &a, count + 1) && v3_arena_alloc_soa(&arena, &b, count + 1) &&
+                         v3_arena_alloc_soa(&arena, &c, count + 1);
+        if (!allocated)
+        {
+            fprintf(stderr, "Error: Cannot allocate arena buffers\n");
+            v3_arena_free(&arena);
+            free_data(&d);
+            return;
+        }
+
+        printf("\n%s working set on arena buffers: %zu KB, %zu vectors\n", levels[l].name, levels[l].bytes / 1024,
+               count);
+        for (size_t i = 0; i < sizeof(align_cases) / sizeof(align_cases[0]); i++)
+        {
+            const bench_case *bc = &align_cases[i];
+            if (options->filter != NULL && strstr(bc->name, options->filter) == NULL)
+            {
+                continue;
+            }
+
+            size_t shift = (strcmp(bc->form, "align4") == 0) ? 1 : 0;
+            bench_data shifted = d;
+            shifted.a.x = a.x + shift;
+            shifted.a.y = a.y + shift;
+            shifted.a.z = a.z + shift;
+            shifted.b.x = b.x + shift;
+            shifted.b.y = b.y + shift;
+            shifted.b.z = b.z + shift;
+            shifted.c.x = c.x + shift;
+            shifted.c.y = c.y + shift;
+            shifted.c.z = c.z + shift;
+            memcpy(shifted.a.x, d.a.x, count * sizeof(float));
+            memcpy(shifted.a.y, d.a.y, count * sizeof(float));
+            memcpy(shifted.a.z, d.a.z, count * sizeof(float));
+            memcpy(shifted.b.x, d.b.x, count * sizeof(float));
+            memcpy(shifted.b.y, d.b.y, count * sizeof(float));
+            memcpy(shifted.b.z, d.b.z, count * sizeof(float));
+            report(bc, &levels[l], count, options->reps, 1, run_case(bc, &shifted, options->reps));
+        }
+
+        v3_arena_free(&arena);
+        free_data(&d);
+    }
+}
+
+static int usage(const char *program)
+{
+    fprintf(stderr, "Usage: %s [--json FILE] [--filter TEXT] [--reps N] [--threads N] [--quick]\n", program);
+    return 1;
+}
+
+int main(int argc, char **argv)
+{
+    bench_options options = {NULL, NULL, 0, v3_pool_threads(), false};
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+        {
+            options.json_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+        {
+            options.filter = argv[++i];
+        }
+        else if (strcmp(argv[i], "--reps") == 0 && i + 1 < argc)
+        {
+            options.reps = atoi(argv[++i]);
+            if (options.reps < 1 || options.reps > MAX_REPS)
+            {
+                fprintf(stderr, "Error: --reps must be between 1 and %d\n", MAX_REPS);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+        {
+            options.max_threads = atoi(argv[++i]);
+            if (options.max_threads < 1)
+            {
+                fprintf(stderr, "Error: --threads must be at least 1\n");
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--quick") == 0)
+        {
+            options.quick = true;
+        }
+        else
+        {
+            return usage(argv[0]);
+        }
+    }
+
+    if (options.reps == 0)
+    {
+        options.reps = options.quick ? QUICK_REPS : DEFAULT_REPS;
+    }
+
+    if (options.json_path != NULL)
+    {
+        json_file = fopen(options.json_path, "w");
+        if (json_file == NULL)
+        {
+            fprintf(stderr, "Error: Cannot open %s for writing\n", options.json_path);
+            return 1;
+        }
+        fprintf(json_file, "{\n  \"isa\": \"%s\",\n  \"results\": [", v3_isa_name(v3_get_isa()));
+    }
+
+    printf("3D Vector Math Library Benchmarks\n");
+    printf("isa %s, %d repetitions: median ns/op [p10 p90], tsc cycles/op, GB/s, million ops (vectors or rays)/s\n",
+           v3_isa_name(v3_get_isa()), options.reps);
+
+    bench_functions(&options);
+    bench_bvh(&options);
+    bench_particle_sizes(&options);
+    bench_shade_sizes(&options);
+    bench_camera_sizes(&options);
+    bench_files(&options);
+    bench_arena(&options);
+    bench_scaling(&options);
+    bench_errors(&options);
+
+    if (json_file != NULL)
+    {
+        fprintf(json_file, "\n  ]\n}\n");
+        fclose(json_file);
+        printf("\nresults written to %s\n", options.json_path);
+    }
+
+    return 0;
+}
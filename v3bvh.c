@@ -0,0 +1,701 @@
+// library inclusions
+#include "v3bvh.h"
+#include "v3arena.h"
+#include "v3pool.h"
+#include "v3ray.h"
+#include "v3instrument.h"
+#include <stdlib.h>
+#include <float.h>
+
+// primitives per block of the parallel passes, each block bins into its own slot
+#define BLOCK 4096
+
+// below this depth nodes are split by the surface area heuristic, past it they
+// are halved, which bounds the depth for any input
+#define MAX_SAH_DEPTH 64
+
+// build and traversal stacks: MAX_SAH_DEPTH levels plus the 32 halvings of a 32-bit count
+#define STACK_SIZE 128
+
+// nodes this small become leaves without a split search, testing a few
+// primitives costs about as much as visiting another node
+#define SMALL_LEAF 4
+
+// cost of visiting a node relative to testing one primitive
+#define TRAVERSAL_COST 1.0f
+
+// marks a build task that is not the right child of a node
+#define NO_PARENT UINT32_MAX
+
+typedef struct
+{
+    float min[3];
+    float max[3];
+} box;
+
+typedef struct
+{
+    box bounds;
+    uint32_t count;
+} bin;
+
+// bounds of a block of primitives and of their centroids
+typedef struct
+{
+    box bounds;
+    box centers;
+} block_bounds;
+
+// a primitive during the build; references are partitioned in place, so each
+// node's primitives stay contiguous and the passes over them stream through memory
+typedef struct
+{
+    box bounds;
+    float center[3];
+    uint32_t index;
+} prim_ref;
+
+// state shared by the parallel passes over one node's primitives
+typedef struct
+{
+    prim_ref *refs;
+    block_bounds *bounds;
+    bin (*bins)[3][V3_BVH_BINS];
+    float cmin[3];
+    float scale[3];
+    int bin_count;
+} node_job;
+
+// primitive references from the input arrays
+typedef struct
+{
+    v3_soa corners[3];
+    int corner_count;
+    prim_ref *refs;
+} prim_job;
+
+// copy of the primitives into leaf order
+typedef struct
+{
+    v3_soa corners[3];
+    int corner_count;
+    const prim_ref *refs;
+    uint32_t *indices;
+    float *data;
+} reorder_job;
+
+// a node waiting to be built
+typedef struct
+{
+    uint32_t begin;
+    uint32_t end;
+    uint32_t right_of;
+    uint32_t depth;
+} build_task;
+
+// a node waiting to be visited, with its distance along the ray or squared distance to the query
+typedef struct
+{
+    uint32_t node;
+    float distance;
+} visit;
+
+static inline float min_f(float a, float b)
+{
+    return (a < b) ? a : b;
+}
+
+static inline float max_f(float a, float b)
+{
+    return (a > b) ? a : b;
+}
+
+static void box_empty(box *b)
+{
+    for (int k = 0; k < 3; k++)
+    {
+        b->min[k] = INFINITY;
+        b->max[k] = -INFINITY;
+    }
+}
+
+static void box_grow(box *b, const box *other)
+{
+    for (int k = 0; k < 3; k++)
+    {
+        b->min[k] = min_f(b->min[k], other->min[k]);
+        b->max[k] = max_f(b->max[k], other->max[k]);
+    }
+}
+
+static void box_grow_point(box *b, const float *p)
+{
+    for (int k = 0; k < 3; k++)
+    {
+        b->min[k] = min_f(b->min[k], p[k]);
+        b->max[k] = max_f(b->max[k], p[k]);
+    }
+}
+
+// half the surface area, proportional to the chance a random ray hits the box
+static float half_area(const box *b)
+{
+    float dx = b->max[0] - b->min[0];
+    float dy = b->max[1] - b->min[1];
+    float dz = b->max[2] - b->min[2];
+    return dx * dy + dy * dz + dz * dx;
+}
+
+// centroid bin along one axis, the same mapping for binning and partitioning
+static inline int bin_of(const node_job *job, const float *center, int axis)
+{
+    int b = (int)((center[axis] - job->cmin[axis]) * job->scale[axis]);
+    return (b < job->bin_count - 1) ? b : job->bin_count - 1;
+}
+
+static void prim_task(void *context, size_t begin, size_t end)
+{
+    prim_job *job = (prim_job *)context;
+
+    for (size_t i = begin; i < end; i++)
+    {
+        prim_ref *ref = &job->refs[i];
+        box *b = &ref->bounds;
+        box_empty(b);
+        for (int c = 0; c < job->corner_count; c++)
+        {
+            float p[3] = {job->corners[c].x[i], job->corners[c].y[i], job->corners[c].z[i]};
+            box_grow_point(b, p);
+        }
+        for (int k = 0; k < 3; k++)
+        {
+            ref->center[k] = 0.5f * (b->min[k] + b->max[k]);
+        }
+        ref->index = (uint32_t)i;
+    }
+}
+
+static void reorder_task(void *context, size_t begin, size_t end)
+{
+    reorder_job *job = (reorder_job *)context;
+
+    for (size_t i = begin; i < end; i++)
+    {
+        uint32_t src = job->refs[i].index;
+        job->indices[i] = src;
+        float *dst = job->data + i * 3 * job->corner_count;
+        for (int c = 0; c < job->corner_count; c++)
+        {
+            dst[c * 3] = job->corners[c].x[src];
+            dst[c * 3 + 1] = job->corners[c].y[src];
+            dst[c * 3 + 2] = job->corners[c].z[src];
+        }
+    }
+}
+
+// bounds of each block in [begin, end), begin is a multiple of BLOCK
+static void bounds_task(void *context, size_t begin, size_t end)
+{
+    node_job *job = (node_job *)context;
+
+    for (size_t start = begin; start < end; start += BLOCK)
+    {
+        size_t stop = (end - start < BLOCK) ? end : start + BLOCK;
+        block_bounds *out = &job->bounds[start / BLOCK];
+        box_empty(&out->bounds);
+        box_empty(&out->centers);
+        for (size_t i = start; i < stop; i++)
+        {
+            box_grow(&out->bounds, &job->refs[i].bounds);
+            box_grow_point(&out->centers, job->refs[i].center);
+        }
+    }
+}
+
+// centroid bins of each block in [begin, end) along all three axes
+static void bins_task(void *context, size_t begin, size_t end)
+{
+    node_job *job = (node_job *)context;
+
+    for (size_t start = begin; start < end; start += BLOCK)
+    {
+        size_t stop = (end - start < BLOCK) ? end : start + BLOCK;
+        bin (*out)[V3_BVH_BINS] = job->bins[start / BLOCK];
+        for (int axis = 0; axis < 3; axis++)
+        {
+            for (int b = 0; b < job->bin_count; b++)
+            {
+                box_empty(&out[axis][b].bounds);
+                out[axis][b].count = 0;
+            }
+        }
+        for (size_t i = start; i < stop; i++)
+        {
+            const prim_ref *ref = &job->refs[i];
+            for (int axis = 0; axis < 3; axis++)
+            {
+                if (job->scale[axis] == 0.0f)
+                {
+                    continue;
+                }
+                bin *target = &out[axis][bin_of(job, ref->center, axis)];
+                box_grow(&target->bounds, &ref->bounds);
+                target->count++;
+            }
+        }
+    }
+}
+
+// pick the split of a node's count primitives, partitioning job->refs to match
+// returns: the number of primitives on the left, or 0 to make a leaf
+static size_t split_node(node_job *job, size_t count, const box *bounds, const box *centers, uint32_t depth)
+{
+    if (count <= SMALL_LEAF)
+    {
+        return 0;
+    }
+    if (depth >= MAX_SAH_DEPTH)
+    {
+        return count / 2;
+    }
+
+    // bin along every axis the centroids spread over; bins and bounds are
+    // exact, so merging the blocks in any order gives the same tree
+    // small nodes use one bin per primitive, which keeps the sweep below cheap
+    job->bin_count = (count < V3_BVH_BINS) ? (int)count : V3_BVH_BINS;
+    bool spread = false;
+    for (int k = 0; k < 3; k++)
+    {
+        float extent = centers->max[k] - centers->min[k];
+        float bins = (float)job->bin_count;
+        job->cmin[k] = centers->min[k];
+        job->scale[k] = (extent > bins / FLT_MAX) ? bins / extent : 0.0f;
+        spread = spread || job->scale[k] > 0.0f;
+    }
+    if (!spread)
+    {
+        return (count <= V3_BVH_MAX_LEAF) ? 0 : count / 2;
+    }
+
+    v3_parallel_for(count, BLOCK, bins_task, job);
+    size_t blocks = (count + BLOCK - 1) / BLOCK;
+    bin total[3][V3_BVH_BINS];
+    memcpy(total, job->bins[0], sizeof(total));
+    for (size_t b = 1; b < blocks; b++)
+    {
+        for (int axis = 0; axis < 3; axis++)
+        {
+            for (int i = 0; i < job->bin_count; i++)
+            {
+                box_grow(&total[axis][i].bounds, &job->bins[b][axis][i].bounds);
+                total[axis][i].count += job->bins[b][axis][i].count;
+            }
+        }
+    }
+
+    // sah cost of splitting before bin i: left area * left count + right area * right count
+    float best_cost = INFINITY;
+    int best_axis = -1;
+    int best_bin = 0;
+    for (int axis = 0; axis < 3; axis++)
+    {
+        if (job->scale[axis] == 0.0f)
+        {
+            continue;
+        }
+
+        float right_area[V3_BVH_BINS];
+        uint32_t right_count[V3_BVH_BINS];
+        box right;
+        box_empty(&right);
+        uint32_t n = 0;
+        for (int i = job->bin_count - 1; i > 0; i--)
+        {
+            box_grow(&right, &total[axis][i].bounds);
+            n += total[axis][i].count;
+            right_count[i] = n;
+            right_area[i] = (n > 0) ? half_area(&right) : 0.0f;
+        }
+
+        box left;
+        box_empty(&left);
+        n = 0;
+        for (int i = 1; i < job->bin_count; i++)
+        {
+            box_grow(&left, &total[axis][i - 1].bounds);
+            n += total[axis][i - 1].count;
+            if (n == 0 || right_count[i] == 0)
+            {
+                continue;
+            }
+            float cost = (float)n * half_area(&left) + (float)right_count[i] * right_area[i];
+            if (cost < best_cost)
+            {
+                best_cost = cost;
+                best_axis = axis;
+                best_bin = i;
+            }
+        }
+    }
+
+    float area = half_area(bounds);
+    if (best_axis < 0)
+    {
+        return (count <= V3_BVH_MAX_LEAF) ? 0 : count / 2;
+    }
+    if (count <= V3_BVH_MAX_LEAF && TRAVERSAL_COST * area + best_cost >= (float)count * area)
+    {
+        return 0;
+    }
+
+    // partition in place, bins below best_bin go left
+    size_t i = 0;
+    size_t j = count;
+    while (i < j)
+    {
+        if (bin_of(job, job->refs[i].center, best_axis) < best_bin)
+        {
+            i++;
+        }
+        else
+        {
+            j--;
+            prim_ref swap = job->refs[i];
+            job->refs[i] = job->refs[j];
+            job->refs[j] = swap;
+        }
+    }
+    return i;
+}
+
+// build the nodes depth first: the left child of a node is built next, and the
+// right child fills in its parent's offset when it is reached
+static void build_nodes(v3_bvh *bvh, node_job *job, prim_ref *refs)
+{
+    build_task stack[STACK_SIZE];
+    int top = 0;
+    build_task root = {0, (uint32_t)bvh->count, NO_PARENT, 0};
+    stack[top++] = root;
+
+    while (top > 0)
+    {
+        build_task task = stack[--top];
+        uint32_t index = (uint32_t)bvh->node_count++;
+        if (task.right_of != NO_PARENT)
+        {
+            bvh->nodes[task.right_of].offset = index;
+        }
+
+        size_t count = task.end - task.begin;
+        job->refs = refs + task.begin;
+        v3_parallel_for(count, BLOCK, bounds_task, job);
+
+        box bounds = job->bounds[0].bounds;
+        box centers = job->bounds[0].centers;
+        for (size_t b = 1; b < (count + BLOCK - 1) / BLOCK; b++)
+        {
+            box_grow(&bounds, &job->bounds[b].bounds);
+            box_grow(&centers, &job->bounds[b].centers);
+        }
+
+        v3_bvh_node *node = &bvh->nodes[index];
+        memcpy(node->min, bounds.min, sizeof(node->min));
+        memcpy(node->max, bounds.max, sizeof(node->max));
+
+        size_t split = split_node(job, count, &bounds, &centers, task.depth);
+        if (split == 0)
+        {
+            node->offset = task.begin;
+            node->count = (uint32_t)count;
+            continue;
+        }
+
+        node->offset = 0;
+        node->count = 0;
+        assert(top + 2 <= STACK_SIZE);
+        build_task right = {task.begin + (uint32_t)split, task.end, index, task.depth + 1};
+        build_task left = {task.begin, task.begin + (uint32_t)split, NO_PARENT, task.depth + 1};
+        stack[top++] = right;
+        stack[top++] = left;
+    }
+}
+
+// shared build for points (one corner) and triangles (three corners)
+static bool build(v3_bvh *bvh, v3_bvh_kind kind, const v3_soa *corners, int corner_count, size_t count)
+{
+    assert(bvh != NULL);
+    assert(count < UINT32_MAX);
+
+    memset(bvh, 0, sizeof(*bvh));
+    bvh->kind = kind;
+    if (count == 0)
+    {
+        return true;
+    }
+
+    // build scratch comes from the thread arena, so repeated builds reuse its blocks
+    v3_arena *arena = v3_thread_arena();
+    v3_arena_mark mark = v3_arena_mark_position(arena);
+    size_t blocks = (count + BLOCK - 1) / BLOCK;
+    prim_ref *refs = (prim_ref *)v3_arena_alloc(arena, count * sizeof(prim_ref));
+    block_bounds *bounds = (block_bounds *)v3_arena_alloc(arena, blocks * sizeof(block_bounds));
+    bin (*bins)[3][V3_BVH_BINS] = (bin (*)[3][V3_BVH_BINS])v3_arena_alloc(arena, blocks * sizeof(*bins));
+    bvh->nodes = (v3_bvh_node *)malloc((2 * count - 1) * sizeof(v3_bvh_node));
+    bvh->indices = (uint32_t *)malloc(count * sizeof(uint32_t));
+    bvh->data = (float *)malloc(count * 3 * corner_count * sizeof(float));
+
+    bool ok = refs != NULL && bounds != NULL && bins != NULL &&
+              bvh->nodes != NULL && bvh->indices != NULL && bvh->data != NULL;
+    if (ok)
+    {
+        bvh->count = count;
+        size_t grain = v3_pool_grain(count, 3 * corner_count * sizeof(float));
+        prim_job prims = {{corners[0], corners[corner_count > 1 ? 1 : 0], corners[corner_count > 2 ? 2 : 0]},
+                          corner_count, refs};
+        v3_parallel_for(count, grain, prim_task, &prims);
+
+        node_job job = {refs, bounds, bins, {0.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 0.0f}, V3_BVH_BINS};
+        build_nodes(bvh, &job, refs);
+
+        reorder_job reorder = {{prims.corners[0], prims.corners[1], prims.corners[2]},
+                               corner_count, refs, bvh->indices, bvh->data};
+        v3_parallel_for(count, grain, reorder_task, &reorder);
+
+        // give back the nodes the 2n - 1 bound did not need
+        v3_bvh_node *shrunk = (v3_bvh_node *)realloc(bvh->nodes, bvh->node_count * sizeof(v3_bvh_node));
+        if (shrunk != NULL)
+        {
+            bvh->nodes = shrunk;
+        }
+    }
+
+    v3_arena_restore(arena, mark);
+    if (!ok)
+    {
+        v3_bvh_free(bvh);
+        bvh->kind = kind;
+    }
+    return ok;
+}
+
+// build over points
+bool v3_bvh_build_points(v3_bvh *bvh, v3_soa points, size_t count)
+{
+    assert(count == 0 || (points.x != NULL && points.y != NULL && points.z != NULL));
+    V3_PROBE_BEGIN();
+
+    bool ok = build(bvh, V3_BVH_POINTS, &points, 1, count);
+
+    V3_PROBE_END(V3_PROBE_BVH_BUILD_POINTS, count, 0);
+    return ok;
+}
+
+// build over triangles
+bool v3_bvh_build_triangles(v3_bvh *bvh, v3_soa v0, v3_soa v1, v3_soa v2, size_t count)
+{
+    assert(count == 0 || (v0.x != NULL && v0.y != NULL && v0.z != NULL));
+    assert(count == 0 || (v1.x != NULL && v1.y != NULL && v1.z != NULL));
+    assert(count == 0 || (v2.x != NULL && v2.y != NULL && v2.z != NULL));
+    V3_PROBE_BEGIN();
+
+    v3_soa corners[3] = {v0, v1, v2};
+    bool ok = build(bvh, V3_BVH_TRIANGLES, corners, 3, count);
+
+    V3_PROBE_END(V3_PROBE_BVH_BUILD_TRIANGLES, count, 0);
+    return ok;
+}
+
+// release a tree
+void v3_bvh_free(v3_bvh *bvh)
+{
+    assert(bvh != NULL);
+
+    free(bvh->nodes);
+    free(bvh->data);
+    free(bvh->indices);
+    memset(bvh, 0, sizeof(*bvh));
+}
+
+// squared distance from a point to a node's box, 0 inside
+static inline float box_distance2(const v3_bvh_node *node, const float *q)
+{
+    float d2 = 0.0f;
+    for (int k = 0; k < 3; k++)
+    {
+        float d = max_f(max_f(node->min[k] - q[k], q[k] - node->max[k]), 0.0f);
+        d2 += d * d;
+    }
+    return d2;
+}
+
+// nearest point, visiting the nearer child first and skipping boxes further than the best so far
+bool v3_bvh_nearest(const v3_bvh *bvh, float *query, size_t *index, float *distance)
+{
+    assert(bvh != NULL && query != NULL && index != NULL && distance != NULL);
+    assert(bvh->kind == V3_BVH_POINTS);
+    V3_PROBE_BEGIN();
+
+    if (bvh->node_count == 0)
+    {
+        V3_PROBE_END(V3_PROBE_BVH_NEAREST, 1, 0);
+        return false;
+    }
+
+    float best2 = INFINITY;
+    size_t best = 0;
+    visit stack[STACK_SIZE];
+    int top = 0;
+    visit root = {0, box_distance2(&bvh->nodes[0], query)};
+    stack[top++] = root;
+
+    while (top > 0)
+    {
+        visit v = stack[--top];
+        if (v.distance >= best2)
+        {
+            continue;
+        }
+
+        const v3_bvh_node *node = &bvh->nodes[v.node];
+        if (node->count > 0)
+        {
+            for (uint32_t i = node->offset; i < node->offset + node->count; i++)
+            {
+                const float *p = bvh->data + 3 * (size_t)i;
+                float dx = p[0] - query[0];
+                float dy = p[1] - query[1];
+                float dz = p[2] - query[2];
+                float d2 = dx * dx + dy * dy + dz * dz;
+                if (d2 < best2)
+                {
+                    best2 = d2;
+                    best = i;
+                }
+            }
+            continue;
+        }
+
+        visit left = {v.node + 1, box_distance2(&bvh->nodes[v.node + 1], query)};
+        visit right = {node->offset, box_distance2(&bvh->nodes[node->offset], query)};
+        visit near = (left.distance <= right.distance) ? left : right;
+        visit far = (left.distance <= right.distance) ? right : left;
+        if (far.distance < best2)
+        {
+            stack[top++] = far;
+        }
+        if (near.distance < best2)
+        {
+            stack[top++] = near;
+        }
+    }
+
+    *index = bvh->indices[best];
+    *distance = sqrtf(best2);
+
+    V3_PROBE_END(V3_PROBE_BVH_NEAREST, 1, 0);
+    return true;
+}
+
+// distance along the ray to where it enters a node's box, within [0, t_max]
+// returns false if the ray misses the box in that interval
+static inline bool box_entry(const v3_bvh_node *node, const float *origin, const float *inv_dir,
+                             float t_max, float *t_entry)
+{
+    float t0 = 0.0f;
+    float t1 = t_max;
+    for (int k = 0; k < 3; k++)
+    {
+        float a = (node->min[k] - origin[k]) * inv_dir[k];
+        float b = (node->max[k] - origin[k]) * inv_dir[k];
+        t0 = max_f(t0, min_f(a, b));
+        t1 = min_f(t1, max_f(a, b));
+    }
+    *t_entry = t0;
+    return t0 <= t1;
+}
+
+// first hit, visiting the child the ray enters first and skipping boxes behind the best hit
+bool v3_bvh_intersect(const v3_bvh *bvh, float *origin, float *dir, size_t *index, float *t)
+{
+    assert(bvh != NULL && origin != NULL && dir != NULL && index != NULL && t != NULL);
+    assert(bvh->kind == V3_BVH_TRIANGLES);
+    V3_PROBE_BEGIN();
+
+    *t = V3_RAY_MISS;
+    if (bvh->node_count == 0)
+    {
+        V3_PROBE_END(V3_PROBE_BVH_INTERSECT, 1, 0);
+        return false;
+    }
+
+    // zero components get a huge finite inverse instead of infinity, so the slab
+    // test never computes 0 * inf for a ray lying in a box face
+    float inv_dir[3];
+    for (int k = 0; k < 3; k++)
+    {
+        inv_dir[k] = (fabsf(dir[k]) > 1e-30f) ? 1.0f / dir[k] : copysignf(1e30f, dir[k]);
+    }
+    bool hit = false;
+    size_t best = 0;
+    visit stack[STACK_SIZE];
+    int top = 0;
+
+    visit root = {0, 0.0f};
+    if (box_entry(&bvh->nodes[0], origin, inv_dir, *t, &root.distance))
+    {
+        stack[top++] = root;
+    }
+
+    while (top > 0)
+    {
+        visit v = stack[--top];
+        if (v.distance > *t)
+        {
+            continue;
+        }
+
+        const v3_bvh_node *node = &bvh->nodes[v.node];
+        if (node->count > 0)
+        {
+            for (uint32_t i = node->offset; i < node->offset + node->count; i++)
+            {
+                float *tri = bvh->data + 9 * (size_t)i;
+                float ti;
+                if (v3_ray_triangle(&ti, origin, dir, tri, tri + 3, tri + 6) && ti < *t)
+                {
+                    *t = ti;
+                    best = i;
+                    hit = true;
+                }
+            }
+            continue;
+        }
+
+        visit left = {v.node + 1, 0.0f};
+        visit right = {node->offset, 0.0f};
+        bool hit_left = box_entry(&bvh->nodes[left.node], origin, inv_dir, *t, &left.distance);
+        bool hit_right = box_entry(&bvh->nodes[right.node], origin, inv_dir, *t, &right.distance);
+        if (hit_left && hit_right)
+        {
+            bool left_first = left.distance <= right.distance;
+            stack[top++] = left_first ? right : left;
+            stack[top++] = left_first ? left : right;
+        }
+        else if (hit_left)
+        {
+            stack[top++] = left;
+        }
+        else if (hit_right)
+        {
+            stack[top++] = right;
+        }
+    }
+
+    if (hit)
+    {
+        *index = bvh->indices[best];
+    }
+
+    V3_PROBE_END(V3_PROBE_BVH_INTERSECT, 1, 0);
+    return hit;
+}
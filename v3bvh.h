@@ -0,0 +1,67 @@
+#ifndef V3BVH_H
+#define V3BVH_H
+
+// library inclusions
+#include "v3math.h"
+
+// bounding volume hierarchy over point or triangle sets
+//
+// the tree is built top-down with the surface area heuristic evaluated over
+// V3_BVH_BINS centroid bins per axis. binning a node's primitives runs on the
+// thread pool, which splits the large nodes near the root across threads; the
+// small nodes below run on the calling thread. nodes are stored in one array in
+// depth-first order: an interior node's left child is the next node and only
+// the right child's index is stored, so descending left walks forward through
+// memory. primitives are copied into leaf order for the same reason
+
+// centroid bins per axis for the split search
+#define V3_BVH_BINS 16
+
+// leaves hold at most this many primitives, fewer where the heuristic prefers a split
+#define V3_BVH_MAX_LEAF 8
+
+// 32 byte node, two per cache line
+typedef struct
+{
+    float min[3];
+    float max[3];
+    uint32_t offset;    // leaf: first primitive in leaf order, interior: right child
+    uint32_t count;     // primitives in a leaf, 0 for interior nodes
+} v3_bvh_node;
+
+typedef enum
+{
+    V3_BVH_POINTS,
+    V3_BVH_TRIANGLES
+} v3_bvh_kind;
+
+typedef struct
+{
+    v3_bvh_kind kind;
+    v3_bvh_node *nodes;     // node_count nodes, root first
+    size_t node_count;
+    float *data;            // primitives in leaf order, 3 floats per point or 9 per triangle
+    uint32_t *indices;      // input index of each primitive in leaf order
+    size_t count;
+} v3_bvh;
+
+// build over count points, overwriting bvh (free a previous tree first)
+// returns false if memory runs out, leaving an empty tree
+bool v3_bvh_build_points(v3_bvh *bvh, v3_soa points, size_t count);
+
+// build over count triangles with corners v0[i], v1[i], v2[i], overwriting bvh
+// returns false if memory runs out, leaving an empty tree
+bool v3_bvh_build_triangles(v3_bvh *bvh, v3_soa v0, v3_soa v1, v3_soa v2, size_t count);
+
+// release a tree, leaving it empty
+void v3_bvh_free(v3_bvh *bvh);
+
+// nearest point of a point tree to query
+// returns: true with the input index and distance, or false for an empty tree
+bool v3_bvh_nearest(const v3_bvh *bvh, float *query, size_t *index, float *distance);
+
+// first triangle of a triangle tree hit by a ray, as v3_ray_triangle
+// returns: true with the input index and hit distance, or false and V3_RAY_MISS in t
+bool v3_bvh_intersect(const v3_bvh *bvh, float *origin, float *dir, size_t *index, float *t);
+
+#endif
@@ -0,0 +1,172 @@
+// library inclusions
+#include "v3camera.h"
+#include "v3pool.h"
+#include "v3simd.h"
+#include "v3instrument.h"
+
+static_assert(offsetof(v3_camera, down) == offsetof(v3_camera, corner) + 6 * sizeof(float),
+              "the kernels read corner, right and down as 9 packed floats");
+
+// pixels in a tile slot, chunks of the pool cover whole slots
+#define TILE_PIXELS (V3_CAMERA_TILE * V3_CAMERA_TILE)
+
+// state shared by the tasks of one call
+typedef struct
+{
+    v3_soa dir;
+    uint32_t *pixel;
+    const v3_camera *camera;
+    int samples;
+    int jitter;
+    uint32_t seed;
+    size_t tiles_x;
+    const v3_kernels *kernels;
+} camera_job;
+
+// camera at eye looking at target
+bool v3_camera_look_at(v3_camera *camera, const float *eye, const float *target, const float *up,
+                       float vertical_fov, size_t width, size_t height)
+{
+    assert(camera != NULL && eye != NULL && target != NULL && up != NULL);
+
+    // written so that a nan field of view fails too
+    if (!(vertical_fov > 0.0f && vertical_fov < (float)M_PI) || width == 0 || height == 0 ||
+        width > UINT32_MAX / height)
+    {
+        errno = EINVAL;
+        return false;
+    }
+
+    float e[3] = {eye[0], eye[1], eye[2]};
+    float t[3] = {target[0], target[1], target[2]};
+    float w[3] = {up[0], up[1], up[2]};
+    float f[3], r[3], u[3];
+    v3_from_points(f, e, t);
+    if (v3_length(f) < V3_EPSILON)
+    {
+        errno = EINVAL;
+        return false;
+    }
+    v3_normalize(f, f);
+    v3_cross_product(r, f, w);
+    if (v3_length(r) < V3_EPSILON)
+    {
+        errno = EINVAL;
+        return false;
+    }
+    v3_normalize(r, r);
+    v3_cross_product(u, r, f);
+
+    // the image plane is one unit along f, pixels are size across
+    float half = tanf(0.5f * vertical_fov);
+    float size = 2.0f * half / (float)height;
+    float left = size * 0.5f * (1.0f - (float)width);
+    float top = half - 0.5f * size;
+    for (int k = 0; k < 3; k++)
+    {
+        camera->origin[k] = e[k];
+        camera->corner[k] = f[k] + left * r[k] + top * u[k];
+        camera->right[k] = size * r[k];
+        camera->down[k] = -size * u[k];
+    }
+    camera->width = width;
+    camera->height = height;
+    return true;
+}
+
+// rays for the whole image
+size_t v3_camera_ray_count(const v3_camera *camera, int samples)
+{
+    assert(camera != NULL && samples >= 1);
+
+    return camera->width * camera->height * (size_t)samples;
+}
+
+// index of the first ray of tile (tile_x, tile_y): the full bands above it and
+// the tiles to its left in its band
+static size_t tile_offset(const v3_camera *camera, size_t tile_x, size_t tile_y, int samples)
+{
+    size_t y0 = tile_y * V3_CAMERA_TILE;
+    size_t band = (camera->height - y0 < V3_CAMERA_TILE) ? camera->height - y0 : V3_CAMERA_TILE;
+    return (y0 * camera->width + tile_x * V3_CAMERA_TILE * band) * (size_t)samples;
+}
+
+// write the rays of one tile, returns how many
+static size_t write_tile(v3_soa dir, uint32_t *pixel, const v3_camera *camera, const v3_kernels *kernels,
+                         size_t tile_x, size_t tile_y, int samples, int jitter, uint32_t seed)
+{
+    size_t x0 = tile_x * V3_CAMERA_TILE, y0 = tile_y * V3_CAMERA_TILE;
+    size_t width = (camera->width - x0 < V3_CAMERA_TILE) ? camera->width - x0 : V3_CAMERA_TILE;
+    size_t height = (camera->height - y0 < V3_CAMERA_TILE) ? camera->height - y0 : V3_CAMERA_TILE;
+    kernels->camera(dir, camera->corner, x0, y0, width, height, camera->width, samples, seed, jitter);
+
+    if (pixel != NULL)
+    {
+        size_t i = 0;
+        for (size_t r = 0; r < height; r++)
+        {
+            for (int s = 0; s < samples; s++)
+            {
+                for (size_t c = 0; c < width; c++)
+                {
+                    pixel[i++] = (uint32_t)((y0 + r) * camera->width + x0 + c);
+                }
+            }
+        }
+    }
+    return width * height * (size_t)samples;
+}
+
+// write the rays of tile (tile_x, tile_y)
+size_t v3_camera_tile(v3_soa dir, uint32_t *pixel, const v3_camera *camera, size_t tile_x, size_t tile_y,
+                      int samples, bool jitter, uint32_t seed)
+{
+    assert(dir.x != NULL && dir.y != NULL && dir.z != NULL);
+    assert(camera != NULL && samples >= 1);
+    assert(tile_x * V3_CAMERA_TILE < camera->width && tile_y * V3_CAMERA_TILE < camera->height);
+    V3_PROBE_BEGIN();
+
+    size_t rays = write_tile(dir, pixel, camera, v3_get_kernels(), tile_x, tile_y, samples, jitter, seed);
+
+    V3_PROBE_END(V3_PROBE_CAMERA_TILE, rays, 0);
+    return rays;
+}
+
+// the tiles of the slots [begin, end), row-major over the image
+static void camera_task(void *context, size_t begin, size_t end)
+{
+    camera_job *job = (camera_job *)context;
+    for (size_t t = begin / TILE_PIXELS; t < end / TILE_PIXELS; t++)
+    {
+        size_t tile_x = t % job->tiles_x, tile_y = t / job->tiles_x;
+        size_t i = tile_offset(job->camera, tile_x, tile_y, job->samples);
+        v3_soa dir = {job->dir.x + i, job->dir.y + i, job->dir.z + i};
+        write_tile(dir, job->pixel != NULL ? job->pixel + i : NULL, job->camera, job->kernels, tile_x, tile_y,
+                   job->samples, job->jitter, job->seed);
+    }
+}
+
+// write the rays of every tile in order
+void v3_camera_rays(v3_soa dir, uint32_t *pixel, const v3_camera *camera, int samples, bool jitter, uint32_t seed)
+{
+    assert(dir.x != NULL && dir.y != NULL && dir.z != NULL);
+    assert(camera != NULL && samples >= 1);
+    V3_PROBE_BEGIN();
+
+    size_t tiles_x = (camera->width + V3_CAMERA_TILE - 1) / V3_CAMERA_TILE;
+    size_t tiles_y = (camera->height + V3_CAMERA_TILE - 1) / V3_CAMERA_TILE;
+    camera_job job = {dir, pixel, camera, samples, jitter ? 1 : 0, seed, tiles_x, v3_get_kernels()};
+
+    // the pool splits tile slots of TILE_PIXELS, a multiple of V3_POOL_ALIGN, so
+    // rounding the grain up to whole slots keeps every chunk on tile boundaries
+    size_t slots = tiles_x * tiles_y * TILE_PIXELS;
+    size_t grain = slots;
+    if (v3_camera_ray_count(camera, samples) >= V3_POOL_MIN_PARALLEL)
+    {
+        grain = v3_pool_grain(slots, 3 * sizeof(float) * (size_t)samples);
+        grain = (grain + TILE_PIXELS - 1) / TILE_PIXELS * TILE_PIXELS;
+    }
+    v3_parallel_for(slots, grain, camera_task, &job);
+
+    V3_PROBE_END(V3_PROBE_CAMERA_RAYS, v3_camera_ray_count(camera, samples), 0);
+}
@@ -0,0 +1,64 @@
+#ifndef V3CAMERA_H
+#define V3CAMERA_H
+
+// library inclusions
+#include "v3math.h"
+
+// primary rays of a pinhole camera
+//
+// the camera keeps the direction through the center of the top left pixel and
+// the direction steps of one pixel right and down, so the ray through pixel
+// (x, y) is corner + x right + y down before normalization. the camera kernel
+// computes the row term once per row and steps the column as an exact float
+// counter, so nothing drifts along a row, and normalizes with the refined
+// reciprocal square root of the fast normalize. the last columns of a row go
+// through the same vector code as the others, so a pixel gets the same ray
+// wherever its column falls; the sets without fused multiply-adds give the
+// scalar rays exactly, the others agree to a few units in the last place
+//
+// rays come out tile by tile, V3_CAMERA_TILE pixels square, the tiles left to
+// right and the bands of tiles top to bottom; tiles at the right and bottom
+// edges are cut to the image. within a tile the rays go row by row, and within
+// a row sample by sample, so every V3_RAY_PACKET consecutive rays of a full
+// tile are neighbouring pixels of one row for one sample
+//
+// jittered rays are offset uniformly within their pixel by a hash of the seed,
+// the pixel and the sample, so they do not depend on the tiling or the thread
+// count; without jitter every sample goes through the pixel center. all rays
+// start at the camera origin
+
+// pixels along each side of a tile
+#define V3_CAMERA_TILE 16
+
+typedef struct
+{
+    float origin[3];
+    float corner[3];    // direction through the center of pixel (0, 0)
+    float right[3];     // direction step of one pixel to the right
+    float down[3];      // direction step of one pixel down
+    size_t width;
+    size_t height;
+} v3_camera;
+
+// camera at eye looking at target, with up towards the top of the image, a
+// vertical field of view in radians and square pixels
+// returns false with errno = EINVAL if eye and target coincide, up is parallel
+// to the view direction, the field of view is outside (0, pi), the image is
+// empty or it has 2^32 pixels or more
+bool v3_camera_look_at(v3_camera *camera, const float *eye, const float *target, const float *up,
+                       float vertical_fov, size_t width, size_t height);
+
+// rays for the whole image with samples per pixel: width * height * samples
+size_t v3_camera_ray_count(const v3_camera *camera, int samples);
+
+// write the normalized directions of the rays of tile (tile_x, tile_y), and the
+// index y * width + x of the pixel of each ray to pixel unless it is NULL
+// returns the number of rays written, the tile's pixels times samples
+size_t v3_camera_tile(v3_soa dir, uint32_t *pixel, const v3_camera *camera, size_t tile_x, size_t tile_y,
+                      int samples, bool jitter, uint32_t seed);
+
+// write the rays of every tile in order, as v3_camera_tile would one after the
+// other, on the thread pool; dir and pixel take v3_camera_ray_count rays
+void v3_camera_rays(v3_soa dir, uint32_t *pixel, const v3_camera *camera, int samples, bool jitter, uint32_t seed);
+
+#endif
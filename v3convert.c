@@ -0,0 +1,40 @@
+// library inclusions
+#include "v3file.h"
+
+// convert a text file of x y z lines into a v3 vector file
+int main(int argc, char **argv)
+{
+    v3_file_layout layout = V3_FILE_SOA;
+    int arg = 1;
+    if (arg < argc && strcmp(argv[arg], "--aos") == 0)
+    {
+        layout = V3_FILE_AOS;
+        arg++;
+    }
+    else if (arg < argc && strcmp(argv[arg], "--soa") == 0)
+    {
+        arg++;
+    }
+
+    if (argc - arg != 2)
+    {
+        fprintf(stderr, "Usage: %s [--aos | --soa] INPUT.txt OUTPUT\n", argv[0]);
+        return 1;
+    }
+
+    if (!v3_file_convert_text(argv[arg], argv[arg + 1], layout))
+    {
+        fprintf(stderr, "Error: Cannot convert %s: %s\n", argv[arg], strerror(errno));
+        return 1;
+    }
+
+    v3_file file;
+    if (!v3_file_open(&file, argv[arg + 1], false))
+    {
+        fprintf(stderr, "Error: Cannot open %s: %s\n", argv[arg + 1], strerror(errno));
+        return 1;
+    }
+    printf("%s: %zu vectors, %s\n", argv[arg + 1], v3_file_count(&file), layout == V3_FILE_SOA ? "soa" : "aos");
+    v3_file_close(&file);
+    return 0;
+}
@@ -0,0 +1,284 @@
+// library inclusions
+#include "v3double.h"
+#include "v3vec.h"
+#include "v3instrument.h"
+
+// the scalar functions load into Vec3d and store back, so dst may alias any input
+
+// form a vector from point a to point b
+// dst = b - a
+void v3d_from_points(double *dst, double *a, double *b)
+{
+    assert(dst != NULL && a != NULL && b != NULL);
+
+    from_points(Vec3d::load(a), Vec3d::load(b)).store(dst);
+}
+
+// add two vectors
+// dst = a + b
+void v3d_add(double *dst, double *a, double *b)
+{
+    assert(dst != NULL && a != NULL && b != NULL);
+
+    add(Vec3d::load(a), Vec3d::load(b)).store(dst);
+}
+
+// subtract vector b from vector a
+// dst = a - b
+void v3d_subtract(double *dst, double *a, double *b)
+{
+    assert(dst != NULL && a != NULL && b != NULL);
+
+    subtract(Vec3d::load(a), Vec3d::load(b)).store(dst);
+}
+
+// calculate dot product of two vectors
+double v3d_dot_product(double *a, double *b)
+{
+    assert(a != NULL && b != NULL);
+
+    return dot_product(Vec3d::load(a), Vec3d::load(b));
+}
+
+// calculate cross product of two vectors
+// dst = a x b
+void v3d_cross_product(double *dst, double *a, double *b)
+{
+    assert(dst != NULL && a != NULL && b != NULL);
+
+    cross_product(Vec3d::load(a), Vec3d::load(b)).store(dst);
+}
+
+// scale a vector by scalar s in-place
+// dst = dst * s
+void v3d_scale(double *dst, double s)
+{
+    assert(dst != NULL);
+
+    scale(Vec3d::load(dst), s).store(dst);
+}
+
+// calculate angle between two vectors in radians
+// returns: angle in range [0, pi]
+double v3d_angle(double *a, double *b)
+{
+    assert(a != NULL && b != NULL);
+
+    Vec3d va = Vec3d::load(a);
+    Vec3d vb = Vec3d::load(b);
+    if (length(va) < V3D_EPSILON || length(vb) < V3D_EPSILON)
+    {
+        v3_report_error(V3_SOURCE_ANGLE, "Cannot compute angle with zero length vector", 1);
+        return 0.0;
+    }
+
+    return angle(va, vb);
+}
+
+// calculate angle between two vectors without inverse cosine
+// returns: cosine of the angle
+double v3d_angle_quick(double *a, double *b)
+{
+    assert(a != NULL && b != NULL);
+
+    Vec3d va = Vec3d::load(a);
+    Vec3d vb = Vec3d::load(b);
+    if (length(va) < V3D_EPSILON || length(vb) < V3D_EPSILON)
+    {
+        v3_report_error(V3_SOURCE_ANGLE_QUICK, "Cannot compute angle with zero length vector", 1);
+        return 1.0;
+    }
+
+    return angle_quick(va, vb);
+}
+
+// reflect vector v across normal n
+// dst = v - 2(v * n)n, assumes n is normalized
+void v3d_reflect(double *dst, double *v, double *n)
+{
+    assert(dst != NULL && v != NULL && n != NULL);
+
+    reflect(Vec3d::load(v), Vec3d::load(n)).store(dst);
+}
+
+// calculate length/magnitude of a vector
+double v3d_length(double *a)
+{
+    assert(a != NULL);
+
+    return length(Vec3d::load(a));
+}
+
+// normalize a vector to make it a unit length
+// dst = a / ||a||
+void v3d_normalize(double *dst, double *a)
+{
+    assert(dst != NULL && a != NULL);
+
+    Vec3d va = Vec3d::load(a);
+    if (length(va) < V3D_EPSILON)
+    {
+        v3_report_error(V3_SOURCE_NORMALIZE, "Cannot normalize zero length vector", 1);
+    }
+
+    normalize(va).store(dst);
+}
+
+// test helper - check if two vectors are equal within tolerance
+bool v3d_equals(double *a, double *b, double tolerance)
+{
+    assert(a != NULL && b != NULL);
+
+    return equals(Vec3d::load(a), Vec3d::load(b), tolerance);
+}
+
+// calculate dot products of vector pairs
+// dst[i] = a[i] * b[i]
+void v3d_dot_product_batch(double *dst, v3d_soa a, v3d_soa b, size_t count)
+{
+    assert(dst != NULL);
+    assert(a.x != NULL && a.y != NULL && a.z != NULL);
+    assert(b.x != NULL && b.y != NULL && b.z != NULL);
+    V3_PROBE_BEGIN();
+
+    for (size_t i = 0; i < count; i++)
+    {
+        dst[i] = a.x[i] * b.x[i] + a.y[i] * b.y[i] + a.z[i] * b.z[i];
+    }
+
+    V3_PROBE_END(V3_PROBE_DOUBLE_DOT_PRODUCT_BATCH, count, 0);
+}
+
+// calculate lengths of vectors
+// dst[i] = ||a[i]||
+void v3d_length_batch(double *dst, v3d_soa a, size_t count)
+{
+    assert(dst != NULL);
+    assert(a.x != NULL && a.y != NULL && a.z != NULL);
+    V3_PROBE_BEGIN();
+
+    for (size_t i = 0; i < count; i++)
+    {
+        dst[i] = sqrt(a.x[i] * a.x[i] + a.y[i] * a.y[i] + a.z[i] * a.z[i]);
+    }
+
+    V3_PROBE_END(V3_PROBE_DOUBLE_LENGTH_BATCH, count, 0);
+}
+
+// normalize vectors to unit length
+// dst[i] = a[i] / ||a[i]||, zero length vectors become zero
+void v3d_normalize_batch(v3d_soa dst, v3d_soa a, size_t count)
+{
+    assert(dst.x != NULL && dst.y != NULL && dst.z != NULL);
+    assert(a.x != NULL && a.y != NULL && a.z != NULL);
+    V3_PROBE_BEGIN();
+
+    uint64_t degenerate = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        Vec3d v(a.x[i], a.y[i], a.z[i]);
+        degenerate += length(v) < V3D_EPSILON;
+
+        Vec3d r = normalize(v);
+        dst.x[i] = r.x;
+        dst.y[i] = r.y;
+        dst.z[i] = r.z;
+    }
+
+    // report once per batch rather than once per element
+    if (degenerate > 0)
+    {
+        v3_report_error(V3_SOURCE_NORMALIZE_BATCH, "Cannot normalize zero length vector", degenerate);
+    }
+
+    V3_PROBE_END(V3_PROBE_DOUBLE_NORMALIZE_BATCH, count, degenerate);
+}
+
+// calculate cross products of vector pairs
+// dst[i] = a[i] x b[i]
+void v3d_cross_product_batch(v3d_soa dst, v3d_soa a, v3d_soa b, size_t count)
+{
+    assert(dst.x != NULL && dst.y != NULL && dst.z != NULL);
+    assert(a.x != NULL && a.y != NULL && a.z != NULL);
+    assert(b.x != NULL && b.y != NULL && b.z != NULL);
+    V3_PROBE_BEGIN();
+
+    for (size_t i = 0; i < count; i++)
+    {
+        Vec3d r = cross_product(Vec3d(a.x[i], a.y[i], a.z[i]), Vec3d(b.x[i], b.y[i], b.z[i]));
+        dst.x[i] = r.x;
+        dst.y[i] = r.y;
+        dst.z[i] = r.z;
+    }
+
+    V3_PROBE_END(V3_PROBE_DOUBLE_CROSS_PRODUCT_BATCH, count, 0);
+}
+
+// reflect vectors across normals
+// dst[i] = v[i] - 2(v[i] * n[i])n[i], assumes every n[i] is normalized
+void v3d_reflect_batch(v3d_soa dst, v3d_soa v, v3d_soa n, size_t count)
+{
+    assert(dst.x != NULL && dst.y != NULL && dst.z != NULL);
+    assert(v.x != NULL && v.y != NULL && v.z != NULL);
+    assert(n.x != NULL && n.y != NULL && n.z != NULL);
+    V3_PROBE_BEGIN();
+
+    for (size_t i = 0; i < count; i++)
+    {
+        Vec3d r = reflect(Vec3d(v.x[i], v.y[i], v.z[i]), Vec3d(n.x[i], n.y[i], n.z[i]));
+        dst.x[i] = r.x;
+        dst.y[i] = r.y;
+        dst.z[i] = r.z;
+    }
+
+    V3_PROBE_END(V3_PROBE_DOUBLE_REFLECT_BATCH, count, 0);
+}
+
+// calculate angles between vector pairs in radians
+// dst[i] = acos(a[i] * b[i] / (||a[i]|| ||b[i]||)), 0 for zero length pairs
+void v3d_angle_batch(double *dst, v3d_soa a, v3d_soa b, size_t count)
+{
+    assert(dst != NULL);
+    assert(a.x != NULL && a.y != NULL && a.z != NULL);
+    assert(b.x != NULL && b.y != NULL && b.z != NULL);
+    V3_PROBE_BEGIN();
+
+    uint64_t degenerate = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        Vec3d va(a.x[i], a.y[i], a.z[i]);
+        Vec3d vb(b.x[i], b.y[i], b.z[i]);
+        degenerate += length(va) < V3D_EPSILON || length(vb) < V3D_EPSILON;
+        dst[i] = angle(va, vb);
+    }
+
+    // report once per batch rather than once per element
+    if (degenerate > 0)
+    {
+        v3_report_error(V3_SOURCE_ANGLE_BATCH, "Cannot compute angle with zero length vector", degenerate);
+    }
+
+    V3_PROBE_END(V3_PROBE_DOUBLE_ANGLE_BATCH, count, degenerate);
+}
+
+// widen floats to doubles
+void v3_float_to_double_batch(double *dst, const float *src, size_t count)
+{
+    assert(dst != NULL && src != NULL);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        dst[i] = (double)src[i];
+    }
+}
+
+// narrow doubles to floats
+void v3_double_to_float_batch(float *dst, const double *src, size_t count)
+{
+    assert(dst != NULL && src != NULL);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        dst[i] = (float)src[i];
+    }
+}
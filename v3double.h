@@ -0,0 +1,79 @@
+#ifndef V3DOUBLE_H
+#define V3DOUBLE_H
+
+// library inclusions
+#include "v3math.h"
+
+// double precision variants of the v3math api, for accumulation heavy code
+// every function matches its float counterpart; zero length vectors use V3D_EPSILON
+
+// structure-of-arrays view over a batch of double vectors
+typedef struct
+{
+    double *x;
+    double *y;
+    double *z;
+} v3d_soa;
+
+// form vector from point a to point b
+void v3d_from_points(double *dst, double *a, double *b);
+
+// add two vectors
+void v3d_add(double *dst, double *a, double *b);
+
+// subtract vector b from vector a
+void v3d_subtract(double *dst, double *a, double *b);
+
+// calculate dot product of two vectors
+double v3d_dot_product(double *a, double *b);
+
+// calculate cross product of two vectors
+void v3d_cross_product(double *dst, double *a, double *b);
+
+// scale a vector by scalar s
+void v3d_scale(double *dst, double s);
+
+// calculate angle between two vectors in radians
+double v3d_angle(double *a, double *b);
+
+// calculate angle between two vectors without inverse cosine
+double v3d_angle_quick(double *a, double *b);
+
+// reflect vector v across normal n
+void v3d_reflect(double *dst, double *v, double *n);
+
+// calculate length/magnitude of a vector
+double v3d_length(double *a);
+
+// normalize a vector to make it unit length
+void v3d_normalize(double *dst, double *a);
+
+// test helper - check if two vectors are equal within tolerance (V3D_TOLERANCE is typical)
+bool v3d_equals(double *a, double *b, double tolerance);
+
+// calculate dot products a[i] * b[i] into dst[i]
+void v3d_dot_product_batch(double *dst, v3d_soa a, v3d_soa b, size_t count);
+
+// calculate lengths of vectors into dst[i]
+void v3d_length_batch(double *dst, v3d_soa a, size_t count);
+
+// normalize vectors to unit length, zero length vectors become zero
+void v3d_normalize_batch(v3d_soa dst, v3d_soa a, size_t count);
+
+// calculate cross products a[i] x b[i] into dst[i]
+void v3d_cross_product_batch(v3d_soa dst, v3d_soa a, v3d_soa b, size_t count);
+
+// reflect vectors v[i] across normals n[i] into dst[i]
+void v3d_reflect_batch(v3d_soa dst, v3d_soa v, v3d_soa n, size_t count);
+
+// calculate angles between a[i] and b[i] in radians into dst[i], with acos in
+// double; zero length pairs give 0 and are reported once for the batch
+void v3d_angle_batch(double *dst, v3d_soa a, v3d_soa b, size_t count);
+
+// widen count floats to doubles
+void v3_float_to_double_batch(double *dst, const float *src, size_t count);
+
+// narrow count doubles to floats, rounding to nearest
+void v3_double_to_float_batch(float *dst, const double *src, size_t count);
+
+#endif
@@ -0,0 +1,282 @@
+#ifndef V3EXPR_H
+#define V3EXPR_H
+
+// library inclusions
+#include "v3vec.h"
+
+// expression templates that fuse chains of vector operations
+//
+// building an expression only records the operation tree; nothing is computed
+// until it is evaluated. evaluating element i walks the whole tree in registers,
+// so a chain such as from_points -> normalize -> reflect -> dot over a batch
+// is one loop with one load per input and one store per output, instead of a
+// full pass over memory per step
+//
+//     v3expr::assign(out, v3expr::dot(v3expr::reflect(v3expr::normalize(
+//         v3expr::from_points(v3expr::soa(p), v3expr::soa(q))), v3expr::soa(n)),
+//         v3expr::vec(light)), count);
+namespace v3expr
+{
+
+// whether two types are the same, for the checks of assign
+template <typename A, typename B>
+struct same_type
+{
+    static const bool value = false;
+};
+
+template <typename A>
+struct same_type<A, A>
+{
+    static const bool value = true;
+};
+
+// terminal holding one vector, the same for every element
+template <typename T>
+struct Constant
+{
+    typedef T value_type;
+    Vec3<T> v;
+
+    Vec3<T> eval(size_t) const { return v; }
+};
+
+// terminal reading element i of a structure-of-arrays batch
+template <typename T>
+struct Batch
+{
+    typedef T value_type;
+    const T *x;
+    const T *y;
+    const T *z;
+
+    Vec3<T> eval(size_t i) const { return Vec3<T>(x[i], y[i], z[i]); }
+};
+
+// vector valued operation nodes
+
+template <typename L, typename R>
+struct FromPoints
+{
+    typedef typename L::value_type value_type;
+    L l;
+    R r;
+
+    Vec3<value_type> eval(size_t i) const { return ::from_points(l.eval(i), r.eval(i)); }
+};
+
+template <typename L, typename R>
+struct Add
+{
+    typedef typename L::value_type value_type;
+    L l;
+    R r;
+
+    Vec3<value_type> eval(size_t i) const { return ::add(l.eval(i), r.eval(i)); }
+};
+
+template <typename L, typename R>
+struct Subtract
+{
+    typedef typename L::value_type value_type;
+    L l;
+    R r;
+
+    Vec3<value_type> eval(size_t i) const { return ::subtract(l.eval(i), r.eval(i)); }
+};
+
+template <typename L, typename R>
+struct Cross
+{
+    typedef typename L::value_type value_type;
+    L l;
+    R r;
+
+    Vec3<value_type> eval(size_t i) const { return ::cross_product(l.eval(i), r.eval(i)); }
+};
+
+template <typename E>
+struct Scale
+{
+    typedef typename E::value_type value_type;
+    E e;
+    value_type s;
+
+    Vec3<value_type> eval(size_t i) const { return ::scale(e.eval(i), s); }
+};
+
+template <typename E>
+struct Normalize
+{
+    typedef typename E::value_type value_type;
+    E e;
+
+    Vec3<value_type> eval(size_t i) const { return ::normalize(e.eval(i)); }
+};
+
+template <typename V, typename N>
+struct Reflect
+{
+    typedef typename V::value_type value_type;
+    V v;
+    N n;
+
+    Vec3<value_type> eval(size_t i) const { return ::reflect(v.eval(i), n.eval(i)); }
+};
+
+// scalar valued operation nodes, the usual end of a chain
+
+template <typename L, typename R>
+struct Dot
+{
+    typedef typename L::value_type value_type;
+    L l;
+    R r;
+
+    value_type eval(size_t i) const { return ::dot_product(l.eval(i), r.eval(i)); }
+};
+
+template <typename E>
+struct Length
+{
+    typedef typename E::value_type value_type;
+    E e;
+
+    value_type eval(size_t i) const { return ::length(e.eval(i)); }
+};
+
+// builders for terminals
+
+template <typename T>
+inline Constant<T> vec(const Vec3<T> &v)
+{
+    Constant<T> c = {v};
+    return c;
+}
+
+inline Batch<float> soa(v3_soa v)
+{
+    Batch<float> b = {v.x, v.y, v.z};
+    return b;
+}
+
+template <typename T>
+inline Batch<T> soa(const T *x, const T *y, const T *z)
+{
+    Batch<T> b = {x, y, z};
+    return b;
+}
+
+// builders for operations, named after the v3math functions they fuse
+
+template <typename L, typename R>
+inline FromPoints<L, R> from_points(const L &a, const R &b)
+{
+    FromPoints<L, R> e = {a, b};
+    return e;
+}
+
+template <typename L, typename R>
+inline Add<L, R> add(const L &a, const R &b)
+{
+    Add<L, R> e = {a, b};
+    return e;
+}
+
+template <typename L, typename R>
+inline Subtract<L, R> subtract(const L &a, const R &b)
+{
+    Subtract<L, R> e = {a, b};
+    return e;
+}
+
+template <typename L, typename R>
+inline Cross<L, R> cross_product(const L &a, const R &b)
+{
+    Cross<L, R> e = {a, b};
+    return e;
+}
+
+template <typename E>
+inline Scale<E> scale(const E &a, typename E::value_type s)
+{
+    Scale<E> e = {a, s};
+    return e;
+}
+
+template <typename E>
+inline Normalize<E> normalize(const E &a)
+{
+    Normalize<E> e = {a};
+    return e;
+}
+
+template <typename V, typename N>
+inline Reflect<V, N> reflect(const V &v, const N &n)
+{
+    Reflect<V, N> e = {v, n};
+    return e;
+}
+
+template <typename L, typename R>
+inline Dot<L, R> dot(const L &a, const R &b)
+{
+    Dot<L, R> e = {a, b};
+    return e;
+}
+
+template <typename E>
+inline Length<E> length(const E &a)
+{
+    Length<E> e = {a};
+    return e;
+}
+
+// evaluation
+
+// evaluate an expression over constant terminals to a single result
+template <typename E>
+inline auto evaluate(const E &e) -> decltype(e.eval(0))
+{
+    return e.eval(0);
+}
+
+// evaluate a vector expression for every element into the arrays x, y, z of its
+// element type in one pass; the outputs may be input batches (in-place) since
+// element i is read before it is written
+template <typename E>
+inline void assign(typename E::value_type *x, typename E::value_type *y, typename E::value_type *z, const E &e,
+                   size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        Vec3<typename E::value_type> r = e.eval(i);
+        x[i] = r.x;
+        y[i] = r.y;
+        z[i] = r.z;
+    }
+}
+
+// the same into a float batch, for float expressions only; double expressions
+// take the typed form above rather than being narrowed here
+template <typename E>
+inline void assign(v3_soa dst, const E &e, size_t count)
+{
+    static_assert(same_type<typename E::value_type, float>::value,
+                  "assign to v3_soa needs a float expression, use assign(x, y, z, e, count)");
+    assign(dst.x, dst.y, dst.z, e, count);
+}
+
+// evaluate a scalar expression for every element into dst in one pass
+template <typename E>
+inline void assign(typename E::value_type *dst, const E &e, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        dst[i] = e.eval(i);
+    }
+}
+
+}
+
+#endif
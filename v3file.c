@@ -0,0 +1,435 @@
+// library inclusions
+#include "v3file.h"
+#include "v3arena.h"
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// longest text line the converter accepts
+#define LINE_SIZE 512
+
+static_assert(sizeof(v3_file_header) == 64, "v3_file_header must stay 64 bytes");
+
+static size_t align_up(size_t n, size_t alignment)
+{
+    return (n + alignment - 1) / alignment * alignment;
+}
+
+// header for count vectors in a layout
+static void plan_header(v3_file_header *header, v3_file_layout layout, size_t count)
+{
+    memset(header, 0, sizeof(*header));
+    memcpy(header->magic, V3_FILE_MAGIC, sizeof(header->magic));
+    header->version = V3_FILE_VERSION;
+    header->layout = (uint32_t)layout;
+    header->count = count;
+    header->data_offset = V3_FILE_ALIGN;
+    header->array_stride = (layout == V3_FILE_SOA) ? align_up(count * sizeof(float), V3_FILE_ALIGN) : 0;
+}
+
+// bytes a file with this header needs
+static size_t file_size(const v3_file_header *header)
+{
+    if (header->layout == V3_FILE_SOA)
+    {
+        return header->data_offset + 3 * header->array_stride;
+    }
+    return header->data_offset + header->count * 3 * sizeof(float);
+}
+
+// check a header read from disk against the size of its file
+static bool valid_header(const v3_file_header *header, size_t size)
+{
+    if (memcmp(header->magic, V3_FILE_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != V3_FILE_VERSION ||
+        (header->layout != V3_FILE_AOS && header->layout != V3_FILE_SOA) ||
+        header->count > SIZE_MAX / (4 * 3 * sizeof(float)) ||
+        header->data_offset < sizeof(v3_file_header) || header->data_offset % V3_FILE_ALIGN != 0 ||
+        header->data_offset > size)
+    {
+        return false;
+    }
+
+    if (header->layout == V3_FILE_SOA &&
+        (header->array_stride < header->count * sizeof(float) || header->array_stride % V3_FILE_ALIGN != 0 ||
+         header->array_stride > size))
+    {
+        return false;
+    }
+    return file_size(header) <= size;
+}
+
+// close a half-opened file without losing the errno of the failure
+static bool fail(v3_file *file)
+{
+    int saved = errno;
+    if (file->map != NULL)
+    {
+        munmap(file->map, file->map_size);
+    }
+    if (file->fd >= 0)
+    {
+        close(file->fd);
+    }
+    memset(file, 0, sizeof(*file));
+    file->fd = -1;
+    errno = saved;
+    return false;
+}
+
+// map the whole file, read front to back
+static bool map_file(v3_file *file, size_t size)
+{
+    int protection = PROT_READ | (file->writable ? PROT_WRITE : 0);
+    void *map = mmap(NULL, size, protection, MAP_SHARED, file->fd, 0);
+    if (map == MAP_FAILED)
+    {
+        return false;
+    }
+
+    file->map = (unsigned char *)map;
+    file->map_size = size;
+    madvise(map, size, MADV_SEQUENTIAL);
+    return true;
+}
+
+// create a file for count vectors
+bool v3_file_create(v3_file *file, const char *path, v3_file_layout layout, size_t count)
+{
+    assert(file != NULL && path != NULL);
+    assert(layout == V3_FILE_AOS || layout == V3_FILE_SOA);
+
+    memset(file, 0, sizeof(*file));
+    file->writable = true;
+    plan_header(&file->header, layout, count);
+
+    // ftruncate leaves the data as a hole that reads back as zeros
+    file->fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (file->fd < 0 || ftruncate(file->fd, (off_t)file_size(&file->header)) != 0 ||
+        !map_file(file, file_size(&file->header)))
+    {
+        return fail(file);
+    }
+
+    memcpy(file->map, &file->header, sizeof(file->header));
+    return true;
+}
+
+// open an existing file
+bool v3_file_open(v3_file *file, const char *path, bool writable)
+{
+    assert(file != NULL && path != NULL);
+
+    memset(file, 0, sizeof(*file));
+    file->writable = writable;
+    file->fd = open(path, writable ? O_RDWR : O_RDONLY);
+    if (file->fd < 0)
+    {
+        return fail(file);
+    }
+
+    struct stat st;
+    if (fstat(file->fd, &st) != 0)
+    {
+        return fail(file);
+    }
+    if (pread(file->fd, &file->header, sizeof(file->header), 0) != (ssize_t)sizeof(file->header) ||
+        !valid_header(&file->header, (size_t)st.st_size))
+    {
+        errno = EINVAL;
+        return fail(file);
+    }
+
+    if (!map_file(file, file_size(&file->header)))
+    {
+        return fail(file);
+    }
+    return true;
+}
+
+// unmap and close
+void v3_file_close(v3_file *file)
+{
+    assert(file != NULL);
+
+    if (file->map != NULL)
+    {
+        munmap(file->map, file->map_size);
+    }
+    if (file->fd >= 0)
+    {
+        close(file->fd);
+    }
+    memset(file, 0, sizeof(*file));
+    file->fd = -1;
+}
+
+size_t v3_file_count(const v3_file *file)
+{
+    assert(file != NULL && file->map != NULL);
+
+    return (size_t)file->header.count;
+}
+
+v3_soa v3_file_soa(const v3_file *file)
+{
+    assert(file != NULL && file->map != NULL);
+    assert(file->header.layout == V3_FILE_SOA);
+
+    float *x = (float *)(file->map + file->header.data_offset);
+    size_t stride = file->header.array_stride / sizeof(float);
+    v3_soa soa = {x, x + stride, x + 2 * stride};
+    return soa;
+}
+
+float *v3_file_aos(const v3_file *file)
+{
+    assert(file != NULL && file->map != NULL);
+    assert(file->header.layout == V3_FILE_AOS);
+
+    return (float *)(file->map + file->header.data_offset);
+}
+
+// advise the bytes [offset, offset + length) of the mapping; readahead covers
+// every page the range touches, dropping only the pages wholly inside it
+static void advise(v3_file *file, size_t offset, size_t length, int advice)
+{
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t begin = (advice == MADV_DONTNEED) ? align_up(offset, page) : offset / page * page;
+    size_t end = (advice == MADV_DONTNEED) ? (offset + length) / page * page : align_up(offset + length, page);
+    if (end > file->map_size)
+    {
+        end = file->map_size;
+    }
+    if (begin < end)
+    {
+        madvise(file->map + begin, end - begin, advice);
+    }
+}
+
+// advise the components of the vectors [begin, begin + count)
+static void advise_vectors(v3_file *file, size_t begin, size_t count, int advice)
+{
+    const v3_file_header *header = &file->header;
+    if (header->layout == V3_FILE_SOA)
+    {
+        for (int axis = 0; axis < 3; axis++)
+        {
+            advise(file, header->data_offset + axis * header->array_stride + begin * sizeof(float),
+                   count * sizeof(float), advice);
+        }
+    }
+    else
+    {
+        advise(file, header->data_offset + begin * 3 * sizeof(float), count * 3 * sizeof(float), advice);
+    }
+}
+
+// walk the file in chunks
+bool v3_file_stream(v3_file *file, size_t chunk, v3_file_chunk_fn fn, void *context)
+{
+    assert(file != NULL && file->map != NULL && fn != NULL);
+
+    if (chunk == 0)
+    {
+        chunk = V3_FILE_CHUNK;
+    }
+
+    size_t count = (size_t)file->header.count;
+    bool soa = file->header.layout == V3_FILE_SOA;
+    // aos chunks are transposed through scratch arrays borrowed from the thread arena
+    v3_arena *arena = v3_thread_arena();
+    v3_arena_mark mark = v3_arena_mark_position(arena);
+    v3_soa scratch = {NULL, NULL, NULL};
+    if (!soa && count > 0)
+    {
+        chunk = (chunk < count) ? chunk : count;
+        if (!v3_arena_alloc_soa(arena, &scratch, chunk))
+        {
+            errno = ENOMEM;
+            return false;
+        }
+    }
+
+    v3_soa data = {NULL, NULL, NULL};
+    float *aos = NULL;
+    if (soa)
+    {
+        data = v3_file_soa(file);
+    }
+    else
+    {
+        aos = v3_file_aos(file);
+    }
+    for (size_t begin = 0; begin < count; begin += chunk)
+    {
+        size_t n = (count - begin < chunk) ? count - begin : chunk;
+
+        // start reading the next chunk while this one is processed
+        if (begin + n < count)
+        {
+            size_t next = (count - begin - n < chunk) ? count - begin - n : chunk;
+            advise_vectors(file, begin + n, next, MADV_WILLNEED);
+        }
+
+        if (soa)
+        {
+            v3_soa view = {data.x + begin, data.y + begin, data.z + begin};
+            fn(context, view, begin, n);
+        }
+        else
+        {
+            v3_soa view = scratch;
+            const float *src = aos + begin * 3;
+            for (size_t i = 0; i < n; i++)
+            {
+                view.x[i] = src[i * 3];
+                view.y[i] = src[i * 3 + 1];
+                view.z[i] = src[i * 3 + 2];
+            }
+
+            fn(context, view, begin, n);
+
+            if (file->writable)
+            {
+                float *dst = aos + begin * 3;
+                for (size_t i = 0; i < n; i++)
+                {
+                    dst[i * 3] = view.x[i];
+                    dst[i * 3 + 1] = view.y[i];
+                    dst[i * 3 + 2] = view.z[i];
+                }
+            }
+        }
+
+        // unmap the finished pages so the resident set stays at a few chunks;
+        // they stay in the page cache, so writes to a writable file are kept
+        advise_vectors(file, begin, n, MADV_DONTNEED);
+    }
+
+    v3_arena_restore(arena, mark);
+    return true;
+}
+
+// parse one text line into v
+// returns: 1 for a vector, 0 for a blank or comment line, -1 for a malformed line
+static int parse_line(const char *line, float *v)
+{
+    const char *p = line;
+    while (*p == ' ' || *p == '\t')
+    {
+        p++;
+    }
+    if (*p == '\0' || *p == '\n' || *p == '\r' || *p == '#')
+    {
+        return 0;
+    }
+
+    for (int k = 0; k < 3; k++)
+    {
+        char *end;
+        v[k] = strtof(p, &end);
+        if (end == p)
+        {
+            return -1;
+        }
+        p = end;
+        while (*p == ' ' || *p == '\t')
+        {
+            p++;
+        }
+        if (k < 2 && *p == ',')
+        {
+            p++;
+        }
+    }
+
+    return (*p == '\0' || *p == '\n' || *p == '\r') ? 1 : -1;
+}
+
+// read every line of a text file, storing vectors when out is not NULL
+// returns: the number of vectors, or SIZE_MAX with errno set on a malformed or
+// overlong line, or on more vectors than out holds
+static size_t read_text(FILE *in, v3_file *out)
+{
+    char line[LINE_SIZE];
+    size_t count = 0;
+    while (fgets(line, sizeof(line), in) != NULL)
+    {
+        if (strchr(line, '\n') == NULL && !feof(in))
+        {
+            errno = EINVAL;
+            return SIZE_MAX;
+        }
+
+        float v[3];
+        int parsed = parse_line(line, v);
+        if (parsed < 0)
+        {
+            errno = EINVAL;
+            return SIZE_MAX;
+        }
+        if (parsed == 0)
+        {
+            continue;
+        }
+
+        if (out != NULL)
+        {
+            // the file grew since it was counted
+            if (count == out->header.count)
+            {
+                errno = EINVAL;
+                return SIZE_MAX;
+            }
+            if (out->header.layout == V3_FILE_SOA)
+            {
+                v3_soa soa = v3_file_soa(out);
+                soa.x[count] = v[0];
+                soa.y[count] = v[1];
+                soa.z[count] = v[2];
+            }
+            else
+            {
+                memcpy(v3_file_aos(out) + count * 3, v, sizeof(v));
+            }
+        }
+        count++;
+    }
+    return count;
+}
+
+// convert text triples, counting them first so the file is created at its final size
+bool v3_file_convert_text(const char *text_path, const char *path, v3_file_layout layout)
+{
+    assert(text_path != NULL && path != NULL);
+
+    FILE *in = fopen(text_path, "r");
+    if (in == NULL)
+    {
+        return false;
+    }
+
+    v3_file out;
+    size_t count = read_text(in, NULL);
+    bool ok = count != SIZE_MAX && !ferror(in) && v3_file_create(&out, path, layout, count);
+    if (ok)
+    {
+        rewind(in);
+        size_t filled = read_text(in, &out);
+        ok = filled == count;
+        if (filled != SIZE_MAX && filled < count)
+        {
+            // the file shrank since it was counted
+            errno = EINVAL;
+        }
+        v3_file_close(&out);
+    }
+
+    int saved = errno;
+    fclose(in);
+    errno = saved;
+    return ok;
+}
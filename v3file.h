@@ -0,0 +1,94 @@
+#ifndef V3FILE_H
+#define V3FILE_H
+
+// library inclusions
+#include "v3math.h"
+
+// memory-mapped binary files of float vectors
+//
+// a file is a 64 byte header followed by the components, either interleaved
+// (aos, x y z x y z ...) or as three arrays (soa, x... y... z...). data and each
+// soa array start on a V3_FILE_ALIGN boundary, so the batch functions run on
+// the mapped pages directly: no parse step, no copy, and the kernel reads the
+// page cache. v3_file_stream walks a file in chunks, asking the kernel to read
+// the next chunk ahead and to drop the pages already processed, so files larger
+// than memory stream through a bounded resident set
+//
+// the format is little endian, the native order of every target the library builds for
+
+// "V3VECTOR"
+#define V3_FILE_MAGIC "V3VECTOR"
+
+// current format version, readers reject other versions
+#define V3_FILE_VERSION 1
+
+// data and soa array alignment in bytes, one page
+#define V3_FILE_ALIGN 4096
+
+// vectors per v3_file_stream chunk when 0 is passed, 768 KB of components
+#define V3_FILE_CHUNK 65536
+
+typedef enum
+{
+    V3_FILE_AOS = 0,
+    V3_FILE_SOA = 1
+} v3_file_layout;
+
+// on-disk header, 64 bytes
+typedef struct
+{
+    char magic[8];          // V3_FILE_MAGIC, not nul terminated
+    uint32_t version;       // V3_FILE_VERSION
+    uint32_t layout;        // v3_file_layout
+    uint64_t count;         // number of vectors
+    uint64_t data_offset;   // byte offset of the first component
+    uint64_t array_stride;  // soa: bytes from the start of x to y and from y to z, 0 for aos
+    uint8_t reserved[24];   // zero
+} v3_file_header;
+
+// an open file and its mapping
+typedef struct
+{
+    int fd;
+    bool writable;
+    unsigned char *map;
+    size_t map_size;
+    v3_file_header header;
+} v3_file;
+
+// called by v3_file_stream for the vectors [begin, begin + count) as soa arrays;
+// changes to chunk are written to the file when it was opened writable
+typedef void (*v3_file_chunk_fn)(void *context, v3_soa chunk, size_t begin, size_t count);
+
+// create or truncate path for count vectors of the given layout, mapped read-write
+// components start as zero; returns false with errno set on failure
+bool v3_file_create(v3_file *file, const char *path, v3_file_layout layout, size_t count);
+
+// open and map an existing file, checking its header
+// returns false with errno set on failure (EINVAL for a bad header)
+bool v3_file_open(v3_file *file, const char *path, bool writable);
+
+// unmap and close; writes through a writable mapping are already in the file's page cache
+void v3_file_close(v3_file *file);
+
+// number of vectors in the file
+size_t v3_file_count(const v3_file *file);
+
+// components of a soa file, pointing into the mapping
+v3_soa v3_file_soa(const v3_file *file);
+
+// components of an aos file, 3 floats per vector pointing into the mapping
+float *v3_file_aos(const v3_file *file);
+
+// run fn over the file in chunks of chunk vectors (0 for V3_FILE_CHUNK)
+// soa files are passed straight from the mapping; aos chunks are transposed
+// into scratch arrays and back. returns false with errno set if scratch memory runs out
+bool v3_file_stream(v3_file *file, size_t chunk, v3_file_chunk_fn fn, void *context);
+
+// convert a text file of "x y z" lines (commas also separate, blank lines and
+// lines starting with # are skipped) into a vector file
+// returns false with errno set on failure (EINVAL for a malformed line or a text
+// file that changes length while it is converted)
+bool v3_file_convert_text(const char *text_path, const char *path, v3_file_layout layout);
+
+#endif
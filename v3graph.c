@@ -0,0 +1,515 @@
+// library inclusions
+#include "v3graph.h"
+#include "v3arena.h"
+#include "v3pool.h"
+#include "v3simd.h"
+#include "v3instrument.h"
+
+static_assert(V3_GRAPH_TILE % V3_POOL_ALIGN == 0, "tiles must hold whole simd groups");
+
+// state shared by the tasks of one run
+typedef struct
+{
+    const v3_graph *graph;
+    const v3_kernels *kernels;
+    bool live[V3_GRAPH_MAX_NODES];  // a stored value depends on the value
+    int slot[V3_GRAPH_MAX_NODES];   // scratch tile of the value, -1 for bound values
+    int slots;
+    size_t degenerate;
+    int failed;
+} graph_job;
+
+// remember the first failure and return -1 with errno = error
+static int fail(v3_graph *graph, int error)
+{
+    if (graph->error == 0)
+    {
+        graph->error = error;
+    }
+    errno = error;
+    return -1;
+}
+
+// whether id names a vector value of graph
+static bool vector_value(const v3_graph *graph, int id)
+{
+    return id >= 0 && id < graph->count && !graph->nodes[id].scalar;
+}
+
+// whether a value is written to arrays of the caller
+static bool stored(const v3_graph_node *node)
+{
+    return node->op != V3_GRAPH_INPUT && (node->vectors.x != NULL || node->scalars != NULL);
+}
+
+// append a node of operands vector operands and return its id
+static int record(v3_graph *graph, v3_graph_op op, bool scalar, int operands, int a, int b)
+{
+    assert(graph != NULL);
+
+    if (graph->error != 0)
+    {
+        errno = graph->error;
+        return -1;
+    }
+    if ((operands > 0 && !vector_value(graph, a)) || (operands > 1 && !vector_value(graph, b)))
+    {
+        return fail(graph, EINVAL);
+    }
+    if (graph->count == V3_GRAPH_MAX_NODES)
+    {
+        return fail(graph, ENOSPC);
+    }
+
+    v3_graph_node *node = &graph->nodes[graph->count];
+    memset(node, 0, sizeof(*node));
+    node->op = op;
+    node->scalar = scalar;
+    node->args[0] = (operands > 0) ? a : -1;
+    node->args[1] = (operands > 1) ? b : -1;
+    return graph->count++;
+}
+
+// start an empty graph
+void v3_graph_init(v3_graph *graph)
+{
+    assert(graph != NULL);
+
+    graph->count = 0;
+    graph->error = 0;
+}
+
+// vectors read from the arrays of a
+int v3_graph_input(v3_graph *graph, v3_soa a)
+{
+    assert(a.x != NULL && a.y != NULL && a.z != NULL);
+
+    int id = record(graph, V3_GRAPH_INPUT, false, 0, -1, -1);
+    if (id >= 0)
+    {
+        graph->nodes[id].vectors = a;
+    }
+    return id;
+}
+
+// the vector v for every element
+int v3_graph_constant(v3_graph *graph, const float *v)
+{
+    assert(v != NULL);
+
+    int id = record(graph, V3_GRAPH_CONSTANT, false, 0, -1, -1);
+    if (id >= 0)
+    {
+        memcpy(graph->nodes[id].param, v, 3 * sizeof(float));
+    }
+    return id;
+}
+
+// dst[i] = b[i] - a[i]
+int v3_graph_from_points(v3_graph *graph, int a, int b)
+{
+    return record(graph, V3_GRAPH_FROM_POINTS, false, 2, a, b);
+}
+
+// dst[i] = a[i] + b[i]
+int v3_graph_add(v3_graph *graph, int a, int b)
+{
+    return record(graph, V3_GRAPH_ADD, false, 2, a, b);
+}
+
+// dst[i] = a[i] - b[i]
+int v3_graph_subtract(v3_graph *graph, int a, int b)
+{
+    return record(graph, V3_GRAPH_SUBTRACT, false, 2, a, b);
+}
+
+// dst[i] = a[i] x b[i]
+int v3_graph_cross_product(v3_graph *graph, int a, int b)
+{
+    return record(graph, V3_GRAPH_CROSS_PRODUCT, false, 2, a, b);
+}
+
+// dst[i] = s a[i]
+int v3_graph_scale(v3_graph *graph, int a, float s)
+{
+    int id = record(graph, V3_GRAPH_SCALE, false, 1, a, -1);
+    if (id >= 0)
+    {
+        graph->nodes[id].param[0] = s;
+    }
+    return id;
+}
+
+// dst[i] = v[i] - 2(v[i] * n[i])n[i]
+int v3_graph_reflect(v3_graph *graph, int v, int n)
+{
+    return record(graph, V3_GRAPH_REFLECT, false, 2, v, n);
+}
+
+// dst[i] = a[i] / ||a[i]||
+int v3_graph_normalize(v3_graph *graph, int a)
+{
+    return record(graph, V3_GRAPH_NORMALIZE, false, 1, a, -1);
+}
+
+// dst[i] = a[i] * b[i]
+int v3_graph_dot_product(v3_graph *graph, int a, int b)
+{
+    return record(graph, V3_GRAPH_DOT_PRODUCT, true, 2, a, b);
+}
+
+// dst[i] = ||a[i]||
+int v3_graph_length(v3_graph *graph, int a)
+{
+    return record(graph, V3_GRAPH_LENGTH, true, 1, a, -1);
+}
+
+// check that id is an operation result of the given kind not stored yet
+static bool check_store(v3_graph *graph, int id, bool scalar)
+{
+    assert(graph != NULL);
+
+    if (graph->error != 0)
+    {
+        errno = graph->error;
+        return false;
+    }
+    if (id < 0 || id >= graph->count)
+    {
+        fail(graph, EINVAL);
+        return false;
+    }
+
+    const v3_graph_node *node = &graph->nodes[id];
+    if (node->op == V3_GRAPH_INPUT || node->op == V3_GRAPH_CONSTANT || node->scalar != scalar || stored(node))
+    {
+        fail(graph, EINVAL);
+        return false;
+    }
+    return true;
+}
+
+// write the vector value id to dst
+bool v3_graph_store(v3_graph *graph, int id, v3_soa dst)
+{
+    assert(dst.x != NULL && dst.y != NULL && dst.z != NULL);
+
+    if (!check_store(graph, id, false))
+    {
+        return false;
+    }
+    graph->nodes[id].vectors = dst;
+    return true;
+}
+
+// write the scalar value id to dst
+bool v3_graph_store_scalars(v3_graph *graph, int id, float *dst)
+{
+    assert(dst != NULL);
+
+    if (!check_store(graph, id, true))
+    {
+        return false;
+    }
+    graph->nodes[id].scalars = dst;
+    return true;
+}
+
+// hand the scratch tile of value arg back once node i was its last reader
+static void release(const graph_job *job, const int *last_use, int arg, int i, int *free_slots, int *free_count)
+{
+    if (arg >= 0 && last_use[arg] == i && job->slot[arg] >= 0 && job->graph->nodes[arg].op != V3_GRAPH_CONSTANT)
+    {
+        free_slots[(*free_count)++] = job->slot[arg];
+    }
+}
+
+// find the values the stored ones depend on and give every unstored one a
+// scratch tile, reusing the tiles of values no later operation reads
+// returns the bytes per element the run streams through memory
+static size_t plan(graph_job *job)
+{
+    const v3_graph *graph = job->graph;
+    int last_use[V3_GRAPH_MAX_NODES];
+    int free_slots[V3_GRAPH_MAX_NODES];
+    int free_count = 0;
+    size_t bytes_per_vector = 0;
+
+    for (int i = graph->count - 1; i >= 0; i--)
+    {
+        const v3_graph_node *node = &graph->nodes[i];
+        job->live[i] = job->live[i] || stored(node);
+        for (int k = 0; k < 2 && job->live[i]; k++)
+        {
+            if (node->args[k] >= 0)
+            {
+                job->live[node->args[k]] = true;
+            }
+        }
+    }
+
+    for (int i = 0; i < graph->count; i++)
+    {
+        last_use[i] = -1;
+        for (int k = 0; k < 2 && job->live[i]; k++)
+        {
+            if (graph->nodes[i].args[k] >= 0)
+            {
+                last_use[graph->nodes[i].args[k]] = i;
+            }
+        }
+    }
+
+    job->slots = 0;
+    for (int i = 0; i < graph->count; i++)
+    {
+        const v3_graph_node *node = &graph->nodes[i];
+        job->slot[i] = -1;
+        if (!job->live[i])
+        {
+            continue;
+        }
+
+        if (node->op == V3_GRAPH_INPUT || stored(node))
+        {
+            bytes_per_vector += (node->scalar ? 1 : 3) * sizeof(float);
+        }
+        if (node->op == V3_GRAPH_INPUT)
+        {
+            continue;
+        }
+
+        // constants are filled once per task and keep their tile to the end
+        if (node->op == V3_GRAPH_CONSTANT)
+        {
+            job->slot[i] = job->slots++;
+            continue;
+        }
+
+        // vector results may take the tile of an operand read for the last
+        // time, as in-place batch calls; scalar ones never share a tile with
+        // the vectors they are computed from
+        int a = node->args[0];
+        int b = (node->args[1] != a) ? node->args[1] : -1;
+        if (!node->scalar)
+        {
+            release(job, last_use, a, i, free_slots, &free_count);
+            release(job, last_use, b, i, free_slots, &free_count);
+        }
+        if (!stored(node))
+        {
+            job->slot[i] = (free_count > 0) ? free_slots[--free_count] : job->slots++;
+        }
+        if (node->scalar)
+        {
+            release(job, last_use, a, i, free_slots, &free_count);
+            release(job, last_use, b, i, free_slots, &free_count);
+        }
+    }
+    return bytes_per_vector;
+}
+
+// view of value i for the tile starting at vector begin; scalars use x
+static v3_soa value_view(const graph_job *job, int i, float *scratch, size_t begin)
+{
+    const v3_graph_node *node = &job->graph->nodes[i];
+    if (job->slot[i] >= 0)
+    {
+        float *tile = scratch + (size_t)job->slot[i] * 3 * V3_GRAPH_TILE;
+        v3_soa r = {tile, tile + V3_GRAPH_TILE, tile + 2 * V3_GRAPH_TILE};
+        return r;
+    }
+    if (node->scalar)
+    {
+        v3_soa r = {node->scalars + begin, NULL, NULL};
+        return r;
+    }
+    v3_soa r = {node->vectors.x + begin, node->vectors.y + begin, node->vectors.z + begin};
+    return r;
+}
+
+// compute value i over count elements of a tile
+static size_t run_node(const graph_job *job, int i, v3_soa *views, size_t count)
+{
+    const v3_graph_node *node = &job->graph->nodes[i];
+    v3_soa dst = views[i];
+    v3_soa a = (node->args[0] >= 0) ? views[node->args[0]] : dst;
+    v3_soa b = (node->args[1] >= 0) ? views[node->args[1]] : dst;
+
+    switch (node->op)
+    {
+    case V3_GRAPH_INPUT:
+    case V3_GRAPH_CONSTANT:
+        break;
+
+    case V3_GRAPH_FROM_POINTS:
+        v3_from_points_batch(dst, a, b, count);
+        break;
+
+    case V3_GRAPH_ADD:
+        v3_add_batch(dst, a, b, count);
+        break;
+
+    case V3_GRAPH_SUBTRACT:
+        v3_subtract_batch(dst, a, b, count);
+        break;
+
+    case V3_GRAPH_CROSS_PRODUCT:
+        v3_cross_product_batch(dst, a, b, count);
+        break;
+
+    case V3_GRAPH_SCALE:
+        if (dst.x != a.x)
+        {
+            memcpy(dst.x, a.x, count * sizeof(float));
+            memcpy(dst.y, a.y, count * sizeof(float));
+            memcpy(dst.z, a.z, count * sizeof(float));
+        }
+        v3_scale_batch(dst, node->param[0], count);
+        break;
+
+    case V3_GRAPH_REFLECT:
+        v3_reflect_batch(dst, a, b, count);
+        break;
+
+    // the kernel itself, so zero length vectors are reported once per run; the
+    // probe counts the tile as a v3_normalize_batch call like the other nodes
+    case V3_GRAPH_NORMALIZE:
+    {
+        V3_PROBE_BEGIN();
+        size_t degenerate = job->kernels->normalize(dst, a, count);
+        V3_PROBE_END(V3_PROBE_NORMALIZE_BATCH, count, degenerate);
+        return degenerate;
+    }
+
+    case V3_GRAPH_DOT_PRODUCT:
+        v3_dot_product_batch(dst.x, a, b, count);
+        break;
+
+    case V3_GRAPH_LENGTH:
+        v3_length_batch(dst.x, a, count);
+        break;
+    }
+    return 0;
+}
+
+// run every live value over the tiles of [begin, end)
+static void graph_task(void *context, size_t begin, size_t end)
+{
+    graph_job *job = (graph_job *)context;
+    const v3_graph *graph = job->graph;
+    v3_soa views[V3_GRAPH_MAX_NODES];
+
+    v3_arena *arena = v3_thread_arena();
+    v3_arena_mark mark = v3_arena_mark_position(arena);
+    float *scratch = NULL;
+    if (job->slots > 0)
+    {
+        scratch = (float *)v3_arena_alloc(arena, (size_t)job->slots * 3 * V3_GRAPH_TILE * sizeof(float));
+        if (scratch == NULL)
+        {
+            __atomic_store_n(&job->failed, 1, __ATOMIC_RELAXED);
+            v3_arena_restore(arena, mark);
+            return;
+        }
+    }
+
+    for (int i = 0; i < graph->count; i++)
+    {
+        if (job->live[i] && graph->nodes[i].op == V3_GRAPH_CONSTANT)
+        {
+            v3_soa c = value_view(job, i, scratch, 0);
+            for (size_t k = 0; k < V3_GRAPH_TILE; k++)
+            {
+                c.x[k] = graph->nodes[i].param[0];
+                c.y[k] = graph->nodes[i].param[1];
+                c.z[k] = graph->nodes[i].param[2];
+            }
+        }
+    }
+
+    size_t degenerate = 0;
+    for (size_t t = begin; t < end; t += V3_GRAPH_TILE)
+    {
+        size_t n = (end - t < V3_GRAPH_TILE) ? end - t : V3_GRAPH_TILE;
+        for (int i = 0; i < graph->count; i++)
+        {
+            if (job->live[i])
+            {
+                views[i] = value_view(job, i, scratch, t);
+                degenerate += run_node(job, i, views, n);
+            }
+        }
+    }
+
+    if (degenerate > 0)
+    {
+        __atomic_fetch_add(&job->degenerate, degenerate, __ATOMIC_RELAXED);
+    }
+    v3_arena_restore(arena, mark);
+}
+
+// grain of whole tiles
+static size_t tile_grain(size_t count, size_t bytes_per_vector)
+{
+    // ranges run on the calling thread skip the heuristic, which asks the os
+    // for the cpu count until the pool has started
+    if (count < V3_POOL_MIN_PARALLEL)
+    {
+        return count;
+    }
+    size_t grain = v3_pool_grain(count, bytes_per_vector);
+    return (grain + V3_GRAPH_TILE - 1) / V3_GRAPH_TILE * V3_GRAPH_TILE;
+}
+
+// compute every stored value over count elements
+bool v3_graph_run(const v3_graph *graph, size_t count)
+{
+    assert(graph != NULL);
+    V3_PROBE_BEGIN();
+
+    if (graph->error != 0)
+    {
+        errno = graph->error;
+        V3_PROBE_END(V3_PROBE_GRAPH_RUN, count, 0);
+        return false;
+    }
+
+    graph_job job;
+    memset(&job, 0, sizeof(job));
+    job.graph = graph;
+    size_t bytes_per_vector = plan(&job);
+
+    bool any_stored = false;
+    for (int i = 0; i < graph->count; i++)
+    {
+        any_stored = any_stored || stored(&graph->nodes[i]);
+    }
+    if (!any_stored)
+    {
+        errno = EINVAL;
+        V3_PROBE_END(V3_PROBE_GRAPH_RUN, count, 0);
+        return false;
+    }
+    if (count == 0)
+    {
+        V3_PROBE_END(V3_PROBE_GRAPH_RUN, count, 0);
+        return true;
+    }
+
+    job.kernels = v3_get_kernels();
+    v3_parallel_for(count, tile_grain(count, bytes_per_vector), graph_task, &job);
+
+    if (job.degenerate > 0)
+    {
+        v3_report_error(V3_SOURCE_NORMALIZE_BATCH, "Cannot normalize zero length vector", job.degenerate);
+    }
+
+    V3_PROBE_END(V3_PROBE_GRAPH_RUN, count, job.degenerate);
+    if (job.failed)
+    {
+        errno = ENOMEM;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,112 @@
+#ifndef V3GRAPH_H
+#define V3GRAPH_H
+
+// library inclusions
+#include "v3math.h"
+
+// operation graphs that run chains of batch operations as one pass
+//
+// a graph records a chain of batch operations over named arrays at run time,
+// the way v3expr.h does at compile time, and computes nothing until it is run.
+// running cuts the range into tiles of V3_GRAPH_TILE vectors and runs every
+// operation of the chain on one tile before moving to the next, so values
+// nothing stores live in l1-sized scratch tiles instead of full arrays, and
+// memory sees one load per input and one store per output. the tiles run on
+// the batch kernels, spread over the thread pool, and each element takes the
+// same kernel path it takes in one batch call, so results are bit-identical to
+// calling the batch functions one after another
+//
+//     v3_graph g;
+//     v3_graph_init(&g);
+//     int d = v3_graph_from_points(&g, v3_graph_input(&g, eye), v3_graph_input(&g, points));
+//     int r = v3_graph_reflect(&g, v3_graph_normalize(&g, d), v3_graph_input(&g, normals));
+//     v3_graph_store_scalars(&g, v3_graph_dot_product(&g, r, v3_graph_constant(&g, light)), shade);
+//     v3_graph_run(&g, count);
+//
+// recording functions return the id of the value they add, or -1 with errno =
+// EINVAL for an unknown id or a vector where a scalar belongs and errno =
+// ENOSPC once V3_GRAPH_MAX_NODES are used. the first failure sticks to the
+// graph, so a chain can be recorded without checks and v3_graph_run fails
+// with that errno
+
+// values per graph: inputs, constants and operations together
+#define V3_GRAPH_MAX_NODES 32
+
+// vectors per tile; a vector tile is 3 KB, so a chain of a few live values
+// stays in l1. a multiple of V3_POOL_ALIGN, so tiles never split a simd group
+#define V3_GRAPH_TILE 256
+
+typedef enum
+{
+    V3_GRAPH_INPUT,         // bound vector arrays
+    V3_GRAPH_CONSTANT,      // one vector for every element
+    V3_GRAPH_FROM_POINTS,
+    V3_GRAPH_ADD,
+    V3_GRAPH_SUBTRACT,
+    V3_GRAPH_CROSS_PRODUCT,
+    V3_GRAPH_SCALE,
+    V3_GRAPH_REFLECT,
+    V3_GRAPH_NORMALIZE,
+    V3_GRAPH_DOT_PRODUCT,   // scalar
+    V3_GRAPH_LENGTH         // scalar
+} v3_graph_op;
+
+typedef struct
+{
+    v3_graph_op op;
+    bool scalar;        // one float per element rather than a vector
+    int args[2];        // ids of the operands, -1 where unused
+    float param[3];     // the constant vector, or the scale factor in param[0]
+    v3_soa vectors;     // input or stored arrays, all NULL when not bound
+    float *scalars;     // stored array of a scalar value, NULL when not bound
+} v3_graph_node;
+
+typedef struct
+{
+    v3_graph_node nodes[V3_GRAPH_MAX_NODES];
+    int count;
+    int error;          // errno of the first failed call, 0 while the graph is valid
+} v3_graph;
+
+// start an empty graph
+void v3_graph_init(v3_graph *graph);
+
+// vectors read from the arrays of a, element i of the run from a[i]
+int v3_graph_input(v3_graph *graph, v3_soa a);
+
+// the vector v for every element
+int v3_graph_constant(v3_graph *graph, const float *v);
+
+// a[i] to b[i], a[i] + b[i], a[i] - b[i] and a[i] x b[i]
+int v3_graph_from_points(v3_graph *graph, int a, int b);
+int v3_graph_add(v3_graph *graph, int a, int b);
+int v3_graph_subtract(v3_graph *graph, int a, int b);
+int v3_graph_cross_product(v3_graph *graph, int a, int b);
+
+// s a[i]
+int v3_graph_scale(v3_graph *graph, int a, float s);
+
+// v[i] reflected across the normalized n[i]
+int v3_graph_reflect(v3_graph *graph, int v, int n);
+
+// a[i] / ||a[i]||, zero length vectors become zero and are reported once per run
+int v3_graph_normalize(v3_graph *graph, int a);
+
+// scalars a[i] * b[i] and ||a[i]||
+int v3_graph_dot_product(v3_graph *graph, int a, int b);
+int v3_graph_length(v3_graph *graph, int a);
+
+// write the vector value id to dst, or the scalar value id to dst; a value is
+// stored at most once and inputs and constants not at all. dst may be the
+// arrays of an input, as in the in-place batch calls, but must not partially
+// overlap any array the graph reads or writes
+bool v3_graph_store(v3_graph *graph, int id, v3_soa dst);
+bool v3_graph_store_scalars(v3_graph *graph, int id, float *dst);
+
+// compute every stored value over count elements; values nothing stored
+// depends on are skipped. returns false with errno set, writing nothing, if
+// recording failed or nothing is stored, and with errno = ENOMEM, after an
+// unknown number of tiles, if a thread's arena cannot hold its scratch tiles
+bool v3_graph_run(const v3_graph *graph, size_t count);
+
+#endif
@@ -0,0 +1,518 @@
+// library inclusions
+#include "v3half.h"
+#include "v3simd.h"
+#include "v3vec.h"
+#include "v3instrument.h"
+#ifdef V3_X86
+#include <cpuid.h>
+#endif
+
+// vectors converted per step by the batch functions, small enough for l1
+#define HALF_TILE 256
+
+// convert one float to half, rounding to nearest even
+v3_half v3_float_to_half(float f)
+{
+    uint32_t x;
+    memcpy(&x, &f, sizeof(x));
+
+    uint32_t sign = (x >> 16) & 0x8000u;
+    uint32_t exponent = (x >> 23) & 0xffu;
+    uint32_t mantissa = x & 0x7fffffu;
+
+    // infinity and nan, keeping nan quiet
+    if (exponent == 0xffu)
+    {
+        return (v3_half)(sign | 0x7c00u | (mantissa != 0 ? 0x200u | (mantissa >> 13) : 0u));
+    }
+
+    int32_t half_exponent = (int32_t)exponent - 127 + 15;
+
+    // too large for half
+    if (half_exponent >= 31)
+    {
+        return (v3_half)(sign | 0x7c00u);
+    }
+
+    // subnormal half or zero
+    if (half_exponent <= 0)
+    {
+        if (half_exponent < -10)
+        {
+            return (v3_half)sign;
+        }
+
+        mantissa |= 0x800000u;
+        uint32_t shift = (uint32_t)(14 - half_exponent);
+        uint32_t half_mantissa = mantissa >> shift;
+        uint32_t remainder = mantissa & ((1u << shift) - 1u);
+        uint32_t halfway = 1u << (shift - 1u);
+        if (remainder > halfway || (remainder == halfway && (half_mantissa & 1u)))
+        {
+            half_mantissa++;
+        }
+        return (v3_half)(sign | half_mantissa);
+    }
+
+    // a carry out of the mantissa correctly bumps the exponent, up to infinity
+    uint32_t half = sign | ((uint32_t)half_exponent << 10) | (mantissa >> 13);
+    uint32_t remainder = mantissa & 0x1fffu;
+    if (remainder > 0x1000u || (remainder == 0x1000u && (half & 1u)))
+    {
+        half++;
+    }
+    return (v3_half)half;
+}
+
+// convert one half to float
+float v3_half_to_float(v3_half h)
+{
+    uint32_t sign = ((uint32_t)h & 0x8000u) << 16;
+    uint32_t exponent = ((uint32_t)h >> 10) & 0x1fu;
+    uint32_t mantissa = (uint32_t)h & 0x3ffu;
+    uint32_t x;
+
+    if (exponent == 0)
+    {
+        // zero or subnormal, mantissa * 2^-24 is exact in float
+        float f = (float)mantissa * 5.9604644775390625e-8f;
+        return (sign != 0) ? -f : f;
+    }
+
+    if (exponent == 31)
+    {
+        x = sign | 0x7f800000u | (mantissa << 13);
+    }
+    else
+    {
+        x = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+    }
+
+    float f;
+    memcpy(&f, &x, sizeof(f));
+    return f;
+}
+
+#ifdef V3_X86
+
+// f16c is used unless the batch kernels were forced to scalar with V3MATH_ISA
+static bool use_f16c(void)
+{
+    static int supported = -1;
+    if (supported < 0)
+    {
+        unsigned eax = 0, ebx = 0, ecx = 0, edx = 0;
+        supported = __get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & bit_F16C) &&
+                    __builtin_cpu_supports("avx");
+    }
+
+    return supported && v3_get_isa() != V3_ISA_SCALAR;
+}
+
+__attribute__((target("avx,f16c")))
+static size_t f16c_float_to_half(v3_half *dst, const float *src, size_t count)
+{
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128i h = _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT);
+        _mm_storeu_si128((__m128i *)(dst + i), h);
+    }
+    return i;
+}
+
+__attribute__((target("avx,f16c")))
+static size_t f16c_half_to_float(float *dst, const v3_half *src, size_t count)
+{
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128i h = _mm_loadu_si128((const __m128i *)(src + i));
+        _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(h));
+    }
+    return i;
+}
+
+#endif
+
+// convert floats to halves
+void v3_float_to_half_batch(v3_half *dst, const float *src, size_t count)
+{
+    assert(dst != NULL && src != NULL);
+
+#ifdef V3_X86
+    size_t i = use_f16c() ? f16c_float_to_half(dst, src, count) : 0;
+#else
+    size_t i = 0;
+#endif
+    for (; i < count; i++)
+    {
+        dst[i] = v3_float_to_half(src[i]);
+    }
+}
+
+// convert halves to floats
+void v3_half_to_float_batch(float *dst, const v3_half *src, size_t count)
+{
+    assert(dst != NULL && src != NULL);
+
+#ifdef V3_X86
+    size_t i = use_f16c() ? f16c_half_to_float(dst, src, count) : 0;
+#else
+    size_t i = 0;
+#endif
+    for (; i < count; i++)
+    {
+        dst[i] = v3_half_to_float(src[i]);
+    }
+}
+
+// decode a half vector into float[3]
+static void decode(float *dst, const v3_half *src)
+{
+    dst[0] = v3_half_to_float(src[0]);
+    dst[1] = v3_half_to_float(src[1]);
+    dst[2] = v3_half_to_float(src[2]);
+}
+
+// encode float[3] into a half vector
+static void encode(v3_half *dst, const float *src)
+{
+    dst[0] = v3_float_to_half(src[0]);
+    dst[1] = v3_float_to_half(src[1]);
+    dst[2] = v3_float_to_half(src[2]);
+}
+
+// widen n half vectors from start into a float tile
+static void widen_tile(v3_soa dst, v3h_soa src, size_t start, size_t n)
+{
+    v3_half_to_float_batch(dst.x, src.x + start, n);
+    v3_half_to_float_batch(dst.y, src.y + start, n);
+    v3_half_to_float_batch(dst.z, src.z + start, n);
+}
+
+// round n float vectors of a tile back into dst from start
+static void narrow_tile(v3h_soa dst, v3_soa src, size_t start, size_t n)
+{
+    v3_float_to_half_batch(dst.x + start, src.x, n);
+    v3_float_to_half_batch(dst.y + start, src.y, n);
+    v3_float_to_half_batch(dst.z + start, src.z, n);
+}
+
+// the scalar functions decode every input before encoding the result,
+// so dst may alias any input
+
+// form a vector from point a to point b
+// dst = b - a
+void v3h_from_points(v3_half *dst, v3_half *a, v3_half *b)
+{
+    assert(dst != NULL && a != NULL && b != NULL);
+
+    float fa[3], fb[3], result[3];
+    decode(fa, a);
+    decode(fb, b);
+    v3_from_points(result, fa, fb);
+    encode(dst, result);
+}
+
+// add two vectors
+// dst = a + b
+void v3h_add(v3_half *dst, v3_half *a, v3_half *b)
+{
+    assert(dst != NULL && a != NULL && b != NULL);
+
+    float fa[3], fb[3], result[3];
+    decode(fa, a);
+    decode(fb, b);
+    v3_add(result, fa, fb);
+    encode(dst, result);
+}
+
+// subtract vector b from vector a
+// dst = a - b
+void v3h_subtract(v3_half *dst, v3_half *a, v3_half *b)
+{
+    assert(dst != NULL && a != NULL && b != NULL);
+
+    float fa[3], fb[3], result[3];
+    decode(fa, a);
+    decode(fb, b);
+    v3_subtract(result, fa, fb);
+    encode(dst, result);
+}
+
+// calculate dot product of two vectors
+float v3h_dot_product(v3_half *a, v3_half *b)
+{
+    assert(a != NULL && b != NULL);
+
+    float fa[3], fb[3];
+    decode(fa, a);
+    decode(fb, b);
+    return v3_dot_product(fa, fb);
+}
+
+// calculate cross product of two vectors
+// dst = a x b
+void v3h_cross_product(v3_half *dst, v3_half *a, v3_half *b)
+{
+    assert(dst != NULL && a != NULL && b != NULL);
+
+    float fa[3], fb[3], result[3];
+    decode(fa, a);
+    decode(fb, b);
+    v3_cross_product(result, fa, fb);
+    encode(dst, result);
+}
+
+// scale a vector by scalar s in-place
+// dst = dst * s
+void v3h_scale(v3_half *dst, float s)
+{
+    assert(dst != NULL);
+
+    float result[3];
+    decode(result, dst);
+    v3_scale(result, s);
+    encode(dst, result);
+}
+
+// calculate angle between two vectors in radians
+float v3h_angle(v3_half *a, v3_half *b)
+{
+    assert(a != NULL && b != NULL);
+
+    float fa[3], fb[3];
+    decode(fa, a);
+    decode(fb, b);
+    return v3_angle(fa, fb);
+}
+
+// calculate angle between two vectors without inverse cosine
+float v3h_angle_quick(v3_half *a, v3_half *b)
+{
+    assert(a != NULL && b != NULL);
+
+    float fa[3], fb[3];
+    decode(fa, a);
+    decode(fb, b);
+    return v3_angle_quick(fa, fb);
+}
+
+// reflect vector v across normal n
+// dst = v - 2(v * n)n
+void v3h_reflect(v3_half *dst, v3_half *v, v3_half *n)
+{
+    assert(dst != NULL && v != NULL && n != NULL);
+
+    float fv[3], fn[3], result[3];
+    decode(fv, v);
+    decode(fn, n);
+    v3_reflect(result, fv, fn);
+    encode(dst, result);
+}
+
+// calculate length/magnitude of a vector
+float v3h_length(v3_half *a)
+{
+    assert(a != NULL);
+
+    float fa[3];
+    decode(fa, a);
+    return v3_length(fa);
+}
+
+// normalize a vector to make it a unit length
+// dst = a / ||a||
+void v3h_normalize(v3_half *dst, v3_half *a)
+{
+    assert(dst != NULL && a != NULL);
+
+    float fa[3], result[3];
+    decode(fa, a);
+    v3_normalize(result, fa);
+    encode(dst, result);
+}
+
+// test helper - check if two vectors are equal within tolerance
+bool v3h_equals(v3_half *a, v3_half *b, float tolerance)
+{
+    assert(a != NULL && b != NULL);
+
+    float fa[3], fb[3];
+    decode(fa, a);
+    decode(fb, b);
+    return v3_equals(fa, fb, tolerance);
+}
+
+// calculate dot products of half vector pairs in float tiles
+// dst[i] = a[i] * b[i]
+void v3h_dot_product_batch(float *dst, v3h_soa a, v3h_soa b, size_t count)
+{
+    assert(dst != NULL);
+    assert(a.x != NULL && a.y != NULL && a.z != NULL);
+    assert(b.x != NULL && b.y != NULL && b.z != NULL);
+    V3_PROBE_BEGIN();
+
+    float ax[HALF_TILE], ay[HALF_TILE], az[HALF_TILE];
+    float bx[HALF_TILE], by[HALF_TILE], bz[HALF_TILE];
+    v3_soa fa = {ax, ay, az};
+    v3_soa fb = {bx, by, bz};
+
+    for (size_t start = 0; start < count; start += HALF_TILE)
+    {
+        size_t n = (count - start < HALF_TILE) ? count - start : HALF_TILE;
+        widen_tile(fa, a, start, n);
+        widen_tile(fb, b, start, n);
+        v3_dot_product_batch(dst + start, fa, fb, n);
+    }
+
+    V3_PROBE_END(V3_PROBE_HALF_DOT_PRODUCT_BATCH, count, 0);
+}
+
+// normalize half vectors in float tiles
+// dst[i] = a[i] / ||a[i]||, zero length vectors become zero
+void v3h_normalize_batch(v3h_soa dst, v3h_soa a, size_t count)
+{
+    assert(dst.x != NULL && dst.y != NULL && dst.z != NULL);
+    assert(a.x != NULL && a.y != NULL && a.z != NULL);
+    V3_PROBE_BEGIN();
+
+    float x[HALF_TILE], y[HALF_TILE], z[HALF_TILE];
+    v3_soa tile = {x, y, z};
+    const v3_kernels *kernels = v3_get_kernels();
+
+    size_t degenerate = 0;
+    for (size_t start = 0; start < count; start += HALF_TILE)
+    {
+        size_t n = (count - start < HALF_TILE) ? count - start : HALF_TILE;
+        widen_tile(tile, a, start, n);
+        degenerate += kernels->normalize(tile, tile, n);
+        narrow_tile(dst, tile, start, n);
+    }
+
+    // report once per batch rather than once per tile
+    if (degenerate > 0)
+    {
+        v3_report_error(V3_SOURCE_NORMALIZE_BATCH, "Cannot normalize zero length vector", degenerate);
+    }
+
+    V3_PROBE_END(V3_PROBE_HALF_NORMALIZE_BATCH, count, degenerate);
+}
+
+// calculate lengths of half vectors in float tiles
+// dst[i] = ||a[i]||
+void v3h_length_batch(float *dst, v3h_soa a, size_t count)
+{
+    assert(dst != NULL);
+    assert(a.x != NULL && a.y != NULL && a.z != NULL);
+    V3_PROBE_BEGIN();
+
+    float x[HALF_TILE], y[HALF_TILE], z[HALF_TILE];
+    v3_soa tile = {x, y, z};
+
+    for (size_t start = 0; start < count; start += HALF_TILE)
+    {
+        size_t n = (count - start < HALF_TILE) ? count - start : HALF_TILE;
+        widen_tile(tile, a, start, n);
+        v3_length_batch(dst + start, tile, n);
+    }
+
+    V3_PROBE_END(V3_PROBE_HALF_LENGTH_BATCH, count, 0);
+}
+
+// calculate cross products of half vector pairs in float tiles
+// dst[i] = a[i] x b[i]
+void v3h_cross_product_batch(v3h_soa dst, v3h_soa a, v3h_soa b, size_t count)
+{
+    assert(dst.x != NULL && dst.y != NULL && dst.z != NULL);
+    assert(a.x != NULL && a.y != NULL && a.z != NULL);
+    assert(b.x != NULL && b.y != NULL && b.z != NULL);
+    V3_PROBE_BEGIN();
+
+    float ax[HALF_TILE], ay[HALF_TILE], az[HALF_TILE];
+    float bx[HALF_TILE], by[HALF_TILE], bz[HALF_TILE];
+    v3_soa fa = {ax, ay, az};
+    v3_soa fb = {bx, by, bz};
+
+    for (size_t start = 0; start < count; start += HALF_TILE)
+    {
+        size_t n = (count - start < HALF_TILE) ? count - start : HALF_TILE;
+        widen_tile(fa, a, start, n);
+        widen_tile(fb, b, start, n);
+        v3_cross_product_batch(fa, fa, fb, n);
+        narrow_tile(dst, fa, start, n);
+    }
+
+    V3_PROBE_END(V3_PROBE_HALF_CROSS_PRODUCT_BATCH, count, 0);
+}
+
+// reflect half vectors across half normals in float tiles
+// dst[i] = v[i] - 2(v[i] * n[i])n[i]
+void v3h_reflect_batch(v3h_soa dst, v3h_soa v, v3h_soa n, size_t count)
+{
+    assert(dst.x != NULL && dst.y != NULL && dst.z != NULL);
+    assert(v.x != NULL && v.y != NULL && v.z != NULL);
+    assert(n.x != NULL && n.y != NULL && n.z != NULL);
+    V3_PROBE_BEGIN();
+
+    float vx[HALF_TILE], vy[HALF_TILE], vz[HALF_TILE];
+    float nx[HALF_TILE], ny[HALF_TILE], nz[HALF_TILE];
+    v3_soa fv = {vx, vy, vz};
+    v3_soa fn = {nx, ny, nz};
+
+    for (size_t start = 0; start < count; start += HALF_TILE)
+    {
+        size_t tile = (count - start < HALF_TILE) ? count - start : HALF_TILE;
+        widen_tile(fv, v, start, tile);
+        widen_tile(fn, n, start, tile);
+        v3_reflect_batch(fv, fv, fn, tile);
+        narrow_tile(dst, fv, start, tile);
+    }
+
+    V3_PROBE_END(V3_PROBE_HALF_REFLECT_BATCH, count, 0);
+}
+
+// angles between half vector pairs in float tiles, the exact tier element by
+// element and the fused tiers in the dispatched kernel
+void v3h_angle_batch(float *dst, v3h_soa a, v3h_soa b, size_t count, v3_angle_accuracy accuracy)
+{
+    assert(dst != NULL);
+    assert(a.x != NULL && a.y != NULL && a.z != NULL);
+    assert(b.x != NULL && b.y != NULL && b.z != NULL);
+    V3_PROBE_BEGIN();
+
+    float ax[HALF_TILE], ay[HALF_TILE], az[HALF_TILE];
+    float bx[HALF_TILE], by[HALF_TILE], bz[HALF_TILE];
+    v3_soa fa = {ax, ay, az};
+    v3_soa fb = {bx, by, bz};
+    const v3_kernels *kernels = v3_get_kernels();
+
+    size_t degenerate = 0;
+    for (size_t start = 0; start < count; start += HALF_TILE)
+    {
+        size_t n = (count - start < HALF_TILE) ? count - start : HALF_TILE;
+        widen_tile(fa, a, start, n);
+        widen_tile(fb, b, start, n);
+        if (accuracy != V3_ANGLE_EXACT)
+        {
+            degenerate += kernels->angle(dst + start, fa, fb, n, accuracy);
+            continue;
+        }
+        for (size_t i = 0; i < n; i++)
+        {
+            Vec3f va(ax[i], ay[i], az[i]);
+            Vec3f vb(bx[i], by[i], bz[i]);
+            degenerate += length(va) < V3_EPSILON || length(vb) < V3_EPSILON;
+            dst[start + i] = angle(va, vb);
+        }
+    }
+
+    // report once per batch rather than once per tile
+    if (degenerate > 0)
+    {
+        v3_report_error(V3_SOURCE_ANGLE_BATCH, "Cannot compute angle with zero length vector", degenerate);
+    }
+
+    V3_PROBE_END(V3_PROBE_HALF_ANGLE_BATCH, count, degenerate);
+}
@@ -0,0 +1,88 @@
+#ifndef V3HALF_H
+#define V3HALF_H
+
+// library inclusions
+#include "v3math.h"
+
+// half precision (ieee binary16) storage variants of the v3math api
+// vectors are stored as 16-bit halves to halve memory traffic, but every
+// operation decodes to float, computes in float, and rounds the result back
+// to half (round to nearest even), so results carry at most 2^-11 relative error
+typedef uint16_t v3_half;
+
+// structure-of-arrays view over a batch of half vectors
+typedef struct
+{
+    v3_half *x;
+    v3_half *y;
+    v3_half *z;
+} v3h_soa;
+
+// convert one float to half, rounding to nearest even
+v3_half v3_float_to_half(float f);
+
+// convert one half to float, exactly
+float v3_half_to_float(v3_half h);
+
+// convert count floats to halves, uses f16c when the cpu has it
+void v3_float_to_half_batch(v3_half *dst, const float *src, size_t count);
+
+// convert count halves to floats, uses f16c when the cpu has it
+void v3_half_to_float_batch(float *dst, const v3_half *src, size_t count);
+
+// form vector from point a to point b
+void v3h_from_points(v3_half *dst, v3_half *a, v3_half *b);
+
+// add two vectors
+void v3h_add(v3_half *dst, v3_half *a, v3_half *b);
+
+// subtract vector b from vector a
+void v3h_subtract(v3_half *dst, v3_half *a, v3_half *b);
+
+// calculate dot product of two vectors, returned in float
+float v3h_dot_product(v3_half *a, v3_half *b);
+
+// calculate cross product of two vectors
+void v3h_cross_product(v3_half *dst, v3_half *a, v3_half *b);
+
+// scale a vector by scalar s
+void v3h_scale(v3_half *dst, float s);
+
+// calculate angle between two vectors in radians
+float v3h_angle(v3_half *a, v3_half *b);
+
+// calculate angle between two vectors without inverse cosine
+float v3h_angle_quick(v3_half *a, v3_half *b);
+
+// reflect vector v across normal n
+void v3h_reflect(v3_half *dst, v3_half *v, v3_half *n);
+
+// calculate length/magnitude of a vector, returned in float
+float v3h_length(v3_half *a);
+
+// normalize a vector to make it unit length
+void v3h_normalize(v3_half *dst, v3_half *a);
+
+// test helper - check if two vectors are equal within tolerance (V3H_TOLERANCE is typical)
+bool v3h_equals(v3_half *a, v3_half *b, float tolerance);
+
+// calculate dot products a[i] * b[i] into float dst[i]
+void v3h_dot_product_batch(float *dst, v3h_soa a, v3h_soa b, size_t count);
+
+// normalize vectors to unit length, zero length vectors become zero
+void v3h_normalize_batch(v3h_soa dst, v3h_soa a, size_t count);
+
+// calculate lengths of vectors into float dst[i]
+void v3h_length_batch(float *dst, v3h_soa a, size_t count);
+
+// calculate cross products a[i] x b[i] into dst[i]
+void v3h_cross_product_batch(v3h_soa dst, v3h_soa a, v3h_soa b, size_t count);
+
+// reflect vectors v[i] across normals n[i] into dst[i]
+void v3h_reflect_batch(v3h_soa dst, v3h_soa v, v3h_soa n, size_t count);
+
+// calculate angles between a[i] and b[i] into float dst[i] at the accuracy tiers of
+// v3_angle_batch; zero length pairs give 0 (cosine 1) and are reported once for the batch
+void v3h_angle_batch(float *dst, v3h_soa a, v3h_soa b, size_t count, v3_angle_accuracy accuracy);
+
+#endif
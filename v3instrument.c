@@ -0,0 +1,246 @@
+// library inclusions
+#include "v3instrument.h"
+#include <stdlib.h>
+#include <pthread.h>
+
+static const char *probe_names[V3_PROBE_COUNT] = {
+    "v3_from_points", "v3_add", "v3_subtract", "v3_dot_product", "v3_cross_product", "v3_scale", "v3_angle",
+    "v3_angle_quick", "v3_reflect", "v3_length", "v3_normalize", "v3_inv_length", "v3_normalize_fast",
+    "v3_from_points_batch", "v3_add_batch", "v3_subtract_batch", "v3_dot_product_batch", "v3_cross_product_batch",
+    "v3_scale_batch", "v3_reflect_batch", "v3_length_batch", "v3_normalize_batch", "v3_inv_length_batch",
+    "v3_normalize_fast_batch", "v3_angle_batch", "v3_mat3_transform_batch", "v3_mat4_transform_points_batch",
+    "v3_mat4_transform_directions_batch", "v3_transform_normals_batch", "v3_quat_rotate_batch", "v3_ray_triangle_batch",
+    "v3_ray_sphere_batch", "v3_bvh_build_points", "v3_bvh_build_triangles", "v3_bvh_nearest", "v3_bvh_intersect",
+    "v3_sum", "v3_mean", "v3_weighted_sum", "v3_dot_sum", "v3_covariance", "v3_bounds", "v3_oct16_encode_batch",
+    "v3_oct8_encode_batch", "v3_oct16_decode_batch", "v3_oct8_decode_batch", "v3_oct16_dot_product_batch",
+    "v3_oct8_dot_product_batch", "v3_oct16_reflect_batch", "v3_oct8_reflect_batch", "v3d_dot_product_batch",
+    "v3d_length_batch", "v3d_normalize_batch", "v3d_cross_product_batch", "v3d_reflect_batch", "v3d_angle_batch",
+    "v3h_dot_product_batch", "v3h_normalize_batch", "v3h_length_batch", "v3h_cross_product_batch", "v3h_reflect_batch",
+    "v3h_angle_batch", "v3_graph_run", "v3_particles_euler", "v3_particles_verlet", "v3_particles_collide_plane",
+    "v3_particles_collide_sphere", "v3_shade_batch", "v3_camera_tile", "v3_camera_rays"};
+
+// name of the function a probe instruments
+const char *v3_probe_name(v3_probe probe)
+{
+    assert(probe < V3_PROBE_COUNT);
+
+    return probe_names[probe];
+}
+
+#ifdef V3_INSTRUMENT
+
+// counters of one thread, written only by that thread; the block is never
+// freed, so the counts of finished threads stay in the totals
+typedef struct probe_block
+{
+    v3_probe_stats stats[V3_PROBE_COUNT];
+    struct probe_block *next;
+} probe_block;
+
+static pthread_mutex_t blocks_lock = PTHREAD_MUTEX_INITIALIZER;
+static probe_block *blocks = NULL;
+static int block_count = 0;
+static __thread probe_block *thread_block = NULL;
+
+// where the exit report goes, NULL for stderr
+static const char *report_path = NULL;
+
+// the calling thread's block, created and linked in on its first call
+// returns NULL if it cannot be allocated, and the sample is dropped
+static probe_block *local_block()
+{
+    if (thread_block != NULL)
+    {
+        return thread_block;
+    }
+
+    probe_block *block = (probe_block *)aligned_alloc(64, (sizeof(probe_block) + 63) / 64 * 64);
+    if (block == NULL)
+    {
+        return NULL;
+    }
+    memset(block, 0, sizeof(probe_block));
+
+    pthread_mutex_lock(&blocks_lock);
+    block->next = blocks;
+    __atomic_store_n(&blocks, block, __ATOMIC_RELEASE);
+    block_count++;
+    pthread_mutex_unlock(&blocks_lock);
+
+    thread_block = block;
+    return block;
+}
+
+// counter += value by the owning thread; relaxed atomics keep concurrent
+// reads defined without a locked instruction
+static inline void bump(uint64_t *counter, uint64_t value)
+{
+    __atomic_store_n(counter, __atomic_load_n(counter, __ATOMIC_RELAXED) + value, __ATOMIC_RELAXED);
+}
+
+// add one call of probe to the calling thread's counters
+void v3_probe_record(v3_probe probe, uint64_t elements, uint64_t degenerate, uint64_t cycles)
+{
+    probe_block *block = local_block();
+    if (block == NULL)
+    {
+        return;
+    }
+
+    int bucket = 63 - __builtin_clzll(cycles | 1);
+    bucket = (bucket < V3_INSTRUMENT_BUCKETS) ? bucket : V3_INSTRUMENT_BUCKETS - 1;
+
+    v3_probe_stats *s = &block->stats[probe];
+    bump(&s->calls, 1);
+    bump(&s->elements, elements);
+    bump(&s->degenerate, degenerate);
+    bump(&s->cycles, cycles);
+    bump(&s->histogram[bucket], 1);
+}
+
+// whether this build records anything
+bool v3_instrument_enabled(void)
+{
+    return true;
+}
+
+// sum the counters of probe over every thread
+void v3_instrument_read(v3_probe probe, v3_probe_stats *dst)
+{
+    assert(probe < V3_PROBE_COUNT && dst != NULL);
+
+    memset(dst, 0, sizeof(*dst));
+    for (probe_block *block = __atomic_load_n(&blocks, __ATOMIC_ACQUIRE); block != NULL; block = block->next)
+    {
+        const v3_probe_stats *s = &block->stats[probe];
+        dst->calls += __atomic_load_n(&s->calls, __ATOMIC_RELAXED);
+        dst->elements += __atomic_load_n(&s->elements, __ATOMIC_RELAXED);
+        dst->degenerate += __atomic_load_n(&s->degenerate, __ATOMIC_RELAXED);
+        dst->cycles += __atomic_load_n(&s->cycles, __ATOMIC_RELAXED);
+        for (int k = 0; k < V3_INSTRUMENT_BUCKETS; k++)
+        {
+            dst->histogram[k] += __atomic_load_n(&s->histogram[k], __ATOMIC_RELAXED);
+        }
+    }
+}
+
+// zero every thread's counters
+void v3_instrument_reset(void)
+{
+    for (probe_block *block = __atomic_load_n(&blocks, __ATOMIC_ACQUIRE); block != NULL; block = block->next)
+    {
+        uint64_t *counters = (uint64_t *)block->stats;
+        for (size_t i = 0; i < V3_PROBE_COUNT * sizeof(v3_probe_stats) / sizeof(uint64_t); i++)
+        {
+            __atomic_store_n(&counters[i], 0, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+// upper bound in cycles of the bucket holding fraction q of the calls
+static uint64_t histogram_percentile(const v3_probe_stats *s, double q)
+{
+    uint64_t target = (uint64_t)(q * (double)s->calls + 0.5);
+    target = (target > 0) ? target : 1;
+    uint64_t seen = 0;
+    for (int k = 0; k < V3_INSTRUMENT_BUCKETS; k++)
+    {
+        seen += s->histogram[k];
+        if (seen >= target)
+        {
+            return (uint64_t)1 << (k + 1);
+        }
+    }
+    return (uint64_t)1 << V3_INSTRUMENT_BUCKETS;
+}
+
+// print every probe that was called
+void v3_instrument_report(FILE *out)
+{
+    assert(out != NULL);
+
+    pthread_mutex_lock(&blocks_lock);
+    int threads = block_count;
+    pthread_mutex_unlock(&blocks_lock);
+
+    fprintf(out, "v3 instrumentation, %d threads recorded: cycles are tsc ticks, percentiles are histogram bucket "
+            "bounds\n", threads);
+    fprintf(out, "  %-34s %12s %14s %11s %12s %10s %9s %9s\n", "function", "calls", "elements", "degenerate",
+            "cycles/call", "cyc/elem", "p50 <", "p99 <");
+    for (int p = 0; p < V3_PROBE_COUNT; p++)
+    {
+        v3_probe_stats s;
+        v3_instrument_read((v3_probe)p, &s);
+        if (s.calls == 0)
+        {
+            continue;
+        }
+        double per_element = (s.elements > 0) ? (double)s.cycles / (double)s.elements : 0.0;
+        fprintf(out, "  %-34s %12llu %14llu %11llu %12.1f %10.2f %9llu %9llu\n", probe_names[p],
+                (unsigned long long)s.calls, (unsigned long long)s.elements, (unsigned long long)s.degenerate,
+                (double)s.cycles / (double)s.calls, per_element,
+                (unsigned long long)histogram_percentile(&s, 0.5), (unsigned long long)histogram_percentile(&s, 0.99));
+    }
+}
+
+// print the report where V3MATH_INSTRUMENT asks
+static void report_at_exit(void)
+{
+    if (report_path == NULL)
+    {
+        v3_instrument_report(stderr);
+        return;
+    }
+
+    FILE *out = fopen(report_path, "w");
+    if (out == NULL)
+    {
+        fprintf(stderr, "Error: Cannot open %s for the instrumentation report\n", report_path);
+        return;
+    }
+    v3_instrument_report(out);
+    fclose(out);
+}
+
+// pick up V3MATH_INSTRUMENT before main
+__attribute__((constructor))
+static void init_instrument_report(void)
+{
+    const char *requested = getenv("V3MATH_INSTRUMENT");
+    if (requested != NULL && strcmp(requested, "off") == 0)
+    {
+        return;
+    }
+
+    report_path = (requested != NULL && requested[0] != '\0') ? requested : NULL;
+    atexit(report_at_exit);
+}
+
+#else
+
+// whether this build records anything
+bool v3_instrument_enabled(void)
+{
+    return false;
+}
+
+// nothing is recorded without V3_INSTRUMENT
+void v3_instrument_read(v3_probe probe, v3_probe_stats *dst)
+{
+    assert(probe < V3_PROBE_COUNT && dst != NULL);
+
+    memset(dst, 0, sizeof(*dst));
+}
+
+void v3_instrument_reset(void)
+{
+}
+
+void v3_instrument_report(FILE *out)
+{
+    assert(out != NULL);
+
+    fprintf(out, "v3 instrumentation is not compiled in, rebuild with -DV3_INSTRUMENT\n");
+}
+
+#endif
@@ -0,0 +1,172 @@
+#ifndef V3INSTRUMENT_H
+#define V3INSTRUMENT_H
+
+// library inclusions
+#include "v3math.h"
+
+// opt-in instrumentation of the library entry points
+//
+// building every source with -DV3_INSTRUMENT (make instrument) makes each
+// v3math.h scalar and batch function, and the batch entry points of the other
+// modules, count its calls, the elements it processed, the degenerate inputs
+// it saw and its duration in tsc cycles, into a log2 histogram. degenerate
+// inputs are the zero length vectors reaching the scalar functions that test
+// for them and the batch functions that normalize. counters live in a block
+// per thread that only that thread writes, so the hot path takes no lock and
+// shares no cache line; reading sums the blocks of every thread that ever
+// recorded, including finished ones
+//
+// the restrict forms count as the function they are a form of. a module entry
+// point counts on top of the v3math.h batch functions it calls, and the pool
+// and graph tiles that run the normalize kernel directly count as
+// v3_normalize_batch calls like the tiles of their other operations
+//
+// without V3_INSTRUMENT the probes expand to nothing and the functions below
+// report that nothing was recorded
+//
+// the report is printed at exit to stderr, to the file named by
+// V3MATH_INSTRUMENT=path, or not at all with V3MATH_INSTRUMENT=off
+
+// log2 buckets of the cycle histogram, bucket k counts calls of [2^k, 2^(k+1))
+// cycles, the last one everything longer
+#define V3_INSTRUMENT_BUCKETS 32
+
+// instrumented entry points
+typedef enum
+{
+    V3_PROBE_FROM_POINTS,
+    V3_PROBE_ADD,
+    V3_PROBE_SUBTRACT,
+    V3_PROBE_DOT_PRODUCT,
+    V3_PROBE_CROSS_PRODUCT,
+    V3_PROBE_SCALE,
+    V3_PROBE_ANGLE,
+    V3_PROBE_ANGLE_QUICK,
+    V3_PROBE_REFLECT,
+    V3_PROBE_LENGTH,
+    V3_PROBE_NORMALIZE,
+    V3_PROBE_INV_LENGTH,
+    V3_PROBE_NORMALIZE_FAST,
+    V3_PROBE_FROM_POINTS_BATCH,
+    V3_PROBE_ADD_BATCH,
+    V3_PROBE_SUBTRACT_BATCH,
+    V3_PROBE_DOT_PRODUCT_BATCH,
+    V3_PROBE_CROSS_PRODUCT_BATCH,
+    V3_PROBE_SCALE_BATCH,
+    V3_PROBE_REFLECT_BATCH,
+    V3_PROBE_LENGTH_BATCH,
+    V3_PROBE_NORMALIZE_BATCH,
+    V3_PROBE_INV_LENGTH_BATCH,
+    V3_PROBE_NORMALIZE_FAST_BATCH,
+    V3_PROBE_ANGLE_BATCH,
+
+    // entry points of the other modules
+    V3_PROBE_MAT3_TRANSFORM_BATCH,
+    V3_PROBE_MAT4_TRANSFORM_POINTS_BATCH,
+    V3_PROBE_MAT4_TRANSFORM_DIRECTIONS_BATCH,
+    V3_PROBE_TRANSFORM_NORMALS_BATCH,
+    V3_PROBE_QUAT_ROTATE_BATCH,
+    V3_PROBE_RAY_TRIANGLE_BATCH,
+    V3_PROBE_RAY_SPHERE_BATCH,
+    V3_PROBE_BVH_BUILD_POINTS,
+    V3_PROBE_BVH_BUILD_TRIANGLES,
+    V3_PROBE_BVH_NEAREST,
+    V3_PROBE_BVH_INTERSECT,
+    V3_PROBE_SUM,
+    V3_PROBE_MEAN,
+    V3_PROBE_WEIGHTED_SUM,
+    V3_PROBE_DOT_SUM,
+    V3_PROBE_COVARIANCE,
+    V3_PROBE_BOUNDS,
+    V3_PROBE_OCT16_ENCODE_BATCH,
+    V3_PROBE_OCT8_ENCODE_BATCH,
+    V3_PROBE_OCT16_DECODE_BATCH,
+    V3_PROBE_OCT8_DECODE_BATCH,
+    V3_PROBE_OCT16_DOT_PRODUCT_BATCH,
+    V3_PROBE_OCT8_DOT_PRODUCT_BATCH,
+    V3_PROBE_OCT16_REFLECT_BATCH,
+    V3_PROBE_OCT8_REFLECT_BATCH,
+    V3_PROBE_DOUBLE_DOT_PRODUCT_BATCH,
+    V3_PROBE_DOUBLE_LENGTH_BATCH,
+    V3_PROBE_DOUBLE_NORMALIZE_BATCH,
+    V3_PROBE_DOUBLE_CROSS_PRODUCT_BATCH,
+    V3_PROBE_DOUBLE_REFLECT_BATCH,
+    V3_PROBE_DOUBLE_ANGLE_BATCH,
+    V3_PROBE_HALF_DOT_PRODUCT_BATCH,
+    V3_PROBE_HALF_NORMALIZE_BATCH,
+    V3_PROBE_HALF_LENGTH_BATCH,
+    V3_PROBE_HALF_CROSS_PRODUCT_BATCH,
+    V3_PROBE_HALF_REFLECT_BATCH,
+    V3_PROBE_HALF_ANGLE_BATCH,
+    V3_PROBE_GRAPH_RUN,
+    V3_PROBE_PARTICLES_EULER,
+    V3_PROBE_PARTICLES_VERLET,
+    V3_PROBE_PARTICLES_COLLIDE_PLANE,
+    V3_PROBE_PARTICLES_COLLIDE_SPHERE,
+    V3_PROBE_SHADE_BATCH,
+    V3_PROBE_CAMERA_TILE,
+    V3_PROBE_CAMERA_RAYS,
+    V3_PROBE_COUNT
+} v3_probe;
+
+// counters of one entry point summed over every thread
+typedef struct
+{
+    uint64_t calls;
+    uint64_t elements;
+    uint64_t degenerate;
+    uint64_t cycles;
+    uint64_t histogram[V3_INSTRUMENT_BUCKETS];
+} v3_probe_stats;
+
+#ifdef V3_INSTRUMENT
+
+// library inclusions
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define V3_PROBE_CLOCK() __rdtsc()
+#else
+#include <time.h>
+
+// off x86 the probes count nanoseconds of the monotonic clock for tsc cycles
+static inline uint64_t v3_probe_clock(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+#define V3_PROBE_CLOCK() v3_probe_clock()
+#endif
+
+// add one call of probe to the calling thread's counters
+void v3_probe_record(v3_probe probe, uint64_t elements, uint64_t degenerate, uint64_t cycles);
+
+// open a probe at the top of a function and close it before every return
+#define V3_PROBE_BEGIN() uint64_t v3_probe_start = V3_PROBE_CLOCK()
+#define V3_PROBE_END(probe, elements, degenerate) \
+    v3_probe_record(probe, elements, degenerate, V3_PROBE_CLOCK() - v3_probe_start)
+
+#else
+
+#define V3_PROBE_BEGIN() ((void)0)
+#define V3_PROBE_END(probe, elements, degenerate) ((void)0)
+
+#endif
+
+// whether this build records anything
+bool v3_instrument_enabled(void);
+
+// name of the function a probe instruments
+const char *v3_probe_name(v3_probe probe);
+
+// sum the counters of probe over every thread into dst, all zero when compiled out
+void v3_instrument_read(v3_probe probe, v3_probe_stats *dst);
+
+// zero every thread's counters; calls running meanwhile may survive the reset
+void v3_instrument_reset(void);
+
+// print calls, elements, degenerate inputs and cycles of every probe that was
+// called, with the median and 99th percentile from the histogram
+void v3_instrument_report(FILE *out);
+
+#endif
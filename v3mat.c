@@ -0,0 +1,329 @@
+// library inclusions
+#include "v3mat.h"
+#include "v3simd.h"
+#include "v3instrument.h"
+
+// vectors per step of the normal transform, small enough for l1
+#define NORMAL_TILE 256
+
+// set a matrix to identity
+void v3_mat3_identity(v3_mat3 *dst)
+{
+    assert(dst != NULL);
+
+    memset(dst->m, 0, sizeof(dst->m));
+    dst->m[0] = dst->m[4] = dst->m[8] = 1.0f;
+}
+
+void v3_mat4_identity(v3_mat4 *dst)
+{
+    assert(dst != NULL);
+
+    memset(dst->m, 0, sizeof(dst->m));
+    dst->m[0] = dst->m[5] = dst->m[10] = dst->m[15] = 1.0f;
+}
+
+// translation by t
+void v3_mat4_translation(v3_mat4 *dst, float *t)
+{
+    assert(dst != NULL && t != NULL);
+
+    v3_mat4_identity(dst);
+    dst->m[3] = t[0];
+    dst->m[7] = t[1];
+    dst->m[11] = t[2];
+}
+
+// scaling along the axes
+void v3_mat4_scaling(v3_mat4 *dst, float *s)
+{
+    assert(dst != NULL && s != NULL);
+
+    v3_mat4_identity(dst);
+    dst->m[0] = s[0];
+    dst->m[5] = s[1];
+    dst->m[10] = s[2];
+}
+
+// rotation about an axis (rodrigues)
+// R = cos(a) I + sin(a) [k]x + (1 - cos(a)) k k^T for the unit axis k
+bool v3_mat4_rotation(v3_mat4 *dst, float *axis, float angle)
+{
+    assert(dst != NULL && axis != NULL);
+
+    v3_mat4_identity(dst);
+    if (v3_length(axis) < V3_EPSILON)
+    {
+        return false;
+    }
+
+    float k[3];
+    v3_normalize(k, axis);
+    float c = cosf(angle);
+    float s = sinf(angle);
+    float t = 1.0f - c;
+
+    dst->m[0] = c + t * k[0] * k[0];
+    dst->m[1] = t * k[0] * k[1] - s * k[2];
+    dst->m[2] = t * k[0] * k[2] + s * k[1];
+    dst->m[4] = t * k[1] * k[0] + s * k[2];
+    dst->m[5] = c + t * k[1] * k[1];
+    dst->m[6] = t * k[1] * k[2] - s * k[0];
+    dst->m[8] = t * k[2] * k[0] - s * k[1];
+    dst->m[9] = t * k[2] * k[1] + s * k[0];
+    dst->m[10] = c + t * k[2] * k[2];
+    return true;
+}
+
+// multiply two 3x3 matrices
+// dst = a * b
+void v3_mat3_multiply(v3_mat3 *dst, const v3_mat3 *a, const v3_mat3 *b)
+{
+    assert(dst != NULL && a != NULL && b != NULL);
+
+    // use temporary storage to handle overlapping memory
+    v3_mat3 temp;
+    for (int row = 0; row < 3; row++)
+    {
+        for (int col = 0; col < 3; col++)
+        {
+            temp.m[row * 3 + col] = a->m[row * 3] * b->m[col] +
+                                    a->m[row * 3 + 1] * b->m[3 + col] +
+                                    a->m[row * 3 + 2] * b->m[6 + col];
+        }
+    }
+
+    *dst = temp;
+}
+
+// multiply two 4x4 matrices
+// dst = a * b
+void v3_mat4_multiply(v3_mat4 *dst, const v3_mat4 *a, const v3_mat4 *b)
+{
+    assert(dst != NULL && a != NULL && b != NULL);
+
+    v3_mat4 temp;
+    for (int row = 0; row < 4; row++)
+    {
+        for (int col = 0; col < 4; col++)
+        {
+            temp.m[row * 4 + col] = a->m[row * 4] * b->m[col] +
+                                    a->m[row * 4 + 1] * b->m[4 + col] +
+                                    a->m[row * 4 + 2] * b->m[8 + col] +
+                                    a->m[row * 4 + 3] * b->m[12 + col];
+        }
+    }
+
+    *dst = temp;
+}
+
+// compose a chain of transforms into one matrix
+// dst = transforms[count - 1] * ... * transforms[0]
+void v3_mat4_compose(v3_mat4 *dst, const v3_mat4 *transforms, size_t count)
+{
+    assert(dst != NULL && (transforms != NULL || count == 0));
+
+    v3_mat4 result;
+    v3_mat4_identity(&result);
+    for (size_t i = 0; i < count; i++)
+    {
+        v3_mat4_multiply(&result, &transforms[i], &result);
+    }
+
+    *dst = result;
+}
+
+// invert a 3x3 matrix with the adjugate
+// dst = adj(m) / det(m)
+bool v3_mat3_inverse(v3_mat3 *dst, const v3_mat3 *m)
+{
+    assert(dst != NULL && m != NULL);
+
+    const float *a = m->m;
+    float c0 = a[4] * a[8] - a[5] * a[7];
+    float c1 = a[5] * a[6] - a[3] * a[8];
+    float c2 = a[3] * a[7] - a[4] * a[6];
+    float det = a[0] * c0 + a[1] * c1 + a[2] * c2;
+
+    // relative to the matrix scale so uniformly small matrices still invert
+    float scale = 0.0f;
+    for (int i = 0; i < 9; i++)
+    {
+        scale = fmaxf(scale, fabsf(a[i]));
+    }
+    if (fabsf(det) <= V3_EPSILON * scale * scale * scale)
+    {
+        return false;
+    }
+
+    float inv_det = 1.0f / det;
+    v3_mat3 temp;
+    temp.m[0] = c0 * inv_det;
+    temp.m[1] = (a[2] * a[7] - a[1] * a[8]) * inv_det;
+    temp.m[2] = (a[1] * a[5] - a[2] * a[4]) * inv_det;
+    temp.m[3] = c1 * inv_det;
+    temp.m[4] = (a[0] * a[8] - a[2] * a[6]) * inv_det;
+    temp.m[5] = (a[2] * a[3] - a[0] * a[5]) * inv_det;
+    temp.m[6] = c2 * inv_det;
+    temp.m[7] = (a[1] * a[6] - a[0] * a[7]) * inv_det;
+    temp.m[8] = (a[0] * a[4] - a[1] * a[3]) * inv_det;
+
+    *dst = temp;
+    return true;
+}
+
+// normal matrix, inverse transpose of the upper 3x3
+bool v3_mat4_normal_matrix(v3_mat3 *dst, const v3_mat4 *m)
+{
+    assert(dst != NULL && m != NULL);
+
+    v3_mat3 upper = {{m->m[0], m->m[1], m->m[2], m->m[4], m->m[5], m->m[6], m->m[8], m->m[9], m->m[10]}};
+    v3_mat3 inverse;
+    if (!v3_mat3_inverse(&inverse, &upper))
+    {
+        return false;
+    }
+
+    for (int row = 0; row < 3; row++)
+    {
+        for (int col = 0; col < 3; col++)
+        {
+            dst->m[row * 3 + col] = inverse.m[col * 3 + row];
+        }
+    }
+    return true;
+}
+
+// expand a 3x3 matrix, or the upper 3x4 of a 4x4 without its translation,
+// into the 3x4 layout of the transform kernel
+static void linear_rows(float *rows, const float *m, int stride)
+{
+    for (int row = 0; row < 3; row++)
+    {
+        rows[row * 4] = m[row * stride];
+        rows[row * 4 + 1] = m[row * stride + 1];
+        rows[row * 4 + 2] = m[row * stride + 2];
+        rows[row * 4 + 3] = 0.0f;
+    }
+}
+
+// transform one vector through the 3x4 kernel layout
+// dst = rows * v + translation, evaluated like the batch kernels
+static void transform_rows(float *dst, const float *rows, float *v)
+{
+    float x = v[0], y = v[1], z = v[2];
+
+    dst[0] = rows[0] * x + rows[1] * y + rows[2] * z + rows[3];
+    dst[1] = rows[4] * x + rows[5] * y + rows[6] * z + rows[7];
+    dst[2] = rows[8] * x + rows[9] * y + rows[10] * z + rows[11];
+}
+
+// transform a vector by a 3x3 matrix
+// dst = m * v
+void v3_mat3_transform(float *dst, const v3_mat3 *m, float *v)
+{
+    assert(dst != NULL && m != NULL && v != NULL);
+
+    float rows[12];
+    linear_rows(rows, m->m, 3);
+    transform_rows(dst, rows, v);
+}
+
+// transform a point
+// dst = m * p + translation
+void v3_mat4_transform_point(float *dst, const v3_mat4 *m, float *p)
+{
+    assert(dst != NULL && m != NULL && p != NULL);
+
+    transform_rows(dst, m->m, p);
+}
+
+// transform a direction
+// dst = m * d
+void v3_mat4_transform_direction(float *dst, const v3_mat4 *m, float *d)
+{
+    assert(dst != NULL && m != NULL && d != NULL);
+
+    float rows[12];
+    linear_rows(rows, m->m, 4);
+    transform_rows(dst, rows, d);
+}
+
+// transform vectors by a 3x3 matrix
+// dst[i] = m * v[i]
+void v3_mat3_transform_batch(v3_soa dst, const v3_mat3 *m, v3_soa v, size_t count)
+{
+    assert(dst.x != NULL && dst.y != NULL && dst.z != NULL);
+    assert(v.x != NULL && v.y != NULL && v.z != NULL);
+    assert(m != NULL);
+    V3_PROBE_BEGIN();
+
+    float rows[12];
+    linear_rows(rows, m->m, 3);
+    v3_get_kernels()->transform(dst, rows, v, count);
+
+    V3_PROBE_END(V3_PROBE_MAT3_TRANSFORM_BATCH, count, 0);
+}
+
+// transform points, the first three rows of a v3_mat4 are the kernel layout as they are
+// dst[i] = m * p[i] + translation
+void v3_mat4_transform_points_batch(v3_soa dst, const v3_mat4 *m, v3_soa p, size_t count)
+{
+    assert(dst.x != NULL && dst.y != NULL && dst.z != NULL);
+    assert(p.x != NULL && p.y != NULL && p.z != NULL);
+    assert(m != NULL);
+    V3_PROBE_BEGIN();
+
+    v3_get_kernels()->transform(dst, m->m, p, count);
+
+    V3_PROBE_END(V3_PROBE_MAT4_TRANSFORM_POINTS_BATCH, count, 0);
+}
+
+// transform directions
+// dst[i] = m * d[i]
+void v3_mat4_transform_directions_batch(v3_soa dst, const v3_mat4 *m, v3_soa d, size_t count)
+{
+    assert(dst.x != NULL && dst.y != NULL && dst.z != NULL);
+    assert(d.x != NULL && d.y != NULL && d.z != NULL);
+    assert(m != NULL);
+    V3_PROBE_BEGIN();
+
+    float rows[12];
+    linear_rows(rows, m->m, 4);
+    v3_get_kernels()->transform(dst, rows, d, count);
+
+    V3_PROBE_END(V3_PROBE_MAT4_TRANSFORM_DIRECTIONS_BATCH, count, 0);
+}
+
+// transform and renormalize normals in l1 sized tiles, so each tile is
+// normalized while it is still in cache
+// dst[i] = normalize(normal_matrix * n[i])
+void v3_transform_normals_batch(v3_soa dst, const v3_mat3 *normal_matrix, v3_soa n, size_t count)
+{
+    assert(dst.x != NULL && dst.y != NULL && dst.z != NULL);
+    assert(n.x != NULL && n.y != NULL && n.z != NULL);
+    assert(normal_matrix != NULL);
+    V3_PROBE_BEGIN();
+
+    float rows[12];
+    linear_rows(rows, normal_matrix->m, 3);
+    const v3_kernels *kernels = v3_get_kernels();
+
+    size_t degenerate = 0;
+    for (size_t start = 0; start < count; start += NORMAL_TILE)
+    {
+        size_t tile = (count - start < NORMAL_TILE) ? count - start : NORMAL_TILE;
+        v3_soa out = {dst.x + start, dst.y + start, dst.z + start};
+        v3_soa in = {n.x + start, n.y + start, n.z + start};
+        kernels->transform(out, rows, in, tile);
+        degenerate += kernels->normalize(out, out, tile);
+    }
+
+    // report once per batch rather than once per tile
+    if (degenerate > 0)
+    {
+        v3_report_error(V3_SOURCE_NORMALIZE_BATCH, "Cannot normalize zero length vector", degenerate);
+    }
+
+    V3_PROBE_END(V3_PROBE_TRANSFORM_NORMALS_BATCH, count, degenerate);
+}
@@ -0,0 +1,80 @@
+#ifndef V3MAT_H
+#define V3MAT_H
+
+// library inclusions
+#include "v3math.h"
+
+// 3x3 and 4x4 matrices for transforming vectors
+//
+// matrices are row-major and act on column vectors: p' = M p, so m[row * 4 + 3]
+// holds the translation of a v3_mat4. a v3_mat4 is treated as affine, its bottom
+// row is ignored. compose a chain of transforms into one matrix with
+// v3_mat4_multiply or v3_mat4_compose and apply it to a batch in a single pass
+
+// 3x3 matrix, m[row * 3 + col]
+typedef struct
+{
+    float m[9];
+} v3_mat3;
+
+// 4x4 matrix, m[row * 4 + col]
+typedef struct
+{
+    float m[16];
+} v3_mat4;
+
+// set a matrix to identity
+void v3_mat3_identity(v3_mat3 *dst);
+void v3_mat4_identity(v3_mat4 *dst);
+
+// translation by t
+void v3_mat4_translation(v3_mat4 *dst, float *t);
+
+// scaling by s[0], s[1], s[2] along x, y and z
+void v3_mat4_scaling(v3_mat4 *dst, float *s);
+
+// rotation by angle radians counterclockwise about axis, which is normalized with v3_normalize
+// returns false and sets identity for a zero length axis
+bool v3_mat4_rotation(v3_mat4 *dst, float *axis, float angle);
+
+// matrix product, b is applied first: dst = a * b
+// dst may be a or b
+void v3_mat3_multiply(v3_mat3 *dst, const v3_mat3 *a, const v3_mat3 *b);
+void v3_mat4_multiply(v3_mat4 *dst, const v3_mat4 *a, const v3_mat4 *b);
+
+// compose count transforms applied in order: dst = transforms[count - 1] * ... * transforms[0]
+void v3_mat4_compose(v3_mat4 *dst, const v3_mat4 *transforms, size_t count);
+
+// inverse of a 3x3 matrix
+// returns false and leaves dst unchanged if m is singular
+bool v3_mat3_inverse(v3_mat3 *dst, const v3_mat3 *m);
+
+// normal matrix of a transform, the inverse transpose of its upper 3x3
+// returns false and leaves dst unchanged if that block is singular
+bool v3_mat4_normal_matrix(v3_mat3 *dst, const v3_mat4 *m);
+
+// transform one vector by a 3x3 matrix
+void v3_mat3_transform(float *dst, const v3_mat3 *m, float *v);
+
+// transform one point, translation included
+void v3_mat4_transform_point(float *dst, const v3_mat4 *m, float *p);
+
+// transform one direction, translation ignored
+void v3_mat4_transform_direction(float *dst, const v3_mat4 *m, float *d);
+
+// batch transforms, dst may be the input arrays (in-place)
+
+// dst[i] = m * v[i]
+void v3_mat3_transform_batch(v3_soa dst, const v3_mat3 *m, v3_soa v, size_t count);
+
+// dst[i] = m * p[i] + translation
+void v3_mat4_transform_points_batch(v3_soa dst, const v3_mat4 *m, v3_soa p, size_t count);
+
+// dst[i] = m * d[i]
+void v3_mat4_transform_directions_batch(v3_soa dst, const v3_mat4 *m, v3_soa d, size_t count);
+
+// dst[i] = normalize(normal_matrix * n[i]), see v3_mat4_normal_matrix
+// zero length results are reported once per batch, as in v3_normalize_batch
+void v3_transform_normals_batch(v3_soa dst, const v3_mat3 *normal_matrix, v3_soa n, size_t count);
+
+#endif
@@ -1,14 +1,180 @@
 // library inclusions
 #include "v3math.h"
+#include "v3simd.h"
+#include "v3instrument.h"
+#include <stdlib.h>
+#include <pthread.h>
 
 // define the tolerance for floating point comparisons
-#define EPSILON 1e-6f
+#define EPSILON V3_EPSILON
+
+// error counters padded to a cache line each so threads hitting
+// different functions do not contend
+typedef struct
+{
+    uint64_t count;
+    char padding[64 - sizeof(uint64_t)];
+} error_counter;
+
+// a callback with its user data, never changed once published
+typedef struct error_handler
+{
+    v3_error_callback callback;
+    void *user_data;
+    struct error_handler *next;
+} error_handler;
+
+static v3_error_policy error_policy = V3_ERROR_SILENT;
+// reporters load the current pair with one acquire and take no lock; every
+// distinct pair is kept on error_handlers for the life of the process, so a
+// reporter may still call through one after it is replaced, and setting a
+// pair registered before allocates nothing
+static error_handler *error_handler_current = NULL;
+static error_handler *error_handlers = NULL;
+static pthread_mutex_t error_handlers_lock = PTHREAD_MUTEX_INITIALIZER;
+static error_counter error_counters[V3_SOURCE_COUNT];
+
+// pick up V3MATH_ERRORS before main
+__attribute__((constructor))
+static void init_error_policy(void)
+{
+    const char *requested = getenv("V3MATH_ERRORS");
+    if (requested == NULL)
+    {
+        return;
+    }
+
+    if (strcmp(requested, "silent") == 0)
+    {
+        error_policy = V3_ERROR_SILENT;
+    }
+    else if (strcmp(requested, "count") == 0)
+    {
+        error_policy = V3_ERROR_COUNT;
+    }
+    else if (strcmp(requested, "print") == 0)
+    {
+        error_policy = V3_ERROR_PRINT;
+    }
+    else
+    {
+        fprintf(stderr, "Error: V3MATH_ERRORS=%s is not a valid policy\n", requested);
+    }
+}
+
+// report count bad elements from source according to the current policy
+// kept out of line so the error check costs the callers one compare
+__attribute__((noinline, cold))
+void v3_report_error(v3_error_source source, const char *message, uint64_t count)
+{
+    switch (__atomic_load_n(&error_policy, __ATOMIC_RELAXED))
+    {
+        case V3_ERROR_SILENT:
+            break;
+        case V3_ERROR_COUNT:
+            __atomic_fetch_add(&error_counters[source].count, count, __ATOMIC_RELAXED);
+            break;
+        case V3_ERROR_CALLBACK:
+        {
+            const error_handler *handler = __atomic_load_n(&error_handler_current, __ATOMIC_ACQUIRE);
+            if (handler != NULL)
+            {
+                handler->callback(source, message, count, handler->user_data);
+            }
+            break;
+        }
+        case V3_ERROR_PRINT:
+            fprintf(stderr, "Error: %s\n", message);
+            errno = EINVAL;
+            break;
+    }
+}
+
+// select how errors are reported
+void v3_set_error_policy(v3_error_policy policy)
+{
+    assert(policy >= V3_ERROR_SILENT && policy <= V3_ERROR_PRINT);
+
+    __atomic_store_n(&error_policy, policy, __ATOMIC_RELAXED);
+}
+
+// get the current error policy
+v3_error_policy v3_get_error_policy(void)
+{
+    return __atomic_load_n(&error_policy, __ATOMIC_RELAXED);
+}
+
+// set the callback used by V3_ERROR_CALLBACK
+bool v3_set_error_callback(v3_error_callback callback, void *user_data)
+{
+    if (callback == NULL)
+    {
+        __atomic_store_n(&error_handler_current, (error_handler *)NULL, __ATOMIC_RELEASE);
+        return true;
+    }
+
+    pthread_mutex_lock(&error_handlers_lock);
+    error_handler *handler = error_handlers;
+    while (handler != NULL && (handler->callback != callback || handler->user_data != user_data))
+    {
+        handler = handler->next;
+    }
+    if (handler == NULL)
+    {
+        handler = (error_handler *)malloc(sizeof(error_handler));
+        if (handler == NULL)
+        {
+            pthread_mutex_unlock(&error_handlers_lock);
+            errno = ENOMEM;
+            return false;
+        }
+        handler->callback = callback;
+        handler->user_data = user_data;
+        handler->next = error_handlers;
+        error_handlers = handler;
+    }
+
+    // the release store publishes the fields written above with the pointer
+    __atomic_store_n(&error_handler_current, handler, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&error_handlers_lock);
+    return true;
+}
+
+// get the number of errors counted for a function
+uint64_t v3_error_count(v3_error_source source)
+{
+    assert(source < V3_SOURCE_COUNT);
+
+    return __atomic_load_n(&error_counters[source].count, __ATOMIC_RELAXED);
+}
+
+// reset all error counters to zero
+void v3_reset_error_counts(void)
+{
+    for (int i = 0; i < V3_SOURCE_COUNT; i++)
+    {
+        __atomic_store_n(&error_counters[i].count, 0, __ATOMIC_RELAXED);
+    }
+}
+
+// the scalar functions use these rather than each other, so every call
+// an instrumented build counts is one the caller made
+static inline float dot3(const float *a, const float *b)
+{
+    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+static inline float length3(const float *a)
+{
+    return sqrtf(dot3(a, a));
+}
 
 // form a vector from point a to point b
 // dst = b - a
 void v3_from_points(float *dst, float *a, float *b)
 {
     assert(dst != NULL && a != NULL && b != NULL);
+    V3_PROBE_BEGIN();
 
     // handle overlapping memory by using temporary storage
     float temp[3];
@@ -19,6 +185,8 @@ void v3_from_points(float *dst, float *a, float *b)
     dst[0] = temp[0];
     dst[1] = temp[1];
     dst[2] = temp[2];
+
+    V3_PROBE_END(V3_PROBE_FROM_POINTS, 1, 0);
 }
 
 // add two vectors
@@ -26,6 +194,7 @@ void v3_from_points(float *dst, float *a, float *b)
 void v3_add(float *dst, float *a, float *b)
 {
     assert(dst != NULL && a != NULL && b != NULL);
+    V3_PROBE_BEGIN();
 
     float temp[3];
     temp[0] = a[0] + b[0];
@@ -35,6 +204,8 @@ void v3_add(float *dst, float *a, float *b)
     dst[0] = temp[0];
     dst[1] = temp[1];
     dst[2] = temp[2];
+
+    V3_PROBE_END(V3_PROBE_ADD, 1, 0);
 }
 
 // subtract vector b from vector a
@@ -42,6 +213,7 @@ void v3_add(float *dst, float *a, float *b)
 void v3_subtract(float *dst, float *a, float *b)
 {
     assert(dst != NULL && a != NULL && b != NULL);
+    V3_PROBE_BEGIN();
     
     float temp[3];
     temp[0] = a[0] - b[0];
@@ -51,6 +223,8 @@ void v3_subtract(float *dst, float *a, float *b)
     dst[0] = temp[0];
     dst[1] = temp[1];
     dst[2] = temp[2];
+
+    V3_PROBE_END(V3_PROBE_SUBTRACT, 1, 0);
 }
 
 // calculate dot product of two vectors
@@ -58,8 +232,12 @@ void v3_subtract(float *dst, float *a, float *b)
 float v3_dot_product(float *a, float *b)
 {
     assert(a != NULL && b != NULL);
-    
-    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+    V3_PROBE_BEGIN();
+
+    float dot = dot3(a, b);
+
+    V3_PROBE_END(V3_PROBE_DOT_PRODUCT, 1, 0);
+    return dot;
 }
 
 // calculate cross product of two vectors
@@ -67,6 +245,7 @@ float v3_dot_product(float *a, float *b)
 void v3_cross_product(float *dst, float *a, float *b)
 {
     assert(dst != NULL && a != NULL && b != NULL);
+    V3_PROBE_BEGIN();
     
     // use temporary storage to handle overlapping memory
     float temp[3];
@@ -77,6 +256,8 @@ void v3_cross_product(float *dst, float *a, float *b)
     dst[0] = temp[0];
     dst[1] = temp[1];
     dst[2] = temp[2];
+
+    V3_PROBE_END(V3_PROBE_CROSS_PRODUCT, 1, 0);
 }
 
 // scale a vector by scalar s in-place
@@ -84,10 +265,35 @@ void v3_cross_product(float *dst, float *a, float *b)
 void v3_scale(float *dst, float s)
 {
     assert(dst != NULL);
+    V3_PROBE_BEGIN();
 
     dst[0] *= s;
     dst[1] *= s;
     dst[2] *= s;
+
+    V3_PROBE_END(V3_PROBE_SCALE, 1, 0);
+}
+
+// cosine of the angle between two vectors, clamped to [-1, 1]
+// returns false for a zero length vector
+static bool angle_cosine(float *a, float *b, float *cos_angle)
+{
+    float len_a = length3(a);
+    float len_b = length3(b);
+
+    // check for zero length vectors
+    if (len_a < EPSILON || len_b < EPSILON)
+    {
+        return false;
+    }
+
+    float dot = dot3(a, b);
+    *cos_angle = dot / (len_a * len_b);
+
+    // clamp to [-1, 1] to avoid numerical errors with acos
+    if (*cos_angle > 1.0f) *cos_angle = 1.0f;
+    if (*cos_angle < -1.0f) *cos_angle = -1.0f;
+    return true;
 }
 
 // calculate angle between two vectors in radians
@@ -95,26 +301,20 @@ void v3_scale(float *dst, float s)
 float v3_angle(float *a, float *b)
 {
     assert(a != NULL && b != NULL);
-    
-    float len_a = v3_length(a);
-    float len_b = v3_length(b);
+    V3_PROBE_BEGIN();
 
-    // check for zero length vectors
-    if (len_a < EPSILON || len_b < EPSILON)
+    float cos_angle;
+    if (!angle_cosine(a, b, &cos_angle))
     {
-        fprintf(stderr, "Error: Cannot compute angle with zero length vector\n");
-        errno = EINVAL;
+        v3_report_error(V3_SOURCE_ANGLE, "Cannot compute angle with zero length vector", 1);
+        V3_PROBE_END(V3_PROBE_ANGLE, 1, 1);
         return 0.0f;
     }
 
-    float dot = v3_dot_product(a, b);
-    float cos_angle = dot / (len_a * len_b);
-
-    // clamp to [-1, 1] to avoid numerical errors with acos
-    if (cos_angle > 1.0f) cos_angle = 1.0f;
-    if (cos_angle < -1.0f) cos_angle = -1.0f;
+    float angle = acosf(cos_angle);
 
-    return acosf(cos_angle);
+    V3_PROBE_END(V3_PROBE_ANGLE, 1, 0);
+    return angle;
 }
 
 // calculate angle between two vectors without inverse cosine
@@ -122,26 +322,18 @@ float v3_angle(float *a, float *b)
 float v3_angle_quick(float *a, float *b)
 {
     assert(a != NULL && b != NULL);
+    V3_PROBE_BEGIN();
 
-    float len_a = v3_length(a);
-    float len_b = v3_length(b);
-
-    // check for zero length vectors
-    if (len_a < EPSILON || len_b < EPSILON)
+    float cos_angle;
+    if (!angle_cosine(a, b, &cos_angle))
     {
-        fprintf(stderr, "Error: Cannot compute angle with zero length vector\n");
-        errno = EINVAL;
+        v3_report_error(V3_SOURCE_ANGLE_QUICK, "Cannot compute angle with zero length vector", 1);
+        V3_PROBE_END(V3_PROBE_ANGLE_QUICK, 1, 1);
         // cos(0) = 1
         return 1.0f;
     }
 
-    float dot = v3_dot_product(a, b);
-    float cos_angle = dot / (len_a * len_b);
-
-    // clamp to [-1, 1]
-    if (cos_angle > 1.0f) cos_angle = 1.0f;
-    if (cos_angle < -1.0f) cos_angle = -1.0f;
-
+    V3_PROBE_END(V3_PROBE_ANGLE_QUICK, 1, 0);
     return cos_angle;
 }
 
@@ -151,8 +343,9 @@ float v3_angle_quick(float *a, float *b)
 void v3_reflect(float *dst, float *v, float *n)
 {
     assert(dst != NULL && v != NULL && n != NULL);
+    V3_PROBE_BEGIN();
 
-    float dot = v3_dot_product(v, n);
+    float dot = dot3(v, n);
 
     // use temporary storage
     float temp[3];
@@ -163,6 +356,8 @@ void v3_reflect(float *dst, float *v, float *n)
     dst[0] = temp[0];
     dst[1] = temp[1];
     dst[2] = temp[2];
+
+    V3_PROBE_END(V3_PROBE_REFLECT, 1, 0);
 }
 
 // calculate length/magnitude of a vector
@@ -170,8 +365,12 @@ void v3_reflect(float *dst, float *v, float *n)
 float v3_length(float *a)
 {
     assert(a != NULL);
+    V3_PROBE_BEGIN();
 
-    return sqrtf(a[0] * a[0] + a[1] * a[1] + a[2] * a[2]);
+    float len = length3(a);
+
+    V3_PROBE_END(V3_PROBE_LENGTH, 1, 0);
+    return len;
 }
 
 // normalize a vector to make it a unit length
@@ -179,16 +378,17 @@ float v3_length(float *a)
 void v3_normalize(float *dst, float *a)
 {
     assert(dst != NULL && a != NULL);
+    V3_PROBE_BEGIN();
 
-    float len = v3_length(a);
+    float len = length3(a);
 
     if (len < EPSILON)
     {
-        fprintf(stderr, "Error: Cannot normalize zero length vector\n");
-        errno = EINVAL;
+        v3_report_error(V3_SOURCE_NORMALIZE, "Cannot normalize zero length vector", 1);
         dst[0] = 0.0f;
         dst[1] = 0.0f;
         dst[2] = 0.0f;
+        V3_PROBE_END(V3_PROBE_NORMALIZE, 1, 1);
         return;
     }
 
@@ -203,6 +403,139 @@ void v3_normalize(float *dst, float *a)
     dst[0] = temp[0];
     dst[1] = temp[1];
     dst[2] = temp[2];
+
+    V3_PROBE_END(V3_PROBE_NORMALIZE, 1, 0);
+}
+
+// fast inverse length of a vector
+// returns: 1 / ||a||, or 0 for zero length vectors
+float v3_inv_length(float *a)
+{
+    assert(a != NULL);
+    V3_PROBE_BEGIN();
+
+    float inv_len = v3_rsqrt_nr(dot3(a, a));
+
+    V3_PROBE_END(V3_PROBE_INV_LENGTH, 1, inv_len == 0.0f);
+    return inv_len;
+}
+
+// fast normalize a vector to unit length without branching
+// dst = a / ||a||, or zero with a false return for zero length vectors
+bool v3_normalize_fast(float *dst, float *a)
+{
+    assert(dst != NULL && a != NULL);
+    V3_PROBE_BEGIN();
+
+    float inv_len = v3_rsqrt_nr(dot3(a, a));
+
+    // use temporary storage
+    float temp[3];
+    temp[0] = a[0] * inv_len;
+    temp[1] = a[1] * inv_len;
+    temp[2] = a[2] * inv_len;
+
+    dst[0] = temp[0];
+    dst[1] = temp[1];
+    dst[2] = temp[2];
+
+    V3_PROBE_END(V3_PROBE_NORMALIZE_FAST, 1, inv_len == 0.0f);
+    return inv_len > 0.0f;
+}
+
+// restrict-qualified forms: dst overlaps no input, so results are stored
+// directly and the compiler may keep inputs in registers across the stores
+
+// dst = b - a
+void v3_from_points_restrict(float *V3_RESTRICT dst, float *V3_RESTRICT a, float *V3_RESTRICT b)
+{
+    assert(dst != NULL && a != NULL && b != NULL);
+    V3_PROBE_BEGIN();
+
+    dst[0] = b[0] - a[0];
+    dst[1] = b[1] - a[1];
+    dst[2] = b[2] - a[2];
+
+    V3_PROBE_END(V3_PROBE_FROM_POINTS, 1, 0);
+}
+
+// dst = a + b
+void v3_add_restrict(float *V3_RESTRICT dst, float *V3_RESTRICT a, float *V3_RESTRICT b)
+{
+    assert(dst != NULL && a != NULL && b != NULL);
+    V3_PROBE_BEGIN();
+
+    dst[0] = a[0] + b[0];
+    dst[1] = a[1] + b[1];
+    dst[2] = a[2] + b[2];
+
+    V3_PROBE_END(V3_PROBE_ADD, 1, 0);
+}
+
+// dst = a - b
+void v3_subtract_restrict(float *V3_RESTRICT dst, float *V3_RESTRICT a, float *V3_RESTRICT b)
+{
+    assert(dst != NULL && a != NULL && b != NULL);
+    V3_PROBE_BEGIN();
+
+    dst[0] = a[0] - b[0];
+    dst[1] = a[1] - b[1];
+    dst[2] = a[2] - b[2];
+
+    V3_PROBE_END(V3_PROBE_SUBTRACT, 1, 0);
+}
+
+// dst = a x b
+void v3_cross_product_restrict(float *V3_RESTRICT dst, float *V3_RESTRICT a, float *V3_RESTRICT b)
+{
+    assert(dst != NULL && a != NULL && b != NULL);
+    V3_PROBE_BEGIN();
+
+    dst[0] = a[1] * b[2] - a[2] * b[1];
+    dst[1] = a[2] * b[0] - a[0] * b[2];
+    dst[2] = a[0] * b[1] - a[1] * b[0];
+
+    V3_PROBE_END(V3_PROBE_CROSS_PRODUCT, 1, 0);
+}
+
+// dst = v - 2(v * n)n
+void v3_reflect_restrict(float *V3_RESTRICT dst, float *V3_RESTRICT v, float *V3_RESTRICT n)
+{
+    assert(dst != NULL && v != NULL && n != NULL);
+    V3_PROBE_BEGIN();
+
+    float dot = dot3(v, n);
+    dst[0] = v[0] - 2.0f * dot * n[0];
+    dst[1] = v[1] - 2.0f * dot * n[1];
+    dst[2] = v[2] - 2.0f * dot * n[2];
+
+    V3_PROBE_END(V3_PROBE_REFLECT, 1, 0);
+}
+
+// dst = a / ||a||
+void v3_normalize_restrict(float *V3_RESTRICT dst, float *V3_RESTRICT a)
+{
+    assert(dst != NULL && a != NULL);
+    V3_PROBE_BEGIN();
+
+    float len = length3(a);
+
+    if (len < EPSILON)
+    {
+        v3_report_error(V3_SOURCE_NORMALIZE, "Cannot normalize zero length vector", 1);
+        dst[0] = 0.0f;
+        dst[1] = 0.0f;
+        dst[2] = 0.0f;
+        V3_PROBE_END(V3_PROBE_NORMALIZE, 1, 1);
+        return;
+    }
+
+    float inv_len = 1.0f / len;
+    dst[0] = a[0] * inv_len;
+    dst[1] = a[1] * inv_len;
+    dst[2] = a[2] * inv_len;
+
+    V3_PROBE_END(V3_PROBE_NORMALIZE, 1, 0);
 }
 
 // test helper - check if two vectors are equal within tolerance
@@ -226,4 +559,354 @@ bool v3_equals(float *a, float *b, float tolerance)
     }
 
     return true;
+}
+// whether count floats at p and count floats at q share no memory
+static inline bool disjoint(const float *p, const float *q, size_t count)
+{
+    uintptr_t x = (uintptr_t)p;
+    uintptr_t y = (uintptr_t)q;
+    uintptr_t bytes = count * sizeof(float);
+    return x + bytes <= y || y + bytes <= x;
+}
+
+// whether no array of dst overlaps an array of a
+static bool soa_disjoint(v3_soa dst, v3_soa a, size_t count)
+{
+    const float *d[3] = {dst.x, dst.y, dst.z};
+    const float *s[3] = {a.x, a.y, a.z};
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            if (!disjoint(d[i], s[j], count))
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// one component of the element-wise batches over arrays that share no memory,
+// which the compiler vectorizes
+
+// dst[i] = b[i] - a[i]
+static void difference_stream(float *V3_RESTRICT dst, const float *V3_RESTRICT b, const float *V3_RESTRICT a,
+                              size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        dst[i] = b[i] - a[i];
+    }
+}
+
+// dst[i] = a[i] + b[i]
+static void sum_stream(float *V3_RESTRICT dst, const float *V3_RESTRICT a, const float *V3_RESTRICT b, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        dst[i] = a[i] + b[i];
+    }
+}
+
+// form vectors from points a[i] to points b[i]
+// dst[i] = b[i] - a[i]
+void v3_from_points_batch(v3_soa dst, v3_soa a, v3_soa b, size_t count)
+{
+    assert(dst.x != NULL && dst.y != NULL && dst.z != NULL);
+    assert(a.x != NULL && a.y != NULL && a.z != NULL);
+    assert(b.x != NULL && b.y != NULL && b.z != NULL);
+    V3_PROBE_BEGIN();
+
+    // in-place calls go one vector at a time, as the compiler cannot vectorize
+    // a loop whose stores may feed its loads
+    if (soa_disjoint(dst, a, count) && soa_disjoint(dst, b, count))
+    {
+        difference_stream(dst.x, b.x, a.x, count);
+        difference_stream(dst.y, b.y, a.y, count);
+        difference_stream(dst.z, b.z, a.z, count);
+    }
+    else
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            dst.x[i] = b.x[i] - a.x[i];
+            dst.y[i] = b.y[i] - a.y[i];
+            dst.z[i] = b.z[i] - a.z[i];
+        }
+    }
+
+    V3_PROBE_END(V3_PROBE_FROM_POINTS_BATCH, count, 0);
+}
+
+// add vectors element-wise
+// dst[i] = a[i] + b[i]
+void v3_add_batch(v3_soa dst, v3_soa a, v3_soa b, size_t count)
+{
+    assert(dst.x != NULL && dst.y != NULL && dst.z != NULL);
+    assert(a.x != NULL && a.y != NULL && a.z != NULL);
+    assert(b.x != NULL && b.y != NULL && b.z != NULL);
+    V3_PROBE_BEGIN();
+
+    // in-place calls go one vector at a time, as the compiler cannot vectorize
+    // a loop whose stores may feed its loads
+    if (soa_disjoint(dst, a, count) && soa_disjoint(dst, b, count))
+    {
+        sum_stream(dst.x, a.x, b.x, count);
+        sum_stream(dst.y, a.y, b.y, count);
+        sum_stream(dst.z, a.z, b.z, count);
+    }
+    else
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            dst.x[i] = a.x[i] + b.x[i];
+            dst.y[i] = a.y[i] + b.y[i];
+            dst.z[i] = a.z[i] + b.z[i];
+        }
+    }
+
+    V3_PROBE_END(V3_PROBE_ADD_BATCH, count, 0);
+}
+
+// subtract vectors b[i] from vectors a[i]
+// dst[i] = a[i] - b[i]
+void v3_subtract_batch(v3_soa dst, v3_soa a, v3_soa b, size_t count)
+{
+    assert(dst.x != NULL && dst.y != NULL && dst.z != NULL);
+    assert(a.x != NULL && a.y != NULL && a.z != NULL);
+    assert(b.x != NULL && b.y != NULL && b.z != NULL);
+    V3_PROBE_BEGIN();
+
+    // in-place calls go one vector at a time, as the compiler cannot vectorize
+    // a loop whose stores may feed its loads
+    if (soa_disjoint(dst, a, count) && soa_disjoint(dst, b, count))
+    {
+        difference_stream(dst.x, a.x, b.x, count);
+        difference_stream(dst.y, a.y, b.y, count);
+        difference_stream(dst.z, a.z, b.z, count);
+    }
+    else
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            dst.x[i] = a.x[i] - b.x[i];
+            dst.y[i] = a.y[i] - b.y[i];
+            dst.z[i] = a.z[i] - b.z[i];
+        }
+    }
+
+    V3_PROBE_END(V3_PROBE_SUBTRACT_BATCH, count, 0);
+}
+
+// calculate dot products of vector pairs
+// dst[i] = a[i] * b[i]
+void v3_dot_product_batch(float *dst, v3_soa a, v3_soa b, size_t count)
+{
+    assert(dst != NULL);
+    assert(a.x != NULL && a.y != NULL && a.z != NULL);
+    assert(b.x != NULL && b.y != NULL && b.z != NULL);
+    V3_PROBE_BEGIN();
+
+    v3_get_kernels()->dot_product(dst, a, b, count);
+
+    V3_PROBE_END(V3_PROBE_DOT_PRODUCT_BATCH, count, 0);
+}
+
+// calculate cross products of vector pairs
+// dst[i] = a[i] x b[i]
+void v3_cross_product_batch(v3_soa dst, v3_soa a, v3_soa b, size_t count)
+{
+    assert(dst.x != NULL && dst.y != NULL && dst.z != NULL);
+    assert(a.x != NULL && a.y != NULL && a.z != NULL);
+    assert(b.x != NULL && b.y != NULL && b.z != NULL);
+    V3_PROBE_BEGIN();
+
+    v3_get_kernels()->cross_product(dst, a, b, count);
+
+    V3_PROBE_END(V3_PROBE_CROSS_PRODUCT_BATCH, count, 0);
+}
+
+// scale every vector by scalar s in-place
+// dst[i] = dst[i] * s
+void v3_scale_batch(v3_soa dst, float s, size_t count)
+{
+    assert(dst.x != NULL && dst.y != NULL && dst.z != NULL);
+    V3_PROBE_BEGIN();
+
+    for (size_t i = 0; i < count; i++)
+    {
+        dst.x[i] *= s;
+        dst.y[i] *= s;
+        dst.z[i] *= s;
+    }
+
+    V3_PROBE_END(V3_PROBE_SCALE_BATCH, count, 0);
+}
+
+// reflect vectors v[i] across normals n[i]
+// dst[i] = v[i] - 2(v[i] * n[i])n[i]
+// assumes every n[i] is normalized
+void v3_reflect_batch(v3_soa dst, v3_soa v, v3_soa n, size_t count)
+{
+    assert(dst.x != NULL && dst.y != NULL && dst.z != NULL);
+    assert(v.x != NULL && v.y != NULL && v.z != NULL);
+    assert(n.x != NULL && n.y != NULL && n.z != NULL);
+    V3_PROBE_BEGIN();
+
+    v3_get_kernels()->reflect(dst, v, n, count);
+
+    V3_PROBE_END(V3_PROBE_REFLECT_BATCH, count, 0);
+}
+
+// calculate lengths of vectors
+// dst[i] = ||a[i]||
+void v3_length_batch(float *dst, v3_soa a, size_t count)
+{
+    assert(dst != NULL);
+    assert(a.x != NULL && a.y != NULL && a.z != NULL);
+    V3_PROBE_BEGIN();
+
+    for (size_t i = 0; i < count; i++)
+    {
+        dst[i] = sqrtf(a.x[i] * a.x[i] + a.y[i] * a.y[i] + a.z[i] * a.z[i]);
+    }
+
+    V3_PROBE_END(V3_PROBE_LENGTH_BATCH, count, 0);
+}
+
+// normalize vectors to unit length
+// dst[i] = a[i] / ||a[i]||, zero length vectors become zero
+void v3_normalize_batch(v3_soa dst, v3_soa a, size_t count)
+{
+    assert(dst.x != NULL && dst.y != NULL && dst.z != NULL);
+    assert(a.x != NULL && a.y != NULL && a.z != NULL);
+    V3_PROBE_BEGIN();
+
+    size_t degenerate = v3_get_kernels()->normalize(dst, a, count);
+
+    // report once per batch rather than once per element
+    if (degenerate > 0)
+    {
+        v3_report_error(V3_SOURCE_NORMALIZE_BATCH, "Cannot normalize zero length vector", degenerate);
+    }
+
+    V3_PROBE_END(V3_PROBE_NORMALIZE_BATCH, count, degenerate);
+}
+
+// calculate fast inverse lengths of vectors
+// dst[i] = 1 / ||a[i]||, or 0 for zero length vectors
+void v3_inv_length_batch(float *dst, v3_soa a, size_t count)
+{
+    assert(dst != NULL);
+    assert(a.x != NULL && a.y != NULL && a.z != NULL);
+    V3_PROBE_BEGIN();
+
+    v3_get_kernels()->inv_length(dst, a, count);
+
+    V3_PROBE_END(V3_PROBE_INV_LENGTH_BATCH, count, 0);
+}
+
+// fast normalize vectors to unit length
+// dst[i] = a[i] / ||a[i]||, valid[i] = 0 and dst[i] = 0 for zero length vectors
+void v3_normalize_fast_batch(v3_soa dst, v3_soa a, uint8_t *valid, size_t count)
+{
+    assert(dst.x != NULL && dst.y != NULL && dst.z != NULL);
+    assert(a.x != NULL && a.y != NULL && a.z != NULL);
+    V3_PROBE_BEGIN();
+
+    v3_get_kernels()->normalize_fast(dst, a, valid, count);
+
+    V3_PROBE_END(V3_PROBE_NORMALIZE_FAST_BATCH, count, 0);
+}
+
+// angles between vectors, the exact tier element by element as v3_angle and
+// the fused tiers in the dispatched kernel
+void v3_angle_batch(float *dst, v3_soa a, v3_soa b, size_t count, v3_angle_accuracy accuracy)
+{
+    assert(dst != NULL);
+    assert(a.x != NULL && a.y != NULL && a.z != NULL);
+    assert(b.x != NULL && b.y != NULL && b.z != NULL);
+    V3_PROBE_BEGIN();
+
+    size_t degenerate = 0;
+    if (accuracy == V3_ANGLE_EXACT)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            float va[3] = {a.x[i], a.y[i], a.z[i]};
+            float vb[3] = {b.x[i], b.y[i], b.z[i]};
+            float cos_angle;
+            if (angle_cosine(va, vb, &cos_angle))
+            {
+                dst[i] = acosf(cos_angle);
+            }
+            else
+            {
+                dst[i] = 0.0f;
+                degenerate++;
+            }
+        }
+    }
+    else
+    {
+        degenerate = v3_get_kernels()->angle(dst, a, b, count, accuracy);
+    }
+
+    // report once per batch rather than once per element
+    if (degenerate > 0)
+    {
+        v3_report_error(V3_SOURCE_ANGLE_BATCH, "Cannot compute angle with zero length vector", degenerate);
+    }
+
+    V3_PROBE_END(V3_PROBE_ANGLE_BATCH, count, degenerate);
+}
+
+// restrict forms of the element-wise batches
+// dst[i] = b[i] - a[i], dst overlapping neither input
+void v3_from_points_batch_restrict(v3_soa dst, v3_soa a, v3_soa b, size_t count)
+{
+    assert(dst.x != NULL && dst.y != NULL && dst.z != NULL);
+    assert(a.x != NULL && a.y != NULL && a.z != NULL);
+    assert(b.x != NULL && b.y != NULL && b.z != NULL);
+    assert(soa_disjoint(dst, a, count) && soa_disjoint(dst, b, count));
+    V3_PROBE_BEGIN();
+
+    difference_stream(dst.x, b.x, a.x, count);
+    difference_stream(dst.y, b.y, a.y, count);
+    difference_stream(dst.z, b.z, a.z, count);
+
+    V3_PROBE_END(V3_PROBE_FROM_POINTS_BATCH, count, 0);
+}
+
+// dst[i] = a[i] + b[i], dst overlapping neither input
+void v3_add_batch_restrict(v3_soa dst, v3_soa a, v3_soa b, size_t count)
+{
+    assert(dst.x != NULL && dst.y != NULL && dst.z != NULL);
+    assert(a.x != NULL && a.y != NULL && a.z != NULL);
+    assert(b.x != NULL && b.y != NULL && b.z != NULL);
+    assert(soa_disjoint(dst, a, count) && soa_disjoint(dst, b, count));
+    V3_PROBE_BEGIN();
+
+    sum_stream(dst.x, a.x, b.x, count);
+    sum_stream(dst.y, a.y, b.y, count);
+    sum_stream(dst.z, a.z, b.z, count);
+
+    V3_PROBE_END(V3_PROBE_ADD_BATCH, count, 0);
+}
+
+// dst[i] = a[i] - b[i], dst overlapping neither input
+void v3_subtract_batch_restrict(v3_soa dst, v3_soa a, v3_soa b, size_t count)
+{
+    assert(dst.x != NULL && dst.y != NULL && dst.z != NULL);
+    assert(a.x != NULL && a.y != NULL && a.z != NULL);
+    assert(b.x != NULL && b.y != NULL && b.z != NULL);
+    assert(soa_disjoint(dst, a, count) && soa_disjoint(dst, b, count));
+    V3_PROBE_BEGIN();
+
+    difference_stream(dst.x, a.x, b.x, count);
+    difference_stream(dst.y, a.y, b.y, count);
+    difference_stream(dst.z, a.z, b.z, count);
+
+    V3_PROBE_END(V3_PROBE_SUBTRACT_BATCH, count, 0);
 }
\ No newline at end of file
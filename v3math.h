@@ -1,5 +1,5 @@
 #ifndef V3MATH_H
-#define V3Math_H
+#define V3MATH_H
 
 // library inclusions
 #include <stdint.h>
@@ -9,6 +9,95 @@
 #include <assert.h>
 #include <string.h>
 #include <errno.h>
+#include <stddef.h>
+
+// length below which a vector is treated as zero length
+#define V3_EPSILON 1e-6f
+
+// double precision zero length threshold, see v3double.h
+#define V3D_EPSILON 1e-12
+
+// default v3_equals tolerances for each storage precision
+// half stores 11 significant bits, so its tolerance is relative to magnitude ~1
+#define V3_TOLERANCE 1e-5f
+#define V3D_TOLERANCE 1e-12
+#define V3H_TOLERANCE 1e-3f
+
+// maximum relative error of the fast rsqrt paths (v3_inv_length, v3_normalize_fast)
+// the sse rsqrt estimate is good to 1.5 * 2^-12, one newton-raphson step squares that
+#define V3_FAST_MAX_REL_ERROR 5e-7f
+
+// maximum absolute error in radians of the polynomial acos used by V3_ANGLE_POLY,
+// against acos of the same cosine
+#define V3_ANGLE_POLY_MAX_ERROR 5e-7f
+
+// restrict qualifier, spelled as the g++ extension since c++ has no keyword
+#define V3_RESTRICT __restrict
+
+// structure-of-arrays view over a batch of vectors
+// element i is (x[i], y[i], z[i])
+typedef struct
+{
+    float *x;
+    float *y;
+    float *z;
+} v3_soa;
+
+// how zero length inputs to v3_angle, v3_angle_quick and v3_normalize are reported
+typedef enum
+{
+    V3_ERROR_SILENT,    // no reporting at all (default)
+    V3_ERROR_COUNT,     // atomic per-function counters, read with v3_error_count
+    V3_ERROR_CALLBACK,  // call the function set with v3_set_error_callback
+    V3_ERROR_PRINT      // print to stderr and set errno, the original behaviour
+} v3_error_policy;
+
+// accuracy tiers of v3_angle_batch
+typedef enum
+{
+    V3_ANGLE_EXACT,     // acosf of the cosine from two lengths and a division, as v3_angle
+    V3_ANGLE_POLY,      // polynomial acos of a cosine from one fused rsqrt
+    V3_ANGLE_COSINE     // the fused cosine itself, as v3_angle_quick
+} v3_angle_accuracy;
+
+// functions that can report an error
+typedef enum
+{
+    V3_SOURCE_ANGLE,
+    V3_SOURCE_ANGLE_QUICK,
+    V3_SOURCE_NORMALIZE,
+    V3_SOURCE_NORMALIZE_BATCH,
+    V3_SOURCE_ANGLE_BATCH,
+    V3_SOURCE_COUNT
+} v3_error_source;
+
+// error callback, count is the number of bad elements (more than 1 for batches)
+typedef void (*v3_error_callback)(v3_error_source source, const char *message, uint64_t count, void *user_data);
+
+// select how errors are reported, can also be set with V3MATH_ERRORS=silent|count|print
+void v3_set_error_policy(v3_error_policy policy);
+
+// get the current error policy
+v3_error_policy v3_get_error_policy(void);
+
+// set the callback used by V3_ERROR_CALLBACK, safe while other threads report
+// errors: every report calls a callback with the user data it was set with,
+// though a report already under way may still call the previous pair after
+// this returns. reports take no lock; each distinct pair is stored once and
+// kept until exit, so switching between a few pairs costs no memory
+// returns false with errno = ENOMEM, keeping the previous pair, if a new pair
+// cannot be stored
+bool v3_set_error_callback(v3_error_callback callback, void *user_data);
+
+// get the number of errors counted for a function since the last reset
+uint64_t v3_error_count(v3_error_source source);
+
+// reset all error counters to zero
+void v3_reset_error_counts(void);
+
+// report count bad elements from source according to the current policy
+// used by the double, half and other v3 modules so they share one policy
+void v3_report_error(v3_error_source source, const char *message, uint64_t count);
 
 // form vector from point a to point b
 void v3_from_points(float *dst, float *a, float *b);
@@ -43,7 +132,81 @@ float v3_length(float *a);
 // normalize a vector to make it unit length
 void v3_normalize(float *dst, float *a);
 
+// fast inverse length 1 / ||a|| using hardware rsqrt and one newton-raphson step
+// relative error is at most V3_FAST_MAX_REL_ERROR, zero length vectors return 0
+float v3_inv_length(float *a);
+
+// fast normalize using v3_inv_length, without branching or error reporting
+// zero length vectors become zero and return false
+bool v3_normalize_fast(float *dst, float *a);
+
+// restrict-qualified forms of the writers above, for callers that know dst
+// overlaps no input, not even in-place: they store straight to dst instead of
+// staging the result in a temporary, and zero length inputs to
+// v3_normalize_restrict are handled and reported as in v3_normalize
+void v3_from_points_restrict(float *V3_RESTRICT dst, float *V3_RESTRICT a, float *V3_RESTRICT b);
+void v3_add_restrict(float *V3_RESTRICT dst, float *V3_RESTRICT a, float *V3_RESTRICT b);
+void v3_subtract_restrict(float *V3_RESTRICT dst, float *V3_RESTRICT a, float *V3_RESTRICT b);
+void v3_cross_product_restrict(float *V3_RESTRICT dst, float *V3_RESTRICT a, float *V3_RESTRICT b);
+void v3_reflect_restrict(float *V3_RESTRICT dst, float *V3_RESTRICT v, float *V3_RESTRICT n);
+void v3_normalize_restrict(float *V3_RESTRICT dst, float *V3_RESTRICT a);
+
 // test helper - check if two vectors are equal within tolerance
+// a nan component fails no tolerance test, so it compares equal
 bool v3_equals(float *a, float *b, float tolerance);
 
+// batch operations over count vectors in structure-of-arrays layout
+// dst may be the same arrays as an input (in-place), but must not partially overlap one
+// from_points, add and subtract check for overlap once per call and run their
+// restrict forms below when dst shares no memory with an input
+
+// form vectors from points a[i] to points b[i]
+void v3_from_points_batch(v3_soa dst, v3_soa a, v3_soa b, size_t count);
+
+// add vectors element-wise
+void v3_add_batch(v3_soa dst, v3_soa a, v3_soa b, size_t count);
+
+// subtract vectors b[i] from vectors a[i]
+void v3_subtract_batch(v3_soa dst, v3_soa a, v3_soa b, size_t count);
+
+// calculate dot products a[i] * b[i] into dst[i]
+void v3_dot_product_batch(float *dst, v3_soa a, v3_soa b, size_t count);
+
+// calculate cross products a[i] x b[i]
+void v3_cross_product_batch(v3_soa dst, v3_soa a, v3_soa b, size_t count);
+
+// scale every vector by scalar s in-place
+void v3_scale_batch(v3_soa dst, float s, size_t count);
+
+// reflect vectors v[i] across normals n[i]
+void v3_reflect_batch(v3_soa dst, v3_soa v, v3_soa n, size_t count);
+
+// calculate lengths of vectors into dst[i]
+void v3_length_batch(float *dst, v3_soa a, size_t count);
+
+// normalize vectors to unit length, zero length vectors become zero
+void v3_normalize_batch(v3_soa dst, v3_soa a, size_t count);
+
+// calculate fast inverse lengths of vectors into dst[i], 0 for zero length
+void v3_inv_length_batch(float *dst, v3_soa a, size_t count);
+
+// fast normalize vectors, valid[i] is set to 1 for nonzero length and 0 otherwise
+// valid may be NULL when the mask is not needed
+void v3_normalize_fast_batch(v3_soa dst, v3_soa a, uint8_t *valid, size_t count);
+
+// angles between vectors a[i] and b[i] in radians, or their cosines for V3_ANGLE_COSINE
+// the fused tiers take the cosine as dot * rsqrt(|a|^2 |b|^2), one newton-raphson
+// step refining the estimate, so |a| |b| must stay below about 1e19. zero length
+// pairs give 0 (cosine 1) and are reported once for the batch
+void v3_angle_batch(float *dst, v3_soa a, v3_soa b, size_t count, v3_angle_accuracy accuracy);
+
+// restrict forms of the element-wise batches: no array of dst may overlap an
+// input array, so in-place use is undefined. the compiler vectorizes these
+// loops, where the forms above fall back to one vector at a time for in-place
+// calls. cross product, reflect and normalize need no such forms: their
+// kernels load every group of vectors before storing it
+void v3_from_points_batch_restrict(v3_soa dst, v3_soa a, v3_soa b, size_t count);
+void v3_add_batch_restrict(v3_soa dst, v3_soa a, v3_soa b, size_t count);
+void v3_subtract_batch_restrict(v3_soa dst, v3_soa a, v3_soa b, size_t count);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,141 @@
+// library inclusions
+#include "v3oct.h"
+#include "v3simd.h"
+#include "v3instrument.h"
+
+// the single vector functions run the batch kernels on one element, which
+// takes their scalar tail, so both give the same codes
+
+// encode the direction of n
+v3_oct16 v3_oct16_encode(float *n)
+{
+    assert(n != NULL);
+
+    v3_oct16 packed;
+    v3_soa a = {&n[0], &n[1], &n[2]};
+    v3_get_kernels()->oct_encode(&packed, a, 1, 16);
+    return packed;
+}
+
+v3_oct8 v3_oct8_encode(float *n)
+{
+    assert(n != NULL);
+
+    v3_oct8 packed;
+    v3_soa a = {&n[0], &n[1], &n[2]};
+    v3_get_kernels()->oct_encode(&packed, a, 1, 8);
+    return packed;
+}
+
+// decode into a unit vector
+void v3_oct16_decode(float *dst, v3_oct16 packed)
+{
+    assert(dst != NULL);
+
+    v3_soa d = {&dst[0], &dst[1], &dst[2]};
+    v3_get_kernels()->oct_decode(d, &packed, 1, 16);
+}
+
+void v3_oct8_decode(float *dst, v3_oct8 packed)
+{
+    assert(dst != NULL);
+
+    v3_soa d = {&dst[0], &dst[1], &dst[2]};
+    v3_get_kernels()->oct_decode(d, &packed, 1, 8);
+}
+
+// encode count directions
+void v3_oct16_encode_batch(v3_oct16 *dst, v3_soa a, size_t count)
+{
+    assert(dst != NULL);
+    assert(a.x != NULL && a.y != NULL && a.z != NULL);
+    V3_PROBE_BEGIN();
+
+    v3_get_kernels()->oct_encode(dst, a, count, 16);
+
+    V3_PROBE_END(V3_PROBE_OCT16_ENCODE_BATCH, count, 0);
+}
+
+void v3_oct8_encode_batch(v3_oct8 *dst, v3_soa a, size_t count)
+{
+    assert(dst != NULL);
+    assert(a.x != NULL && a.y != NULL && a.z != NULL);
+    V3_PROBE_BEGIN();
+
+    v3_get_kernels()->oct_encode(dst, a, count, 8);
+
+    V3_PROBE_END(V3_PROBE_OCT8_ENCODE_BATCH, count, 0);
+}
+
+// decode count codes
+void v3_oct16_decode_batch(v3_soa dst, const v3_oct16 *src, size_t count)
+{
+    assert(dst.x != NULL && dst.y != NULL && dst.z != NULL);
+    assert(src != NULL);
+    V3_PROBE_BEGIN();
+
+    v3_get_kernels()->oct_decode(dst, src, count, 16);
+
+    V3_PROBE_END(V3_PROBE_OCT16_DECODE_BATCH, count, 0);
+}
+
+void v3_oct8_decode_batch(v3_soa dst, const v3_oct8 *src, size_t count)
+{
+    assert(dst.x != NULL && dst.y != NULL && dst.z != NULL);
+    assert(src != NULL);
+    V3_PROBE_BEGIN();
+
+    v3_get_kernels()->oct_decode(dst, src, count, 8);
+
+    V3_PROBE_END(V3_PROBE_OCT8_DECODE_BATCH, count, 0);
+}
+
+// dot products against packed normals
+// dst[i] = decode(n[i]) * v[i]
+void v3_oct16_dot_product_batch(float *dst, const v3_oct16 *n, v3_soa v, size_t count)
+{
+    assert(dst != NULL && n != NULL);
+    assert(v.x != NULL && v.y != NULL && v.z != NULL);
+    V3_PROBE_BEGIN();
+
+    v3_get_kernels()->oct_dot(dst, n, v, count, 16);
+
+    V3_PROBE_END(V3_PROBE_OCT16_DOT_PRODUCT_BATCH, count, 0);
+}
+
+void v3_oct8_dot_product_batch(float *dst, const v3_oct8 *n, v3_soa v, size_t count)
+{
+    assert(dst != NULL && n != NULL);
+    assert(v.x != NULL && v.y != NULL && v.z != NULL);
+    V3_PROBE_BEGIN();
+
+    v3_get_kernels()->oct_dot(dst, n, v, count, 8);
+
+    V3_PROBE_END(V3_PROBE_OCT8_DOT_PRODUCT_BATCH, count, 0);
+}
+
+// reflect across packed normals
+// dst[i] = v[i] - 2(v[i] * n)n, n = decode(n[i])
+void v3_oct16_reflect_batch(v3_soa dst, v3_soa v, const v3_oct16 *n, size_t count)
+{
+    assert(dst.x != NULL && dst.y != NULL && dst.z != NULL);
+    assert(v.x != NULL && v.y != NULL && v.z != NULL);
+    assert(n != NULL);
+    V3_PROBE_BEGIN();
+
+    v3_get_kernels()->oct_reflect(dst, v, n, count, 16);
+
+    V3_PROBE_END(V3_PROBE_OCT16_REFLECT_BATCH, count, 0);
+}
+
+void v3_oct8_reflect_batch(v3_soa dst, v3_soa v, const v3_oct8 *n, size_t count)
+{
+    assert(dst.x != NULL && dst.y != NULL && dst.z != NULL);
+    assert(v.x != NULL && v.y != NULL && v.z != NULL);
+    assert(n != NULL);
+    V3_PROBE_BEGIN();
+
+    v3_get_kernels()->oct_reflect(dst, v, n, count, 8);
+
+    V3_PROBE_END(V3_PROBE_OCT8_REFLECT_BATCH, count, 0);
+}
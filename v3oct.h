@@ -0,0 +1,59 @@
+#ifndef V3OCT_H
+#define V3OCT_H
+
+// library inclusions
+#include "v3math.h"
+
+// octahedral encoding of unit vectors
+//
+// a direction is projected onto the octahedron |x| + |y| + |z| = 1, the lower
+// half (z < 0) is folded over the upper one, and the remaining square [-1, 1]^2
+// is stored as two snorm integers: 2 x 16 bits in 4 bytes (v3_oct16) or 2 x 8
+// bits in 2 bytes (v3_oct8), against 12 bytes for float[3]. codes spread over
+// the sphere nearly evenly, so the angular error is bounded everywhere, unlike
+// storing x and y alone or spherical angles
+//
+// decoding unfolds the square and renormalizes, so a decoded vector is unit
+// length to float precision. the dot product and reflect batches decode in
+// registers and never write the float vectors out
+//
+// any nonzero vector encodes its direction; the zero vector encodes as +z.
+// encoding rounds to the nearest code and is bit-identical on every instruction set
+
+// largest angle in radians between a unit vector and its decoded code,
+// measured over a few million random directions and rounded up:
+// 0.004 degrees for 16 bits, 1 degree for 8 bits
+#define V3_OCT16_MAX_ERROR 7.0e-5f
+#define V3_OCT8_MAX_ERROR 1.8e-2f
+
+// u in the low 16 bits, v in the high 16 bits
+typedef uint32_t v3_oct16;
+
+// u in the low byte, v in the high byte
+typedef uint16_t v3_oct8;
+
+// encode the direction of n
+v3_oct16 v3_oct16_encode(float *n);
+v3_oct8 v3_oct8_encode(float *n);
+
+// decode into a unit vector
+void v3_oct16_decode(float *dst, v3_oct16 packed);
+void v3_oct8_decode(float *dst, v3_oct8 packed);
+
+// encode the directions of count vectors
+void v3_oct16_encode_batch(v3_oct16 *dst, v3_soa a, size_t count);
+void v3_oct8_encode_batch(v3_oct8 *dst, v3_soa a, size_t count);
+
+// decode count codes into unit vectors
+void v3_oct16_decode_batch(v3_soa dst, const v3_oct16 *src, size_t count);
+void v3_oct8_decode_batch(v3_soa dst, const v3_oct8 *src, size_t count);
+
+// dst[i] = decode(n[i]) * v[i]
+void v3_oct16_dot_product_batch(float *dst, const v3_oct16 *n, v3_soa v, size_t count);
+void v3_oct8_dot_product_batch(float *dst, const v3_oct8 *n, v3_soa v, size_t count);
+
+// reflect v[i] across decode(n[i]), dst may alias v
+void v3_oct16_reflect_batch(v3_soa dst, v3_soa v, const v3_oct16 *n, size_t count);
+void v3_oct8_reflect_batch(v3_soa dst, v3_soa v, const v3_oct8 *n, size_t count);
+
+#endif
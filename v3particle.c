@@ -0,0 +1,367 @@
+// library inclusions
+#include "v3particle.h"
+#include "v3pool.h"
+#include "v3simd.h"
+#include "v3instrument.h"
+#include <stdlib.h>
+
+// bytes an integration step streams per particle, position and velocity read
+// and written; init touches the arrays with the split of the steps
+#define STEP_BYTES (12 * sizeof(float))
+
+// scratch tiles of one collision task
+typedef struct
+{
+    float q[3][V3_PARTICLE_TILE];   // offsets from the sphere center
+    float n[3][V3_PARTICLE_TILE];   // contact normals
+    float v[3][V3_PARTICLE_TILE];   // gathered velocities
+    float r[3][V3_PARTICLE_TILE];   // reflected velocities
+    float s[V3_PARTICLE_TILE];      // plane distances or squared center distances
+    uint32_t index[V3_PARTICLE_TILE];
+} __attribute__((aligned(64))) collision_tiles;
+
+// state shared by the tasks of one call
+typedef struct
+{
+    v3_particles particles;
+    float a[3];         // acceleration
+    float dt;
+    float p[3];         // plane normal or sphere center
+    float d;            // plane offset or sphere radius
+    float restitution;
+    size_t hits;
+    size_t degenerate;  // sphere offsets too short for the normalize kernel
+} particle_job;
+
+// view of a scratch tile
+static v3_soa tile_soa(float (*tile)[V3_PARTICLE_TILE])
+{
+    v3_soa r = {tile[0], tile[1], tile[2]};
+    return r;
+}
+
+// grain for count particles; small counts run on the calling thread without
+// asking the pool, which queries the cpu count until it has started
+static size_t particle_grain(size_t count, size_t bytes_per_vector)
+{
+    return (count < V3_POOL_MIN_PARALLEL) ? count : v3_pool_grain(count, bytes_per_vector);
+}
+
+// allocate count particles at rest at the origin
+bool v3_particles_init(v3_particles *particles, size_t count)
+{
+    assert(particles != NULL);
+
+    // each array starts on a cache line
+    size_t stride = (count + 15) / 16 * 16;
+    float *block = (float *)aligned_alloc(64, (stride > 0 ? stride : 16) * 6 * sizeof(float));
+    if (block == NULL)
+    {
+        memset(particles, 0, sizeof(*particles));
+        errno = ENOMEM;
+        return false;
+    }
+
+    particles->position.x = block;
+    particles->position.y = block + stride;
+    particles->position.z = block + 2 * stride;
+    particles->velocity.x = block + 3 * stride;
+    particles->velocity.y = block + 4 * stride;
+    particles->velocity.z = block + 5 * stride;
+    particles->count = count;
+
+    v3_first_touch(particles->position.x, count, STEP_BYTES);
+    v3_first_touch(particles->position.y, count, STEP_BYTES);
+    v3_first_touch(particles->position.z, count, STEP_BYTES);
+    v3_first_touch(particles->velocity.x, count, STEP_BYTES);
+    v3_first_touch(particles->velocity.y, count, STEP_BYTES);
+    v3_first_touch(particles->velocity.z, count, STEP_BYTES);
+    return true;
+}
+
+// free arrays allocated by v3_particles_init
+void v3_particles_free(v3_particles *particles)
+{
+    assert(particles != NULL);
+
+    free(particles->position.x);
+    memset(particles, 0, sizeof(*particles));
+}
+
+// v += a dt, then x += v dt along one axis
+static void euler_axis(float *V3_RESTRICT x, float *V3_RESTRICT v, float a, float dt, size_t count)
+{
+    float dv = a * dt;
+    for (size_t i = 0; i < count; i++)
+    {
+        v[i] += dv;
+        x[i] += v[i] * dt;
+    }
+}
+
+// x += (v + a dt / 2) dt, then v += a dt along one axis
+static void verlet_axis(float *V3_RESTRICT x, float *V3_RESTRICT v, float a, float dt, size_t count)
+{
+    float dv = a * dt;
+    float half = 0.5f * dv;
+    for (size_t i = 0; i < count; i++)
+    {
+        x[i] += (v[i] + half) * dt;
+        v[i] += dv;
+    }
+}
+
+static void euler_task(void *context, size_t begin, size_t end)
+{
+    particle_job *job = (particle_job *)context;
+    v3_soa x = job->particles.position, v = job->particles.velocity;
+    euler_axis(x.x + begin, v.x + begin, job->a[0], job->dt, end - begin);
+    euler_axis(x.y + begin, v.y + begin, job->a[1], job->dt, end - begin);
+    euler_axis(x.z + begin, v.z + begin, job->a[2], job->dt, end - begin);
+}
+
+static void verlet_task(void *context, size_t begin, size_t end)
+{
+    particle_job *job = (particle_job *)context;
+    v3_soa x = job->particles.position, v = job->particles.velocity;
+    verlet_axis(x.x + begin, v.x + begin, job->a[0], job->dt, end - begin);
+    verlet_axis(x.y + begin, v.y + begin, job->a[1], job->dt, end - begin);
+    verlet_axis(x.z + begin, v.z + begin, job->a[2], job->dt, end - begin);
+}
+
+// semi-implicit euler step
+// v += a dt, then x += v dt
+void v3_particles_euler(v3_particles *particles, const float *a, float dt)
+{
+    assert(particles != NULL && a != NULL);
+    V3_PROBE_BEGIN();
+
+    particle_job job = {*particles, {a[0], a[1], a[2]}, dt, {0.0f, 0.0f, 0.0f}, 0.0f, 0.0f, 0, 0};
+    v3_parallel_for(particles->count, particle_grain(particles->count, STEP_BYTES), euler_task, &job);
+
+    V3_PROBE_END(V3_PROBE_PARTICLES_EULER, particles->count, 0);
+}
+
+// velocity verlet step
+// x += (v + a dt / 2) dt, then v += a dt
+void v3_particles_verlet(v3_particles *particles, const float *a, float dt)
+{
+    assert(particles != NULL && a != NULL);
+    V3_PROBE_BEGIN();
+
+    particle_job job = {*particles, {a[0], a[1], a[2]}, dt, {0.0f, 0.0f, 0.0f}, 0.0f, 0.0f, 0, 0};
+    v3_parallel_for(particles->count, particle_grain(particles->count, STEP_BYTES), verlet_task, &job);
+
+    V3_PROBE_END(V3_PROBE_PARTICLES_VERLET, particles->count, 0);
+}
+
+// reflect the count gathered velocities about their normals and write them
+// back to the particles at begin + index[k] with the restitution applied
+// v - (1 + e)(v . n)n = (1 - e) / 2 v + (1 + e) / 2 reflect(v, n)
+static void respond(collision_tiles *tiles, v3_soa velocity, size_t begin, size_t count, float restitution)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    v3_get_kernels()->reflect(tile_soa(tiles->r), tile_soa(tiles->v), tile_soa(tiles->n), count);
+
+    float keep = 0.5f * (1.0f - restitution);
+    float bounce = 0.5f * (1.0f + restitution);
+    for (size_t k = 0; k < count; k++)
+    {
+        size_t i = begin + tiles->index[k];
+        velocity.x[i] = keep * tiles->v[0][k] + bounce * tiles->r[0][k];
+        velocity.y[i] = keep * tiles->v[1][k] + bounce * tiles->r[1][k];
+        velocity.z[i] = keep * tiles->v[2][k] + bounce * tiles->r[2][k];
+    }
+}
+
+// collide the particles [begin, end) with the plane n . x = d
+static void plane_task(void *context, size_t begin, size_t end)
+{
+    particle_job *job = (particle_job *)context;
+    v3_soa x = job->particles.position, v = job->particles.velocity;
+    const float *n = job->p;
+    collision_tiles tiles;
+    size_t hits = 0;
+
+    for (int axis = 0; axis < 3; axis++)
+    {
+        for (size_t k = 0; k < V3_PARTICLE_TILE; k++)
+        {
+            tiles.n[axis][k] = n[axis];
+        }
+    }
+
+    for (size_t t = begin; t < end; t += V3_PARTICLE_TILE)
+    {
+        size_t count = (end - t < V3_PARTICLE_TILE) ? end - t : V3_PARTICLE_TILE;
+        v3_soa tx = {x.x + t, x.y + t, x.z + t};
+        v3_get_kernels()->dot_product(tiles.s, tx, tile_soa(tiles.n), count);
+
+        // move the particles behind onto the plane, gather those moving into it
+        size_t moving = 0;
+        for (size_t k = 0; k < count; k++)
+        {
+            float depth = job->d - tiles.s[k];
+            if (depth <= 0.0f)
+            {
+                continue;
+            }
+            size_t i = t + k;
+            hits++;
+            tx.x[k] += depth * n[0];
+            tx.y[k] += depth * n[1];
+            tx.z[k] += depth * n[2];
+            if (v.x[i] * n[0] + v.y[i] * n[1] + v.z[i] * n[2] < 0.0f)
+            {
+                tiles.index[moving] = (uint32_t)k;
+                tiles.v[0][moving] = v.x[i];
+                tiles.v[1][moving] = v.y[i];
+                tiles.v[2][moving] = v.z[i];
+                moving++;
+            }
+        }
+        respond(&tiles, v, t, moving, job->restitution);
+    }
+
+    __atomic_fetch_add(&job->hits, hits, __ATOMIC_RELAXED);
+}
+
+// the normalize kernel gives offsets below V3_EPSILON a zero normal; those
+// that are not exactly zero are scaled up by their largest component first,
+// so their particles still leave through the nearest point of the surface
+static void recover_normals(collision_tiles *tiles, size_t count)
+{
+    for (size_t k = 0; k < count; k++)
+    {
+        if (tiles->n[0][k] != 0.0f || tiles->n[1][k] != 0.0f || tiles->n[2][k] != 0.0f)
+        {
+            continue;
+        }
+        float q[3] = {tiles->q[0][k], tiles->q[1][k], tiles->q[2][k]};
+        float m = fmaxf(fabsf(q[0]), fmaxf(fabsf(q[1]), fabsf(q[2])));
+        if (m == 0.0f)
+        {
+            continue;
+        }
+        q[0] /= m;
+        q[1] /= m;
+        q[2] /= m;
+        float inv = 1.0f / sqrtf(q[0] * q[0] + q[1] * q[1] + q[2] * q[2]);
+        tiles->n[0][k] = q[0] * inv;
+        tiles->n[1][k] = q[1] * inv;
+        tiles->n[2][k] = q[2] * inv;
+    }
+}
+
+// collide the particles [begin, end) with the solid sphere at p of radius d
+static void sphere_task(void *context, size_t begin, size_t end)
+{
+    particle_job *job = (particle_job *)context;
+    v3_soa x = job->particles.position, v = job->particles.velocity;
+    const float *c = job->p;
+    float radius2 = job->d * job->d;
+    collision_tiles tiles;
+    size_t hits = 0, degenerate = 0;
+
+    for (size_t t = begin; t < end; t += V3_PARTICLE_TILE)
+    {
+        size_t count = (end - t < V3_PARTICLE_TILE) ? end - t : V3_PARTICLE_TILE;
+        for (size_t k = 0; k < count; k++)
+        {
+            tiles.q[0][k] = x.x[t + k] - c[0];
+            tiles.q[1][k] = x.y[t + k] - c[1];
+            tiles.q[2][k] = x.z[t + k] - c[2];
+        }
+        v3_get_kernels()->dot_product(tiles.s, tile_soa(tiles.q), tile_soa(tiles.q), count);
+
+        // compact the offsets of the particles inside to the front of the tile
+        size_t inside = 0;
+        for (size_t k = 0; k < count; k++)
+        {
+            if (tiles.s[k] < radius2)
+            {
+                tiles.index[inside] = (uint32_t)k;
+                tiles.q[0][inside] = tiles.q[0][k];
+                tiles.q[1][inside] = tiles.q[1][k];
+                tiles.q[2][inside] = tiles.q[2][k];
+                inside++;
+            }
+        }
+        if (inside == 0)
+        {
+            continue;
+        }
+        hits += inside;
+
+        // a particle exactly at the center keeps a zero normal and stays where it is
+        size_t zeros = v3_get_kernels()->normalize(tile_soa(tiles.n), tile_soa(tiles.q), inside);
+        if (zeros > 0)
+        {
+            recover_normals(&tiles, inside);
+            degenerate += zeros;
+        }
+
+        // move out to the surface, gather those moving inward
+        size_t moving = 0;
+        for (size_t k = 0; k < inside; k++)
+        {
+            size_t i = t + tiles.index[k];
+            float nx = tiles.n[0][k], ny = tiles.n[1][k], nz = tiles.n[2][k];
+            x.x[i] = c[0] + nx * job->d;
+            x.y[i] = c[1] + ny * job->d;
+            x.z[i] = c[2] + nz * job->d;
+            if (v.x[i] * nx + v.y[i] * ny + v.z[i] * nz < 0.0f)
+            {
+                tiles.index[moving] = tiles.index[k];
+                tiles.n[0][moving] = nx;
+                tiles.n[1][moving] = ny;
+                tiles.n[2][moving] = nz;
+                tiles.v[0][moving] = v.x[i];
+                tiles.v[1][moving] = v.y[i];
+                tiles.v[2][moving] = v.z[i];
+                moving++;
+            }
+        }
+        respond(&tiles, v, t, moving, job->restitution);
+    }
+
+    __atomic_fetch_add(&job->hits, hits, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&job->degenerate, degenerate, __ATOMIC_RELAXED);
+}
+
+// collide the particles with the plane n . x = d
+size_t v3_particles_collide_plane(v3_particles *particles, const float *n, float d, float restitution)
+{
+    assert(particles != NULL && n != NULL);
+    V3_PROBE_BEGIN();
+
+    particle_job job = {*particles, {0.0f, 0.0f, 0.0f}, 0.0f, {n[0], n[1], n[2]}, d, restitution, 0, 0};
+    v3_parallel_for(particles->count, particle_grain(particles->count, 3 * sizeof(float)), plane_task, &job);
+
+    V3_PROBE_END(V3_PROBE_PARTICLES_COLLIDE_PLANE, particles->count, 0);
+    return job.hits;
+}
+
+// collide the particles with the solid sphere at center
+size_t v3_particles_collide_sphere(v3_particles *particles, const float *center, float radius, float restitution)
+{
+    assert(particles != NULL && center != NULL);
+    V3_PROBE_BEGIN();
+
+    particle_job job = {*particles, {0.0f, 0.0f, 0.0f}, 0.0f, {center[0], center[1], center[2]}, radius,
+                        restitution, 0, 0};
+    v3_parallel_for(particles->count, particle_grain(particles->count, 3 * sizeof(float)), sphere_task, &job);
+
+    // report once per call rather than once per task
+    if (job.degenerate > 0)
+    {
+        v3_report_error(V3_SOURCE_NORMALIZE_BATCH, "Cannot normalize zero length vector", job.degenerate);
+    }
+
+    V3_PROBE_END(V3_PROBE_PARTICLES_COLLIDE_SPHERE, particles->count, job.degenerate);
+    return job.hits;
+}
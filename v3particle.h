@@ -0,0 +1,63 @@
+#ifndef V3PARTICLE_H
+#define V3PARTICLE_H
+
+// library inclusions
+#include "v3math.h"
+
+// particle systems in structure-of-arrays layout
+//
+// positions and velocities are kept as two v3_soa views, so a step streams six
+// float arrays that the compiler vectorizes without gathers. every call runs
+// on the thread pool in chunks of whole vectors, so results are bit-identical
+// for any thread count
+//
+// collision response takes the distances of a tile of V3_PARTICLE_TILE
+// particles from the dot product kernel, gathers the ones inside the obstacle
+// into scratch tiles and runs the reflect kernel, and for spheres the normalize
+// kernel, on just those. the common case without contact is one read of the
+// positions, and the per-particle work is spent on colliding particles only
+
+// particles per collision tile, the scratch tiles of a task take 14 KB of stack
+#define V3_PARTICLE_TILE 256
+
+typedef struct
+{
+    v3_soa position;
+    v3_soa velocity;
+    size_t count;
+} v3_particles;
+
+// allocate count particles at rest at the origin, arrays aligned to 64 bytes
+// and first touched by the pool threads with the split of the step functions
+// returns false with errno = ENOMEM, leaving particles empty, if allocation fails
+// the functions below also take particles whose arrays the caller owns
+bool v3_particles_init(v3_particles *particles, size_t count);
+
+// free arrays allocated by v3_particles_init
+void v3_particles_free(v3_particles *particles);
+
+// semi-implicit euler step under the uniform acceleration a
+// v += a dt, then x += v dt
+void v3_particles_euler(v3_particles *particles, const float *a, float dt);
+
+// velocity verlet step under the uniform acceleration a, exact up to rounding
+// for constant a, where euler drifts by a t dt / 2
+// x += (v + a dt / 2) dt, then v += a dt
+void v3_particles_verlet(v3_particles *particles, const float *a, float dt);
+
+// the plane n . x = d, with n normalized, bounds the space on the side n points
+// to; particles behind it are moved onto it along n and, when moving into it,
+// their velocity becomes v - (1 + restitution)(v . n)n, v3_reflect for 1
+// returns the number of particles that were behind the plane
+size_t v3_particles_collide_plane(v3_particles *particles, const float *n, float d, float restitution);
+
+// particles inside the solid sphere are moved out to its surface along the
+// radius through them, and their velocity is reflected about that radius as
+// for planes when moving inward; a particle exactly at the center stays.
+// offsets from the center shorter than V3_EPSILON are reported once per call
+// as V3_SOURCE_NORMALIZE_BATCH errors, those not exactly zero still leave
+// along their own direction
+// returns the number of particles that were inside the sphere
+size_t v3_particles_collide_sphere(v3_particles *particles, const float *center, float radius, float restitution);
+
+#endif
@@ -0,0 +1,541 @@
+// library inclusions
+#include "v3pool.h"
+#include "v3simd.h"
+#include "v3instrument.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+// upper bound on pool threads, including the caller
+#define MAX_THREADS 256
+
+// smallest grain the heuristic picks, a few pages per array
+#define MIN_GRAIN 1024
+
+// chunks [next, end) still to run in one thread's block, padded so the
+// blocks of different threads never share a cache line
+typedef struct
+{
+    pthread_mutex_t lock;
+    size_t next;
+    size_t end;
+} __attribute__((aligned(64))) chunk_block;
+
+// the job being run; written by the caller before it wakes the workers
+typedef struct
+{
+    v3_task task;
+    void *context;
+    size_t count;
+    size_t grain;
+} pool_job;
+
+static chunk_block blocks[MAX_THREADS];
+static pool_job job;
+
+// pool_lock guards generation, busy and stopping; submit_lock admits one job at a time
+static pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t submit_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t wake = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t done = PTHREAD_COND_INITIALIZER;
+static pthread_t workers[MAX_THREADS];
+static uint64_t generation = 0;
+static uint64_t start_generation = 0;
+static int busy = 0;
+static bool stopping = false;
+
+// threads of the running pool, 0 when it is not started
+static int started_threads = 0;
+
+// threads requested with v3_pool_set_threads, 0 for the default
+static int requested_threads = 0;
+
+// set on pool threads so nested parallel calls run inline instead of deadlocking
+static __thread bool in_worker = false;
+
+// V3MATH_THREADS if set, otherwise one thread per online cpu
+static int default_threads(void)
+{
+    const char *requested = getenv("V3MATH_THREADS");
+    long threads = (requested != NULL) ? atol(requested) : sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads < 1)
+    {
+        threads = 1;
+    }
+    return (threads > MAX_THREADS) ? MAX_THREADS : (int)threads;
+}
+
+// take the next chunk of this thread's own block
+static bool take_chunk(int self, size_t *chunk)
+{
+    chunk_block *block = &blocks[self];
+    pthread_mutex_lock(&block->lock);
+    bool found = block->next < block->end;
+    if (found)
+    {
+        *chunk = block->next++;
+    }
+    pthread_mutex_unlock(&block->lock);
+    return found;
+}
+
+// steal the last chunk of another thread's block, the one its owner would reach last
+static bool steal_chunk(int self, int threads, size_t *chunk)
+{
+    for (int k = 1; k < threads; k++)
+    {
+        chunk_block *block = &blocks[(self + k) % threads];
+        pthread_mutex_lock(&block->lock);
+        bool found = block->next < block->end;
+        if (found)
+        {
+            *chunk = --block->end;
+        }
+        pthread_mutex_unlock(&block->lock);
+        if (found)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// run chunks until every block is empty
+static void run_chunks(int self, int threads)
+{
+    size_t chunk;
+    while (take_chunk(self, &chunk) || steal_chunk(self, threads, &chunk))
+    {
+        size_t begin = chunk * job.grain;
+        size_t end = (job.count - begin < job.grain) ? job.count : begin + job.grain;
+        job.task(job.context, begin, end);
+    }
+}
+
+static void *worker_main(void *arg)
+{
+    int self = (int)(intptr_t)arg;
+    in_worker = true;
+
+    // a worker scheduled late may find the first job already published,
+    // so it compares against the generation the pool started at
+    pthread_mutex_lock(&pool_lock);
+    uint64_t seen = start_generation;
+    for (;;)
+    {
+        while (generation == seen && !stopping)
+        {
+            pthread_cond_wait(&wake, &pool_lock);
+        }
+        if (stopping)
+        {
+            break;
+        }
+        seen = generation;
+        int threads = started_threads;
+        pthread_mutex_unlock(&pool_lock);
+
+        run_chunks(self, threads);
+
+        pthread_mutex_lock(&pool_lock);
+        if (--busy == 0)
+        {
+            pthread_cond_signal(&done);
+        }
+    }
+    pthread_mutex_unlock(&pool_lock);
+    return NULL;
+}
+
+// start the worker threads, called with submit_lock held
+// falls back to fewer threads if the system refuses to create more
+static void start_pool(void)
+{
+    int threads = (requested_threads > 0) ? requested_threads : default_threads();
+
+    pthread_mutex_lock(&pool_lock);
+    start_generation = generation;
+    int created = 1;
+    while (created < threads &&
+           pthread_create(&workers[created], NULL, worker_main, (void *)(intptr_t)created) == 0)
+    {
+        created++;
+    }
+    __atomic_store_n(&started_threads, created, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&pool_lock);
+}
+
+// stop and join the worker threads, called with submit_lock held
+static void stop_pool(void)
+{
+    pthread_mutex_lock(&pool_lock);
+    stopping = true;
+    pthread_cond_broadcast(&wake);
+    pthread_mutex_unlock(&pool_lock);
+
+    for (int i = 1; i < started_threads; i++)
+    {
+        pthread_join(workers[i], NULL);
+    }
+
+    pthread_mutex_lock(&pool_lock);
+    stopping = false;
+    __atomic_store_n(&started_threads, 0, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&pool_lock);
+}
+
+__attribute__((constructor))
+static void init_blocks(void)
+{
+    for (int i = 0; i < MAX_THREADS; i++)
+    {
+        pthread_mutex_init(&blocks[i].lock, NULL);
+    }
+}
+
+__attribute__((destructor))
+static void shutdown_pool(void)
+{
+    pthread_mutex_lock(&submit_lock);
+    if (started_threads > 0)
+    {
+        stop_pool();
+    }
+    pthread_mutex_unlock(&submit_lock);
+}
+
+// number of threads parallel calls use, including the caller
+int v3_pool_threads(void)
+{
+    // lock-free so the grain heuristic can run inside a task while a job holds submit_lock
+    int threads = __atomic_load_n(&started_threads, __ATOMIC_RELAXED);
+    if (threads == 0)
+    {
+        int requested = __atomic_load_n(&requested_threads, __ATOMIC_RELAXED);
+        threads = (requested > 0) ? requested : default_threads();
+    }
+    return threads;
+}
+
+// stop the pool; the next parallel call starts it with the new thread count
+void v3_pool_set_threads(int threads)
+{
+    assert(threads >= 0);
+
+    pthread_mutex_lock(&submit_lock);
+    if (started_threads > 0)
+    {
+        stop_pool();
+    }
+    __atomic_store_n(&requested_threads, (threads > MAX_THREADS) ? MAX_THREADS : threads, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&submit_lock);
+}
+
+// round count up to a multiple of V3_POOL_ALIGN
+static size_t align_grain(size_t count)
+{
+    return (count + V3_POOL_ALIGN - 1) / V3_POOL_ALIGN * V3_POOL_ALIGN;
+}
+
+// grain for count vectors: V3_POOL_CHUNK_BYTES per chunk, at least 4 chunks per thread
+size_t v3_pool_grain(size_t count, size_t bytes_per_vector)
+{
+    size_t grain = V3_POOL_CHUNK_BYTES / (bytes_per_vector > 0 ? bytes_per_vector : 1);
+    size_t balanced = count / ((size_t)v3_pool_threads() * 4);
+    if (balanced < grain)
+    {
+        grain = balanced;
+    }
+    return align_grain(grain < MIN_GRAIN ? MIN_GRAIN : grain);
+}
+
+// run task over [0, count) on the pool
+void v3_parallel_for(size_t count, size_t grain, v3_task task, void *context)
+{
+    assert(task != NULL);
+
+    grain = align_grain(grain > 0 ? grain : 1);
+    size_t chunks = (count + grain - 1) / grain;
+    if (count < V3_POOL_MIN_PARALLEL || chunks < 2 || in_worker)
+    {
+        if (count > 0)
+        {
+            task(context, 0, count);
+        }
+        return;
+    }
+
+    pthread_mutex_lock(&submit_lock);
+    if (started_threads == 0)
+    {
+        start_pool();
+    }
+
+    int threads = started_threads;
+    if (threads == 1)
+    {
+        pthread_mutex_unlock(&submit_lock);
+        task(context, 0, count);
+        return;
+    }
+
+    // every worker is idle here, so the job and blocks are published by pool_lock below
+    job.task = task;
+    job.context = context;
+    job.count = count;
+    job.grain = grain;
+    for (int i = 0; i < threads; i++)
+    {
+        blocks[i].next = chunks * (size_t)i / (size_t)threads;
+        blocks[i].end = chunks * (size_t)(i + 1) / (size_t)threads;
+    }
+
+    pthread_mutex_lock(&pool_lock);
+    generation++;
+    busy = threads - 1;
+    pthread_cond_broadcast(&wake);
+    pthread_mutex_unlock(&pool_lock);
+
+    // the caller works on block 0, then waits for workers still finishing a chunk
+    in_worker = true;
+    run_chunks(0, threads);
+    in_worker = false;
+
+    pthread_mutex_lock(&pool_lock);
+    while (busy > 0)
+    {
+        pthread_cond_wait(&done, &pool_lock);
+    }
+    pthread_mutex_unlock(&pool_lock);
+
+    pthread_mutex_unlock(&submit_lock);
+}
+
+// arguments of the parallel batch operations
+typedef struct
+{
+    v3_soa dst;
+    v3_soa a;
+    v3_soa b;
+    float *out;
+    uint8_t *valid;
+    float s;
+    size_t degenerate;
+} batch_args;
+
+// view of a batch starting at vector begin
+static v3_soa offset(v3_soa v, size_t begin)
+{
+    v3_soa r = {v.x + begin, v.y + begin, v.z + begin};
+    return r;
+}
+
+static void first_touch_task(void *context, size_t begin, size_t end)
+{
+    memset((float *)context + begin, 0, (end - begin) * sizeof(float));
+}
+
+// zero floats with the block split of parallel calls
+void v3_first_touch(float *data, size_t count, size_t bytes_per_vector)
+{
+    assert(data != NULL);
+
+    v3_parallel_for(count, v3_pool_grain(count, bytes_per_vector), first_touch_task, data);
+}
+
+static void from_points_task(void *context, size_t begin, size_t end)
+{
+    batch_args *args = (batch_args *)context;
+    v3_from_points_batch(offset(args->dst, begin), offset(args->a, begin), offset(args->b, begin), end - begin);
+}
+
+// dst[i] = b[i] - a[i]
+void v3_from_points_batch_parallel(v3_soa dst, v3_soa a, v3_soa b, size_t count)
+{
+    assert(dst.x != NULL && dst.y != NULL && dst.z != NULL);
+    assert(a.x != NULL && a.y != NULL && a.z != NULL);
+    assert(b.x != NULL && b.y != NULL && b.z != NULL);
+
+    batch_args args = {dst, a, b, NULL, NULL, 0.0f, 0};
+    v3_parallel_for(count, v3_pool_grain(count, 9 * sizeof(float)), from_points_task, &args);
+}
+
+static void add_task(void *context, size_t begin, size_t end)
+{
+    batch_args *args = (batch_args *)context;
+    v3_add_batch(offset(args->dst, begin), offset(args->a, begin), offset(args->b, begin), end - begin);
+}
+
+// dst[i] = a[i] + b[i]
+void v3_add_batch_parallel(v3_soa dst, v3_soa a, v3_soa b, size_t count)
+{
+    assert(dst.x != NULL && dst.y != NULL && dst.z != NULL);
+    assert(a.x != NULL && a.y != NULL && a.z != NULL);
+    assert(b.x != NULL && b.y != NULL && b.z != NULL);
+
+    batch_args args = {dst, a, b, NULL, NULL, 0.0f, 0};
+    v3_parallel_for(count, v3_pool_grain(count, 9 * sizeof(float)), add_task, &args);
+}
+
+static void subtract_task(void *context, size_t begin, size_t end)
+{
+    batch_args *args = (batch_args *)context;
+    v3_subtract_batch(offset(args->dst, begin), offset(args->a, begin), offset(args->b, begin), end - begin);
+}
+
+// dst[i] = a[i] - b[i]
+void v3_subtract_batch_parallel(v3_soa dst, v3_soa a, v3_soa b, size_t count)
+{
+    assert(dst.x != NULL && dst.y != NULL && dst.z != NULL);
+    assert(a.x != NULL && a.y != NULL && a.z != NULL);
+    assert(b.x != NULL && b.y != NULL && b.z != NULL);
+
+    batch_args args = {dst, a, b, NULL, NULL, 0.0f, 0};
+    v3_parallel_for(count, v3_pool_grain(count, 9 * sizeof(float)), subtract_task, &args);
+}
+
+static void dot_product_task(void *context, size_t begin, size_t end)
+{
+    batch_args *args = (batch_args *)context;
+    v3_dot_product_batch(args->out + begin, offset(args->a, begin), offset(args->b, begin), end - begin);
+}
+
+// dst[i] = a[i] * b[i]
+void v3_dot_product_batch_parallel(float *dst, v3_soa a, v3_soa b, size_t count)
+{
+    assert(dst != NULL);
+    assert(a.x != NULL && a.y != NULL && a.z != NULL);
+    assert(b.x != NULL && b.y != NULL && b.z != NULL);
+
+    batch_args args = {a, a, b, dst, NULL, 0.0f, 0};
+    v3_parallel_for(count, v3_pool_grain(count, 7 * sizeof(float)), dot_product_task, &args);
+}
+
+static void cross_product_task(void *context, size_t begin, size_t end)
+{
+    batch_args *args = (batch_args *)context;
+    v3_cross_product_batch(offset(args->dst, begin), offset(args->a, begin), offset(args->b, begin), end - begin);
+}
+
+// dst[i] = a[i] x b[i]
+void v3_cross_product_batch_parallel(v3_soa dst, v3_soa a, v3_soa b, size_t count)
+{
+    assert(dst.x != NULL && dst.y != NULL && dst.z != NULL);
+    assert(a.x != NULL && a.y != NULL && a.z != NULL);
+    assert(b.x != NULL && b.y != NULL && b.z != NULL);
+
+    batch_args args = {dst, a, b, NULL, NULL, 0.0f, 0};
+    v3_parallel_for(count, v3_pool_grain(count, 9 * sizeof(float)), cross_product_task, &args);
+}
+
+static void scale_task(void *context, size_t begin, size_t end)
+{
+    batch_args *args = (batch_args *)context;
+    v3_scale_batch(offset(args->dst, begin), args->s, end - begin);
+}
+
+// dst[i] = dst[i] * s
+void v3_scale_batch_parallel(v3_soa dst, float s, size_t count)
+{
+    assert(dst.x != NULL && dst.y != NULL && dst.z != NULL);
+
+    batch_args args = {dst, dst, dst, NULL, NULL, s, 0};
+    v3_parallel_for(count, v3_pool_grain(count, 6 * sizeof(float)), scale_task, &args);
+}
+
+static void reflect_task(void *context, size_t begin, size_t end)
+{
+    batch_args *args = (batch_args *)context;
+    v3_reflect_batch(offset(args->dst, begin), offset(args->a, begin), offset(args->b, begin), end - begin);
+}
+
+// dst[i] = v[i] - 2(v[i] * n[i])n[i]
+void v3_reflect_batch_parallel(v3_soa dst, v3_soa v, v3_soa n, size_t count)
+{
+    assert(dst.x != NULL && dst.y != NULL && dst.z != NULL);
+    assert(v.x != NULL && v.y != NULL && v.z != NULL);
+    assert(n.x != NULL && n.y != NULL && n.z != NULL);
+
+    batch_args args = {dst, v, n, NULL, NULL, 0.0f, 0};
+    v3_parallel_for(count, v3_pool_grain(count, 9 * sizeof(float)), reflect_task, &args);
+}
+
+static void length_task(void *context, size_t begin, size_t end)
+{
+    batch_args *args = (batch_args *)context;
+    v3_length_batch(args->out + begin, offset(args->a, begin), end - begin);
+}
+
+// dst[i] = ||a[i]||
+void v3_length_batch_parallel(float *dst, v3_soa a, size_t count)
+{
+    assert(dst != NULL);
+    assert(a.x != NULL && a.y != NULL && a.z != NULL);
+
+    batch_args args = {a, a, a, dst, NULL, 0.0f, 0};
+    v3_parallel_for(count, v3_pool_grain(count, 4 * sizeof(float)), length_task, &args);
+}
+
+static void inv_length_task(void *context, size_t begin, size_t end)
+{
+    batch_args *args = (batch_args *)context;
+    v3_inv_length_batch(args->out + begin, offset(args->a, begin), end - begin);
+}
+
+// dst[i] = 1 / ||a[i]||, or 0 for zero length vectors
+void v3_inv_length_batch_parallel(float *dst, v3_soa a, size_t count)
+{
+    assert(dst != NULL);
+    assert(a.x != NULL && a.y != NULL && a.z != NULL);
+
+    batch_args args = {a, a, a, dst, NULL, 0.0f, 0};
+    v3_parallel_for(count, v3_pool_grain(count, 4 * sizeof(float)), inv_length_task, &args);
+}
+
+static void normalize_fast_task(void *context, size_t begin, size_t end)
+{
+    batch_args *args = (batch_args *)context;
+    uint8_t *valid = (args->valid != NULL) ? args->valid + begin : NULL;
+    v3_normalize_fast_batch(offset(args->dst, begin), offset(args->a, begin), valid, end - begin);
+}
+
+// dst[i] = a[i] / ||a[i]||, valid[i] = 0 and dst[i] = 0 for zero length vectors
+void v3_normalize_fast_batch_parallel(v3_soa dst, v3_soa a, uint8_t *valid, size_t count)
+{
+    assert(dst.x != NULL && dst.y != NULL && dst.z != NULL);
+    assert(a.x != NULL && a.y != NULL && a.z != NULL);
+
+    batch_args args = {dst, a, a, NULL, valid, 0.0f, 0};
+    v3_parallel_for(count, v3_pool_grain(count, 6 * sizeof(float) + 1), normalize_fast_task, &args);
+}
+
+// chunks call the kernel directly and add up zero length vectors for a single report;
+// the probe counts each chunk as a v3_normalize_batch call like the other tasks
+static void normalize_task(void *context, size_t begin, size_t end)
+{
+    V3_PROBE_BEGIN();
+
+    batch_args *args = (batch_args *)context;
+    size_t degenerate = v3_get_kernels()->normalize(offset(args->dst, begin), offset(args->a, begin), end - begin);
+    if (degenerate > 0)
+    {
+        __atomic_fetch_add(&args->degenerate, degenerate, __ATOMIC_RELAXED);
+    }
+
+    V3_PROBE_END(V3_PROBE_NORMALIZE_BATCH, end - begin, degenerate);
+}
+
+// dst[i] = a[i] / ||a[i]||, zero length vectors become zero
+void v3_normalize_batch_parallel(v3_soa dst, v3_soa a, size_t count)
+{
+    assert(dst.x != NULL && dst.y != NULL && dst.z != NULL);
+    assert(a.x != NULL && a.y != NULL && a.z != NULL);
+
+    batch_args args = {dst, a, a, NULL, NULL, 0.0f, 0};
+    v3_parallel_for(count, v3_pool_grain(count, 6 * sizeof(float)), normalize_task, &args);
+
+    if (args.degenerate > 0)
+    {
+        v3_report_error(V3_SOURCE_NORMALIZE_BATCH, "Cannot normalize zero length vector", args.degenerate);
+    }
+}
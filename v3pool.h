@@ -0,0 +1,68 @@
+#ifndef V3POOL_H
+#define V3POOL_H
+
+// library inclusions
+#include "v3math.h"
+
+// persistent thread pool that runs the batch operations over large arrays
+//
+// a range of vectors is cut into chunks of a grain size. every thread starts
+// with a contiguous block of chunks, takes chunks from the front of its own
+// block and, once it runs dry, steals single chunks from the back of the
+// other blocks. chunk boundaries are multiples of V3_POOL_ALIGN, so every
+// element goes through the same simd or tail path as in the sequential
+// batch call and the results are bit-identical to it
+//
+// the pool starts on first use with V3MATH_THREADS threads (default: one per
+// online cpu), counting the calling thread, which works on the first block
+
+// chunk boundaries are multiples of this many vectors, the widest kernel
+#define V3_POOL_ALIGN 16
+
+// the grain heuristic aims for chunks of this many bytes, well inside l2
+#define V3_POOL_CHUNK_BYTES (256u * 1024u)
+
+// ranges with fewer vectors than this run on the calling thread
+#define V3_POOL_MIN_PARALLEL 16384
+
+// task run on the vectors [begin, end) of a range
+typedef void (*v3_task)(void *context, size_t begin, size_t end);
+
+// number of threads parallel calls use, including the caller
+int v3_pool_threads(void);
+
+// stop the pool and use threads threads from the next parallel call on
+// 0 selects the default; must not be called while a parallel call is running
+void v3_pool_set_threads(int threads);
+
+// grain for count vectors of bytes_per_vector bytes: about V3_POOL_CHUNK_BYTES
+// per chunk, but small enough to give every thread several chunks to balance
+size_t v3_pool_grain(size_t count, size_t bytes_per_vector);
+
+// run task over [0, count) in chunks of grain vectors (rounded up to V3_POOL_ALIGN)
+// returns when every chunk is done; calls from inside a task run sequentially
+void v3_parallel_for(size_t count, size_t grain, v3_task task, void *context);
+
+// zero count floats with the block split that parallel calls over vectors of
+// bytes_per_vector bytes start with; pass the bytes_per_vector of the operations
+// that will stream through the array. placement is best effort only: pool
+// threads are not pinned and idle threads steal chunks, so on numa systems the
+// thread that first touches a page need not run near the one that uses it later
+void v3_first_touch(float *data, size_t count, size_t bytes_per_vector);
+
+// parallel versions of the batch operations, same contracts and results
+void v3_from_points_batch_parallel(v3_soa dst, v3_soa a, v3_soa b, size_t count);
+void v3_add_batch_parallel(v3_soa dst, v3_soa a, v3_soa b, size_t count);
+void v3_subtract_batch_parallel(v3_soa dst, v3_soa a, v3_soa b, size_t count);
+void v3_dot_product_batch_parallel(float *dst, v3_soa a, v3_soa b, size_t count);
+void v3_cross_product_batch_parallel(v3_soa dst, v3_soa a, v3_soa b, size_t count);
+void v3_scale_batch_parallel(v3_soa dst, float s, size_t count);
+void v3_reflect_batch_parallel(v3_soa dst, v3_soa v, v3_soa n, size_t count);
+void v3_length_batch_parallel(float *dst, v3_soa a, size_t count);
+void v3_inv_length_batch_parallel(float *dst, v3_soa a, size_t count);
+void v3_normalize_fast_batch_parallel(v3_soa dst, v3_soa a, uint8_t *valid, size_t count);
+
+// zero length vectors are reported once for the whole range, as in v3_normalize_batch
+void v3_normalize_batch_parallel(v3_soa dst, v3_soa a, size_t count);
+
+#endif
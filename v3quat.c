@@ -0,0 +1,197 @@
+// library inclusions
+#include "v3quat.h"
+#include "v3simd.h"
+#include "v3instrument.h"
+
+// above this cosine the rotations are so close that slerp divides by a tiny sine
+#define SLERP_THRESHOLD 0.9995f
+
+// identity rotation
+void v3_quat_identity(v3_quat *dst)
+{
+    assert(dst != NULL);
+
+    dst->x = 0.0f;
+    dst->y = 0.0f;
+    dst->z = 0.0f;
+    dst->w = 1.0f;
+}
+
+// rotation about an axis
+// q = (sin(a / 2) k, cos(a / 2)) for the unit axis k
+bool v3_quat_from_axis_angle(v3_quat *dst, float *axis, float angle)
+{
+    assert(dst != NULL && axis != NULL);
+
+    if (v3_length(axis) < V3_EPSILON)
+    {
+        v3_quat_identity(dst);
+        return false;
+    }
+
+    float k[3];
+    v3_normalize(k, axis);
+    float s = sinf(0.5f * angle);
+
+    dst->x = k[0] * s;
+    dst->y = k[1] * s;
+    dst->z = k[2] * s;
+    dst->w = cosf(0.5f * angle);
+    return true;
+}
+
+// hamilton product
+// dst = a * b
+void v3_quat_multiply(v3_quat *dst, const v3_quat *a, const v3_quat *b)
+{
+    assert(dst != NULL && a != NULL && b != NULL);
+
+    // use temporary storage to handle overlapping memory
+    v3_quat temp;
+    temp.x = a->w * b->x + a->x * b->w + a->y * b->z - a->z * b->y;
+    temp.y = a->w * b->y - a->x * b->z + a->y * b->w + a->z * b->x;
+    temp.z = a->w * b->z + a->x * b->y - a->y * b->x + a->z * b->w;
+    temp.w = a->w * b->w - a->x * b->x - a->y * b->y - a->z * b->z;
+
+    *dst = temp;
+}
+
+// conjugate
+// dst = (-x, -y, -z, w)
+void v3_quat_conjugate(v3_quat *dst, const v3_quat *q)
+{
+    assert(dst != NULL && q != NULL);
+
+    dst->x = -q->x;
+    dst->y = -q->y;
+    dst->z = -q->z;
+    dst->w = q->w;
+}
+
+// 4d dot product
+// a . b = ax*bx + ay*by + az*bz + aw*bw
+float v3_quat_dot(const v3_quat *a, const v3_quat *b)
+{
+    assert(a != NULL && b != NULL);
+
+    return a->x * b->x + a->y * b->y + a->z * b->z + a->w * b->w;
+}
+
+// scale to unit length
+// dst = q / |q|
+bool v3_quat_normalize(v3_quat *dst, const v3_quat *q)
+{
+    assert(dst != NULL && q != NULL);
+
+    float len = sqrtf(v3_quat_dot(q, q));
+    if (len < V3_EPSILON)
+    {
+        v3_quat_identity(dst);
+        return false;
+    }
+
+    float inv_len = 1.0f / len;
+    dst->x = q->x * inv_len;
+    dst->y = q->y * inv_len;
+    dst->z = q->z * inv_len;
+    dst->w = q->w * inv_len;
+    return true;
+}
+
+// weighted sum of a and b, with b flipped onto the hemisphere of a so the
+// shorter arc is taken (q and -q are the same rotation)
+static void blend(v3_quat *dst, const v3_quat *a, const v3_quat *b, float wa, float wb)
+{
+    if (v3_quat_dot(a, b) < 0.0f)
+    {
+        wb = -wb;
+    }
+
+    dst->x = wa * a->x + wb * b->x;
+    dst->y = wa * a->y + wb * b->y;
+    dst->z = wa * a->z + wb * b->z;
+    dst->w = wa * a->w + wb * b->w;
+}
+
+// normalized linear interpolation
+// dst = normalize((1 - t) a + t b)
+void v3_quat_nlerp(v3_quat *dst, const v3_quat *a, const v3_quat *b, float t)
+{
+    assert(dst != NULL && a != NULL && b != NULL);
+
+    v3_quat temp;
+    blend(&temp, a, b, 1.0f - t, t);
+    v3_quat_normalize(dst, &temp);
+}
+
+// spherical linear interpolation
+// dst = (sin((1 - t) theta) a + sin(t theta) b) / sin(theta), cos(theta) = |a . b|
+void v3_quat_slerp(v3_quat *dst, const v3_quat *a, const v3_quat *b, float t)
+{
+    assert(dst != NULL && a != NULL && b != NULL);
+
+    float cos_theta = fabsf(v3_quat_dot(a, b));
+    if (cos_theta > SLERP_THRESHOLD)
+    {
+        v3_quat_nlerp(dst, a, b, t);
+        return;
+    }
+
+    float theta = acosf(cos_theta);
+    float inv_sin = 1.0f / sinf(theta);
+
+    v3_quat temp;
+    blend(&temp, a, b, sinf((1.0f - t) * theta) * inv_sin, sinf(t * theta) * inv_sin);
+    *dst = temp;
+}
+
+// rotation matrix of a unit quaternion
+void v3_quat_to_mat3(v3_mat3 *dst, const v3_quat *q)
+{
+    assert(dst != NULL && q != NULL);
+
+    float xx = q->x * q->x, yy = q->y * q->y, zz = q->z * q->z;
+    float xy = q->x * q->y, xz = q->x * q->z, yz = q->y * q->z;
+    float wx = q->w * q->x, wy = q->w * q->y, wz = q->w * q->z;
+
+    dst->m[0] = 1.0f - 2.0f * (yy + zz);
+    dst->m[1] = 2.0f * (xy - wz);
+    dst->m[2] = 2.0f * (xz + wy);
+    dst->m[3] = 2.0f * (xy + wz);
+    dst->m[4] = 1.0f - 2.0f * (xx + zz);
+    dst->m[5] = 2.0f * (yz - wx);
+    dst->m[6] = 2.0f * (xz - wy);
+    dst->m[7] = 2.0f * (yz + wx);
+    dst->m[8] = 1.0f - 2.0f * (xx + yy);
+}
+
+// rotate a vector with two cross products, written out in the order of the batch kernels
+// t = 2 (u x v), dst = v + w t + u x t for u = q.xyz
+void v3_quat_rotate(float *dst, const v3_quat *q, float *v)
+{
+    assert(dst != NULL && q != NULL && v != NULL);
+
+    float x = v[0], y = v[1], z = v[2];
+    float tx = 2.0f * (q->y * z - q->z * y);
+    float ty = 2.0f * (q->z * x - q->x * z);
+    float tz = 2.0f * (q->x * y - q->y * x);
+
+    dst[0] = x + q->w * tx + (q->y * tz - q->z * ty);
+    dst[1] = y + q->w * ty + (q->z * tx - q->x * tz);
+    dst[2] = z + q->w * tz + (q->x * ty - q->y * tx);
+}
+
+// rotate vectors with the dispatched kernel
+// dst[i] = q v[i] q*
+void v3_quat_rotate_batch(v3_soa dst, const v3_quat *q, v3_soa v, size_t count)
+{
+    assert(dst.x != NULL && dst.y != NULL && dst.z != NULL);
+    assert(v.x != NULL && v.y != NULL && v.z != NULL);
+    assert(q != NULL);
+    V3_PROBE_BEGIN();
+
+    float packed[4] = {q->x, q->y, q->z, q->w};
+    v3_get_kernels()->rotate(dst, packed, v, count);
+
+    V3_PROBE_END(V3_PROBE_QUAT_ROTATE_BATCH, count, 0);
+}
@@ -0,0 +1,57 @@
+#ifndef V3QUAT_H
+#define V3QUAT_H
+
+// library inclusions
+#include "v3math.h"
+#include "v3mat.h"
+
+// unit quaternions for rotating vectors
+//
+// q = (x, y, z, w) with the vector part first, so a quaternion can be passed to
+// the v3 functions as its axis. rotations compose like matrices: the product a * b
+// applies b first. rotating with the fast form
+//     t = 2 (q.xyz x v),  v' = v + w t + q.xyz x t
+// costs two cross products instead of building a matrix or two quaternion products
+
+typedef struct
+{
+    float x, y, z, w;
+} v3_quat;
+
+// identity rotation (0, 0, 0, 1)
+void v3_quat_identity(v3_quat *dst);
+
+// rotation by angle radians counterclockwise about axis, which is normalized with v3_normalize
+// returns false and sets identity for a zero length axis
+bool v3_quat_from_axis_angle(v3_quat *dst, float *axis, float angle);
+
+// quaternion product, b is applied first: dst = a * b
+// dst may be a or b
+void v3_quat_multiply(v3_quat *dst, const v3_quat *a, const v3_quat *b);
+
+// inverse rotation of a unit quaternion: dst = (-x, -y, -z, w)
+void v3_quat_conjugate(v3_quat *dst, const v3_quat *q);
+
+// dot product of two quaternions as 4-vectors
+float v3_quat_dot(const v3_quat *a, const v3_quat *b);
+
+// scale to unit length, removes the drift of long chains of products
+// returns false and sets identity for a zero quaternion
+bool v3_quat_normalize(v3_quat *dst, const v3_quat *q);
+
+// interpolate along the shorter arc, t in [0, 1]
+// nlerp blends linearly and normalizes: cheap, but not constant angular speed
+// slerp keeps constant angular speed and falls back to nlerp for nearly equal rotations
+void v3_quat_nlerp(v3_quat *dst, const v3_quat *a, const v3_quat *b, float t);
+void v3_quat_slerp(v3_quat *dst, const v3_quat *a, const v3_quat *b, float t);
+
+// rotation matrix of a unit quaternion
+void v3_quat_to_mat3(v3_mat3 *dst, const v3_quat *q);
+
+// rotate one vector by a unit quaternion, dst may be v
+void v3_quat_rotate(float *dst, const v3_quat *q, float *v);
+
+// rotate count vectors by a unit quaternion, dst may be v (in-place)
+void v3_quat_rotate_batch(v3_soa dst, const v3_quat *q, v3_soa v, size_t count);
+
+#endif
@@ -0,0 +1,159 @@
+// library inclusions
+#include "v3ray.h"
+#include "v3simd.h"
+#include "v3instrument.h"
+
+// intersect a ray with a triangle (moller-trumbore)
+// t = (e2 * q) / det with e1 = v1 - v0, e2 = v2 - v0, p = dir x e2, det = e1 * p,
+// s = origin - v0, q = s x e1; hits need barycentrics u, v >= 0 and u + v <= 1
+bool v3_ray_triangle(float *t, float *origin, float *dir, float *v0, float *v1, float *v2)
+{
+    assert(t != NULL && origin != NULL && dir != NULL);
+    assert(v0 != NULL && v1 != NULL && v2 != NULL);
+
+    float e1[3], e2[3], p[3], s[3], q[3];
+    *t = V3_RAY_MISS;
+
+    v3_from_points(e1, v0, v1);
+    v3_from_points(e2, v0, v2);
+    v3_cross_product(p, dir, e2);
+    float det = v3_dot_product(e1, p);
+    if (fabsf(det) < V3_RAY_EPSILON)
+    {
+        return false;
+    }
+
+    float inv_det = 1.0f / det;
+    v3_from_points(s, v0, origin);
+    float u = v3_dot_product(s, p) * inv_det;
+    if (u < 0.0f || u > 1.0f)
+    {
+        return false;
+    }
+
+    v3_cross_product(q, s, e1);
+    float v = v3_dot_product(dir, q) * inv_det;
+    if (v < 0.0f || u + v > 1.0f)
+    {
+        return false;
+    }
+
+    float hit = v3_dot_product(e2, q) * inv_det;
+    if (hit <= V3_RAY_EPSILON)
+    {
+        return false;
+    }
+
+    *t = hit;
+    return true;
+}
+
+// intersect a ray with a sphere
+// t = (-b -+ sqrt(b^2 - ac)) / a with a = dir * dir, b = oc * dir, c = oc * oc - r^2, oc = origin - center
+bool v3_ray_sphere(float *t, float *origin, float *dir, float *center, float radius)
+{
+    assert(t != NULL && origin != NULL && dir != NULL && center != NULL);
+
+    float oc[3];
+    *t = V3_RAY_MISS;
+
+    v3_from_points(oc, center, origin);
+    float a = v3_dot_product(dir, dir);
+    float b = v3_dot_product(oc, dir);
+    float c = v3_dot_product(oc, oc) - radius * radius;
+    float disc = b * b - a * c;
+    if (a < V3_RAY_EPSILON || disc < 0.0f)
+    {
+        return false;
+    }
+
+    float root = sqrtf(disc);
+    float near = (-b - root) / a;
+    float far = (-b + root) / a;
+    float hit = (near > V3_RAY_EPSILON) ? near : far;
+    if (hit <= V3_RAY_EPSILON)
+    {
+        return false;
+    }
+
+    *t = hit;
+    return true;
+}
+
+// the kernels take a triangle as v0 and its two edges from v0, 9 floats
+static void triangle_edges(float *tri, float *v0, float *v1, float *v2)
+{
+    tri[0] = v0[0];
+    tri[1] = v0[1];
+    tri[2] = v0[2];
+    v3_from_points(tri + 3, v0, v1);
+    v3_from_points(tri + 6, v0, v2);
+}
+
+// fold one hit byte per ray into a packet hit mask
+static uint32_t packet_mask(const uint8_t *hit)
+{
+    uint32_t mask = 0;
+    for (int lane = 0; lane < V3_RAY_PACKET; lane++)
+    {
+        mask |= (uint32_t)hit[lane] << lane;
+    }
+    return mask;
+}
+
+// packets and batches run on the ray kernels of the current instruction set
+uint32_t v3_ray_triangle_packet(float *t, v3_soa origin, v3_soa dir, float *v0, float *v1, float *v2)
+{
+    assert(t != NULL && v0 != NULL && v1 != NULL && v2 != NULL);
+    assert(origin.x != NULL && origin.y != NULL && origin.z != NULL);
+    assert(dir.x != NULL && dir.y != NULL && dir.z != NULL);
+
+    float tri[9];
+    uint8_t hit[V3_RAY_PACKET];
+    triangle_edges(tri, v0, v1, v2);
+    v3_get_kernels()->ray_triangle(t, hit, origin, dir, tri, V3_RAY_PACKET);
+    return packet_mask(hit);
+}
+
+uint32_t v3_ray_sphere_packet(float *t, v3_soa origin, v3_soa dir, float *center, float radius)
+{
+    assert(t != NULL && center != NULL);
+    assert(origin.x != NULL && origin.y != NULL && origin.z != NULL);
+    assert(dir.x != NULL && dir.y != NULL && dir.z != NULL);
+
+    float sphere[4] = {center[0], center[1], center[2], radius};
+    uint8_t hit[V3_RAY_PACKET];
+    v3_get_kernels()->ray_sphere(t, hit, origin, dir, sphere, V3_RAY_PACKET);
+    return packet_mask(hit);
+}
+
+// intersect count rays with one triangle, whole vectors first and the rest one ray at a time
+void v3_ray_triangle_batch(float *t, uint8_t *hit, v3_soa origin, v3_soa dir, size_t count,
+                           float *v0, float *v1, float *v2)
+{
+    assert(t != NULL && v0 != NULL && v1 != NULL && v2 != NULL);
+    assert(origin.x != NULL && origin.y != NULL && origin.z != NULL);
+    assert(dir.x != NULL && dir.y != NULL && dir.z != NULL);
+    V3_PROBE_BEGIN();
+
+    float tri[9];
+    triangle_edges(tri, v0, v1, v2);
+    v3_get_kernels()->ray_triangle(t, hit, origin, dir, tri, count);
+
+    V3_PROBE_END(V3_PROBE_RAY_TRIANGLE_BATCH, count, 0);
+}
+
+// intersect count rays with one sphere, whole vectors first and the rest one ray at a time
+void v3_ray_sphere_batch(float *t, uint8_t *hit, v3_soa origin, v3_soa dir, size_t count,
+                         float *center, float radius)
+{
+    assert(t != NULL && center != NULL);
+    assert(origin.x != NULL && origin.y != NULL && origin.z != NULL);
+    assert(dir.x != NULL && dir.y != NULL && dir.z != NULL);
+    V3_PROBE_BEGIN();
+
+    float sphere[4] = {center[0], center[1], center[2], radius};
+    v3_get_kernels()->ray_sphere(t, hit, origin, dir, sphere, count);
+
+    V3_PROBE_END(V3_PROBE_RAY_SPHERE_BATCH, count, 0);
+}
@@ -0,0 +1,53 @@
+#ifndef V3RAY_H
+#define V3RAY_H
+
+// library inclusions
+#include "v3math.h"
+
+// ray/triangle (moller-trumbore) and ray/sphere intersection
+//
+// a ray is an origin and a direction, and hits at origin + t * dir. the scalar
+// functions are built on the v3math calls; the packet and batch functions run
+// the ray kernels of the instruction set the batch functions dispatch to (see
+// v3simd.h), which test rays stored in structure-of-arrays layout a vector at a
+// time and evaluate the same operations in the same order without fma, so every
+// lane is bit-identical to the scalar result on any instruction set
+
+// rays per packet
+#define V3_RAY_PACKET 8
+
+// determinants below this are treated as rays parallel to the triangle,
+// and hits must be further than this along the ray
+#define V3_RAY_EPSILON 1e-8f
+
+// t reported for rays that miss
+#define V3_RAY_MISS INFINITY
+
+// intersect a ray with triangle v0 v1 v2, either winding
+// returns: true and the hit distance in t, or false and V3_RAY_MISS
+bool v3_ray_triangle(float *t, float *origin, float *dir, float *v0, float *v1, float *v2);
+
+// intersect a ray with a sphere, dir need not be normalized
+// returns: true and the nearest hit in front of the origin in t (the exit point
+// when the origin is inside), or false and V3_RAY_MISS
+bool v3_ray_sphere(float *t, float *origin, float *dir, float *center, float radius);
+
+// intersect the V3_RAY_PACKET rays in lanes [0, V3_RAY_PACKET) of origin and dir
+// with one triangle, t receives V3_RAY_PACKET distances
+// returns: hit mask, bit i set when ray i hits
+uint32_t v3_ray_triangle_packet(float *t, v3_soa origin, v3_soa dir, float *v0, float *v1, float *v2);
+
+// intersect the V3_RAY_PACKET rays of a packet with one sphere
+// returns: hit mask, bit i set when ray i hits
+uint32_t v3_ray_sphere_packet(float *t, v3_soa origin, v3_soa dir, float *center, float radius);
+
+// intersect count rays with one triangle in packets, hit[i] is 1 for hits and 0 otherwise
+// hit may be NULL when only the distances are needed
+void v3_ray_triangle_batch(float *t, uint8_t *hit, v3_soa origin, v3_soa dir, size_t count,
+                           float *v0, float *v1, float *v2);
+
+// intersect count rays with one sphere in packets
+void v3_ray_sphere_batch(float *t, uint8_t *hit, v3_soa origin, v3_soa dir, size_t count,
+                         float *center, float radius);
+
+#endif
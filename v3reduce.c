@@ -0,0 +1,352 @@
+// library inclusions
+#include "v3reduce.h"
+#include "v3arena.h"
+#include "v3pool.h"
+#include "v3simd.h"
+#include "v3instrument.h"
+
+// values per tile of a derived stream, 4 KB on the stack and in l1; a multiple
+// of V3_SUM_LANES, so tiles of a block feed the lanes in the same order as one pass
+#define TILE 1024
+
+// largest number of streams a reduction sums
+#define MAX_STREAMS 6
+
+static_assert(V3_REDUCE_BLOCK % TILE == 0, "blocks must hold whole tiles");
+static_assert(TILE % V3_SUM_LANES == 0, "tiles must start on lane 0");
+
+typedef enum
+{
+    REDUCE_SUM,         // x, y, z
+    REDUCE_WEIGHTED,    // w x, w y, w z
+    REDUCE_DOT,         // a . b
+    REDUCE_COVARIANCE   // xx, xy, xz, yy, yz, zz about center
+} reduce_kind;
+
+// state shared by the block tasks of one reduction
+typedef struct
+{
+    reduce_kind kind;
+    int streams;
+    v3_reduce_mode mode;
+    const v3_kernels *kernels;
+    v3_soa a;
+    v3_soa b;
+    const float *w;
+    float center[3];
+    float *partials;    // streams floats per block
+} reduce_job;
+
+// covariance streams as pairs of axes
+static const int covariance_axes[MAX_STREAMS][2] = {{0, 0}, {0, 1}, {0, 2}, {1, 1}, {1, 2}, {2, 2}};
+
+static const float *axis_of(v3_soa a, int axis)
+{
+    return (axis == 0) ? a.x : (axis == 1) ? a.y : a.z;
+}
+
+// values of a stream for the vectors [begin, begin + count): the input itself
+// for plain sums, otherwise computed into tile
+static const float *stream_values(const reduce_job *job, int stream, size_t begin, size_t count, float *tile)
+{
+    switch (job->kind)
+    {
+    case REDUCE_SUM:
+        return axis_of(job->a, stream) + begin;
+
+    case REDUCE_WEIGHTED:
+    {
+        const float *x = axis_of(job->a, stream) + begin;
+        const float *w = job->w + begin;
+        for (size_t i = 0; i < count; i++)
+        {
+            tile[i] = w[i] * x[i];
+        }
+        return tile;
+    }
+
+    case REDUCE_DOT:
+    {
+        v3_soa a = {job->a.x + begin, job->a.y + begin, job->a.z + begin};
+        v3_soa b = {job->b.x + begin, job->b.y + begin, job->b.z + begin};
+        job->kernels->dot_product(tile, a, b, count);
+        return tile;
+    }
+
+    case REDUCE_COVARIANCE:
+    {
+        int p = covariance_axes[stream][0], q = covariance_axes[stream][1];
+        const float *u = axis_of(job->a, p) + begin;
+        const float *v = axis_of(job->a, q) + begin;
+        float cu = job->center[p], cv = job->center[q];
+        for (size_t i = 0; i < count; i++)
+        {
+            tile[i] = (u[i] - cu) * (v[i] - cv);
+        }
+        return tile;
+    }
+    }
+    return NULL;
+}
+
+// sum of count values stride apart, halving the range at every level
+static float pairwise(const float *v, size_t count, size_t stride)
+{
+    if (count <= 1)
+    {
+        return (count == 1) ? v[0] : 0.0f;
+    }
+    size_t half = count / 2;
+    return pairwise(v, half, stride) + pairwise(v + half * stride, count - half, stride);
+}
+
+// sum every stream of the blocks in [begin, end)
+static void reduce_task(void *context, size_t begin, size_t end)
+{
+    reduce_job *job = (reduce_job *)context;
+    float tile[TILE];
+
+    for (size_t block = begin; block < end; block += V3_REDUCE_BLOCK)
+    {
+        size_t n = (end - block < V3_REDUCE_BLOCK) ? end - block : V3_REDUCE_BLOCK;
+        float *partial = job->partials + block / V3_REDUCE_BLOCK * job->streams;
+
+        for (int stream = 0; stream < job->streams; stream++)
+        {
+            float lanes[V3_SUM_LANES] = {0.0f};
+            float comp[V3_SUM_LANES] = {0.0f};
+            for (size_t t = 0; t < n; t += TILE)
+            {
+                size_t m = (n - t < TILE) ? n - t : TILE;
+                const float *x = stream_values(job, stream, block + t, m, tile);
+                if (job->mode == V3_REDUCE_KAHAN)
+                {
+                    job->kernels->sum_compensated(lanes, comp, x, m);
+                }
+                else
+                {
+                    job->kernels->sum(lanes, x, m);
+                }
+            }
+
+            // the compensation holds what the lane sum overshot by
+            if (job->mode == V3_REDUCE_KAHAN)
+            {
+                for (int k = 0; k < V3_SUM_LANES; k++)
+                {
+                    lanes[k] -= comp[k];
+                }
+            }
+            partial[stream] = pairwise(lanes, V3_SUM_LANES, 1);
+        }
+    }
+}
+
+// grain of whole blocks, so chunk boundaries never split one
+static size_t block_grain(size_t count, size_t bytes_per_vector)
+{
+    // ranges run on the calling thread skip the heuristic, which asks the os
+    // for the cpu count until the pool has started
+    if (count < V3_POOL_MIN_PARALLEL)
+    {
+        return V3_REDUCE_BLOCK;
+    }
+    size_t grain = v3_pool_grain(count, bytes_per_vector);
+    return (grain + V3_REDUCE_BLOCK - 1) / V3_REDUCE_BLOCK * V3_REDUCE_BLOCK;
+}
+
+// run a reduction and write its stream sums to dst
+static bool reduce(float *dst, reduce_job *job, size_t count, size_t bytes_per_vector)
+{
+    if (count == 0)
+    {
+        for (int stream = 0; stream < job->streams; stream++)
+        {
+            dst[stream] = 0.0f;
+        }
+        return true;
+    }
+
+    v3_arena *arena = v3_thread_arena();
+    v3_arena_mark mark = v3_arena_mark_position(arena);
+    size_t blocks = (count + V3_REDUCE_BLOCK - 1) / V3_REDUCE_BLOCK;
+    job->partials = (float *)v3_arena_alloc(arena, blocks * job->streams * sizeof(float));
+    if (job->partials == NULL)
+    {
+        v3_arena_restore(arena, mark);
+        errno = ENOMEM;
+        return false;
+    }
+
+    job->kernels = v3_get_kernels();
+    v3_parallel_for(count, block_grain(count, bytes_per_vector), reduce_task, job);
+    for (int stream = 0; stream < job->streams; stream++)
+    {
+        dst[stream] = pairwise(job->partials + stream, blocks, job->streams);
+    }
+
+    v3_arena_restore(arena, mark);
+    return true;
+}
+
+// dst = sum of a
+bool v3_sum(float *dst, v3_soa a, size_t count, v3_reduce_mode mode)
+{
+    assert(dst != NULL);
+    assert(count == 0 || (a.x != NULL && a.y != NULL && a.z != NULL));
+
+    V3_PROBE_BEGIN();
+
+    reduce_job job = {REDUCE_SUM, 3, mode, NULL, a, a, NULL, {0.0f, 0.0f, 0.0f}, NULL};
+    bool ok = reduce(dst, &job, count, 3 * sizeof(float));
+
+    V3_PROBE_END(V3_PROBE_SUM, count, 0);
+    return ok;
+}
+
+// mean of a, shared by v3_mean and v3_covariance so neither counts as a v3_sum call
+static bool mean(float *dst, v3_soa a, size_t count, v3_reduce_mode mode)
+{
+    assert(count == 0 || (a.x != NULL && a.y != NULL && a.z != NULL));
+
+    reduce_job job = {REDUCE_SUM, 3, mode, NULL, a, a, NULL, {0.0f, 0.0f, 0.0f}, NULL};
+    float sum[3];
+    if (!reduce(sum, &job, count, 3 * sizeof(float)))
+    {
+        return false;
+    }
+
+    float inv = (count > 0) ? 1.0f / (float)count : 0.0f;
+    dst[0] = sum[0] * inv;
+    dst[1] = sum[1] * inv;
+    dst[2] = sum[2] * inv;
+    return true;
+}
+
+// dst = sum of a / count
+bool v3_mean(float *dst, v3_soa a, size_t count, v3_reduce_mode mode)
+{
+    assert(dst != NULL);
+    V3_PROBE_BEGIN();
+
+    bool ok = mean(dst, a, count, mode);
+
+    V3_PROBE_END(V3_PROBE_MEAN, count, 0);
+    return ok;
+}
+
+// dst = sum of w[i] * a[i]
+bool v3_weighted_sum(float *dst, v3_soa a, const float *w, size_t count, v3_reduce_mode mode)
+{
+    assert(dst != NULL);
+    assert(count == 0 || (a.x != NULL && a.y != NULL && a.z != NULL && w != NULL));
+    V3_PROBE_BEGIN();
+
+    reduce_job job = {REDUCE_WEIGHTED, 3, mode, NULL, a, a, w, {0.0f, 0.0f, 0.0f}, NULL};
+    bool ok = reduce(dst, &job, count, 4 * sizeof(float));
+
+    V3_PROBE_END(V3_PROBE_WEIGHTED_SUM, count, 0);
+    return ok;
+}
+
+// dst = sum of a[i] . b[i]
+bool v3_dot_sum(float *dst, v3_soa a, v3_soa b, size_t count, v3_reduce_mode mode)
+{
+    assert(dst != NULL);
+    assert(count == 0 || (a.x != NULL && a.y != NULL && a.z != NULL));
+    assert(count == 0 || (b.x != NULL && b.y != NULL && b.z != NULL));
+    V3_PROBE_BEGIN();
+
+    reduce_job job = {REDUCE_DOT, 1, mode, NULL, a, b, NULL, {0.0f, 0.0f, 0.0f}, NULL};
+    bool ok = reduce(dst, &job, count, 6 * sizeof(float));
+
+    V3_PROBE_END(V3_PROBE_DOT_SUM, count, 0);
+    return ok;
+}
+
+// covariance of a about its mean
+bool v3_covariance(v3_mat3 *dst, v3_soa a, size_t count, v3_reduce_mode mode)
+{
+    assert(dst != NULL);
+    V3_PROBE_BEGIN();
+
+    // centering first keeps the products small; the one pass form
+    // sum(x y) / n - mx my cancels catastrophically when the mean is large
+    reduce_job job = {REDUCE_COVARIANCE, MAX_STREAMS, mode, NULL, a, a, NULL, {0.0f, 0.0f, 0.0f}, NULL};
+    float sums[MAX_STREAMS];
+    if (!mean(job.center, a, count, mode) || !reduce(sums, &job, count, 3 * sizeof(float)))
+    {
+        V3_PROBE_END(V3_PROBE_COVARIANCE, count, 0);
+        return false;
+    }
+
+    float inv = (count > 0) ? 1.0f / (float)count : 0.0f;
+    for (int stream = 0; stream < MAX_STREAMS; stream++)
+    {
+        int p = covariance_axes[stream][0], q = covariance_axes[stream][1];
+        dst->m[p * 3 + q] = sums[stream] * inv;
+        dst->m[q * 3 + p] = sums[stream] * inv;
+    }
+
+    V3_PROBE_END(V3_PROBE_COVARIANCE, count, 0);
+    return true;
+}
+
+// bounds of the blocks in [begin, end), 6 floats per block
+static void bounds_task(void *context, size_t begin, size_t end)
+{
+    reduce_job *job = (reduce_job *)context;
+
+    for (size_t block = begin; block < end; block += V3_REDUCE_BLOCK)
+    {
+        size_t n = (end - block < V3_REDUCE_BLOCK) ? end - block : V3_REDUCE_BLOCK;
+        float *partial = job->partials + block / V3_REDUCE_BLOCK * 6;
+        for (int axis = 0; axis < 3; axis++)
+        {
+            partial[axis] = INFINITY;
+            partial[axis + 3] = -INFINITY;
+            job->kernels->bounds(&partial[axis], &partial[axis + 3], axis_of(job->a, axis) + block, n);
+        }
+    }
+}
+
+// axis-aligned bounding box of a
+bool v3_bounds(float *min, float *max, v3_soa a, size_t count)
+{
+    assert(min != NULL && max != NULL);
+    assert(count == 0 || (a.x != NULL && a.y != NULL && a.z != NULL));
+    V3_PROBE_BEGIN();
+
+    float lo[3] = {INFINITY, INFINITY, INFINITY};
+    float hi[3] = {-INFINITY, -INFINITY, -INFINITY};
+    v3_arena *arena = v3_thread_arena();
+    v3_arena_mark mark = v3_arena_mark_position(arena);
+    size_t blocks = (count + V3_REDUCE_BLOCK - 1) / V3_REDUCE_BLOCK;
+    reduce_job job = {REDUCE_SUM, 6, V3_REDUCE_FAST, v3_get_kernels(), a, a, NULL, {0.0f, 0.0f, 0.0f}, NULL};
+    job.partials = (float *)v3_arena_alloc(arena, blocks * 6 * sizeof(float));
+    if (count > 0 && job.partials == NULL)
+    {
+        v3_arena_restore(arena, mark);
+        errno = ENOMEM;
+        V3_PROBE_END(V3_PROBE_BOUNDS, count, 0);
+        return false;
+    }
+
+    v3_parallel_for(count, block_grain(count, 3 * sizeof(float)), bounds_task, &job);
+    for (size_t block = 0; block < blocks; block++)
+    {
+        const float *partial = job.partials + block * 6;
+        for (int axis = 0; axis < 3; axis++)
+        {
+            lo[axis] = (partial[axis] < lo[axis]) ? partial[axis] : lo[axis];
+            hi[axis] = (partial[axis + 3] > hi[axis]) ? partial[axis + 3] : hi[axis];
+        }
+    }
+
+    v3_arena_restore(arena, mark);
+    memcpy(min, lo, sizeof(lo));
+    memcpy(max, hi, sizeof(hi));
+
+    V3_PROBE_END(V3_PROBE_BOUNDS, count, 0);
+    return true;
+}
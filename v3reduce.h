@@ -0,0 +1,56 @@
+#ifndef V3REDUCE_H
+#define V3REDUCE_H
+
+// library inclusions
+#include "v3math.h"
+#include "v3mat.h"
+
+// parallel reductions over vector arrays: sums, means, bounding boxes,
+// covariance and dot product sums
+//
+// summing n floats one after another loses about n * FLT_EPSILON / 2 of
+// relative accuracy, so past ~10M elements a running float sum is off in the
+// second or third digit. every reduction here cuts the array into blocks of
+// V3_REDUCE_BLOCK vectors and sums each block into V3_SUM_LANES interleaved
+// lanes on the simd kernels; the lanes of a block and then the block partials
+// are added pairwise, so rounding grows with the log of the count
+//
+// the block size and the order of every addition are fixed by the count alone,
+// never by the thread count or chunk stealing, so results are bit-identical for
+// any number of threads. the lanes are the same on every instruction set, so
+// every reduction but v3_dot_sum, whose products are fused on avx2 and
+// avx-512, also matches across them
+
+// vectors per block, the unit of work the partial sums are kept for
+#define V3_REDUCE_BLOCK 4096
+
+typedef enum
+{
+    V3_REDUCE_FAST,     // plain lanes, pairwise above them
+    V3_REDUCE_KAHAN     // kahan compensated lanes, slower, error nearly independent of count
+} v3_reduce_mode;
+
+// the reductions take their block partials from the calling thread's arena and
+// return false with errno = ENOMEM, leaving dst unchanged, if it cannot grow
+
+// dst = sum of a
+bool v3_sum(float *dst, v3_soa a, size_t count, v3_reduce_mode mode);
+
+// dst = sum of a / count, the centroid; zero for count 0
+bool v3_mean(float *dst, v3_soa a, size_t count, v3_reduce_mode mode);
+
+// dst = sum of w[i] * a[i]
+bool v3_weighted_sum(float *dst, v3_soa a, const float *w, size_t count, v3_reduce_mode mode);
+
+// dst = sum of a[i] . b[i]
+bool v3_dot_sum(float *dst, v3_soa a, v3_soa b, size_t count, v3_reduce_mode mode);
+
+// axis-aligned bounding box of a; exact, so there is no mode
+// count 0 gives min = +inf and max = -inf
+bool v3_bounds(float *min, float *max, v3_soa a, size_t count);
+
+// population covariance of a about its mean, dst = sum of (a[i] - m)(a[i] - m)^T / count,
+// from two passes; scale by count / (count - 1) for the sample covariance. zero for count 0
+bool v3_covariance(v3_mat3 *dst, v3_soa a, size_t count, v3_reduce_mode mode);
+
+#endif
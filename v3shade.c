@@ -0,0 +1,57 @@
+// library inclusions
+#include "v3shade.h"
+#include "v3pool.h"
+#include "v3simd.h"
+#include "v3instrument.h"
+
+static_assert(sizeof(v3_light) == 6 * sizeof(float), "the kernels read lights as 6 packed floats");
+
+// state shared by the tasks of one call
+typedef struct
+{
+    v3_soa diffuse;
+    v3_soa specular;
+    const v3_gbuffer *g;
+    const float *lights;
+    int light_count;
+    int shininess;
+    v3_shade_model model;
+    const v3_kernels *kernels;
+} shade_job;
+
+// view of a batch starting at vector begin
+static v3_soa offset(v3_soa v, size_t begin)
+{
+    v3_soa r = {v.x + begin, v.y + begin, v.z + begin};
+    return r;
+}
+
+static void shade_task(void *context, size_t begin, size_t end)
+{
+    shade_job *job = (shade_job *)context;
+    job->kernels->shade(offset(job->diffuse, begin), offset(job->specular, begin), offset(job->g->position, begin),
+                        offset(job->g->normal, begin), offset(job->g->view, begin), job->lights, job->light_count,
+                        job->shininess, job->model, end - begin);
+}
+
+// shade every pixel of g into rgb diffuse and specular terms
+void v3_shade_batch(v3_soa diffuse, v3_soa specular, const v3_gbuffer *g, const v3_light *lights, int light_count,
+                    int shininess, v3_shade_model model)
+{
+    assert(diffuse.x != NULL && diffuse.y != NULL && diffuse.z != NULL);
+    assert(specular.x != NULL && specular.y != NULL && specular.z != NULL);
+    assert(g != NULL && g->position.x != NULL && g->normal.x != NULL && g->view.x != NULL);
+    assert(light_count >= 0 && (lights != NULL || light_count == 0));
+    assert(shininess >= 0);
+    V3_PROBE_BEGIN();
+
+    shade_job job = {diffuse, specular, g, (const float *)lights, light_count, shininess, model, v3_get_kernels()};
+
+    // the work grows with the lights, so the threshold for threads counts
+    // pixel-lights; below it the pool and its grain heuristic are not asked
+    size_t work = g->count * (size_t)(light_count > 0 ? light_count : 1);
+    size_t grain = (work < V3_POOL_MIN_PARALLEL) ? g->count : v3_pool_grain(g->count, 15 * sizeof(float));
+    v3_parallel_for(g->count, grain, shade_task, &job);
+
+    V3_PROBE_END(V3_PROBE_SHADE_BATCH, g->count, 0);
+}
@@ -0,0 +1,60 @@
+#ifndef V3SHADE_H
+#define V3SHADE_H
+
+// library inclusions
+#include "v3math.h"
+
+// diffuse and specular lighting of g-buffer batches
+//
+// per pixel, the normal n and the view direction v (surface to eye) are
+// normalized once, then for every point light the direction l to it is
+// normalized and
+//
+//     diffuse  += color * max(n . l, 0)
+//     specular += color * s^shininess, where n . l > 0
+//
+// with s = max(r . v, 0) and r = 2(n . l)n - l, l reflected about n, for phong,
+// or s = max(n . h, 0) with h = normalize(l + v) for blinn-phong. lambert
+// leaves the specular term at zero. lights have no falloff
+//
+// the shade kernel keeps a simd group of pixels in registers through every
+// light, so each pixel is read and written once whatever the light count. it
+// normalizes with the refined reciprocal square root of the fast normalize
+// and raises s to the integer shininess by repeated squaring, the same
+// multiplications on every instruction set. a cosine whose power would fall
+// under 2^-120 gives a zero term, which keeps the squaring out of denormals
+// that cost a hundred cycles each on x86. zero length normals, views and
+// light directions normalize to zero and contribute nothing. pixels are
+// independent, so threads take runs of whole simd groups
+
+// lighting model
+typedef enum
+{
+    V3_SHADE_LAMBERT,
+    V3_SHADE_PHONG,
+    V3_SHADE_BLINN_PHONG
+} v3_shade_model;
+
+// point light, color is the rgb intensity
+typedef struct
+{
+    float position[3];
+    float color[3];
+} v3_light;
+
+// g-buffer of count pixels: surface positions, normals and view directions
+typedef struct
+{
+    v3_soa position;
+    v3_soa normal;
+    v3_soa view;
+    size_t count;
+} v3_gbuffer;
+
+// shade every pixel of g under light_count lights into rgb diffuse and specular
+// terms, x, y and z holding red, green and blue; shininess must not be negative
+// the outputs must not overlap the g-buffer
+void v3_shade_batch(v3_soa diffuse, v3_soa specular, const v3_gbuffer *g, const v3_light *lights, int light_count,
+                    int shininess, v3_shade_model model);
+
+#endif
@@ -0,0 +1,2964 @@
+// library inclusions
+#include "v3simd.h"
+#include "v3shade.h"
+#include "v3ray.h"
+#include <stdlib.h>
+#include <float.h>
+
+// acos(x) = sqrt(1 - x) * p(x) on [0, 1], abramowitz and stegun 4.4.46, error 2e-8
+// before float rounding; negative x use acos(x) = pi - acos(-x)
+#define ACOS_C0 1.5707963050f
+#define ACOS_C1 -0.2145988016f
+#define ACOS_C2 0.0889789874f
+#define ACOS_C3 -0.0501743046f
+#define ACOS_C4 0.0308918810f
+#define ACOS_C5 -0.0170881256f
+#define ACOS_C6 0.0066700901f
+#define ACOS_C7 -0.0012624911f
+#define ACOS_PI 3.14159265358979f
+
+// single element helpers shared by the scalar kernels and the simd tails
+
+static inline float dot_one(v3_soa a, v3_soa b, size_t i)
+{
+    return a.x[i] * b.x[i] + a.y[i] * b.y[i] + a.z[i] * b.z[i];
+}
+
+static inline void cross_one(v3_soa dst, v3_soa a, v3_soa b, size_t i)
+{
+    // load the element before storing so dst may alias a or b
+    float ax = a.x[i], ay = a.y[i], az = a.z[i];
+    float bx = b.x[i], by = b.y[i], bz = b.z[i];
+
+    dst.x[i] = ay * bz - az * by;
+    dst.y[i] = az * bx - ax * bz;
+    dst.z[i] = ax * by - ay * bx;
+}
+
+// returns 1 if the element was zero length
+static inline size_t normalize_one(v3_soa dst, v3_soa a, size_t i)
+{
+    float ax = a.x[i], ay = a.y[i], az = a.z[i];
+    float len = sqrtf(ax * ax + ay * ay + az * az);
+
+    if (len < V3_EPSILON)
+    {
+        dst.x[i] = 0.0f;
+        dst.y[i] = 0.0f;
+        dst.z[i] = 0.0f;
+        return 1;
+    }
+
+    float inv_len = 1.0f / len;
+    dst.x[i] = ax * inv_len;
+    dst.y[i] = ay * inv_len;
+    dst.z[i] = az * inv_len;
+    return 0;
+}
+
+static inline void reflect_one(v3_soa dst, v3_soa v, v3_soa n, size_t i)
+{
+    float vx = v.x[i], vy = v.y[i], vz = v.z[i];
+    float nx = n.x[i], ny = n.y[i], nz = n.z[i];
+    float dot = vx * nx + vy * ny + vz * nz;
+
+    dst.x[i] = vx - 2.0f * dot * nx;
+    dst.y[i] = vy - 2.0f * dot * ny;
+    dst.z[i] = vz - 2.0f * dot * nz;
+}
+
+static inline void normalize_fast_one(v3_soa dst, v3_soa a, uint8_t *valid, size_t i)
+{
+    float ax = a.x[i], ay = a.y[i], az = a.z[i];
+    float inv_len = v3_rsqrt_nr(ax * ax + ay * ay + az * az);
+
+    dst.x[i] = ax * inv_len;
+    dst.y[i] = ay * inv_len;
+    dst.z[i] = az * inv_len;
+    if (valid != NULL)
+    {
+        valid[i] = inv_len > 0.0f;
+    }
+}
+
+static inline void inv_length_one(float *dst, v3_soa a, size_t i)
+{
+    dst[i] = v3_rsqrt_nr(a.x[i] * a.x[i] + a.y[i] * a.y[i] + a.z[i] * a.z[i]);
+}
+
+static inline void transform_one(v3_soa dst, const float *m, v3_soa a, size_t i)
+{
+    float x = a.x[i], y = a.y[i], z = a.z[i];
+
+    dst.x[i] = m[0] * x + m[1] * y + m[2] * z + m[3];
+    dst.y[i] = m[4] * x + m[5] * y + m[6] * z + m[7];
+    dst.z[i] = m[8] * x + m[9] * y + m[10] * z + m[11];
+}
+
+static inline void rotate_one(v3_soa dst, const float *q, v3_soa a, size_t i)
+{
+    float x = a.x[i], y = a.y[i], z = a.z[i];
+    float tx = 2.0f * (q[1] * z - q[2] * y);
+    float ty = 2.0f * (q[2] * x - q[0] * z);
+    float tz = 2.0f * (q[0] * y - q[1] * x);
+
+    dst.x[i] = x + q[3] * tx + (q[1] * tz - q[2] * ty);
+    dst.y[i] = y + q[3] * ty + (q[2] * tx - q[0] * tz);
+    dst.z[i] = z + q[3] * tz + (q[0] * ty - q[1] * tx);
+}
+
+static inline float acos_poly_one(float c)
+{
+    float x = fabsf(c);
+    float p = ACOS_C7;
+    p = p * x + ACOS_C6;
+    p = p * x + ACOS_C5;
+    p = p * x + ACOS_C4;
+    p = p * x + ACOS_C3;
+    p = p * x + ACOS_C2;
+    p = p * x + ACOS_C1;
+    p = p * x + ACOS_C0;
+    float r = sqrtf(1.0f - x) * p;
+    return (c < 0.0f) ? ACOS_PI - r : r;
+}
+
+// fused cosine from one rsqrt of the product of squared lengths
+// returns 1 if either vector was zero length, storing cosine 1 (angle 0)
+static inline size_t angle_one(float *dst, v3_soa a, v3_soa b, size_t i, v3_angle_accuracy accuracy)
+{
+    float ax = a.x[i], ay = a.y[i], az = a.z[i];
+    float bx = b.x[i], by = b.y[i], bz = b.z[i];
+    float len2_a = ax * ax + ay * ay + az * az;
+    float len2_b = bx * bx + by * by + bz * bz;
+    float dot = ax * bx + ay * by + az * bz;
+
+    bool valid = len2_a >= V3_EPSILON * V3_EPSILON && len2_b >= V3_EPSILON * V3_EPSILON;
+    float c = 1.0f;
+    if (valid)
+    {
+        // y = y * (1.5 - 0.5 * x * y * y)
+        float x = len2_a * len2_b;
+#ifdef V3_X86
+        float y = _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(x)));
+#else
+        float y = 1.0f / sqrtf(x);
+#endif
+        y = y * (1.5f - (0.5f * x) * (y * y));
+        c = dot * y;
+        c = (c > 1.0f) ? 1.0f : c;
+        c = (c < -1.0f) ? -1.0f : c;
+    }
+
+    dst[i] = (accuracy == V3_ANGLE_POLY) ? acos_poly_one(c) : c;
+    return !valid;
+}
+
+// kahan step: the compensation c carries the low bits lost by the previous add
+// y = x - c, t = s + y, c = (t - s) - y, s = t
+static inline void kahan_one(float *s, float *c, float x)
+{
+    float y = x - *c;
+    float t = *s + y;
+    *c = (t - *s) - y;
+    *s = t;
+}
+
+// largest snorm value of a bits-bit octahedral coordinate
+static inline float oct_scale(int bits)
+{
+    return (float)((1 << (bits - 1)) - 1);
+}
+
+// packed coordinates of element i, 16-bit pairs in a uint32_t or 8-bit pairs in a uint16_t
+static inline void oct_load(const void *src, size_t i, int bits, int32_t *qu, int32_t *qv)
+{
+    if (bits == 16)
+    {
+        uint32_t p = ((const uint32_t *)src)[i];
+        *qu = (int16_t)(p & 0xffffu);
+        *qv = (int16_t)(p >> 16);
+    }
+    else
+    {
+        uint16_t p = ((const uint16_t *)src)[i];
+        *qu = (int8_t)(p & 0xffu);
+        *qv = (int8_t)(p >> 8);
+    }
+}
+
+static inline void oct_store(void *dst, size_t i, int bits, int32_t qu, int32_t qv)
+{
+    if (bits == 16)
+    {
+        ((uint32_t *)dst)[i] = ((uint32_t)qu & 0xffffu) | ((uint32_t)qv << 16);
+    }
+    else
+    {
+        ((uint16_t *)dst)[i] = (uint16_t)(((uint32_t)qu & 0xffu) | (((uint32_t)qv & 0xffu) << 8));
+    }
+}
+
+// project onto the octahedron |x| + |y| + |z| = 1, fold the lower half over the
+// upper one and round u and v to snorm; a zero vector becomes (0, 0), which is +z
+static inline void oct_encode_one(void *dst, v3_soa a, size_t i, int bits)
+{
+    float x = a.x[i], y = a.y[i], z = a.z[i];
+    float inv = 1.0f / fmaxf(fabsf(x) + fabsf(y) + fabsf(z), FLT_MIN);
+    float u = x * inv, v = y * inv;
+    if (z < 0.0f)
+    {
+        float folded_u = copysignf(1.0f - fabsf(v), u);
+        v = copysignf(1.0f - fabsf(u), v);
+        u = folded_u;
+    }
+
+    float scale = oct_scale(bits);
+    oct_store(dst, i, bits, (int32_t)lrintf(u * scale), (int32_t)lrintf(v * scale));
+}
+
+// unfold and normalize element i into n
+static inline void oct_decode_one(float *n, const void *src, size_t i, int bits)
+{
+    int32_t qu, qv;
+    oct_load(src, i, bits, &qu, &qv);
+
+    // the most negative snorm code lies past -1
+    float inv_scale = 1.0f / oct_scale(bits);
+    float u = fmaxf((float)qu * inv_scale, -1.0f), v = fmaxf((float)qv * inv_scale, -1.0f);
+    float z = 1.0f - fabsf(u) - fabsf(v);
+    float t = fmaxf(-z, 0.0f);
+    float x = u - copysignf(t, u), y = v - copysignf(t, v);
+
+    // the octahedron lies between radius 1 / sqrt(3) and 1, so the length is never small
+    float inv_len = v3_rsqrt_nr(x * x + y * y + z * z);
+    n[0] = x * inv_len;
+    n[1] = y * inv_len;
+    n[2] = z * inv_len;
+}
+
+static inline void oct_dot_one(float *dst, const void *packed, v3_soa v, size_t i, int bits)
+{
+    float n[3];
+    oct_decode_one(n, packed, i, bits);
+    dst[i] = n[0] * v.x[i] + n[1] * v.y[i] + n[2] * v.z[i];
+}
+
+static inline void oct_reflect_one(v3_soa dst, v3_soa v, const void *packed, size_t i, int bits)
+{
+    float n[3];
+    oct_decode_one(n, packed, i, bits);
+    float vx = v.x[i], vy = v.y[i], vz = v.z[i];
+    float k = 2.0f * (vx * n[0] + vy * n[1] + vz * n[2]);
+    dst.x[i] = vx - k * n[0];
+    dst.y[i] = vy - k * n[1];
+    dst.z[i] = vz - k * n[2];
+}
+
+// x^k by repeated squaring, the multiplications every simd power makes; no
+// square is taken past the top bit of k
+static inline float power_one(float x, int k)
+{
+    float r = 1.0f;
+    for (; k > 0; k >>= 1)
+    {
+        if (k & 1)
+        {
+            r *= x;
+        }
+        if (k > 1)
+        {
+            x *= x;
+        }
+    }
+    return r;
+}
+
+// smallest specular cosine that is shaded; below it s^shininess is under
+// 2^-120 and its powers go denormal, at a hundred cycles a multiplication on
+// x86. every cosine passes for shininess 0, where s^0 is 1
+static inline float shade_cutoff(int shininess)
+{
+    return (shininess > 0) ? exp2f(-120.0f / (float)shininess) : -INFINITY;
+}
+
+static inline void shade_one(v3_soa diffuse, v3_soa specular, v3_soa p, v3_soa n, v3_soa v, const float *lights,
+                             int light_count, int shininess, float cutoff, int model, size_t i)
+{
+    float px = p.x[i], py = p.y[i], pz = p.z[i];
+    float nx = n.x[i], ny = n.y[i], nz = n.z[i];
+    float vx = v.x[i], vy = v.y[i], vz = v.z[i];
+    float inv = v3_rsqrt_nr(nx * nx + ny * ny + nz * nz);
+    nx *= inv;
+    ny *= inv;
+    nz *= inv;
+    inv = v3_rsqrt_nr(vx * vx + vy * vy + vz * vz);
+    vx *= inv;
+    vy *= inv;
+    vz *= inv;
+
+    float dr = 0.0f, dg = 0.0f, db = 0.0f, sr = 0.0f, sg = 0.0f, sb = 0.0f;
+    for (int j = 0; j < light_count; j++)
+    {
+        const float *light = lights + 6 * j;
+        float lx = light[0] - px, ly = light[1] - py, lz = light[2] - pz;
+        inv = v3_rsqrt_nr(lx * lx + ly * ly + lz * lz);
+        lx *= inv;
+        ly *= inv;
+        lz *= inv;
+
+        float ndl = nx * lx + ny * ly + nz * lz;
+        if (ndl <= 0.0f)
+        {
+            continue;
+        }
+        dr += ndl * light[3];
+        dg += ndl * light[4];
+        db += ndl * light[5];
+        if (model == V3_SHADE_LAMBERT)
+        {
+            continue;
+        }
+
+        // r = 2(n . l)n - l against v, or n against h = normalize(l + v)
+        float cosine;
+        if (model == V3_SHADE_PHONG)
+        {
+            float k = 2.0f * ndl;
+            cosine = (k * nx - lx) * vx + (k * ny - ly) * vy + (k * nz - lz) * vz;
+        }
+        else
+        {
+            float hx = lx + vx, hy = ly + vy, hz = lz + vz;
+            cosine = (nx * hx + ny * hy + nz * hz) * v3_rsqrt_nr(hx * hx + hy * hy + hz * hz);
+        }
+        float term = (cosine >= cutoff) ? power_one(cosine, shininess) : 0.0f;
+        sr += term * light[3];
+        sg += term * light[4];
+        sb += term * light[5];
+    }
+
+    diffuse.x[i] = dr;
+    diffuse.y[i] = dg;
+    diffuse.z[i] = db;
+    specular.x[i] = sr;
+    specular.y[i] = sg;
+    specular.z[i] = sb;
+}
+
+// lowbias32 integer hash, the jitter source of the camera kernels
+static inline uint32_t camera_hash(uint32_t h)
+{
+    h ^= h >> 16;
+    h *= 0x7feb352du;
+    h ^= h >> 15;
+    h *= 0x846ca68bu;
+    h ^= h >> 16;
+    return h;
+}
+
+// offset in [-0.5, 0.5) from the top 24 bits of a hash, exact in float
+static inline float camera_offset(uint32_t h)
+{
+    return (float)(h >> 8) * (1.0f / 16777216.0f) - 0.5f;
+}
+
+// key of the first pixel of a tile row for one sample; the pixel c columns
+// further has key + c * samples
+static inline uint32_t camera_key(size_t x, size_t y, size_t image_width, int samples, int sample, uint32_t seed)
+{
+    return (uint32_t)((y * image_width + x) * (size_t)samples + (size_t)sample) + seed * 0x9e3779b9u;
+}
+
+// direction through column x of the row whose pixel centers lie on base + x right,
+// jittered within the pixel by the hash of key; the down term is added before
+// the right term, as in the simd kernels
+static inline void camera_one(v3_soa dst, size_t i, const float *frame, const float *base, float x, uint32_t key,
+                              int jitter)
+{
+    float jx = 0.0f, jy = 0.0f;
+    if (jitter)
+    {
+        uint32_t h = camera_hash(key);
+        jx = camera_offset(h);
+        jy = camera_offset(camera_hash(h));
+    }
+    float fx = x + jx;
+    float dx = (base[0] + jy * frame[6]) + fx * frame[3];
+    float dy = (base[1] + jy * frame[7]) + fx * frame[4];
+    float dz = (base[2] + jy * frame[8]) + fx * frame[5];
+    float inv = v3_rsqrt_nr(dx * dx + dy * dy + dz * dz);
+    dst.x[i] = dx * inv;
+    dst.y[i] = dy * inv;
+    dst.z[i] = dz * inv;
+}
+
+// ray i against tri = v0, e1 = v1 - v0, e2 = v2 - v0, with the operations of
+// v3_ray_triangle in the same order so the simd lanes can match it bit for bit
+static inline void ray_triangle_one(float *t, uint8_t *hit, v3_soa origin, v3_soa dir, const float *tri, size_t i)
+{
+    const float *v0 = tri, *e1 = tri + 3, *e2 = tri + 6;
+    float dx = dir.x[i], dy = dir.y[i], dz = dir.z[i];
+    bool found = false;
+    t[i] = V3_RAY_MISS;
+
+    float px = dy * e2[2] - dz * e2[1];
+    float py = dz * e2[0] - dx * e2[2];
+    float pz = dx * e2[1] - dy * e2[0];
+    float det = e1[0] * px + e1[1] * py + e1[2] * pz;
+    if (fabsf(det) >= V3_RAY_EPSILON)
+    {
+        float inv_det = 1.0f / det;
+        float sx = origin.x[i] - v0[0], sy = origin.y[i] - v0[1], sz = origin.z[i] - v0[2];
+        float u = (sx * px + sy * py + sz * pz) * inv_det;
+        float qx = sy * e1[2] - sz * e1[1];
+        float qy = sz * e1[0] - sx * e1[2];
+        float qz = sx * e1[1] - sy * e1[0];
+        float v = (dx * qx + dy * qy + dz * qz) * inv_det;
+        float hit_t = (e2[0] * qx + e2[1] * qy + e2[2] * qz) * inv_det;
+        found = !(u < 0.0f || u > 1.0f) && !(v < 0.0f || u + v > 1.0f) && !(hit_t <= V3_RAY_EPSILON);
+        t[i] = found ? hit_t : V3_RAY_MISS;
+    }
+    if (hit != NULL)
+    {
+        hit[i] = found;
+    }
+}
+
+// ray i against sphere = center, radius, in the order of v3_ray_sphere
+static inline void ray_sphere_one(float *t, uint8_t *hit, v3_soa origin, v3_soa dir, const float *sphere, size_t i)
+{
+    float dx = dir.x[i], dy = dir.y[i], dz = dir.z[i];
+    float ox = origin.x[i] - sphere[0], oy = origin.y[i] - sphere[1], oz = origin.z[i] - sphere[2];
+    bool found = false;
+    t[i] = V3_RAY_MISS;
+
+    float a = dx * dx + dy * dy + dz * dz;
+    float b = ox * dx + oy * dy + oz * dz;
+    float c = (ox * ox + oy * oy + oz * oz) - sphere[3] * sphere[3];
+    float disc = b * b - a * c;
+    if (!(a < V3_RAY_EPSILON || disc < 0.0f))
+    {
+        float root = sqrtf(disc);
+        float near = (-b - root) / a;
+        float far = (-b + root) / a;
+        float hit_t = (near > V3_RAY_EPSILON) ? near : far;
+        found = !(hit_t <= V3_RAY_EPSILON);
+        t[i] = found ? hit_t : V3_RAY_MISS;
+    }
+    if (hit != NULL)
+    {
+        hit[i] = found;
+    }
+}
+
+// expand a movemask style bit set into one validity byte per element
+static inline void store_valid(uint8_t *valid, size_t i, unsigned bits, int width)
+{
+    if (valid == NULL)
+    {
+        return;
+    }
+
+    for (int k = 0; k < width; k++)
+    {
+        valid[i + k] = (bits >> k) & 1u;
+    }
+}
+
+// scalar kernels, the reference every simd path is checked against
+
+static void scalar_dot_product(float *dst, v3_soa a, v3_soa b, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        dst[i] = dot_one(a, b, i);
+    }
+}
+
+static void scalar_cross_product(v3_soa dst, v3_soa a, v3_soa b, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        cross_one(dst, a, b, i);
+    }
+}
+
+static size_t scalar_normalize(v3_soa dst, v3_soa a, size_t count)
+{
+    size_t zero = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        zero += normalize_one(dst, a, i);
+    }
+    return zero;
+}
+
+static void scalar_reflect(v3_soa dst, v3_soa v, v3_soa n, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        reflect_one(dst, v, n, i);
+    }
+}
+
+static void scalar_normalize_fast(v3_soa dst, v3_soa a, uint8_t *valid, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        normalize_fast_one(dst, a, valid, i);
+    }
+}
+
+static void scalar_inv_length(float *dst, v3_soa a, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        inv_length_one(dst, a, i);
+    }
+}
+
+static void scalar_transform(v3_soa dst, const float *m, v3_soa a, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        transform_one(dst, m, a, i);
+    }
+}
+
+static void scalar_rotate(v3_soa dst, const float *q, v3_soa a, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        rotate_one(dst, q, a, i);
+    }
+}
+
+static size_t scalar_angle(float *dst, v3_soa a, v3_soa b, size_t count, v3_angle_accuracy accuracy)
+{
+    size_t degenerate = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        degenerate += angle_one(dst, a, b, i, accuracy);
+    }
+    return degenerate;
+}
+
+static void scalar_sum(float *lanes, const float *x, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        lanes[i % V3_SUM_LANES] += x[i];
+    }
+}
+
+static void scalar_sum_compensated(float *lanes, float *comp, const float *x, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        kahan_one(&lanes[i % V3_SUM_LANES], &comp[i % V3_SUM_LANES], x[i]);
+    }
+}
+
+static void scalar_bounds(float *lo, float *hi, const float *x, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        *lo = (x[i] < *lo) ? x[i] : *lo;
+        *hi = (x[i] > *hi) ? x[i] : *hi;
+    }
+}
+
+static void scalar_oct_encode(void *dst, v3_soa a, size_t count, int bits)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        oct_encode_one(dst, a, i, bits);
+    }
+}
+
+static void scalar_oct_decode(v3_soa dst, const void *src, size_t count, int bits)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        float n[3];
+        oct_decode_one(n, src, i, bits);
+        dst.x[i] = n[0];
+        dst.y[i] = n[1];
+        dst.z[i] = n[2];
+    }
+}
+
+static void scalar_oct_dot(float *dst, const void *n, v3_soa v, size_t count, int bits)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        oct_dot_one(dst, n, v, i, bits);
+    }
+}
+
+static void scalar_oct_reflect(v3_soa dst, v3_soa v, const void *n, size_t count, int bits)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        oct_reflect_one(dst, v, n, i, bits);
+    }
+}
+
+static void scalar_shade(v3_soa diffuse, v3_soa specular, v3_soa p, v3_soa n, v3_soa v, const float *lights,
+                         int light_count, int shininess, int model, size_t count)
+{
+    float cutoff = shade_cutoff(shininess);
+    for (size_t i = 0; i < count; i++)
+    {
+        shade_one(diffuse, specular, p, n, v, lights, light_count, shininess, cutoff, model, i);
+    }
+}
+
+static void scalar_camera(v3_soa dst, const float *frame, size_t x0, size_t y0, size_t width, size_t height,
+                          size_t image_width, int samples, uint32_t seed, int jitter)
+{
+    size_t i = 0;
+    for (size_t r = 0; r < height; r++)
+    {
+        float y = (float)(y0 + r);
+        float base[3] = {frame[0] + y * frame[6], frame[1] + y * frame[7], frame[2] + y * frame[8]};
+        for (int s = 0; s < samples; s++)
+        {
+            uint32_t key = camera_key(x0, y0 + r, image_width, samples, s, seed);
+            for (size_t c = 0; c < width; c++, i++)
+            {
+                camera_one(dst, i, frame, base, (float)(x0 + c), key + (uint32_t)(c * (size_t)samples), jitter);
+            }
+        }
+    }
+}
+
+static void scalar_ray_triangle(float *t, uint8_t *hit, v3_soa origin, v3_soa dir, const float *tri, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        ray_triangle_one(t, hit, origin, dir, tri, i);
+    }
+}
+
+static void scalar_ray_sphere(float *t, uint8_t *hit, v3_soa origin, v3_soa dir, const float *sphere, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        ray_sphere_one(t, hit, origin, dir, sphere, i);
+    }
+}
+
+#ifdef V3_X86
+
+// fold count lane minima into lo and lane maxima into hi; lanes that saw no
+// element still hold the starting bounds, so each side only meets its own
+static void fold_bounds(float *lo, float *hi, const float *lane_lo, const float *lane_hi, size_t count)
+{
+    for (size_t k = 0; k < count; k++)
+    {
+        *lo = (lane_lo[k] < *lo) ? lane_lo[k] : *lo;
+        *hi = (lane_hi[k] > *hi) ? lane_hi[k] : *hi;
+    }
+}
+
+// sse4.1 kernels, 4 elements per iteration
+
+__attribute__((target("sse4.1")))
+static void sse41_dot_product(float *dst, v3_soa a, v3_soa b, size_t count)
+{
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 d = _mm_mul_ps(_mm_loadu_ps(a.x + i), _mm_loadu_ps(b.x + i));
+        d = _mm_add_ps(d, _mm_mul_ps(_mm_loadu_ps(a.y + i), _mm_loadu_ps(b.y + i)));
+        d = _mm_add_ps(d, _mm_mul_ps(_mm_loadu_ps(a.z + i), _mm_loadu_ps(b.z + i)));
+        _mm_storeu_ps(dst + i, d);
+    }
+    for (; i < count; i++)
+    {
+        dst[i] = dot_one(a, b, i);
+    }
+}
+
+__attribute__((target("sse4.1")))
+static void sse41_cross_product(v3_soa dst, v3_soa a, v3_soa b, size_t count)
+{
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 ax = _mm_loadu_ps(a.x + i), ay = _mm_loadu_ps(a.y + i), az = _mm_loadu_ps(a.z + i);
+        __m128 bx = _mm_loadu_ps(b.x + i), by = _mm_loadu_ps(b.y + i), bz = _mm_loadu_ps(b.z + i);
+        _mm_storeu_ps(dst.x + i, _mm_sub_ps(_mm_mul_ps(ay, bz), _mm_mul_ps(az, by)));
+        _mm_storeu_ps(dst.y + i, _mm_sub_ps(_mm_mul_ps(az, bx), _mm_mul_ps(ax, bz)));
+        _mm_storeu_ps(dst.z + i, _mm_sub_ps(_mm_mul_ps(ax, by), _mm_mul_ps(ay, bx)));
+    }
+    for (; i < count; i++)
+    {
+        cross_one(dst, a, b, i);
+    }
+}
+
+__attribute__((target("sse4.1")))
+static size_t sse41_normalize(v3_soa dst, v3_soa a, size_t count)
+{
+    const __m128 eps = _mm_set1_ps(V3_EPSILON);
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 zero = _mm_setzero_ps();
+    size_t degenerate = 0;
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 x = _mm_loadu_ps(a.x + i), y = _mm_loadu_ps(a.y + i), z = _mm_loadu_ps(a.z + i);
+        __m128 len2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+        __m128 len = _mm_sqrt_ps(len2);
+
+        // lanes that are not below epsilon keep their value, like the scalar compare
+        __m128 valid = _mm_cmpnlt_ps(len, eps);
+        __m128 inv_len = _mm_div_ps(one, len);
+        degenerate += 4 - __builtin_popcount(_mm_movemask_ps(valid));
+
+        _mm_storeu_ps(dst.x + i, _mm_blendv_ps(zero, _mm_mul_ps(x, inv_len), valid));
+        _mm_storeu_ps(dst.y + i, _mm_blendv_ps(zero, _mm_mul_ps(y, inv_len), valid));
+        _mm_storeu_ps(dst.z + i, _mm_blendv_ps(zero, _mm_mul_ps(z, inv_len), valid));
+    }
+    for (; i < count; i++)
+    {
+        degenerate += normalize_one(dst, a, i);
+    }
+    return degenerate;
+}
+
+__attribute__((target("sse4.1")))
+static void sse41_reflect(v3_soa dst, v3_soa v, v3_soa n, size_t count)
+{
+    const __m128 two = _mm_set1_ps(2.0f);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 vx = _mm_loadu_ps(v.x + i), vy = _mm_loadu_ps(v.y + i), vz = _mm_loadu_ps(v.z + i);
+        __m128 nx = _mm_loadu_ps(n.x + i), ny = _mm_loadu_ps(n.y + i), nz = _mm_loadu_ps(n.z + i);
+        __m128 dot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, nx), _mm_mul_ps(vy, ny)), _mm_mul_ps(vz, nz));
+        __m128 k = _mm_mul_ps(two, dot);
+        _mm_storeu_ps(dst.x + i, _mm_sub_ps(vx, _mm_mul_ps(k, nx)));
+        _mm_storeu_ps(dst.y + i, _mm_sub_ps(vy, _mm_mul_ps(k, ny)));
+        _mm_storeu_ps(dst.z + i, _mm_sub_ps(vz, _mm_mul_ps(k, nz)));
+    }
+    for (; i < count; i++)
+    {
+        reflect_one(dst, v, n, i);
+    }
+}
+
+// rsqrt estimate plus one newton-raphson step, zeroed below epsilon squared
+__attribute__((target("sse4.1")))
+static inline __m128 sse41_rsqrt_nr(__m128 len2, __m128 *valid)
+{
+    __m128 y = _mm_rsqrt_ps(len2);
+    __m128 half_x = _mm_mul_ps(_mm_set1_ps(0.5f), len2);
+    y = _mm_mul_ps(y, _mm_sub_ps(_mm_set1_ps(1.5f), _mm_mul_ps(half_x, _mm_mul_ps(y, y))));
+    *valid = _mm_cmpge_ps(len2, _mm_set1_ps(V3_EPSILON * V3_EPSILON));
+    return _mm_and_ps(y, *valid);
+}
+
+__attribute__((target("sse4.1")))
+static void sse41_normalize_fast(v3_soa dst, v3_soa a, uint8_t *valid, size_t count)
+{
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 x = _mm_loadu_ps(a.x + i), y = _mm_loadu_ps(a.y + i), z = _mm_loadu_ps(a.z + i);
+        __m128 len2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+        __m128 mask;
+        __m128 inv_len = sse41_rsqrt_nr(len2, &mask);
+
+        _mm_storeu_ps(dst.x + i, _mm_mul_ps(x, inv_len));
+        _mm_storeu_ps(dst.y + i, _mm_mul_ps(y, inv_len));
+        _mm_storeu_ps(dst.z + i, _mm_mul_ps(z, inv_len));
+        store_valid(valid, i, _mm_movemask_ps(mask), 4);
+    }
+    for (; i < count; i++)
+    {
+        normalize_fast_one(dst, a, valid, i);
+    }
+}
+
+__attribute__((target("sse4.1")))
+static void sse41_inv_length(float *dst, v3_soa a, size_t count)
+{
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 x = _mm_loadu_ps(a.x + i), y = _mm_loadu_ps(a.y + i), z = _mm_loadu_ps(a.z + i);
+        __m128 len2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+        __m128 mask;
+        _mm_storeu_ps(dst + i, sse41_rsqrt_nr(len2, &mask));
+    }
+    for (; i < count; i++)
+    {
+        inv_length_one(dst, a, i);
+    }
+}
+
+__attribute__((target("sse4.1")))
+static void sse41_transform(v3_soa dst, const float *m, v3_soa a, size_t count)
+{
+    __m128 m0 = _mm_set1_ps(m[0]), m1 = _mm_set1_ps(m[1]), m2 = _mm_set1_ps(m[2]), m3 = _mm_set1_ps(m[3]);
+    __m128 m4 = _mm_set1_ps(m[4]), m5 = _mm_set1_ps(m[5]), m6 = _mm_set1_ps(m[6]), m7 = _mm_set1_ps(m[7]);
+    __m128 m8 = _mm_set1_ps(m[8]), m9 = _mm_set1_ps(m[9]), m10 = _mm_set1_ps(m[10]), m11 = _mm_set1_ps(m[11]);
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 x = _mm_loadu_ps(a.x + i), y = _mm_loadu_ps(a.y + i), z = _mm_loadu_ps(a.z + i);
+        __m128 rx = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(m0, x), _mm_mul_ps(m1, y)), _mm_mul_ps(m2, z)), m3);
+        __m128 ry = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(m4, x), _mm_mul_ps(m5, y)), _mm_mul_ps(m6, z)), m7);
+        __m128 rz = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(m8, x), _mm_mul_ps(m9, y)), _mm_mul_ps(m10, z)), m11);
+        _mm_storeu_ps(dst.x + i, rx);
+        _mm_storeu_ps(dst.y + i, ry);
+        _mm_storeu_ps(dst.z + i, rz);
+    }
+    for (; i < count; i++)
+    {
+        transform_one(dst, m, a, i);
+    }
+}
+
+__attribute__((target("sse4.1")))
+static void sse41_rotate(v3_soa dst, const float *q, v3_soa a, size_t count)
+{
+    __m128 qx = _mm_set1_ps(q[0]), qy = _mm_set1_ps(q[1]), qz = _mm_set1_ps(q[2]), qw = _mm_set1_ps(q[3]);
+    __m128 two = _mm_set1_ps(2.0f);
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 x = _mm_loadu_ps(a.x + i), y = _mm_loadu_ps(a.y + i), z = _mm_loadu_ps(a.z + i);
+        __m128 tx = _mm_mul_ps(two, _mm_sub_ps(_mm_mul_ps(qy, z), _mm_mul_ps(qz, y)));
+        __m128 ty = _mm_mul_ps(two, _mm_sub_ps(_mm_mul_ps(qz, x), _mm_mul_ps(qx, z)));
+        __m128 tz = _mm_mul_ps(two, _mm_sub_ps(_mm_mul_ps(qx, y), _mm_mul_ps(qy, x)));
+        __m128 cx = _mm_sub_ps(_mm_mul_ps(qy, tz), _mm_mul_ps(qz, ty));
+        __m128 cy = _mm_sub_ps(_mm_mul_ps(qz, tx), _mm_mul_ps(qx, tz));
+        __m128 cz = _mm_sub_ps(_mm_mul_ps(qx, ty), _mm_mul_ps(qy, tx));
+        _mm_storeu_ps(dst.x + i, _mm_add_ps(_mm_add_ps(x, _mm_mul_ps(qw, tx)), cx));
+        _mm_storeu_ps(dst.y + i, _mm_add_ps(_mm_add_ps(y, _mm_mul_ps(qw, ty)), cy));
+        _mm_storeu_ps(dst.z + i, _mm_add_ps(_mm_add_ps(z, _mm_mul_ps(qw, tz)), cz));
+    }
+    for (; i < count; i++)
+    {
+        rotate_one(dst, q, a, i);
+    }
+}
+
+__attribute__((target("sse4.1")))
+static inline __m128 sse41_acos_poly(__m128 c)
+{
+    __m128 x = _mm_andnot_ps(_mm_set1_ps(-0.0f), c);
+    __m128 p = _mm_set1_ps(ACOS_C7);
+    p = _mm_add_ps(_mm_mul_ps(p, x), _mm_set1_ps(ACOS_C6));
+    p = _mm_add_ps(_mm_mul_ps(p, x), _mm_set1_ps(ACOS_C5));
+    p = _mm_add_ps(_mm_mul_ps(p, x), _mm_set1_ps(ACOS_C4));
+    p = _mm_add_ps(_mm_mul_ps(p, x), _mm_set1_ps(ACOS_C3));
+    p = _mm_add_ps(_mm_mul_ps(p, x), _mm_set1_ps(ACOS_C2));
+    p = _mm_add_ps(_mm_mul_ps(p, x), _mm_set1_ps(ACOS_C1));
+    p = _mm_add_ps(_mm_mul_ps(p, x), _mm_set1_ps(ACOS_C0));
+    __m128 r = _mm_mul_ps(_mm_sqrt_ps(_mm_sub_ps(_mm_set1_ps(1.0f), x)), p);
+    return _mm_blendv_ps(r, _mm_sub_ps(_mm_set1_ps(ACOS_PI), r), c);
+}
+
+__attribute__((target("sse4.1")))
+static size_t sse41_angle(float *dst, v3_soa a, v3_soa b, size_t count, v3_angle_accuracy accuracy)
+{
+    const __m128 eps2 = _mm_set1_ps(V3_EPSILON * V3_EPSILON);
+    const __m128 one = _mm_set1_ps(1.0f);
+    size_t degenerate = 0;
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 ax = _mm_loadu_ps(a.x + i), ay = _mm_loadu_ps(a.y + i), az = _mm_loadu_ps(a.z + i);
+        __m128 bx = _mm_loadu_ps(b.x + i), by = _mm_loadu_ps(b.y + i), bz = _mm_loadu_ps(b.z + i);
+        __m128 len2_a = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, ax), _mm_mul_ps(ay, ay)), _mm_mul_ps(az, az));
+        __m128 len2_b = _mm_add_ps(_mm_add_ps(_mm_mul_ps(bx, bx), _mm_mul_ps(by, by)), _mm_mul_ps(bz, bz));
+        __m128 dot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)), _mm_mul_ps(az, bz));
+        __m128 valid = _mm_and_ps(_mm_cmpge_ps(len2_a, eps2), _mm_cmpge_ps(len2_b, eps2));
+        degenerate += 4 - __builtin_popcount(_mm_movemask_ps(valid));
+
+        // zero length lanes give nan here, the blend replaces them with cosine 1
+        __m128 x = _mm_mul_ps(len2_a, len2_b);
+        __m128 y = _mm_rsqrt_ps(x);
+        y = _mm_mul_ps(y, _mm_sub_ps(_mm_set1_ps(1.5f), _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(0.5f), x), _mm_mul_ps(y, y))));
+        __m128 c = _mm_min_ps(_mm_max_ps(_mm_mul_ps(dot, y), _mm_set1_ps(-1.0f)), one);
+        c = _mm_blendv_ps(one, c, valid);
+
+        _mm_storeu_ps(dst + i, (accuracy == V3_ANGLE_POLY) ? sse41_acos_poly(c) : c);
+    }
+    for (; i < count; i++)
+    {
+        degenerate += angle_one(dst, a, b, i, accuracy);
+    }
+    return degenerate;
+}
+
+__attribute__((target("sse4.1")))
+static void sse41_sum(float *lanes, const float *x, size_t count)
+{
+    __m128 s0 = _mm_loadu_ps(lanes), s1 = _mm_loadu_ps(lanes + 4);
+    __m128 s2 = _mm_loadu_ps(lanes + 8), s3 = _mm_loadu_ps(lanes + 12);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        s0 = _mm_add_ps(s0, _mm_loadu_ps(x + i));
+        s1 = _mm_add_ps(s1, _mm_loadu_ps(x + i + 4));
+        s2 = _mm_add_ps(s2, _mm_loadu_ps(x + i + 8));
+        s3 = _mm_add_ps(s3, _mm_loadu_ps(x + i + 12));
+    }
+    _mm_storeu_ps(lanes, s0);
+    _mm_storeu_ps(lanes + 4, s1);
+    _mm_storeu_ps(lanes + 8, s2);
+    _mm_storeu_ps(lanes + 12, s3);
+    scalar_sum(lanes, x + i, count - i);
+}
+
+// y = x - c, t = s + y, c = (t - s) - y, s = t
+__attribute__((target("sse4.1")))
+static inline void sse41_kahan(__m128 *s, __m128 *c, __m128 x)
+{
+    __m128 y = _mm_sub_ps(x, *c);
+    __m128 t = _mm_add_ps(*s, y);
+    *c = _mm_sub_ps(_mm_sub_ps(t, *s), y);
+    *s = t;
+}
+
+__attribute__((target("sse4.1")))
+static void sse41_sum_compensated(float *lanes, float *comp, const float *x, size_t count)
+{
+    __m128 s0 = _mm_loadu_ps(lanes), s1 = _mm_loadu_ps(lanes + 4);
+    __m128 s2 = _mm_loadu_ps(lanes + 8), s3 = _mm_loadu_ps(lanes + 12);
+    __m128 c0 = _mm_loadu_ps(comp), c1 = _mm_loadu_ps(comp + 4);
+    __m128 c2 = _mm_loadu_ps(comp + 8), c3 = _mm_loadu_ps(comp + 12);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        sse41_kahan(&s0, &c0, _mm_loadu_ps(x + i));
+        sse41_kahan(&s1, &c1, _mm_loadu_ps(x + i + 4));
+        sse41_kahan(&s2, &c2, _mm_loadu_ps(x + i + 8));
+        sse41_kahan(&s3, &c3, _mm_loadu_ps(x + i + 12));
+    }
+    _mm_storeu_ps(lanes, s0);
+    _mm_storeu_ps(lanes + 4, s1);
+    _mm_storeu_ps(lanes + 8, s2);
+    _mm_storeu_ps(lanes + 12, s3);
+    _mm_storeu_ps(comp, c0);
+    _mm_storeu_ps(comp + 4, c1);
+    _mm_storeu_ps(comp + 8, c2);
+    _mm_storeu_ps(comp + 12, c3);
+    scalar_sum_compensated(lanes, comp, x + i, count - i);
+}
+
+__attribute__((target("sse4.1")))
+static void sse41_bounds(float *lo, float *hi, const float *x, size_t count)
+{
+    __m128 l = _mm_set1_ps(*lo), h = _mm_set1_ps(*hi);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 v = _mm_loadu_ps(x + i);
+        l = _mm_min_ps(l, v);
+        h = _mm_max_ps(h, v);
+    }
+    float ls[4], hs[4];
+    _mm_storeu_ps(ls, l);
+    _mm_storeu_ps(hs, h);
+    fold_bounds(lo, hi, ls, hs, 4);
+    scalar_bounds(lo, hi, x + i, count - i);
+}
+
+// packed coordinates of 4 elements, sign extended from the low and high halves
+__attribute__((target("sse4.1")))
+static inline void sse41_oct_load(const void *src, size_t i, int bits, __m128i *qu, __m128i *qv)
+{
+    if (bits == 16)
+    {
+        __m128i p = _mm_loadu_si128((const __m128i *)((const uint32_t *)src + i));
+        *qu = _mm_srai_epi32(_mm_slli_epi32(p, 16), 16);
+        *qv = _mm_srai_epi32(p, 16);
+    }
+    else
+    {
+        __m128i p = _mm_cvtepu16_epi32(_mm_loadl_epi64((const __m128i *)((const uint16_t *)src + i)));
+        *qu = _mm_srai_epi32(_mm_slli_epi32(p, 24), 24);
+        *qv = _mm_srai_epi32(_mm_slli_epi32(p, 16), 24);
+    }
+}
+
+__attribute__((target("sse4.1")))
+static inline void sse41_oct_store(void *dst, size_t i, int bits, __m128i qu, __m128i qv)
+{
+    if (bits == 16)
+    {
+        __m128i p = _mm_or_si128(_mm_and_si128(qu, _mm_set1_epi32(0xffff)), _mm_slli_epi32(qv, 16));
+        _mm_storeu_si128((__m128i *)((uint32_t *)dst + i), p);
+    }
+    else
+    {
+        const __m128i low = _mm_set1_epi32(0xff);
+        __m128i p = _mm_or_si128(_mm_and_si128(qu, low), _mm_slli_epi32(_mm_and_si128(qv, low), 8));
+        _mm_storel_epi64((__m128i *)((uint16_t *)dst + i), _mm_packus_epi32(p, p));
+    }
+}
+
+// unfolded, normalized directions of 4 packed elements
+__attribute__((target("sse4.1")))
+static inline void sse41_oct_decode4(const void *src, size_t i, int bits, __m128 *x, __m128 *y, __m128 *z)
+{
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    const __m128 inv_scale = _mm_set1_ps(1.0f / oct_scale(bits));
+    const __m128 minus_one = _mm_set1_ps(-1.0f);
+    __m128i qu, qv;
+    sse41_oct_load(src, i, bits, &qu, &qv);
+
+    __m128 u = _mm_max_ps(_mm_mul_ps(_mm_cvtepi32_ps(qu), inv_scale), minus_one);
+    __m128 v = _mm_max_ps(_mm_mul_ps(_mm_cvtepi32_ps(qv), inv_scale), minus_one);
+    __m128 w = _mm_sub_ps(_mm_sub_ps(_mm_set1_ps(1.0f), _mm_andnot_ps(sign, u)), _mm_andnot_ps(sign, v));
+    __m128 t = _mm_max_ps(_mm_sub_ps(_mm_setzero_ps(), w), _mm_setzero_ps());
+    __m128 ux = _mm_sub_ps(u, _mm_or_ps(t, _mm_and_ps(sign, u)));
+    __m128 vy = _mm_sub_ps(v, _mm_or_ps(t, _mm_and_ps(sign, v)));
+
+    __m128 valid;
+    __m128 len2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ux, ux), _mm_mul_ps(vy, vy)), _mm_mul_ps(w, w));
+    __m128 inv_len = sse41_rsqrt_nr(len2, &valid);
+    *x = _mm_mul_ps(ux, inv_len);
+    *y = _mm_mul_ps(vy, inv_len);
+    *z = _mm_mul_ps(w, inv_len);
+}
+
+__attribute__((target("sse4.1")))
+static void sse41_oct_encode(void *dst, v3_soa a, size_t count, int bits)
+{
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 scale = _mm_set1_ps(oct_scale(bits));
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 x = _mm_loadu_ps(a.x + i), y = _mm_loadu_ps(a.y + i), z = _mm_loadu_ps(a.z + i);
+        __m128 l1 = _mm_add_ps(_mm_add_ps(_mm_andnot_ps(sign, x), _mm_andnot_ps(sign, y)), _mm_andnot_ps(sign, z));
+        __m128 inv = _mm_div_ps(one, _mm_max_ps(l1, _mm_set1_ps(FLT_MIN)));
+        __m128 u = _mm_mul_ps(x, inv), v = _mm_mul_ps(y, inv);
+
+        // 1 - |v| is never negative, so or-ing in the sign bit of u is copysign
+        __m128 folded_u = _mm_or_ps(_mm_sub_ps(one, _mm_andnot_ps(sign, v)), _mm_and_ps(sign, u));
+        __m128 folded_v = _mm_or_ps(_mm_sub_ps(one, _mm_andnot_ps(sign, u)), _mm_and_ps(sign, v));
+        __m128 lower = _mm_cmplt_ps(z, _mm_setzero_ps());
+        u = _mm_blendv_ps(u, folded_u, lower);
+        v = _mm_blendv_ps(v, folded_v, lower);
+
+        sse41_oct_store(dst, i, bits, _mm_cvtps_epi32(_mm_mul_ps(u, scale)), _mm_cvtps_epi32(_mm_mul_ps(v, scale)));
+    }
+    for (; i < count; i++)
+    {
+        oct_encode_one(dst, a, i, bits);
+    }
+}
+
+__attribute__((target("sse4.1")))
+static void sse41_oct_decode(v3_soa dst, const void *src, size_t count, int bits)
+{
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 x, y, z;
+        sse41_oct_decode4(src, i, bits, &x, &y, &z);
+        _mm_storeu_ps(dst.x + i, x);
+        _mm_storeu_ps(dst.y + i, y);
+        _mm_storeu_ps(dst.z + i, z);
+    }
+    for (; i < count; i++)
+    {
+        float n[3];
+        oct_decode_one(n, src, i, bits);
+        dst.x[i] = n[0];
+        dst.y[i] = n[1];
+        dst.z[i] = n[2];
+    }
+}
+
+__attribute__((target("sse4.1")))
+static void sse41_oct_dot(float *dst, const void *n, v3_soa v, size_t count, int bits)
+{
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 nx, ny, nz;
+        sse41_oct_decode4(n, i, bits, &nx, &ny, &nz);
+        __m128 vx = _mm_loadu_ps(v.x + i), vy = _mm_loadu_ps(v.y + i), vz = _mm_loadu_ps(v.z + i);
+        _mm_storeu_ps(dst + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, vx), _mm_mul_ps(ny, vy)), _mm_mul_ps(nz, vz)));
+    }
+    for (; i < count; i++)
+    {
+        oct_dot_one(dst, n, v, i, bits);
+    }
+}
+
+__attribute__((target("sse4.1")))
+static void sse41_oct_reflect(v3_soa dst, v3_soa v, const void *n, size_t count, int bits)
+{
+    const __m128 two = _mm_set1_ps(2.0f);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 nx, ny, nz;
+        sse41_oct_decode4(n, i, bits, &nx, &ny, &nz);
+        __m128 vx = _mm_loadu_ps(v.x + i), vy = _mm_loadu_ps(v.y + i), vz = _mm_loadu_ps(v.z + i);
+        __m128 dot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, nx), _mm_mul_ps(vy, ny)), _mm_mul_ps(vz, nz));
+        __m128 k = _mm_mul_ps(two, dot);
+        _mm_storeu_ps(dst.x + i, _mm_sub_ps(vx, _mm_mul_ps(k, nx)));
+        _mm_storeu_ps(dst.y + i, _mm_sub_ps(vy, _mm_mul_ps(k, ny)));
+        _mm_storeu_ps(dst.z + i, _mm_sub_ps(vz, _mm_mul_ps(k, nz)));
+    }
+    for (; i < count; i++)
+    {
+        oct_reflect_one(dst, v, n, i, bits);
+    }
+}
+__attribute__((target("sse4.1")))
+static inline __m128 sse41_dot3(__m128 ax, __m128 ay, __m128 az, __m128 bx, __m128 by, __m128 bz)
+{
+    return _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)), _mm_mul_ps(az, bz));
+}
+
+__attribute__((target("sse4.1")))
+static inline __m128 sse41_power(__m128 x, int k)
+{
+    __m128 r = _mm_set1_ps(1.0f);
+    for (; k > 0; k >>= 1)
+    {
+        if (k & 1)
+        {
+            r = _mm_mul_ps(r, x);
+        }
+        if (k > 1)
+        {
+            x = _mm_mul_ps(x, x);
+        }
+    }
+    return r;
+}
+
+// lights that face away are masked out rather than skipped
+__attribute__((target("sse4.1")))
+static void sse41_shade(v3_soa diffuse, v3_soa specular, v3_soa p, v3_soa n, v3_soa v, const float *lights,
+                        int light_count, int shininess, int model, size_t count)
+{
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 two = _mm_set1_ps(2.0f);
+    float cutoff = shade_cutoff(shininess);
+    const __m128 cut = _mm_set1_ps(cutoff);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 px = _mm_loadu_ps(p.x + i), py = _mm_loadu_ps(p.y + i), pz = _mm_loadu_ps(p.z + i);
+        __m128 nx = _mm_loadu_ps(n.x + i), ny = _mm_loadu_ps(n.y + i), nz = _mm_loadu_ps(n.z + i);
+        __m128 vx = _mm_loadu_ps(v.x + i), vy = _mm_loadu_ps(v.y + i), vz = _mm_loadu_ps(v.z + i);
+        __m128 valid;
+        __m128 inv = sse41_rsqrt_nr(sse41_dot3(nx, ny, nz, nx, ny, nz), &valid);
+        nx = _mm_mul_ps(nx, inv);
+        ny = _mm_mul_ps(ny, inv);
+        nz = _mm_mul_ps(nz, inv);
+        inv = sse41_rsqrt_nr(sse41_dot3(vx, vy, vz, vx, vy, vz), &valid);
+        vx = _mm_mul_ps(vx, inv);
+        vy = _mm_mul_ps(vy, inv);
+        vz = _mm_mul_ps(vz, inv);
+
+        __m128 dr = zero, dg = zero, db = zero, sr = zero, sg = zero, sb = zero;
+        for (int j = 0; j < light_count; j++)
+        {
+            const float *light = lights + 6 * j;
+            __m128 lx = _mm_sub_ps(_mm_set1_ps(light[0]), px);
+            __m128 ly = _mm_sub_ps(_mm_set1_ps(light[1]), py);
+            __m128 lz = _mm_sub_ps(_mm_set1_ps(light[2]), pz);
+            inv = sse41_rsqrt_nr(sse41_dot3(lx, ly, lz, lx, ly, lz), &valid);
+            lx = _mm_mul_ps(lx, inv);
+            ly = _mm_mul_ps(ly, inv);
+            lz = _mm_mul_ps(lz, inv);
+
+            __m128 ndl = sse41_dot3(nx, ny, nz, lx, ly, lz);
+            __m128 lit = _mm_cmpgt_ps(ndl, zero);
+            __m128 lambert = _mm_and_ps(ndl, lit);
+            __m128 r = _mm_set1_ps(light[3]), g = _mm_set1_ps(light[4]), b = _mm_set1_ps(light[5]);
+            dr = _mm_add_ps(dr, _mm_mul_ps(lambert, r));
+            dg = _mm_add_ps(dg, _mm_mul_ps(lambert, g));
+            db = _mm_add_ps(db, _mm_mul_ps(lambert, b));
+            if (model == V3_SHADE_LAMBERT)
+            {
+                continue;
+            }
+
+            __m128 cosine;
+            if (model == V3_SHADE_PHONG)
+            {
+                __m128 k = _mm_mul_ps(two, ndl);
+                cosine = sse41_dot3(_mm_sub_ps(_mm_mul_ps(k, nx), lx), _mm_sub_ps(_mm_mul_ps(k, ny), ly),
+                                    _mm_sub_ps(_mm_mul_ps(k, nz), lz), vx, vy, vz);
+            }
+            else
+            {
+                __m128 hx = _mm_add_ps(lx, vx), hy = _mm_add_ps(ly, vy), hz = _mm_add_ps(lz, vz);
+                inv = sse41_rsqrt_nr(sse41_dot3(hx, hy, hz, hx, hy, hz), &valid);
+                cosine = _mm_mul_ps(sse41_dot3(nx, ny, nz, hx, hy, hz), inv);
+            }
+            __m128 shine = _mm_and_ps(lit, _mm_cmpge_ps(cosine, cut));
+            __m128 term = _mm_and_ps(sse41_power(_mm_and_ps(cosine, shine), shininess), shine);
+            sr = _mm_add_ps(sr, _mm_mul_ps(term, r));
+            sg = _mm_add_ps(sg, _mm_mul_ps(term, g));
+            sb = _mm_add_ps(sb, _mm_mul_ps(term, b));
+        }
+
+        _mm_storeu_ps(diffuse.x + i, dr);
+        _mm_storeu_ps(diffuse.y + i, dg);
+        _mm_storeu_ps(diffuse.z + i, db);
+        _mm_storeu_ps(specular.x + i, sr);
+        _mm_storeu_ps(specular.y + i, sg);
+        _mm_storeu_ps(specular.z + i, sb);
+    }
+    for (; i < count; i++)
+    {
+        shade_one(diffuse, specular, p, n, v, lights, light_count, shininess, cutoff, model, i);
+    }
+}
+
+__attribute__((target("sse4.1")))
+static inline __m128i sse41_camera_hash(__m128i h)
+{
+    h = _mm_xor_si128(h, _mm_srli_epi32(h, 16));
+    h = _mm_mullo_epi32(h, _mm_set1_epi32(0x7feb352d));
+    h = _mm_xor_si128(h, _mm_srli_epi32(h, 15));
+    h = _mm_mullo_epi32(h, _mm_set1_epi32((int)0x846ca68bu));
+    return _mm_xor_si128(h, _mm_srli_epi32(h, 16));
+}
+
+__attribute__((target("sse4.1")))
+static inline __m128 sse41_camera_offset(__m128i h)
+{
+    __m128 top = _mm_cvtepi32_ps(_mm_srli_epi32(h, 8));
+    return _mm_sub_ps(_mm_mul_ps(top, _mm_set1_ps(1.0f / 16777216.0f)), _mm_set1_ps(0.5f));
+}
+
+__attribute__((target("sse4.1")))
+static void sse41_camera(v3_soa dst, const float *frame, size_t x0, size_t y0, size_t width, size_t height,
+                         size_t image_width, int samples, uint32_t seed, int jitter)
+{
+    const __m128 iota = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+    const __m128i lanes = _mm_mullo_epi32(_mm_setr_epi32(0, 1, 2, 3), _mm_set1_epi32(samples));
+    const __m128 rx = _mm_set1_ps(frame[3]), ry = _mm_set1_ps(frame[4]), rz = _mm_set1_ps(frame[5]);
+    const __m128 dx = _mm_set1_ps(frame[6]), dy = _mm_set1_ps(frame[7]), dz = _mm_set1_ps(frame[8]);
+    size_t i = 0;
+    for (size_t r = 0; r < height; r++)
+    {
+        float y = (float)(y0 + r);
+        float base[3] = {frame[0] + y * frame[6], frame[1] + y * frame[7], frame[2] + y * frame[8]};
+        const __m128 bx = _mm_set1_ps(base[0]), by = _mm_set1_ps(base[1]), bz = _mm_set1_ps(base[2]);
+        for (int s = 0; s < samples; s++)
+        {
+            uint32_t key = camera_key(x0, y0 + r, image_width, samples, s, seed);
+            size_t c = 0;
+            for (; c < width; c += 4)
+            {
+                size_t n = (width - c < 4) ? width - c : 4;
+                __m128 x = _mm_add_ps(_mm_set1_ps((float)(x0 + c)), iota);
+                __m128 ox = bx, oy = by, oz = bz;
+                if (jitter)
+                {
+                    __m128i first = _mm_set1_epi32((int)(key + (uint32_t)(c * (size_t)samples)));
+                    __m128i h = sse41_camera_hash(_mm_add_epi32(first, lanes));
+                    x = _mm_add_ps(x, sse41_camera_offset(h));
+                    __m128 jy = sse41_camera_offset(sse41_camera_hash(h));
+                    ox = _mm_add_ps(_mm_mul_ps(jy, dx), ox);
+                    oy = _mm_add_ps(_mm_mul_ps(jy, dy), oy);
+                    oz = _mm_add_ps(_mm_mul_ps(jy, dz), oz);
+                }
+                ox = _mm_add_ps(_mm_mul_ps(x, rx), ox);
+                oy = _mm_add_ps(_mm_mul_ps(x, ry), oy);
+                oz = _mm_add_ps(_mm_mul_ps(x, rz), oz);
+                __m128 valid;
+                __m128 inv = sse41_rsqrt_nr(sse41_dot3(ox, oy, oz, ox, oy, oz), &valid);
+                if (n == 4)
+                {
+                    _mm_storeu_ps(dst.x + i, _mm_mul_ps(ox, inv));
+                    _mm_storeu_ps(dst.y + i, _mm_mul_ps(oy, inv));
+                    _mm_storeu_ps(dst.z + i, _mm_mul_ps(oz, inv));
+                }
+                else
+                {
+                    // a row ending inside the vector keeps its leading lanes
+                    float tx[4], ty[4], tz[4];
+                    _mm_storeu_ps(tx, _mm_mul_ps(ox, inv));
+                    _mm_storeu_ps(ty, _mm_mul_ps(oy, inv));
+                    _mm_storeu_ps(tz, _mm_mul_ps(oz, inv));
+                    memcpy(dst.x + i, tx, n * sizeof(float));
+                    memcpy(dst.y + i, ty, n * sizeof(float));
+                    memcpy(dst.z + i, tz, n * sizeof(float));
+                }
+                i += n;
+            }
+        }
+    }
+}
+
+// the ray kernels use no fma on any instruction set, so every lane rounds
+// exactly like v3_ray_triangle and v3_ray_sphere
+__attribute__((target("sse4.1")))
+static void sse41_ray_triangle(float *t, uint8_t *hit, v3_soa origin, v3_soa dir, const float *tri, size_t count)
+{
+    const __m128 v0x = _mm_set1_ps(tri[0]), v0y = _mm_set1_ps(tri[1]), v0z = _mm_set1_ps(tri[2]);
+    const __m128 e1x = _mm_set1_ps(tri[3]), e1y = _mm_set1_ps(tri[4]), e1z = _mm_set1_ps(tri[5]);
+    const __m128 e2x = _mm_set1_ps(tri[6]), e2y = _mm_set1_ps(tri[7]), e2z = _mm_set1_ps(tri[8]);
+    const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f), eps = _mm_set1_ps(V3_RAY_EPSILON);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 dx = _mm_loadu_ps(dir.x + i), dy = _mm_loadu_ps(dir.y + i), dz = _mm_loadu_ps(dir.z + i);
+
+        // p = dir x e2, det = e1 * p
+        __m128 px = _mm_sub_ps(_mm_mul_ps(dy, e2z), _mm_mul_ps(dz, e2y));
+        __m128 py = _mm_sub_ps(_mm_mul_ps(dz, e2x), _mm_mul_ps(dx, e2z));
+        __m128 pz = _mm_sub_ps(_mm_mul_ps(dx, e2y), _mm_mul_ps(dy, e2x));
+        __m128 det = sse41_dot3(e1x, e1y, e1z, px, py, pz);
+        __m128 inv_det = _mm_div_ps(one, det);
+
+        // s = origin - v0, u = (s * p) / det
+        __m128 sx = _mm_sub_ps(_mm_loadu_ps(origin.x + i), v0x);
+        __m128 sy = _mm_sub_ps(_mm_loadu_ps(origin.y + i), v0y);
+        __m128 sz = _mm_sub_ps(_mm_loadu_ps(origin.z + i), v0z);
+        __m128 u = _mm_mul_ps(sse41_dot3(sx, sy, sz, px, py, pz), inv_det);
+
+        // q = s x e1, v = (dir * q) / det, t = (e2 * q) / det
+        __m128 qx = _mm_sub_ps(_mm_mul_ps(sy, e1z), _mm_mul_ps(sz, e1y));
+        __m128 qy = _mm_sub_ps(_mm_mul_ps(sz, e1x), _mm_mul_ps(sx, e1z));
+        __m128 qz = _mm_sub_ps(_mm_mul_ps(sx, e1y), _mm_mul_ps(sy, e1x));
+        __m128 v = _mm_mul_ps(sse41_dot3(dx, dy, dz, qx, qy, qz), inv_det);
+        __m128 hit_t = _mm_mul_ps(sse41_dot3(e2x, e2y, e2z, qx, qy, qz), inv_det);
+
+        // the same rejections as the scalar function, each negated into a hit mask
+        __m128 miss = _mm_cmplt_ps(_mm_andnot_ps(_mm_set1_ps(-0.0f), det), eps);
+        miss = _mm_or_ps(miss, _mm_or_ps(_mm_cmplt_ps(u, zero), _mm_cmpgt_ps(u, one)));
+        miss = _mm_or_ps(miss, _mm_or_ps(_mm_cmplt_ps(v, zero), _mm_cmpgt_ps(_mm_add_ps(u, v), one)));
+        miss = _mm_or_ps(miss, _mm_cmple_ps(hit_t, eps));
+
+        _mm_storeu_ps(t + i, _mm_blendv_ps(hit_t, _mm_set1_ps(V3_RAY_MISS), miss));
+        store_valid(hit, i, ~_mm_movemask_ps(miss) & 0xfu, 4);
+    }
+    for (; i < count; i++)
+    {
+        ray_triangle_one(t, hit, origin, dir, tri, i);
+    }
+}
+
+__attribute__((target("sse4.1")))
+static void sse41_ray_sphere(float *t, uint8_t *hit, v3_soa origin, v3_soa dir, const float *sphere, size_t count)
+{
+    const __m128 cx = _mm_set1_ps(sphere[0]), cy = _mm_set1_ps(sphere[1]), cz = _mm_set1_ps(sphere[2]);
+    const __m128 r2 = _mm_set1_ps(sphere[3] * sphere[3]), eps = _mm_set1_ps(V3_RAY_EPSILON);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 dx = _mm_loadu_ps(dir.x + i), dy = _mm_loadu_ps(dir.y + i), dz = _mm_loadu_ps(dir.z + i);
+        __m128 ox = _mm_sub_ps(_mm_loadu_ps(origin.x + i), cx);
+        __m128 oy = _mm_sub_ps(_mm_loadu_ps(origin.y + i), cy);
+        __m128 oz = _mm_sub_ps(_mm_loadu_ps(origin.z + i), cz);
+
+        __m128 a = sse41_dot3(dx, dy, dz, dx, dy, dz);
+        __m128 b = sse41_dot3(ox, oy, oz, dx, dy, dz);
+        __m128 c = _mm_sub_ps(sse41_dot3(ox, oy, oz, ox, oy, oz), r2);
+        __m128 disc = _mm_sub_ps(_mm_mul_ps(b, b), _mm_mul_ps(a, c));
+
+        // negative discriminants give nan roots here, the miss mask discards them
+        __m128 root = _mm_sqrt_ps(disc);
+        __m128 neg_b = _mm_xor_ps(b, _mm_set1_ps(-0.0f));
+        __m128 near = _mm_div_ps(_mm_sub_ps(neg_b, root), a);
+        __m128 far = _mm_div_ps(_mm_add_ps(neg_b, root), a);
+        __m128 hit_t = _mm_blendv_ps(far, near, _mm_cmpgt_ps(near, eps));
+
+        __m128 miss = _mm_or_ps(_mm_cmplt_ps(a, eps), _mm_cmplt_ps(disc, _mm_setzero_ps()));
+        miss = _mm_or_ps(miss, _mm_cmple_ps(hit_t, eps));
+
+        _mm_storeu_ps(t + i, _mm_blendv_ps(hit_t, _mm_set1_ps(V3_RAY_MISS), miss));
+        store_valid(hit, i, ~_mm_movemask_ps(miss) & 0xfu, 4);
+    }
+    for (; i < count; i++)
+    {
+        ray_sphere_one(t, hit, origin, dir, sphere, i);
+    }
+}
+
+// avx2 + fma kernels, 8 elements per iteration
+
+__attribute__((target("avx2,fma")))
+static void avx2_dot_product(float *dst, v3_soa a, v3_soa b, size_t count)
+{
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 d = _mm256_mul_ps(_mm256_loadu_ps(a.x + i), _mm256_loadu_ps(b.x + i));
+        d = _mm256_fmadd_ps(_mm256_loadu_ps(a.y + i), _mm256_loadu_ps(b.y + i), d);
+        d = _mm256_fmadd_ps(_mm256_loadu_ps(a.z + i), _mm256_loadu_ps(b.z + i), d);
+        _mm256_storeu_ps(dst + i, d);
+    }
+    for (; i < count; i++)
+    {
+        dst[i] = dot_one(a, b, i);
+    }
+}
+
+__attribute__((target("avx2,fma")))
+static void avx2_cross_product(v3_soa dst, v3_soa a, v3_soa b, size_t count)
+{
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 ax = _mm256_loadu_ps(a.x + i), ay = _mm256_loadu_ps(a.y + i), az = _mm256_loadu_ps(a.z + i);
+        __m256 bx = _mm256_loadu_ps(b.x + i), by = _mm256_loadu_ps(b.y + i), bz = _mm256_loadu_ps(b.z + i);
+        _mm256_storeu_ps(dst.x + i, _mm256_fmsub_ps(ay, bz, _mm256_mul_ps(az, by)));
+        _mm256_storeu_ps(dst.y + i, _mm256_fmsub_ps(az, bx, _mm256_mul_ps(ax, bz)));
+        _mm256_storeu_ps(dst.z + i, _mm256_fmsub_ps(ax, by, _mm256_mul_ps(ay, bx)));
+    }
+    for (; i < count; i++)
+    {
+        cross_one(dst, a, b, i);
+    }
+}
+
+__attribute__((target("avx2,fma")))
+static size_t avx2_normalize(v3_soa dst, v3_soa a, size_t count)
+{
+    const __m256 eps = _mm256_set1_ps(V3_EPSILON);
+    const __m256 one = _mm256_set1_ps(1.0f);
+    size_t degenerate = 0;
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 x = _mm256_loadu_ps(a.x + i), y = _mm256_loadu_ps(a.y + i), z = _mm256_loadu_ps(a.z + i);
+        __m256 len2 = _mm256_fmadd_ps(z, z, _mm256_fmadd_ps(y, y, _mm256_mul_ps(x, x)));
+        __m256 len = _mm256_sqrt_ps(len2);
+        __m256 valid = _mm256_cmp_ps(len, eps, _CMP_NLT_UQ);
+        __m256 inv_len = _mm256_and_ps(_mm256_div_ps(one, len), valid);
+        degenerate += 8 - __builtin_popcount(_mm256_movemask_ps(valid));
+
+        _mm256_storeu_ps(dst.x + i, _mm256_mul_ps(x, inv_len));
+        _mm256_storeu_ps(dst.y + i, _mm256_mul_ps(y, inv_len));
+        _mm256_storeu_ps(dst.z + i, _mm256_mul_ps(z, inv_len));
+    }
+    for (; i < count; i++)
+    {
+        degenerate += normalize_one(dst, a, i);
+    }
+    return degenerate;
+}
+
+__attribute__((target("avx2,fma")))
+static void avx2_reflect(v3_soa dst, v3_soa v, v3_soa n, size_t count)
+{
+    const __m256 two = _mm256_set1_ps(2.0f);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 vx = _mm256_loadu_ps(v.x + i), vy = _mm256_loadu_ps(v.y + i), vz = _mm256_loadu_ps(v.z + i);
+        __m256 nx = _mm256_loadu_ps(n.x + i), ny = _mm256_loadu_ps(n.y + i), nz = _mm256_loadu_ps(n.z + i);
+        __m256 dot = _mm256_fmadd_ps(vz, nz, _mm256_fmadd_ps(vy, ny, _mm256_mul_ps(vx, nx)));
+        __m256 k = _mm256_mul_ps(two, dot);
+        _mm256_storeu_ps(dst.x + i, _mm256_fnmadd_ps(k, nx, vx));
+        _mm256_storeu_ps(dst.y + i, _mm256_fnmadd_ps(k, ny, vy));
+        _mm256_storeu_ps(dst.z + i, _mm256_fnmadd_ps(k, nz, vz));
+    }
+    for (; i < count; i++)
+    {
+        reflect_one(dst, v, n, i);
+    }
+}
+
+__attribute__((target("avx2,fma")))
+static inline __m256 avx2_rsqrt_nr(__m256 len2, __m256 *valid)
+{
+    __m256 y = _mm256_rsqrt_ps(len2);
+    __m256 half_x = _mm256_mul_ps(_mm256_set1_ps(0.5f), len2);
+    y = _mm256_mul_ps(y, _mm256_fnmadd_ps(half_x, _mm256_mul_ps(y, y), _mm256_set1_ps(1.5f)));
+    *valid = _mm256_cmp_ps(len2, _mm256_set1_ps(V3_EPSILON * V3_EPSILON), _CMP_GE_OQ);
+    return _mm256_and_ps(y, *valid);
+}
+
+__attribute__((target("avx2,fma")))
+static void avx2_normalize_fast(v3_soa dst, v3_soa a, uint8_t *valid, size_t count)
+{
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 x = _mm256_loadu_ps(a.x + i), y = _mm256_loadu_ps(a.y + i), z = _mm256_loadu_ps(a.z + i);
+        __m256 len2 = _mm256_fmadd_ps(z, z, _mm256_fmadd_ps(y, y, _mm256_mul_ps(x, x)));
+        __m256 mask;
+        __m256 inv_len = avx2_rsqrt_nr(len2, &mask);
+
+        _mm256_storeu_ps(dst.x + i, _mm256_mul_ps(x, inv_len));
+        _mm256_storeu_ps(dst.y + i, _mm256_mul_ps(y, inv_len));
+        _mm256_storeu_ps(dst.z + i, _mm256_mul_ps(z, inv_len));
+        store_valid(valid, i, _mm256_movemask_ps(mask), 8);
+    }
+    for (; i < count; i++)
+    {
+        normalize_fast_one(dst, a, valid, i);
+    }
+}
+
+__attribute__((target("avx2,fma")))
+static void avx2_inv_length(float *dst, v3_soa a, size_t count)
+{
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 x = _mm256_loadu_ps(a.x + i), y = _mm256_loadu_ps(a.y + i), z = _mm256_loadu_ps(a.z + i);
+        __m256 len2 = _mm256_fmadd_ps(z, z, _mm256_fmadd_ps(y, y, _mm256_mul_ps(x, x)));
+        __m256 mask;
+        _mm256_storeu_ps(dst + i, avx2_rsqrt_nr(len2, &mask));
+    }
+    for (; i < count; i++)
+    {
+        inv_length_one(dst, a, i);
+    }
+}
+
+__attribute__((target("avx2,fma")))
+static void avx2_transform(v3_soa dst, const float *m, v3_soa a, size_t count)
+{
+    // broadcast the matrix once, 12 registers stay live across the loop
+    __m256 m0 = _mm256_set1_ps(m[0]), m1 = _mm256_set1_ps(m[1]), m2 = _mm256_set1_ps(m[2]), m3 = _mm256_set1_ps(m[3]);
+    __m256 m4 = _mm256_set1_ps(m[4]), m5 = _mm256_set1_ps(m[5]), m6 = _mm256_set1_ps(m[6]), m7 = _mm256_set1_ps(m[7]);
+    __m256 m8 = _mm256_set1_ps(m[8]), m9 = _mm256_set1_ps(m[9]), m10 = _mm256_set1_ps(m[10]), m11 = _mm256_set1_ps(m[11]);
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 x = _mm256_loadu_ps(a.x + i), y = _mm256_loadu_ps(a.y + i), z = _mm256_loadu_ps(a.z + i);
+        _mm256_storeu_ps(dst.x + i, _mm256_fmadd_ps(m2, z, _mm256_fmadd_ps(m1, y, _mm256_fmadd_ps(m0, x, m3))));
+        _mm256_storeu_ps(dst.y + i, _mm256_fmadd_ps(m6, z, _mm256_fmadd_ps(m5, y, _mm256_fmadd_ps(m4, x, m7))));
+        _mm256_storeu_ps(dst.z + i, _mm256_fmadd_ps(m10, z, _mm256_fmadd_ps(m9, y, _mm256_fmadd_ps(m8, x, m11))));
+    }
+    for (; i < count; i++)
+    {
+        transform_one(dst, m, a, i);
+    }
+}
+
+__attribute__((target("avx2,fma")))
+static void avx2_rotate(v3_soa dst, const float *q, v3_soa a, size_t count)
+{
+    // the factor 2 is folded into the broadcast vector part for t
+    __m256 qx = _mm256_set1_ps(q[0]), qy = _mm256_set1_ps(q[1]), qz = _mm256_set1_ps(q[2]), qw = _mm256_set1_ps(q[3]);
+    __m256 qx2 = _mm256_set1_ps(2.0f * q[0]), qy2 = _mm256_set1_ps(2.0f * q[1]), qz2 = _mm256_set1_ps(2.0f * q[2]);
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 x = _mm256_loadu_ps(a.x + i), y = _mm256_loadu_ps(a.y + i), z = _mm256_loadu_ps(a.z + i);
+        __m256 tx = _mm256_fmsub_ps(qy2, z, _mm256_mul_ps(qz2, y));
+        __m256 ty = _mm256_fmsub_ps(qz2, x, _mm256_mul_ps(qx2, z));
+        __m256 tz = _mm256_fmsub_ps(qx2, y, _mm256_mul_ps(qy2, x));
+        __m256 cx = _mm256_fmsub_ps(qy, tz, _mm256_mul_ps(qz, ty));
+        __m256 cy = _mm256_fmsub_ps(qz, tx, _mm256_mul_ps(qx, tz));
+        __m256 cz = _mm256_fmsub_ps(qx, ty, _mm256_mul_ps(qy, tx));
+        _mm256_storeu_ps(dst.x + i, _mm256_add_ps(_mm256_fmadd_ps(qw, tx, x), cx));
+        _mm256_storeu_ps(dst.y + i, _mm256_add_ps(_mm256_fmadd_ps(qw, ty, y), cy));
+        _mm256_storeu_ps(dst.z + i, _mm256_add_ps(_mm256_fmadd_ps(qw, tz, z), cz));
+    }
+    for (; i < count; i++)
+    {
+        rotate_one(dst, q, a, i);
+    }
+}
+
+__attribute__((target("avx2,fma")))
+static inline __m256 avx2_acos_poly(__m256 c)
+{
+    __m256 x = _mm256_andnot_ps(_mm256_set1_ps(-0.0f), c);
+    __m256 p = _mm256_set1_ps(ACOS_C7);
+    p = _mm256_fmadd_ps(p, x, _mm256_set1_ps(ACOS_C6));
+    p = _mm256_fmadd_ps(p, x, _mm256_set1_ps(ACOS_C5));
+    p = _mm256_fmadd_ps(p, x, _mm256_set1_ps(ACOS_C4));
+    p = _mm256_fmadd_ps(p, x, _mm256_set1_ps(ACOS_C3));
+    p = _mm256_fmadd_ps(p, x, _mm256_set1_ps(ACOS_C2));
+    p = _mm256_fmadd_ps(p, x, _mm256_set1_ps(ACOS_C1));
+    p = _mm256_fmadd_ps(p, x, _mm256_set1_ps(ACOS_C0));
+    __m256 r = _mm256_mul_ps(_mm256_sqrt_ps(_mm256_sub_ps(_mm256_set1_ps(1.0f), x)), p);
+    return _mm256_blendv_ps(r, _mm256_sub_ps(_mm256_set1_ps(ACOS_PI), r), c);
+}
+
+__attribute__((target("avx2,fma")))
+static size_t avx2_angle(float *dst, v3_soa a, v3_soa b, size_t count, v3_angle_accuracy accuracy)
+{
+    const __m256 eps2 = _mm256_set1_ps(V3_EPSILON * V3_EPSILON);
+    const __m256 one = _mm256_set1_ps(1.0f);
+    size_t degenerate = 0;
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 ax = _mm256_loadu_ps(a.x + i), ay = _mm256_loadu_ps(a.y + i), az = _mm256_loadu_ps(a.z + i);
+        __m256 bx = _mm256_loadu_ps(b.x + i), by = _mm256_loadu_ps(b.y + i), bz = _mm256_loadu_ps(b.z + i);
+        __m256 len2_a = _mm256_fmadd_ps(az, az, _mm256_fmadd_ps(ay, ay, _mm256_mul_ps(ax, ax)));
+        __m256 len2_b = _mm256_fmadd_ps(bz, bz, _mm256_fmadd_ps(by, by, _mm256_mul_ps(bx, bx)));
+        __m256 dot = _mm256_fmadd_ps(az, bz, _mm256_fmadd_ps(ay, by, _mm256_mul_ps(ax, bx)));
+        __m256 valid = _mm256_and_ps(_mm256_cmp_ps(len2_a, eps2, _CMP_GE_OQ), _mm256_cmp_ps(len2_b, eps2, _CMP_GE_OQ));
+        degenerate += 8 - __builtin_popcount(_mm256_movemask_ps(valid));
+
+        // zero length lanes give nan here, the blend replaces them with cosine 1
+        __m256 x = _mm256_mul_ps(len2_a, len2_b);
+        __m256 y = _mm256_rsqrt_ps(x);
+        __m256 half_x = _mm256_mul_ps(_mm256_set1_ps(0.5f), x);
+        y = _mm256_mul_ps(y, _mm256_fnmadd_ps(half_x, _mm256_mul_ps(y, y), _mm256_set1_ps(1.5f)));
+        __m256 c = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(dot, y), _mm256_set1_ps(-1.0f)), one);
+        c = _mm256_blendv_ps(one, c, valid);
+
+        _mm256_storeu_ps(dst + i, (accuracy == V3_ANGLE_POLY) ? avx2_acos_poly(c) : c);
+    }
+    for (; i < count; i++)
+    {
+        degenerate += angle_one(dst, a, b, i, accuracy);
+    }
+    return degenerate;
+}
+
+__attribute__((target("avx2,fma")))
+static void avx2_sum(float *lanes, const float *x, size_t count)
+{
+    __m256 s0 = _mm256_loadu_ps(lanes), s1 = _mm256_loadu_ps(lanes + 8);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        s0 = _mm256_add_ps(s0, _mm256_loadu_ps(x + i));
+        s1 = _mm256_add_ps(s1, _mm256_loadu_ps(x + i + 8));
+    }
+    _mm256_storeu_ps(lanes, s0);
+    _mm256_storeu_ps(lanes + 8, s1);
+    scalar_sum(lanes, x + i, count - i);
+}
+
+__attribute__((target("avx2,fma")))
+static inline void avx2_kahan(__m256 *s, __m256 *c, __m256 x)
+{
+    __m256 y = _mm256_sub_ps(x, *c);
+    __m256 t = _mm256_add_ps(*s, y);
+    *c = _mm256_sub_ps(_mm256_sub_ps(t, *s), y);
+    *s = t;
+}
+
+__attribute__((target("avx2,fma")))
+static void avx2_sum_compensated(float *lanes, float *comp, const float *x, size_t count)
+{
+    __m256 s0 = _mm256_loadu_ps(lanes), s1 = _mm256_loadu_ps(lanes + 8);
+    __m256 c0 = _mm256_loadu_ps(comp), c1 = _mm256_loadu_ps(comp + 8);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        avx2_kahan(&s0, &c0, _mm256_loadu_ps(x + i));
+        avx2_kahan(&s1, &c1, _mm256_loadu_ps(x + i + 8));
+    }
+    _mm256_storeu_ps(lanes, s0);
+    _mm256_storeu_ps(lanes + 8, s1);
+    _mm256_storeu_ps(comp, c0);
+    _mm256_storeu_ps(comp + 8, c1);
+    scalar_sum_compensated(lanes, comp, x + i, count - i);
+}
+
+__attribute__((target("avx2,fma")))
+static void avx2_bounds(float *lo, float *hi, const float *x, size_t count)
+{
+    __m256 l = _mm256_set1_ps(*lo), h = _mm256_set1_ps(*hi);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 v = _mm256_loadu_ps(x + i);
+        l = _mm256_min_ps(l, v);
+        h = _mm256_max_ps(h, v);
+    }
+    float ls[8], hs[8];
+    _mm256_storeu_ps(ls, l);
+    _mm256_storeu_ps(hs, h);
+    fold_bounds(lo, hi, ls, hs, 8);
+    scalar_bounds(lo, hi, x + i, count - i);
+}
+
+__attribute__((target("avx2,fma")))
+static inline void avx2_oct_load(const void *src, size_t i, int bits, __m256i *qu, __m256i *qv)
+{
+    if (bits == 16)
+    {
+        __m256i p = _mm256_loadu_si256((const __m256i *)((const uint32_t *)src + i));
+        *qu = _mm256_srai_epi32(_mm256_slli_epi32(p, 16), 16);
+        *qv = _mm256_srai_epi32(p, 16);
+    }
+    else
+    {
+        __m256i p = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)((const uint16_t *)src + i)));
+        *qu = _mm256_srai_epi32(_mm256_slli_epi32(p, 24), 24);
+        *qv = _mm256_srai_epi32(_mm256_slli_epi32(p, 16), 24);
+    }
+}
+
+__attribute__((target("avx2,fma")))
+static inline void avx2_oct_store(void *dst, size_t i, int bits, __m256i qu, __m256i qv)
+{
+    if (bits == 16)
+    {
+        __m256i p = _mm256_or_si256(_mm256_and_si256(qu, _mm256_set1_epi32(0xffff)), _mm256_slli_epi32(qv, 16));
+        _mm256_storeu_si256((__m256i *)((uint32_t *)dst + i), p);
+    }
+    else
+    {
+        // packus works within 128-bit halves, the permute gathers both results into the low half
+        const __m256i low = _mm256_set1_epi32(0xff);
+        __m256i p = _mm256_or_si256(_mm256_and_si256(qu, low), _mm256_slli_epi32(_mm256_and_si256(qv, low), 8));
+        p = _mm256_permute4x64_epi64(_mm256_packus_epi32(p, p), 0x08);
+        _mm_storeu_si128((__m128i *)((uint16_t *)dst + i), _mm256_castsi256_si128(p));
+    }
+}
+
+__attribute__((target("avx2,fma")))
+static inline void avx2_oct_decode8(const void *src, size_t i, int bits, __m256 *x, __m256 *y, __m256 *z)
+{
+    const __m256 sign = _mm256_set1_ps(-0.0f);
+    const __m256 inv_scale = _mm256_set1_ps(1.0f / oct_scale(bits));
+    const __m256 minus_one = _mm256_set1_ps(-1.0f);
+    __m256i qu, qv;
+    avx2_oct_load(src, i, bits, &qu, &qv);
+
+    __m256 u = _mm256_max_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(qu), inv_scale), minus_one);
+    __m256 v = _mm256_max_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(qv), inv_scale), minus_one);
+    __m256 w = _mm256_sub_ps(_mm256_sub_ps(_mm256_set1_ps(1.0f), _mm256_andnot_ps(sign, u)), _mm256_andnot_ps(sign, v));
+    __m256 t = _mm256_max_ps(_mm256_sub_ps(_mm256_setzero_ps(), w), _mm256_setzero_ps());
+    __m256 ux = _mm256_sub_ps(u, _mm256_or_ps(t, _mm256_and_ps(sign, u)));
+    __m256 vy = _mm256_sub_ps(v, _mm256_or_ps(t, _mm256_and_ps(sign, v)));
+
+    __m256 valid;
+    __m256 len2 = _mm256_fmadd_ps(w, w, _mm256_fmadd_ps(vy, vy, _mm256_mul_ps(ux, ux)));
+    __m256 inv_len = avx2_rsqrt_nr(len2, &valid);
+    *x = _mm256_mul_ps(ux, inv_len);
+    *y = _mm256_mul_ps(vy, inv_len);
+    *z = _mm256_mul_ps(w, inv_len);
+}
+
+__attribute__((target("avx2,fma")))
+static void avx2_oct_encode(void *dst, v3_soa a, size_t count, int bits)
+{
+    const __m256 sign = _mm256_set1_ps(-0.0f);
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 scale = _mm256_set1_ps(oct_scale(bits));
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 x = _mm256_loadu_ps(a.x + i), y = _mm256_loadu_ps(a.y + i), z = _mm256_loadu_ps(a.z + i);
+        __m256 l1 = _mm256_add_ps(_mm256_add_ps(_mm256_andnot_ps(sign, x), _mm256_andnot_ps(sign, y)),
+                                  _mm256_andnot_ps(sign, z));
+        __m256 inv = _mm256_div_ps(one, _mm256_max_ps(l1, _mm256_set1_ps(FLT_MIN)));
+        __m256 u = _mm256_mul_ps(x, inv), v = _mm256_mul_ps(y, inv);
+
+        __m256 folded_u = _mm256_or_ps(_mm256_sub_ps(one, _mm256_andnot_ps(sign, v)), _mm256_and_ps(sign, u));
+        __m256 folded_v = _mm256_or_ps(_mm256_sub_ps(one, _mm256_andnot_ps(sign, u)), _mm256_and_ps(sign, v));
+        __m256 lower = _mm256_cmp_ps(z, _mm256_setzero_ps(), _CMP_LT_OQ);
+        u = _mm256_blendv_ps(u, folded_u, lower);
+        v = _mm256_blendv_ps(v, folded_v, lower);
+
+        avx2_oct_store(dst, i, bits, _mm256_cvtps_epi32(_mm256_mul_ps(u, scale)),
+                       _mm256_cvtps_epi32(_mm256_mul_ps(v, scale)));
+    }
+    for (; i < count; i++)
+    {
+        oct_encode_one(dst, a, i, bits);
+    }
+}
+
+__attribute__((target("avx2,fma")))
+static void avx2_oct_decode(v3_soa dst, const void *src, size_t count, int bits)
+{
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 x, y, z;
+        avx2_oct_decode8(src, i, bits, &x, &y, &z);
+        _mm256_storeu_ps(dst.x + i, x);
+        _mm256_storeu_ps(dst.y + i, y);
+        _mm256_storeu_ps(dst.z + i, z);
+    }
+    for (; i < count; i++)
+    {
+        float n[3];
+        oct_decode_one(n, src, i, bits);
+        dst.x[i] = n[0];
+        dst.y[i] = n[1];
+        dst.z[i] = n[2];
+    }
+}
+
+__attribute__((target("avx2,fma")))
+static void avx2_oct_dot(float *dst, const void *n, v3_soa v, size_t count, int bits)
+{
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 nx, ny, nz;
+        avx2_oct_decode8(n, i, bits, &nx, &ny, &nz);
+        __m256 vx = _mm256_loadu_ps(v.x + i), vy = _mm256_loadu_ps(v.y + i), vz = _mm256_loadu_ps(v.z + i);
+        _mm256_storeu_ps(dst + i, _mm256_fmadd_ps(nz, vz, _mm256_fmadd_ps(ny, vy, _mm256_mul_ps(nx, vx))));
+    }
+    for (; i < count; i++)
+    {
+        oct_dot_one(dst, n, v, i, bits);
+    }
+}
+
+__attribute__((target("avx2,fma")))
+static void avx2_oct_reflect(v3_soa dst, v3_soa v, const void *n, size_t count, int bits)
+{
+    const __m256 two = _mm256_set1_ps(2.0f);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 nx, ny, nz;
+        avx2_oct_decode8(n, i, bits, &nx, &ny, &nz);
+        __m256 vx = _mm256_loadu_ps(v.x + i), vy = _mm256_loadu_ps(v.y + i), vz = _mm256_loadu_ps(v.z + i);
+        __m256 dot = _mm256_fmadd_ps(vz, nz, _mm256_fmadd_ps(vy, ny, _mm256_mul_ps(vx, nx)));
+        __m256 k = _mm256_mul_ps(two, dot);
+        _mm256_storeu_ps(dst.x + i, _mm256_fnmadd_ps(k, nx, vx));
+        _mm256_storeu_ps(dst.y + i, _mm256_fnmadd_ps(k, ny, vy));
+        _mm256_storeu_ps(dst.z + i, _mm256_fnmadd_ps(k, nz, vz));
+    }
+    for (; i < count; i++)
+    {
+        oct_reflect_one(dst, v, n, i, bits);
+    }
+}
+__attribute__((target("avx2,fma")))
+static inline __m256 avx2_dot3(__m256 ax, __m256 ay, __m256 az, __m256 bx, __m256 by, __m256 bz)
+{
+    return _mm256_fmadd_ps(az, bz, _mm256_fmadd_ps(ay, by, _mm256_mul_ps(ax, bx)));
+}
+
+__attribute__((target("avx2,fma")))
+static inline __m256 avx2_power(__m256 x, int k)
+{
+    __m256 r = _mm256_set1_ps(1.0f);
+    for (; k > 0; k >>= 1)
+    {
+        if (k & 1)
+        {
+            r = _mm256_mul_ps(r, x);
+        }
+        if (k > 1)
+        {
+            x = _mm256_mul_ps(x, x);
+        }
+    }
+    return r;
+}
+
+__attribute__((target("avx2,fma")))
+static void avx2_shade(v3_soa diffuse, v3_soa specular, v3_soa p, v3_soa n, v3_soa v, const float *lights,
+                       int light_count, int shininess, int model, size_t count)
+{
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 two = _mm256_set1_ps(2.0f);
+    float cutoff = shade_cutoff(shininess);
+    const __m256 cut = _mm256_set1_ps(cutoff);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 px = _mm256_loadu_ps(p.x + i), py = _mm256_loadu_ps(p.y + i), pz = _mm256_loadu_ps(p.z + i);
+        __m256 nx = _mm256_loadu_ps(n.x + i), ny = _mm256_loadu_ps(n.y + i), nz = _mm256_loadu_ps(n.z + i);
+        __m256 vx = _mm256_loadu_ps(v.x + i), vy = _mm256_loadu_ps(v.y + i), vz = _mm256_loadu_ps(v.z + i);
+        __m256 valid;
+        __m256 inv = avx2_rsqrt_nr(avx2_dot3(nx, ny, nz, nx, ny, nz), &valid);
+        nx = _mm256_mul_ps(nx, inv);
+        ny = _mm256_mul_ps(ny, inv);
+        nz = _mm256_mul_ps(nz, inv);
+        inv = avx2_rsqrt_nr(avx2_dot3(vx, vy, vz, vx, vy, vz), &valid);
+        vx = _mm256_mul_ps(vx, inv);
+        vy = _mm256_mul_ps(vy, inv);
+        vz = _mm256_mul_ps(vz, inv);
+
+        __m256 dr = zero, dg = zero, db = zero, sr = zero, sg = zero, sb = zero;
+        for (int j = 0; j < light_count; j++)
+        {
+            const float *light = lights + 6 * j;
+            __m256 lx = _mm256_sub_ps(_mm256_set1_ps(light[0]), px);
+            __m256 ly = _mm256_sub_ps(_mm256_set1_ps(light[1]), py);
+            __m256 lz = _mm256_sub_ps(_mm256_set1_ps(light[2]), pz);
+            inv = avx2_rsqrt_nr(avx2_dot3(lx, ly, lz, lx, ly, lz), &valid);
+            lx = _mm256_mul_ps(lx, inv);
+            ly = _mm256_mul_ps(ly, inv);
+            lz = _mm256_mul_ps(lz, inv);
+
+            __m256 ndl = avx2_dot3(nx, ny, nz, lx, ly, lz);
+            __m256 lit = _mm256_cmp_ps(ndl, zero, _CMP_GT_OQ);
+            __m256 lambert = _mm256_and_ps(ndl, lit);
+            __m256 r = _mm256_set1_ps(light[3]), g = _mm256_set1_ps(light[4]), b = _mm256_set1_ps(light[5]);
+            dr = _mm256_fmadd_ps(lambert, r, dr);
+            dg = _mm256_fmadd_ps(lambert, g, dg);
+            db = _mm256_fmadd_ps(lambert, b, db);
+            if (model == V3_SHADE_LAMBERT)
+            {
+                continue;
+            }
+
+            __m256 cosine;
+            if (model == V3_SHADE_PHONG)
+            {
+                __m256 k = _mm256_mul_ps(two, ndl);
+                cosine = avx2_dot3(_mm256_fmsub_ps(k, nx, lx), _mm256_fmsub_ps(k, ny, ly),
+                                   _mm256_fmsub_ps(k, nz, lz), vx, vy, vz);
+            }
+            else
+            {
+                __m256 hx = _mm256_add_ps(lx, vx), hy = _mm256_add_ps(ly, vy), hz = _mm256_add_ps(lz, vz);
+                inv = avx2_rsqrt_nr(avx2_dot3(hx, hy, hz, hx, hy, hz), &valid);
+                cosine = _mm256_mul_ps(avx2_dot3(nx, ny, nz, hx, hy, hz), inv);
+            }
+            __m256 shine = _mm256_and_ps(lit, _mm256_cmp_ps(cosine, cut, _CMP_GE_OQ));
+            __m256 term = _mm256_and_ps(avx2_power(_mm256_and_ps(cosine, shine), shininess), shine);
+            sr = _mm256_fmadd_ps(term, r, sr);
+            sg = _mm256_fmadd_ps(term, g, sg);
+            sb = _mm256_fmadd_ps(term, b, sb);
+        }
+
+        _mm256_storeu_ps(diffuse.x + i, dr);
+        _mm256_storeu_ps(diffuse.y + i, dg);
+        _mm256_storeu_ps(diffuse.z + i, db);
+        _mm256_storeu_ps(specular.x + i, sr);
+        _mm256_storeu_ps(specular.y + i, sg);
+        _mm256_storeu_ps(specular.z + i, sb);
+    }
+    for (; i < count; i++)
+    {
+        shade_one(diffuse, specular, p, n, v, lights, light_count, shininess, cutoff, model, i);
+    }
+}
+
+__attribute__((target("avx2,fma")))
+static inline __m256i avx2_camera_hash(__m256i h)
+{
+    h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 16));
+    h = _mm256_mullo_epi32(h, _mm256_set1_epi32(0x7feb352d));
+    h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 15));
+    h = _mm256_mullo_epi32(h, _mm256_set1_epi32((int)0x846ca68bu));
+    return _mm256_xor_si256(h, _mm256_srli_epi32(h, 16));
+}
+
+__attribute__((target("avx2,fma")))
+static inline __m256 avx2_camera_offset(__m256i h)
+{
+    __m256 top = _mm256_cvtepi32_ps(_mm256_srli_epi32(h, 8));
+    return _mm256_sub_ps(_mm256_mul_ps(top, _mm256_set1_ps(1.0f / 16777216.0f)), _mm256_set1_ps(0.5f));
+}
+
+__attribute__((target("avx2,fma")))
+static void avx2_camera(v3_soa dst, const float *frame, size_t x0, size_t y0, size_t width, size_t height,
+                        size_t image_width, int samples, uint32_t seed, int jitter)
+{
+    const __m256 iota = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+    const __m256i lanes = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(samples));
+    const __m256 rx = _mm256_set1_ps(frame[3]), ry = _mm256_set1_ps(frame[4]), rz = _mm256_set1_ps(frame[5]);
+    const __m256 dx = _mm256_set1_ps(frame[6]), dy = _mm256_set1_ps(frame[7]), dz = _mm256_set1_ps(frame[8]);
+    size_t i = 0;
+    for (size_t r = 0; r < height; r++)
+    {
+        float y = (float)(y0 + r);
+        float base[3] = {frame[0] + y * frame[6], frame[1] + y * frame[7], frame[2] + y * frame[8]};
+        const __m256 bx = _mm256_set1_ps(base[0]), by = _mm256_set1_ps(base[1]), bz = _mm256_set1_ps(base[2]);
+        for (int s = 0; s < samples; s++)
+        {
+            uint32_t key = camera_key(x0, y0 + r, image_width, samples, s, seed);
+            size_t c = 0;
+            for (; c < width; c += 8)
+            {
+                size_t n = (width - c < 8) ? width - c : 8;
+                __m256 x = _mm256_add_ps(_mm256_set1_ps((float)(x0 + c)), iota);
+                __m256 ox = bx, oy = by, oz = bz;
+                if (jitter)
+                {
+                    __m256i first = _mm256_set1_epi32((int)(key + (uint32_t)(c * (size_t)samples)));
+                    __m256i h = avx2_camera_hash(_mm256_add_epi32(first, lanes));
+                    x = _mm256_add_ps(x, avx2_camera_offset(h));
+                    __m256 jy = avx2_camera_offset(avx2_camera_hash(h));
+                    ox = _mm256_fmadd_ps(jy, dx, ox);
+                    oy = _mm256_fmadd_ps(jy, dy, oy);
+                    oz = _mm256_fmadd_ps(jy, dz, oz);
+                }
+                ox = _mm256_fmadd_ps(x, rx, ox);
+                oy = _mm256_fmadd_ps(x, ry, oy);
+                oz = _mm256_fmadd_ps(x, rz, oz);
+                __m256 valid;
+                __m256 inv = avx2_rsqrt_nr(avx2_dot3(ox, oy, oz, ox, oy, oz), &valid);
+                if (n == 8)
+                {
+                    _mm256_storeu_ps(dst.x + i, _mm256_mul_ps(ox, inv));
+                    _mm256_storeu_ps(dst.y + i, _mm256_mul_ps(oy, inv));
+                    _mm256_storeu_ps(dst.z + i, _mm256_mul_ps(oz, inv));
+                }
+                else
+                {
+                    // a row ending inside the vector keeps its leading lanes
+                    float tx[8], ty[8], tz[8];
+                    _mm256_storeu_ps(tx, _mm256_mul_ps(ox, inv));
+                    _mm256_storeu_ps(ty, _mm256_mul_ps(oy, inv));
+                    _mm256_storeu_ps(tz, _mm256_mul_ps(oz, inv));
+                    memcpy(dst.x + i, tx, n * sizeof(float));
+                    memcpy(dst.y + i, ty, n * sizeof(float));
+                    memcpy(dst.z + i, tz, n * sizeof(float));
+                }
+                i += n;
+            }
+        }
+    }
+}
+
+// avx2_dot3 fuses with fma; the ray kernels keep the separate roundings of the
+// scalar dot product
+__attribute__((target("avx2")))
+static inline __m256 avx2_ray_dot3(__m256 ax, __m256 ay, __m256 az, __m256 bx, __m256 by, __m256 bz)
+{
+    return _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ax, bx), _mm256_mul_ps(ay, by)), _mm256_mul_ps(az, bz));
+}
+
+__attribute__((target("avx2")))
+static void avx2_ray_triangle(float *t, uint8_t *hit, v3_soa origin, v3_soa dir, const float *tri, size_t count)
+{
+    const __m256 v0x = _mm256_set1_ps(tri[0]), v0y = _mm256_set1_ps(tri[1]), v0z = _mm256_set1_ps(tri[2]);
+    const __m256 e1x = _mm256_set1_ps(tri[3]), e1y = _mm256_set1_ps(tri[4]), e1z = _mm256_set1_ps(tri[5]);
+    const __m256 e2x = _mm256_set1_ps(tri[6]), e2y = _mm256_set1_ps(tri[7]), e2z = _mm256_set1_ps(tri[8]);
+    const __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.0f), eps = _mm256_set1_ps(V3_RAY_EPSILON);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 dx = _mm256_loadu_ps(dir.x + i), dy = _mm256_loadu_ps(dir.y + i), dz = _mm256_loadu_ps(dir.z + i);
+
+        __m256 px = _mm256_sub_ps(_mm256_mul_ps(dy, e2z), _mm256_mul_ps(dz, e2y));
+        __m256 py = _mm256_sub_ps(_mm256_mul_ps(dz, e2x), _mm256_mul_ps(dx, e2z));
+        __m256 pz = _mm256_sub_ps(_mm256_mul_ps(dx, e2y), _mm256_mul_ps(dy, e2x));
+        __m256 det = avx2_ray_dot3(e1x, e1y, e1z, px, py, pz);
+        __m256 inv_det = _mm256_div_ps(one, det);
+
+        __m256 sx = _mm256_sub_ps(_mm256_loadu_ps(origin.x + i), v0x);
+        __m256 sy = _mm256_sub_ps(_mm256_loadu_ps(origin.y + i), v0y);
+        __m256 sz = _mm256_sub_ps(_mm256_loadu_ps(origin.z + i), v0z);
+        __m256 u = _mm256_mul_ps(avx2_ray_dot3(sx, sy, sz, px, py, pz), inv_det);
+
+        __m256 qx = _mm256_sub_ps(_mm256_mul_ps(sy, e1z), _mm256_mul_ps(sz, e1y));
+        __m256 qy = _mm256_sub_ps(_mm256_mul_ps(sz, e1x), _mm256_mul_ps(sx, e1z));
+        __m256 qz = _mm256_sub_ps(_mm256_mul_ps(sx, e1y), _mm256_mul_ps(sy, e1x));
+        __m256 v = _mm256_mul_ps(avx2_ray_dot3(dx, dy, dz, qx, qy, qz), inv_det);
+        __m256 hit_t = _mm256_mul_ps(avx2_ray_dot3(e2x, e2y, e2z, qx, qy, qz), inv_det);
+
+        __m256 miss = _mm256_cmp_ps(_mm256_andnot_ps(_mm256_set1_ps(-0.0f), det), eps, _CMP_LT_OQ);
+        miss = _mm256_or_ps(miss, _mm256_or_ps(_mm256_cmp_ps(u, zero, _CMP_LT_OQ), _mm256_cmp_ps(u, one, _CMP_GT_OQ)));
+        miss = _mm256_or_ps(miss, _mm256_or_ps(_mm256_cmp_ps(v, zero, _CMP_LT_OQ),
+                                               _mm256_cmp_ps(_mm256_add_ps(u, v), one, _CMP_GT_OQ)));
+        miss = _mm256_or_ps(miss, _mm256_cmp_ps(hit_t, eps, _CMP_LE_OQ));
+
+        _mm256_storeu_ps(t + i, _mm256_blendv_ps(hit_t, _mm256_set1_ps(V3_RAY_MISS), miss));
+        store_valid(hit, i, ~_mm256_movemask_ps(miss) & 0xffu, 8);
+    }
+    for (; i < count; i++)
+    {
+        ray_triangle_one(t, hit, origin, dir, tri, i);
+    }
+}
+
+__attribute__((target("avx2")))
+static void avx2_ray_sphere(float *t, uint8_t *hit, v3_soa origin, v3_soa dir, const float *sphere, size_t count)
+{
+    const __m256 cx = _mm256_set1_ps(sphere[0]), cy = _mm256_set1_ps(sphere[1]), cz = _mm256_set1_ps(sphere[2]);
+    const __m256 r2 = _mm256_set1_ps(sphere[3] * sphere[3]), eps = _mm256_set1_ps(V3_RAY_EPSILON);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 dx = _mm256_loadu_ps(dir.x + i), dy = _mm256_loadu_ps(dir.y + i), dz = _mm256_loadu_ps(dir.z + i);
+        __m256 ox = _mm256_sub_ps(_mm256_loadu_ps(origin.x + i), cx);
+        __m256 oy = _mm256_sub_ps(_mm256_loadu_ps(origin.y + i), cy);
+        __m256 oz = _mm256_sub_ps(_mm256_loadu_ps(origin.z + i), cz);
+
+        __m256 a = avx2_ray_dot3(dx, dy, dz, dx, dy, dz);
+        __m256 b = avx2_ray_dot3(ox, oy, oz, dx, dy, dz);
+        __m256 c = _mm256_sub_ps(avx2_ray_dot3(ox, oy, oz, ox, oy, oz), r2);
+        __m256 disc = _mm256_sub_ps(_mm256_mul_ps(b, b), _mm256_mul_ps(a, c));
+
+        __m256 root = _mm256_sqrt_ps(disc);
+        __m256 neg_b = _mm256_xor_ps(b, _mm256_set1_ps(-0.0f));
+        __m256 near = _mm256_div_ps(_mm256_sub_ps(neg_b, root), a);
+        __m256 far = _mm256_div_ps(_mm256_add_ps(neg_b, root), a);
+        __m256 hit_t = _mm256_blendv_ps(far, near, _mm256_cmp_ps(near, eps, _CMP_GT_OQ));
+
+        __m256 miss = _mm256_or_ps(_mm256_cmp_ps(a, eps, _CMP_LT_OQ),
+                                   _mm256_cmp_ps(disc, _mm256_setzero_ps(), _CMP_LT_OQ));
+        miss = _mm256_or_ps(miss, _mm256_cmp_ps(hit_t, eps, _CMP_LE_OQ));
+
+        _mm256_storeu_ps(t + i, _mm256_blendv_ps(hit_t, _mm256_set1_ps(V3_RAY_MISS), miss));
+        store_valid(hit, i, ~_mm256_movemask_ps(miss) & 0xffu, 8);
+    }
+    for (; i < count; i++)
+    {
+        ray_sphere_one(t, hit, origin, dir, sphere, i);
+    }
+}
+
+// avx-512 kernels, 16 elements per iteration
+
+__attribute__((target("avx512f")))
+static void avx512_dot_product(float *dst, v3_soa a, v3_soa b, size_t count)
+{
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        __m512 d = _mm512_mul_ps(_mm512_loadu_ps(a.x + i), _mm512_loadu_ps(b.x + i));
+        d = _mm512_fmadd_ps(_mm512_loadu_ps(a.y + i), _mm512_loadu_ps(b.y + i), d);
+        d = _mm512_fmadd_ps(_mm512_loadu_ps(a.z + i), _mm512_loadu_ps(b.z + i), d);
+        _mm512_storeu_ps(dst + i, d);
+    }
+    for (; i < count; i++)
+    {
+        dst[i] = dot_one(a, b, i);
+    }
+}
+
+__attribute__((target("avx512f")))
+static void avx512_cross_product(v3_soa dst, v3_soa a, v3_soa b, size_t count)
+{
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        __m512 ax = _mm512_loadu_ps(a.x + i), ay = _mm512_loadu_ps(a.y + i), az = _mm512_loadu_ps(a.z + i);
+        __m512 bx = _mm512_loadu_ps(b.x + i), by = _mm512_loadu_ps(b.y + i), bz = _mm512_loadu_ps(b.z + i);
+        _mm512_storeu_ps(dst.x + i, _mm512_fmsub_ps(ay, bz, _mm512_mul_ps(az, by)));
+        _mm512_storeu_ps(dst.y + i, _mm512_fmsub_ps(az, bx, _mm512_mul_ps(ax, bz)));
+        _mm512_storeu_ps(dst.z + i, _mm512_fmsub_ps(ax, by, _mm512_mul_ps(ay, bx)));
+    }
+    for (; i < count; i++)
+    {
+        cross_one(dst, a, b, i);
+    }
+}
+
+__attribute__((target("avx512f")))
+static size_t avx512_normalize(v3_soa dst, v3_soa a, size_t count)
+{
+    const __m512 eps = _mm512_set1_ps(V3_EPSILON);
+    const __m512 one = _mm512_set1_ps(1.0f);
+    size_t degenerate = 0;
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        __m512 x = _mm512_loadu_ps(a.x + i), y = _mm512_loadu_ps(a.y + i), z = _mm512_loadu_ps(a.z + i);
+        __m512 len2 = _mm512_fmadd_ps(z, z, _mm512_fmadd_ps(y, y, _mm512_mul_ps(x, x)));
+        // the zero-masking form avoids an undefined merge source in the unmasked intrinsic
+        __m512 len = _mm512_maskz_sqrt_ps((__mmask16)0xffff, len2);
+        __mmask16 valid = _mm512_cmp_ps_mask(len, eps, _CMP_NLT_UQ);
+        __m512 inv_len = _mm512_maskz_div_ps(valid, one, len);
+        degenerate += 16 - __builtin_popcount(valid);
+
+        _mm512_storeu_ps(dst.x + i, _mm512_mul_ps(x, inv_len));
+        _mm512_storeu_ps(dst.y + i, _mm512_mul_ps(y, inv_len));
+        _mm512_storeu_ps(dst.z + i, _mm512_mul_ps(z, inv_len));
+    }
+    for (; i < count; i++)
+    {
+        degenerate += normalize_one(dst, a, i);
+    }
+    return degenerate;
+}
+
+__attribute__((target("avx512f")))
+static void avx512_reflect(v3_soa dst, v3_soa v, v3_soa n, size_t count)
+{
+    const __m512 two = _mm512_set1_ps(2.0f);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        __m512 vx = _mm512_loadu_ps(v.x + i), vy = _mm512_loadu_ps(v.y + i), vz = _mm512_loadu_ps(v.z + i);
+        __m512 nx = _mm512_loadu_ps(n.x + i), ny = _mm512_loadu_ps(n.y + i), nz = _mm512_loadu_ps(n.z + i);
+        __m512 dot = _mm512_fmadd_ps(vz, nz, _mm512_fmadd_ps(vy, ny, _mm512_mul_ps(vx, nx)));
+        __m512 k = _mm512_mul_ps(two, dot);
+        _mm512_storeu_ps(dst.x + i, _mm512_fnmadd_ps(k, nx, vx));
+        _mm512_storeu_ps(dst.y + i, _mm512_fnmadd_ps(k, ny, vy));
+        _mm512_storeu_ps(dst.z + i, _mm512_fnmadd_ps(k, nz, vz));
+    }
+    for (; i < count; i++)
+    {
+        reflect_one(dst, v, n, i);
+    }
+}
+
+// rsqrt14 is accurate to 2^-14, so one step lands well inside the sse bound
+__attribute__((target("avx512f")))
+static inline __m512 avx512_rsqrt_nr(__m512 len2, __mmask16 *valid)
+{
+    *valid = _mm512_cmp_ps_mask(len2, _mm512_set1_ps(V3_EPSILON * V3_EPSILON), _CMP_GE_OQ);
+    __m512 y = _mm512_maskz_rsqrt14_ps(*valid, len2);
+    __m512 half_x = _mm512_mul_ps(_mm512_set1_ps(0.5f), len2);
+    y = _mm512_mul_ps(y, _mm512_fnmadd_ps(half_x, _mm512_mul_ps(y, y), _mm512_set1_ps(1.5f)));
+    return _mm512_maskz_mov_ps(*valid, y);
+}
+
+__attribute__((target("avx512f")))
+static void avx512_normalize_fast(v3_soa dst, v3_soa a, uint8_t *valid, size_t count)
+{
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        __m512 x = _mm512_loadu_ps(a.x + i), y = _mm512_loadu_ps(a.y + i), z = _mm512_loadu_ps(a.z + i);
+        __m512 len2 = _mm512_fmadd_ps(z, z, _mm512_fmadd_ps(y, y, _mm512_mul_ps(x, x)));
+        __mmask16 mask;
+        __m512 inv_len = avx512_rsqrt_nr(len2, &mask);
+
+        _mm512_storeu_ps(dst.x + i, _mm512_mul_ps(x, inv_len));
+        _mm512_storeu_ps(dst.y + i, _mm512_mul_ps(y, inv_len));
+        _mm512_storeu_ps(dst.z + i, _mm512_mul_ps(z, inv_len));
+        store_valid(valid, i, mask, 16);
+    }
+    for (; i < count; i++)
+    {
+        normalize_fast_one(dst, a, valid, i);
+    }
+}
+
+__attribute__((target("avx512f")))
+static void avx512_inv_length(float *dst, v3_soa a, size_t count)
+{
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        __m512 x = _mm512_loadu_ps(a.x + i), y = _mm512_loadu_ps(a.y + i), z = _mm512_loadu_ps(a.z + i);
+        __m512 len2 = _mm512_fmadd_ps(z, z, _mm512_fmadd_ps(y, y, _mm512_mul_ps(x, x)));
+        __mmask16 mask;
+        _mm512_storeu_ps(dst + i, avx512_rsqrt_nr(len2, &mask));
+    }
+    for (; i < count; i++)
+    {
+        inv_length_one(dst, a, i);
+    }
+}
+
+__attribute__((target("avx512f")))
+static void avx512_transform(v3_soa dst, const float *m, v3_soa a, size_t count)
+{
+    __m512 m0 = _mm512_set1_ps(m[0]), m1 = _mm512_set1_ps(m[1]), m2 = _mm512_set1_ps(m[2]), m3 = _mm512_set1_ps(m[3]);
+    __m512 m4 = _mm512_set1_ps(m[4]), m5 = _mm512_set1_ps(m[5]), m6 = _mm512_set1_ps(m[6]), m7 = _mm512_set1_ps(m[7]);
+    __m512 m8 = _mm512_set1_ps(m[8]), m9 = _mm512_set1_ps(m[9]), m10 = _mm512_set1_ps(m[10]), m11 = _mm512_set1_ps(m[11]);
+
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        __m512 x = _mm512_loadu_ps(a.x + i), y = _mm512_loadu_ps(a.y + i), z = _mm512_loadu_ps(a.z + i);
+        _mm512_storeu_ps(dst.x + i, _mm512_fmadd_ps(m2, z, _mm512_fmadd_ps(m1, y, _mm512_fmadd_ps(m0, x, m3))));
+        _mm512_storeu_ps(dst.y + i, _mm512_fmadd_ps(m6, z, _mm512_fmadd_ps(m5, y, _mm512_fmadd_ps(m4, x, m7))));
+        _mm512_storeu_ps(dst.z + i, _mm512_fmadd_ps(m10, z, _mm512_fmadd_ps(m9, y, _mm512_fmadd_ps(m8, x, m11))));
+    }
+    for (; i < count; i++)
+    {
+        transform_one(dst, m, a, i);
+    }
+}
+
+__attribute__((target("avx512f")))
+static void avx512_rotate(v3_soa dst, const float *q, v3_soa a, size_t count)
+{
+    __m512 qx = _mm512_set1_ps(q[0]), qy = _mm512_set1_ps(q[1]), qz = _mm512_set1_ps(q[2]), qw = _mm512_set1_ps(q[3]);
+    __m512 qx2 = _mm512_set1_ps(2.0f * q[0]), qy2 = _mm512_set1_ps(2.0f * q[1]), qz2 = _mm512_set1_ps(2.0f * q[2]);
+
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        __m512 x = _mm512_loadu_ps(a.x + i), y = _mm512_loadu_ps(a.y + i), z = _mm512_loadu_ps(a.z + i);
+        __m512 tx = _mm512_fmsub_ps(qy2, z, _mm512_mul_ps(qz2, y));
+        __m512 ty = _mm512_fmsub_ps(qz2, x, _mm512_mul_ps(qx2, z));
+        __m512 tz = _mm512_fmsub_ps(qx2, y, _mm512_mul_ps(qy2, x));
+        __m512 cx = _mm512_fmsub_ps(qy, tz, _mm512_mul_ps(qz, ty));
+        __m512 cy = _mm512_fmsub_ps(qz, tx, _mm512_mul_ps(qx, tz));
+        __m512 cz = _mm512_fmsub_ps(qx, ty, _mm512_mul_ps(qy, tx));
+        _mm512_storeu_ps(dst.x + i, _mm512_add_ps(_mm512_fmadd_ps(qw, tx, x), cx));
+        _mm512_storeu_ps(dst.y + i, _mm512_add_ps(_mm512_fmadd_ps(qw, ty, y), cy));
+        _mm512_storeu_ps(dst.z + i, _mm512_add_ps(_mm512_fmadd_ps(qw, tz, z), cz));
+    }
+    for (; i < count; i++)
+    {
+        rotate_one(dst, q, a, i);
+    }
+}
+
+__attribute__((target("avx512f")))
+static inline __m512 avx512_acos_poly(__m512 c)
+{
+    __m512 x = _mm512_abs_ps(c);
+    __m512 p = _mm512_set1_ps(ACOS_C7);
+    p = _mm512_fmadd_ps(p, x, _mm512_set1_ps(ACOS_C6));
+    p = _mm512_fmadd_ps(p, x, _mm512_set1_ps(ACOS_C5));
+    p = _mm512_fmadd_ps(p, x, _mm512_set1_ps(ACOS_C4));
+    p = _mm512_fmadd_ps(p, x, _mm512_set1_ps(ACOS_C3));
+    p = _mm512_fmadd_ps(p, x, _mm512_set1_ps(ACOS_C2));
+    p = _mm512_fmadd_ps(p, x, _mm512_set1_ps(ACOS_C1));
+    p = _mm512_fmadd_ps(p, x, _mm512_set1_ps(ACOS_C0));
+    // the masked sqrt with every lane set is the plain one; gcc 12 warns about the
+    // undefined pass-through of _mm512_sqrt_ps once the caller's loop is unswitched
+    __m512 s = _mm512_sub_ps(_mm512_set1_ps(1.0f), x);
+    __m512 r = _mm512_mul_ps(_mm512_mask_sqrt_ps(s, (__mmask16)0xffff, s), p);
+    __mmask16 negative = _mm512_cmp_ps_mask(c, _mm512_setzero_ps(), _CMP_LT_OQ);
+    return _mm512_mask_sub_ps(r, negative, _mm512_set1_ps(ACOS_PI), r);
+}
+
+__attribute__((target("avx512f")))
+static size_t avx512_angle(float *dst, v3_soa a, v3_soa b, size_t count, v3_angle_accuracy accuracy)
+{
+    const __m512 eps2 = _mm512_set1_ps(V3_EPSILON * V3_EPSILON);
+    const __m512 one = _mm512_set1_ps(1.0f);
+    size_t degenerate = 0;
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        __m512 ax = _mm512_loadu_ps(a.x + i), ay = _mm512_loadu_ps(a.y + i), az = _mm512_loadu_ps(a.z + i);
+        __m512 bx = _mm512_loadu_ps(b.x + i), by = _mm512_loadu_ps(b.y + i), bz = _mm512_loadu_ps(b.z + i);
+        __m512 len2_a = _mm512_fmadd_ps(az, az, _mm512_fmadd_ps(ay, ay, _mm512_mul_ps(ax, ax)));
+        __m512 len2_b = _mm512_fmadd_ps(bz, bz, _mm512_fmadd_ps(by, by, _mm512_mul_ps(bx, bx)));
+        __m512 dot = _mm512_fmadd_ps(az, bz, _mm512_fmadd_ps(ay, by, _mm512_mul_ps(ax, bx)));
+        __mmask16 valid = _mm512_cmp_ps_mask(len2_a, eps2, _CMP_GE_OQ) & _mm512_cmp_ps_mask(len2_b, eps2, _CMP_GE_OQ);
+        degenerate += 16 - __builtin_popcount(valid);
+
+        // rsqrt14 is accurate to 2^-14, so one step lands well inside the sse bound
+        __m512 x = _mm512_mul_ps(len2_a, len2_b);
+        __m512 y = _mm512_maskz_rsqrt14_ps(valid, x);
+        __m512 half_x = _mm512_mul_ps(_mm512_set1_ps(0.5f), x);
+        y = _mm512_mul_ps(y, _mm512_fnmadd_ps(half_x, _mm512_mul_ps(y, y), _mm512_set1_ps(1.5f)));
+        // clamp the valid lanes, the others take cosine 1
+        __m512 c = _mm512_mask_max_ps(one, valid, _mm512_mul_ps(dot, y), _mm512_set1_ps(-1.0f));
+        c = _mm512_mask_min_ps(one, valid, c, one);
+
+        _mm512_storeu_ps(dst + i, (accuracy == V3_ANGLE_POLY) ? avx512_acos_poly(c) : c);
+    }
+    for (; i < count; i++)
+    {
+        degenerate += angle_one(dst, a, b, i, accuracy);
+    }
+    return degenerate;
+}
+
+__attribute__((target("avx512f")))
+static void avx512_sum(float *lanes, const float *x, size_t count)
+{
+    __m512 s = _mm512_loadu_ps(lanes);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        s = _mm512_add_ps(s, _mm512_loadu_ps(x + i));
+    }
+    _mm512_storeu_ps(lanes, s);
+    scalar_sum(lanes, x + i, count - i);
+}
+
+__attribute__((target("avx512f")))
+static void avx512_sum_compensated(float *lanes, float *comp, const float *x, size_t count)
+{
+    __m512 s = _mm512_loadu_ps(lanes), c = _mm512_loadu_ps(comp);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        __m512 y = _mm512_sub_ps(_mm512_loadu_ps(x + i), c);
+        __m512 t = _mm512_add_ps(s, y);
+        c = _mm512_sub_ps(_mm512_sub_ps(t, s), y);
+        s = t;
+    }
+    _mm512_storeu_ps(lanes, s);
+    _mm512_storeu_ps(comp, c);
+    scalar_sum_compensated(lanes, comp, x + i, count - i);
+}
+
+__attribute__((target("avx512f")))
+static void avx512_bounds(float *lo, float *hi, const float *x, size_t count)
+{
+    // full masks rather than min/max and reduce, which gcc 12 flags as maybe uninitialized
+    __m512 l = _mm512_set1_ps(*lo), h = _mm512_set1_ps(*hi);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        __m512 v = _mm512_loadu_ps(x + i);
+        l = _mm512_mask_min_ps(l, 0xffff, l, v);
+        h = _mm512_mask_max_ps(h, 0xffff, h, v);
+    }
+    float ls[16], hs[16];
+    _mm512_storeu_ps(ls, l);
+    _mm512_storeu_ps(hs, h);
+    fold_bounds(lo, hi, ls, hs, 16);
+    scalar_bounds(lo, hi, x + i, count - i);
+}
+
+// the octahedral and camera kernels use the zero-masking forms with every lane
+// set; gcc 12 flags the undefined pass-through of the plain conversions and
+// shifts once the bits or jitter branch is unswitched out of the loops
+#define ALL_LANES ((__mmask16)0xffff)
+
+__attribute__((target("avx512f")))
+static inline void avx512_oct_load(const void *src, size_t i, int bits, __m512i *qu, __m512i *qv)
+{
+    if (bits == 16)
+    {
+        __m512i p = _mm512_loadu_si512((const void *)((const uint32_t *)src + i));
+        *qu = _mm512_maskz_srai_epi32(ALL_LANES, _mm512_maskz_slli_epi32(ALL_LANES, p, 16), 16);
+        *qv = _mm512_maskz_srai_epi32(ALL_LANES, p, 16);
+    }
+    else
+    {
+        __m512i p = _mm512_maskz_cvtepu16_epi32(ALL_LANES, _mm256_loadu_si256((const __m256i *)((const uint16_t *)src + i)));
+        *qu = _mm512_maskz_srai_epi32(ALL_LANES, _mm512_maskz_slli_epi32(ALL_LANES, p, 24), 24);
+        *qv = _mm512_maskz_srai_epi32(ALL_LANES, _mm512_maskz_slli_epi32(ALL_LANES, p, 16), 24);
+    }
+}
+
+__attribute__((target("avx512f")))
+static inline void avx512_oct_store(void *dst, size_t i, int bits, __m512i qu, __m512i qv)
+{
+    if (bits == 16)
+    {
+        __m512i p = _mm512_or_si512(_mm512_and_si512(qu, _mm512_set1_epi32(0xffff)), _mm512_maskz_slli_epi32(ALL_LANES, qv, 16));
+        _mm512_storeu_si512((void *)((uint32_t *)dst + i), p);
+    }
+    else
+    {
+        const __m512i low = _mm512_set1_epi32(0xff);
+        __m512i p = _mm512_or_si512(_mm512_and_si512(qu, low), _mm512_maskz_slli_epi32(ALL_LANES, _mm512_and_si512(qv, low), 8));
+        _mm256_storeu_si256((__m256i *)((uint16_t *)dst + i), _mm512_maskz_cvtepi32_epi16(ALL_LANES, p));
+    }
+}
+
+// avx512f has no float and/or, so the sign bits are moved with integer ops
+__attribute__((target("avx512f")))
+static inline __m512 avx512_copysign(__m512 magnitude, __m512 sign_of)
+{
+    const __m512i sign = _mm512_set1_epi32((int)0x80000000u);
+    return _mm512_castsi512_ps(_mm512_or_si512(_mm512_castps_si512(magnitude),
+                                               _mm512_and_si512(_mm512_castps_si512(sign_of), sign)));
+}
+
+__attribute__((target("avx512f")))
+static inline void avx512_oct_decode16(const void *src, size_t i, int bits, __m512 *x, __m512 *y, __m512 *z)
+{
+    const __m512 inv_scale = _mm512_set1_ps(1.0f / oct_scale(bits));
+    const __m512 minus_one = _mm512_set1_ps(-1.0f);
+    const __m512 zero = _mm512_setzero_ps();
+    __m512i qu, qv;
+    avx512_oct_load(src, i, bits, &qu, &qv);
+
+    __m512 u = _mm512_mul_ps(_mm512_maskz_cvtepi32_ps(ALL_LANES, qu), inv_scale);
+    __m512 v = _mm512_mul_ps(_mm512_maskz_cvtepi32_ps(ALL_LANES, qv), inv_scale);
+    u = _mm512_mask_max_ps(u, ALL_LANES, u, minus_one);
+    v = _mm512_mask_max_ps(v, ALL_LANES, v, minus_one);
+    __m512 w = _mm512_sub_ps(_mm512_sub_ps(_mm512_set1_ps(1.0f), _mm512_abs_ps(u)), _mm512_abs_ps(v));
+    __m512 t = _mm512_sub_ps(zero, w);
+    t = _mm512_mask_max_ps(t, ALL_LANES, t, zero);
+    __m512 ux = _mm512_sub_ps(u, avx512_copysign(t, u));
+    __m512 vy = _mm512_sub_ps(v, avx512_copysign(t, v));
+
+    __mmask16 valid;
+    __m512 len2 = _mm512_fmadd_ps(w, w, _mm512_fmadd_ps(vy, vy, _mm512_mul_ps(ux, ux)));
+    __m512 inv_len = avx512_rsqrt_nr(len2, &valid);
+    *x = _mm512_mul_ps(ux, inv_len);
+    *y = _mm512_mul_ps(vy, inv_len);
+    *z = _mm512_mul_ps(w, inv_len);
+}
+
+__attribute__((target("avx512f")))
+static void avx512_oct_encode(void *dst, v3_soa a, size_t count, int bits)
+{
+    const __m512 one = _mm512_set1_ps(1.0f);
+    const __m512 scale = _mm512_set1_ps(oct_scale(bits));
+    const __m512 tiny = _mm512_set1_ps(FLT_MIN);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        __m512 x = _mm512_loadu_ps(a.x + i), y = _mm512_loadu_ps(a.y + i), z = _mm512_loadu_ps(a.z + i);
+        __m512 l1 = _mm512_add_ps(_mm512_add_ps(_mm512_abs_ps(x), _mm512_abs_ps(y)), _mm512_abs_ps(z));
+        l1 = _mm512_mask_max_ps(l1, ALL_LANES, l1, tiny);
+        __m512 inv = _mm512_maskz_div_ps(ALL_LANES, one, l1);
+        __m512 u = _mm512_mul_ps(x, inv), v = _mm512_mul_ps(y, inv);
+
+        // the lower half is folded over, blending in place through the mask
+        __mmask16 lower = _mm512_cmp_ps_mask(z, _mm512_setzero_ps(), _CMP_LT_OQ);
+        __m512 folded_u = avx512_copysign(_mm512_sub_ps(one, _mm512_abs_ps(v)), u);
+        __m512 folded_v = avx512_copysign(_mm512_sub_ps(one, _mm512_abs_ps(u)), v);
+        u = _mm512_mask_blend_ps(lower, u, folded_u);
+        v = _mm512_mask_blend_ps(lower, v, folded_v);
+
+        avx512_oct_store(dst, i, bits, _mm512_maskz_cvtps_epi32(ALL_LANES, _mm512_mul_ps(u, scale)),
+                         _mm512_maskz_cvtps_epi32(ALL_LANES, _mm512_mul_ps(v, scale)));
+    }
+    for (; i < count; i++)
+    {
+        oct_encode_one(dst, a, i, bits);
+    }
+}
+
+__attribute__((target("avx512f")))
+static void avx512_oct_decode(v3_soa dst, const void *src, size_t count, int bits)
+{
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        __m512 x, y, z;
+        avx512_oct_decode16(src, i, bits, &x, &y, &z);
+        _mm512_storeu_ps(dst.x + i, x);
+        _mm512_storeu_ps(dst.y + i, y);
+        _mm512_storeu_ps(dst.z + i, z);
+    }
+    for (; i < count; i++)
+    {
+        float n[3];
+        oct_decode_one(n, src, i, bits);
+        dst.x[i] = n[0];
+        dst.y[i] = n[1];
+        dst.z[i] = n[2];
+    }
+}
+
+__attribute__((target("avx512f")))
+static void avx512_oct_dot(float *dst, const void *n, v3_soa v, size_t count, int bits)
+{
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        __m512 nx, ny, nz;
+        avx512_oct_decode16(n, i, bits, &nx, &ny, &nz);
+        __m512 vx = _mm512_loadu_ps(v.x + i), vy = _mm512_loadu_ps(v.y + i), vz = _mm512_loadu_ps(v.z + i);
+        _mm512_storeu_ps(dst + i, _mm512_fmadd_ps(nz, vz, _mm512_fmadd_ps(ny, vy, _mm512_mul_ps(nx, vx))));
+    }
+    for (; i < count; i++)
+    {
+        oct_dot_one(dst, n, v, i, bits);
+    }
+}
+
+__attribute__((target("avx512f")))
+static void avx512_oct_reflect(v3_soa dst, v3_soa v, const void *n, size_t count, int bits)
+{
+    const __m512 two = _mm512_set1_ps(2.0f);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        __m512 nx, ny, nz;
+        avx512_oct_decode16(n, i, bits, &nx, &ny, &nz);
+        __m512 vx = _mm512_loadu_ps(v.x + i), vy = _mm512_loadu_ps(v.y + i), vz = _mm512_loadu_ps(v.z + i);
+        __m512 dot = _mm512_fmadd_ps(vz, nz, _mm512_fmadd_ps(vy, ny, _mm512_mul_ps(vx, nx)));
+        __m512 k = _mm512_mul_ps(two, dot);
+        _mm512_storeu_ps(dst.x + i, _mm512_fnmadd_ps(k, nx, vx));
+        _mm512_storeu_ps(dst.y + i, _mm512_fnmadd_ps(k, ny, vy));
+        _mm512_storeu_ps(dst.z + i, _mm512_fnmadd_ps(k, nz, vz));
+    }
+    for (; i < count; i++)
+    {
+        oct_reflect_one(dst, v, n, i, bits);
+    }
+}
+__attribute__((target("avx512f")))
+static inline __m512 avx512_dot3(__m512 ax, __m512 ay, __m512 az, __m512 bx, __m512 by, __m512 bz)
+{
+    return _mm512_fmadd_ps(az, bz, _mm512_fmadd_ps(ay, by, _mm512_mul_ps(ax, bx)));
+}
+
+__attribute__((target("avx512f")))
+static inline __m512 avx512_power(__m512 x, int k)
+{
+    __m512 r = _mm512_set1_ps(1.0f);
+    for (; k > 0; k >>= 1)
+    {
+        if (k & 1)
+        {
+            r = _mm512_mul_ps(r, x);
+        }
+        if (k > 1)
+        {
+            x = _mm512_mul_ps(x, x);
+        }
+    }
+    return r;
+}
+
+__attribute__((target("avx512f")))
+static void avx512_shade(v3_soa diffuse, v3_soa specular, v3_soa p, v3_soa n, v3_soa v, const float *lights,
+                         int light_count, int shininess, int model, size_t count)
+{
+    const __m512 zero = _mm512_setzero_ps();
+    const __m512 two = _mm512_set1_ps(2.0f);
+    float cutoff = shade_cutoff(shininess);
+    const __m512 cut = _mm512_set1_ps(cutoff);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        __m512 px = _mm512_loadu_ps(p.x + i), py = _mm512_loadu_ps(p.y + i), pz = _mm512_loadu_ps(p.z + i);
+        __m512 nx = _mm512_loadu_ps(n.x + i), ny = _mm512_loadu_ps(n.y + i), nz = _mm512_loadu_ps(n.z + i);
+        __m512 vx = _mm512_loadu_ps(v.x + i), vy = _mm512_loadu_ps(v.y + i), vz = _mm512_loadu_ps(v.z + i);
+        __mmask16 valid;
+        __m512 inv = avx512_rsqrt_nr(avx512_dot3(nx, ny, nz, nx, ny, nz), &valid);
+        nx = _mm512_mul_ps(nx, inv);
+        ny = _mm512_mul_ps(ny, inv);
+        nz = _mm512_mul_ps(nz, inv);
+        inv = avx512_rsqrt_nr(avx512_dot3(vx, vy, vz, vx, vy, vz), &valid);
+        vx = _mm512_mul_ps(vx, inv);
+        vy = _mm512_mul_ps(vy, inv);
+        vz = _mm512_mul_ps(vz, inv);
+
+        __m512 dr = zero, dg = zero, db = zero, sr = zero, sg = zero, sb = zero;
+        for (int j = 0; j < light_count; j++)
+        {
+            const float *light = lights + 6 * j;
+            __m512 lx = _mm512_sub_ps(_mm512_set1_ps(light[0]), px);
+            __m512 ly = _mm512_sub_ps(_mm512_set1_ps(light[1]), py);
+            __m512 lz = _mm512_sub_ps(_mm512_set1_ps(light[2]), pz);
+            inv = avx512_rsqrt_nr(avx512_dot3(lx, ly, lz, lx, ly, lz), &valid);
+            lx = _mm512_mul_ps(lx, inv);
+            ly = _mm512_mul_ps(ly, inv);
+            lz = _mm512_mul_ps(lz, inv);
+
+            __m512 ndl = avx512_dot3(nx, ny, nz, lx, ly, lz);
+            __mmask16 lit = _mm512_cmp_ps_mask(ndl, zero, _CMP_GT_OQ);
+            __m512 lambert = _mm512_maskz_mov_ps(lit, ndl);
+            __m512 r = _mm512_set1_ps(light[3]), g = _mm512_set1_ps(light[4]), b = _mm512_set1_ps(light[5]);
+            dr = _mm512_fmadd_ps(lambert, r, dr);
+            dg = _mm512_fmadd_ps(lambert, g, dg);
+            db = _mm512_fmadd_ps(lambert, b, db);
+            if (model == V3_SHADE_LAMBERT)
+            {
+                continue;
+            }
+
+            __m512 cosine;
+            if (model == V3_SHADE_PHONG)
+            {
+                __m512 k = _mm512_mul_ps(two, ndl);
+                cosine = avx512_dot3(_mm512_fmsub_ps(k, nx, lx), _mm512_fmsub_ps(k, ny, ly),
+                                     _mm512_fmsub_ps(k, nz, lz), vx, vy, vz);
+            }
+            else
+            {
+                __m512 hx = _mm512_add_ps(lx, vx), hy = _mm512_add_ps(ly, vy), hz = _mm512_add_ps(lz, vz);
+                inv = avx512_rsqrt_nr(avx512_dot3(hx, hy, hz, hx, hy, hz), &valid);
+                cosine = _mm512_mul_ps(avx512_dot3(nx, ny, nz, hx, hy, hz), inv);
+            }
+            __mmask16 shine = _mm512_mask_cmp_ps_mask(lit, cosine, cut, _CMP_GE_OQ);
+            __m512 term = _mm512_maskz_mov_ps(shine, avx512_power(_mm512_maskz_mov_ps(shine, cosine), shininess));
+            sr = _mm512_fmadd_ps(term, r, sr);
+            sg = _mm512_fmadd_ps(term, g, sg);
+            sb = _mm512_fmadd_ps(term, b, sb);
+        }
+
+        _mm512_storeu_ps(diffuse.x + i, dr);
+        _mm512_storeu_ps(diffuse.y + i, dg);
+        _mm512_storeu_ps(diffuse.z + i, db);
+        _mm512_storeu_ps(specular.x + i, sr);
+        _mm512_storeu_ps(specular.y + i, sg);
+        _mm512_storeu_ps(specular.z + i, sb);
+    }
+    for (; i < count; i++)
+    {
+        shade_one(diffuse, specular, p, n, v, lights, light_count, shininess, cutoff, model, i);
+    }
+}
+
+__attribute__((target("avx512f")))
+static inline __m512i avx512_camera_hash(__m512i h)
+{
+    h = _mm512_xor_si512(h, _mm512_maskz_srli_epi32(ALL_LANES, h, 16));
+    h = _mm512_mullo_epi32(h, _mm512_set1_epi32(0x7feb352d));
+    h = _mm512_xor_si512(h, _mm512_maskz_srli_epi32(ALL_LANES, h, 15));
+    h = _mm512_mullo_epi32(h, _mm512_set1_epi32((int)0x846ca68bu));
+    return _mm512_xor_si512(h, _mm512_maskz_srli_epi32(ALL_LANES, h, 16));
+}
+
+__attribute__((target("avx512f")))
+static inline __m512 avx512_camera_offset(__m512i h)
+{
+    __m512 top = _mm512_maskz_cvtepi32_ps(ALL_LANES, _mm512_maskz_srli_epi32(ALL_LANES, h, 8));
+    return _mm512_sub_ps(_mm512_mul_ps(top, _mm512_set1_ps(1.0f / 16777216.0f)), _mm512_set1_ps(0.5f));
+}
+
+__attribute__((target("avx512f")))
+static void avx512_camera(v3_soa dst, const float *frame, size_t x0, size_t y0, size_t width, size_t height,
+                          size_t image_width, int samples, uint32_t seed, int jitter)
+{
+    const __m512i index = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    const __m512 iota = _mm512_maskz_cvtepi32_ps(ALL_LANES, index);
+    const __m512i lanes = _mm512_mullo_epi32(index, _mm512_set1_epi32(samples));
+    const __m512 rx = _mm512_set1_ps(frame[3]), ry = _mm512_set1_ps(frame[4]), rz = _mm512_set1_ps(frame[5]);
+    const __m512 dx = _mm512_set1_ps(frame[6]), dy = _mm512_set1_ps(frame[7]), dz = _mm512_set1_ps(frame[8]);
+    size_t i = 0;
+    for (size_t r = 0; r < height; r++)
+    {
+        float y = (float)(y0 + r);
+        float base[3] = {frame[0] + y * frame[6], frame[1] + y * frame[7], frame[2] + y * frame[8]};
+        const __m512 bx = _mm512_set1_ps(base[0]), by = _mm512_set1_ps(base[1]), bz = _mm512_set1_ps(base[2]);
+        for (int s = 0; s < samples; s++)
+        {
+            uint32_t key = camera_key(x0, y0 + r, image_width, samples, s, seed);
+            size_t c = 0;
+            for (; c < width; c += 16)
+            {
+                size_t n = (width - c < 16) ? width - c : 16;
+                __mmask16 store = (__mmask16)((1u << n) - 1u);
+                __m512 x = _mm512_add_ps(_mm512_set1_ps((float)(x0 + c)), iota);
+                __m512 ox = bx, oy = by, oz = bz;
+                if (jitter)
+                {
+                    __m512i first = _mm512_set1_epi32((int)(key + (uint32_t)(c * (size_t)samples)));
+                    __m512i h = avx512_camera_hash(_mm512_add_epi32(first, lanes));
+                    x = _mm512_add_ps(x, avx512_camera_offset(h));
+                    __m512 jy = avx512_camera_offset(avx512_camera_hash(h));
+                    ox = _mm512_fmadd_ps(jy, dx, ox);
+                    oy = _mm512_fmadd_ps(jy, dy, oy);
+                    oz = _mm512_fmadd_ps(jy, dz, oz);
+                }
+                ox = _mm512_fmadd_ps(x, rx, ox);
+                oy = _mm512_fmadd_ps(x, ry, oy);
+                oz = _mm512_fmadd_ps(x, rz, oz);
+                __mmask16 valid;
+                __m512 inv = avx512_rsqrt_nr(avx512_dot3(ox, oy, oz, ox, oy, oz), &valid);
+                _mm512_mask_storeu_ps(dst.x + i, store, _mm512_mul_ps(ox, inv));
+                _mm512_mask_storeu_ps(dst.y + i, store, _mm512_mul_ps(oy, inv));
+                _mm512_mask_storeu_ps(dst.z + i, store, _mm512_mul_ps(oz, inv));
+                i += n;
+            }
+        }
+    }
+}
+
+// avx-512 implies fma, and gcc contracts the mul and add intrinsics into it;
+// fp-contract=off keeps the ray kernels rounding like the scalar functions
+__attribute__((target("avx512f"), optimize("fp-contract=off")))
+static inline __m512 avx512_ray_dot3(__m512 ax, __m512 ay, __m512 az, __m512 bx, __m512 by, __m512 bz)
+{
+    return _mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(ax, bx), _mm512_mul_ps(ay, by)), _mm512_mul_ps(az, bz));
+}
+
+__attribute__((target("avx512f"), optimize("fp-contract=off")))
+static void avx512_ray_triangle(float *t, uint8_t *hit, v3_soa origin, v3_soa dir, const float *tri, size_t count)
+{
+    const __m512 v0x = _mm512_set1_ps(tri[0]), v0y = _mm512_set1_ps(tri[1]), v0z = _mm512_set1_ps(tri[2]);
+    const __m512 e1x = _mm512_set1_ps(tri[3]), e1y = _mm512_set1_ps(tri[4]), e1z = _mm512_set1_ps(tri[5]);
+    const __m512 e2x = _mm512_set1_ps(tri[6]), e2y = _mm512_set1_ps(tri[7]), e2z = _mm512_set1_ps(tri[8]);
+    const __m512 zero = _mm512_setzero_ps(), one = _mm512_set1_ps(1.0f), eps = _mm512_set1_ps(V3_RAY_EPSILON);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        __m512 dx = _mm512_loadu_ps(dir.x + i), dy = _mm512_loadu_ps(dir.y + i), dz = _mm512_loadu_ps(dir.z + i);
+
+        __m512 px = _mm512_sub_ps(_mm512_mul_ps(dy, e2z), _mm512_mul_ps(dz, e2y));
+        __m512 py = _mm512_sub_ps(_mm512_mul_ps(dz, e2x), _mm512_mul_ps(dx, e2z));
+        __m512 pz = _mm512_sub_ps(_mm512_mul_ps(dx, e2y), _mm512_mul_ps(dy, e2x));
+        __m512 det = avx512_ray_dot3(e1x, e1y, e1z, px, py, pz);
+        __m512 inv_det = _mm512_div_ps(one, det);
+
+        __m512 sx = _mm512_sub_ps(_mm512_loadu_ps(origin.x + i), v0x);
+        __m512 sy = _mm512_sub_ps(_mm512_loadu_ps(origin.y + i), v0y);
+        __m512 sz = _mm512_sub_ps(_mm512_loadu_ps(origin.z + i), v0z);
+        __m512 u = _mm512_mul_ps(avx512_ray_dot3(sx, sy, sz, px, py, pz), inv_det);
+
+        __m512 qx = _mm512_sub_ps(_mm512_mul_ps(sy, e1z), _mm512_mul_ps(sz, e1y));
+        __m512 qy = _mm512_sub_ps(_mm512_mul_ps(sz, e1x), _mm512_mul_ps(sx, e1z));
+        __m512 qz = _mm512_sub_ps(_mm512_mul_ps(sx, e1y), _mm512_mul_ps(sy, e1x));
+        __m512 v = _mm512_mul_ps(avx512_ray_dot3(dx, dy, dz, qx, qy, qz), inv_det);
+        __m512 hit_t = _mm512_mul_ps(avx512_ray_dot3(e2x, e2y, e2z, qx, qy, qz), inv_det);
+
+        __mmask16 miss = _mm512_cmp_ps_mask(_mm512_abs_ps(det), eps, _CMP_LT_OQ);
+        miss |= _mm512_cmp_ps_mask(u, zero, _CMP_LT_OQ) | _mm512_cmp_ps_mask(u, one, _CMP_GT_OQ);
+        miss |= _mm512_cmp_ps_mask(v, zero, _CMP_LT_OQ) | _mm512_cmp_ps_mask(_mm512_add_ps(u, v), one, _CMP_GT_OQ);
+        miss |= _mm512_cmp_ps_mask(hit_t, eps, _CMP_LE_OQ);
+
+        _mm512_storeu_ps(t + i, _mm512_mask_blend_ps(miss, hit_t, _mm512_set1_ps(V3_RAY_MISS)));
+        store_valid(hit, i, ~miss & 0xffffu, 16);
+    }
+    for (; i < count; i++)
+    {
+        ray_triangle_one(t, hit, origin, dir, tri, i);
+    }
+}
+
+__attribute__((target("avx512f"), optimize("fp-contract=off")))
+static void avx512_ray_sphere(float *t, uint8_t *hit, v3_soa origin, v3_soa dir, const float *sphere, size_t count)
+{
+    const __m512 cx = _mm512_set1_ps(sphere[0]), cy = _mm512_set1_ps(sphere[1]), cz = _mm512_set1_ps(sphere[2]);
+    const __m512 r2 = _mm512_set1_ps(sphere[3] * sphere[3]), eps = _mm512_set1_ps(V3_RAY_EPSILON);
+    const __m512 zero = _mm512_setzero_ps();
+    const __m512i sign = _mm512_set1_epi32((int)0x80000000u);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        __m512 dx = _mm512_loadu_ps(dir.x + i), dy = _mm512_loadu_ps(dir.y + i), dz = _mm512_loadu_ps(dir.z + i);
+        __m512 ox = _mm512_sub_ps(_mm512_loadu_ps(origin.x + i), cx);
+        __m512 oy = _mm512_sub_ps(_mm512_loadu_ps(origin.y + i), cy);
+        __m512 oz = _mm512_sub_ps(_mm512_loadu_ps(origin.z + i), cz);
+
+        __m512 a = avx512_ray_dot3(dx, dy, dz, dx, dy, dz);
+        __m512 b = avx512_ray_dot3(ox, oy, oz, dx, dy, dz);
+        __m512 c = _mm512_sub_ps(avx512_ray_dot3(ox, oy, oz, ox, oy, oz), r2);
+        __m512 disc = _mm512_sub_ps(_mm512_mul_ps(b, b), _mm512_mul_ps(a, c));
+
+        // a negative discriminant is a miss, so only the others take a root
+        __mmask16 miss = _mm512_cmp_ps_mask(a, eps, _CMP_LT_OQ) | _mm512_cmp_ps_mask(disc, zero, _CMP_LT_OQ);
+        __m512 root = _mm512_maskz_sqrt_ps((__mmask16)~miss, disc);
+        __m512 neg_b = _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(b), sign));
+        __m512 near = _mm512_div_ps(_mm512_sub_ps(neg_b, root), a);
+        __m512 far = _mm512_div_ps(_mm512_add_ps(neg_b, root), a);
+        __m512 hit_t = _mm512_mask_blend_ps(_mm512_cmp_ps_mask(near, eps, _CMP_GT_OQ), far, near);
+        miss |= _mm512_cmp_ps_mask(hit_t, eps, _CMP_LE_OQ);
+
+        _mm512_storeu_ps(t + i, _mm512_mask_blend_ps(miss, hit_t, _mm512_set1_ps(V3_RAY_MISS)));
+        store_valid(hit, i, ~miss & 0xffffu, 16);
+    }
+    for (; i < count; i++)
+    {
+        ray_sphere_one(t, hit, origin, dir, sphere, i);
+    }
+}
+
+#endif
+
+// kernel tables, indexed by v3_isa; off x86 every slot holds the scalar
+// kernels and v3_isa_supported never reports the others
+#define SCALAR_KERNELS \
+    {scalar_dot_product, scalar_cross_product, scalar_normalize, scalar_reflect, \
+     scalar_normalize_fast, scalar_inv_length, scalar_transform, scalar_rotate, scalar_angle, \
+     scalar_sum, scalar_sum_compensated, scalar_bounds, \
+     scalar_oct_encode, scalar_oct_decode, scalar_oct_dot, scalar_oct_reflect, \
+     scalar_shade, scalar_camera, scalar_ray_triangle, scalar_ray_sphere}
+
+static const v3_kernels kernel_tables[V3_ISA_COUNT] =
+{
+    SCALAR_KERNELS,
+#ifdef V3_X86
+    {sse41_dot_product, sse41_cross_product, sse41_normalize, sse41_reflect,
+     sse41_normalize_fast, sse41_inv_length, sse41_transform, sse41_rotate, sse41_angle,
+     sse41_sum, sse41_sum_compensated, sse41_bounds,
+     sse41_oct_encode, sse41_oct_decode, sse41_oct_dot, sse41_oct_reflect,
+     sse41_shade, sse41_camera, sse41_ray_triangle, sse41_ray_sphere},
+    {avx2_dot_product, avx2_cross_product, avx2_normalize, avx2_reflect,
+     avx2_normalize_fast, avx2_inv_length, avx2_transform, avx2_rotate, avx2_angle,
+     avx2_sum, avx2_sum_compensated, avx2_bounds,
+     avx2_oct_encode, avx2_oct_decode, avx2_oct_dot, avx2_oct_reflect,
+     avx2_shade, avx2_camera, avx2_ray_triangle, avx2_ray_sphere},
+    {avx512_dot_product, avx512_cross_product, avx512_normalize, avx512_reflect,
+     avx512_normalize_fast, avx512_inv_length, avx512_transform, avx512_rotate, avx512_angle,
+     avx512_sum, avx512_sum_compensated, avx512_bounds,
+     avx512_oct_encode, avx512_oct_decode, avx512_oct_dot, avx512_oct_reflect,
+     avx512_shade, avx512_camera, avx512_ray_triangle, avx512_ray_sphere}
+#else
+    SCALAR_KERNELS, SCALAR_KERNELS, SCALAR_KERNELS
+#endif
+};
+
+static const char *isa_names[V3_ISA_COUNT] = {"scalar", "sse4.1", "avx2", "avx512"};
+
+// currently selected instruction set, chosen once at startup
+static v3_isa current_isa = V3_ISA_SCALAR;
+static const v3_kernels *current_kernels = NULL;
+
+const char *v3_isa_name(v3_isa isa)
+{
+    assert(isa < V3_ISA_COUNT);
+
+    return isa_names[isa];
+}
+
+bool v3_isa_supported(v3_isa isa)
+{
+#ifdef V3_X86
+    __builtin_cpu_init();
+
+    switch (isa)
+    {
+        case V3_ISA_SCALAR:
+            return true;
+        case V3_ISA_SSE41:
+            return __builtin_cpu_supports("sse4.1");
+        case V3_ISA_AVX2:
+            return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+        case V3_ISA_AVX512:
+            return __builtin_cpu_supports("avx512f");
+        default:
+            return false;
+    }
+#else
+    return isa == V3_ISA_SCALAR;
+#endif
+}
+
+// pick the widest supported instruction set, unless V3MATH_ISA names another
+static void select_isa(void)
+{
+    v3_isa best = V3_ISA_SCALAR;
+    for (int isa = V3_ISA_COUNT - 1; isa > V3_ISA_SCALAR; isa--)
+    {
+        if (v3_isa_supported((v3_isa)isa))
+        {
+            best = (v3_isa)isa;
+            break;
+        }
+    }
+
+    const char *requested = getenv("V3MATH_ISA");
+    if (requested != NULL)
+    {
+        int isa = 0;
+        while (isa < V3_ISA_COUNT && strcmp(requested, isa_names[isa]) != 0)
+        {
+            isa++;
+        }
+
+        if (isa == V3_ISA_COUNT || !v3_isa_supported((v3_isa)isa))
+        {
+            fprintf(stderr, "Error: V3MATH_ISA=%s is not available, using %s\n", requested, isa_names[best]);
+        }
+        else
+        {
+            best = (v3_isa)isa;
+        }
+    }
+
+    current_isa = best;
+    current_kernels = &kernel_tables[best];
+}
+
+// run the cpuid check before main so the hot path never has to
+__attribute__((constructor))
+static void init_isa(void)
+{
+    select_isa();
+}
+
+v3_isa v3_get_isa(void)
+{
+    if (current_kernels == NULL)
+    {
+        select_isa();
+    }
+
+    return current_isa;
+}
+
+bool v3_set_isa(v3_isa isa)
+{
+    if (isa >= V3_ISA_COUNT || !v3_isa_supported(isa))
+    {
+        return false;
+    }
+
+    current_isa = isa;
+    current_kernels = &kernel_tables[isa];
+    return true;
+}
+
+const v3_kernels *v3_get_kernels(void)
+{
+    if (current_kernels == NULL)
+    {
+        select_isa();
+    }
+
+    return current_kernels;
+}
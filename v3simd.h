@@ -0,0 +1,110 @@
+#ifndef V3SIMD_H
+#define V3SIMD_H
+
+// library inclusions
+#include "v3math.h"
+
+// the vector kernels and the hardware reciprocal square root need an x86
+// target; elsewhere the scalar kernels stand in for every instruction set
+#if defined(__x86_64__) || defined(__i386__)
+#define V3_X86 1
+#include <immintrin.h>
+#endif
+
+// instruction sets the batch kernels are implemented for
+typedef enum
+{
+    V3_ISA_SCALAR,
+    V3_ISA_SSE41,
+    V3_ISA_AVX2,
+    V3_ISA_AVX512,
+    V3_ISA_COUNT
+} v3_isa;
+
+// table of batch kernels for one instruction set
+// normalize returns the number of zero length vectors it found
+// transform applies a row-major 3x4 affine matrix m: dst = m[0..2] * a + m[3] per row
+// rotate applies a unit quaternion q = (x, y, z, w) with the two cross product form
+// angle computes the V3_ANGLE_POLY or V3_ANGLE_COSINE tier, returning the zero length pairs
+// sum adds count floats into 16 lane sums, x[i] into lanes[i % 16], so every
+// instruction set rounds the same additions; sum_compensated does the same with
+// kahan compensation terms in comp. bounds lowers lo and raises hi to cover x
+// oct_* work on octahedral unit vectors packed as bits = 16 (a uint32_t each)
+// or bits = 8 (a uint16_t each), see v3oct.h; encoding is exact on every set
+// shade lights the pixels at p with normals n and view directions v under
+// light_count lights of 6 floats (position, rgb color) with a v3_shade_model,
+// see v3shade.h
+// camera writes the rays of a width x height pixel block at (x0, y0) of an
+// image image_width pixels wide, row by row and within a row sample by sample;
+// frame holds the directions through pixel (0, 0) and of one pixel step right
+// and down, 9 floats. see v3camera.h for the jitter
+// ray_triangle and ray_sphere intersect count rays with tri (v0, v1 - v0, v2 - v0,
+// 9 floats) or sphere (center, radius, 4 floats), writing V3_RAY_MISS for misses
+// and, unless hit is NULL, 1 or 0 per ray; see v3ray.h
+typedef struct
+{
+    void (*dot_product)(float *dst, v3_soa a, v3_soa b, size_t count);
+    void (*cross_product)(v3_soa dst, v3_soa a, v3_soa b, size_t count);
+    size_t (*normalize)(v3_soa dst, v3_soa a, size_t count);
+    void (*reflect)(v3_soa dst, v3_soa v, v3_soa n, size_t count);
+    void (*normalize_fast)(v3_soa dst, v3_soa a, uint8_t *valid, size_t count);
+    void (*inv_length)(float *dst, v3_soa a, size_t count);
+    void (*transform)(v3_soa dst, const float *m, v3_soa a, size_t count);
+    void (*rotate)(v3_soa dst, const float *q, v3_soa a, size_t count);
+    size_t (*angle)(float *dst, v3_soa a, v3_soa b, size_t count, v3_angle_accuracy accuracy);
+    void (*sum)(float *lanes, const float *x, size_t count);
+    void (*sum_compensated)(float *lanes, float *comp, const float *x, size_t count);
+    void (*bounds)(float *lo, float *hi, const float *x, size_t count);
+    void (*oct_encode)(void *dst, v3_soa a, size_t count, int bits);
+    void (*oct_decode)(v3_soa dst, const void *src, size_t count, int bits);
+    void (*oct_dot)(float *dst, const void *n, v3_soa v, size_t count, int bits);
+    void (*oct_reflect)(v3_soa dst, v3_soa v, const void *n, size_t count, int bits);
+    void (*shade)(v3_soa diffuse, v3_soa specular, v3_soa p, v3_soa n, v3_soa v, const float *lights,
+                  int light_count, int shininess, int model, size_t count);
+    void (*camera)(v3_soa dst, const float *frame, size_t x0, size_t y0, size_t width, size_t height,
+                   size_t image_width, int samples, uint32_t seed, int jitter);
+    void (*ray_triangle)(float *t, uint8_t *hit, v3_soa origin, v3_soa dir, const float *tri, size_t count);
+    void (*ray_sphere)(float *t, uint8_t *hit, v3_soa origin, v3_soa dir, const float *sphere, size_t count);
+} v3_kernels;
+
+// lanes of the sum kernels on every instruction set
+#define V3_SUM_LANES 16
+
+// hardware reciprocal square root refined with one newton-raphson step, or a
+// plain 1 / sqrt off x86
+// returns 0 when len2 is below V3_EPSILON squared, without branching
+static inline float v3_rsqrt_nr(float len2)
+{
+#ifdef V3_X86
+    __m128 x = _mm_set_ss(len2);
+    __m128 y = _mm_rsqrt_ss(x);
+
+    // y = y * (1.5 - 0.5 * x * y * y)
+    __m128 half_x = _mm_mul_ss(_mm_set_ss(0.5f), x);
+    y = _mm_mul_ss(y, _mm_sub_ss(_mm_set_ss(1.5f), _mm_mul_ss(half_x, _mm_mul_ss(y, y))));
+
+    // zero length gives inf * 0 = nan above, the mask clears it
+    __m128 valid = _mm_cmpge_ss(x, _mm_set_ss(V3_EPSILON * V3_EPSILON));
+    return _mm_cvtss_f32(_mm_and_ps(y, valid));
+#else
+    return (len2 >= V3_EPSILON * V3_EPSILON) ? 1.0f / sqrtf(len2) : 0.0f;
+#endif
+}
+
+// short name of an instruction set, as accepted by V3MATH_ISA
+const char *v3_isa_name(v3_isa isa);
+
+// check whether this cpu can run the kernels for an instruction set
+bool v3_isa_supported(v3_isa isa);
+
+// get the instruction set the batch functions currently dispatch to
+v3_isa v3_get_isa(void);
+
+// switch the batch functions to another instruction set
+// returns false and keeps the current one if isa is not supported
+bool v3_set_isa(v3_isa isa);
+
+// get the kernel table for the current instruction set
+const v3_kernels *v3_get_kernels(void);
+
+#endif
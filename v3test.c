@@ -1,5 +1,28 @@
 // library inclusions
 #include "v3math.h"
+#include "v3simd.h"
+#include "v3vec.h"
+#include "v3expr.h"
+#include "v3double.h"
+#include "v3half.h"
+#include "v3pool.h"
+#include "v3ray.h"
+#include "v3mat.h"
+#include "v3quat.h"
+#include "v3bvh.h"
+#include "v3file.h"
+#include "v3arena.h"
+#include "v3reduce.h"
+#include "v3oct.h"
+#include "v3instrument.h"
+#include "v3graph.h"
+#include "v3particle.h"
+#include "v3shade.h"
+#include "v3camera.h"
+#include <stdlib.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
 
 // test tolerance
 #define TEST_TOLERANCE 1e-5f
@@ -590,6 +613,3623 @@ void test_v3_equals()
     }
 }
 
+// number of vectors used by the batch tests, not a multiple of any simd width
+#define BATCH_COUNT 37
+
+v3_soa alloc_batch(size_t count)
+{
+    v3_soa v;
+    v.x = (float *)malloc(count * sizeof(float));
+    v.y = (float *)malloc(count * sizeof(float));
+    v.z = (float *)malloc(count * sizeof(float));
+    return v;
+}
+
+void free_batch(v3_soa v)
+{
+    free(v.x);
+    free(v.y);
+    free(v.z);
+}
+
+// fill a batch with deterministic pseudo-random components in [-10, 10]
+void fill_batch(v3_soa v, size_t count, uint32_t seed)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        v.x[i] = (float)(seed >> 8) / 16777216.0f * 20.0f - 10.0f;
+        seed = seed * 1664525u + 1013904223u;
+        v.y[i] = (float)(seed >> 8) / 16777216.0f * 20.0f - 10.0f;
+        seed = seed * 1664525u + 1013904223u;
+        v.z[i] = (float)(seed >> 8) / 16777216.0f * 20.0f - 10.0f;
+    }
+}
+
+// helper to compare every element of a batch result against scalar results
+void assert_batch_equals(const char *test_name, v3_soa expected, v3_soa actual, size_t count)
+{
+    current_test_num++;
+    for (size_t i = 0; i < count; i++)
+    {
+        float e[3] = {expected.x[i], expected.y[i], expected.z[i]};
+        float r[3] = {actual.x[i], actual.y[i], actual.z[i]};
+
+        // fused multiply-add paths round differently, so scale the tolerance with magnitude
+        float scale = fmaxf(1.0f, fmaxf(fabsf(e[0]), fmaxf(fabsf(e[1]), fabsf(e[2]))));
+        if (!v3_equals(e, r, TEST_TOLERANCE * scale))
+        {
+            printf(COLOR_RED "FAIL" COLOR_RESET " [%d] %s\n", current_test_num, test_name);
+            printf("  Element:  %zu\n", i);
+            printf("  Expected: (%.6f, %.6f, %.6f)\n", e[0], e[1], e[2]);
+            printf("  Actual:   (%.6f, %.6f, %.6f)\n", r[0], r[1], r[2]);
+            tests_failed++;
+            return;
+        }
+    }
+    printf(COLOR_GREEN "PASS" COLOR_RESET " [%d] %s\n", current_test_num, test_name);
+    tests_passed++;
+}
+
+void assert_batch_float_equals(const char *test_name, float *expected, float *actual, size_t count)
+{
+    current_test_num++;
+    for (size_t i = 0; i < count; i++)
+    {
+        if (fabsf(expected[i] - actual[i]) > TEST_TOLERANCE * fmaxf(1.0f, fabsf(expected[i])))
+        {
+            printf(COLOR_RED "FAIL" COLOR_RESET " [%d] %s\n", current_test_num, test_name);
+            printf("  Element:  %zu\n", i);
+            printf("  Expected: %.6f\n", expected[i]);
+            printf("  Actual:   %.6f\n", actual[i]);
+            tests_failed++;
+            return;
+        }
+    }
+    printf(COLOR_GREEN "PASS" COLOR_RESET " [%d] %s\n", current_test_num, test_name);
+    tests_passed++;
+}
+
+// test batch operations against the scalar reference functions
+void test_v3_batch()
+{
+    print_test_section("batch operations");
+
+    float ax[BATCH_COUNT], ay[BATCH_COUNT], az[BATCH_COUNT];
+    float bx[BATCH_COUNT], by[BATCH_COUNT], bz[BATCH_COUNT];
+    float rx[BATCH_COUNT], ry[BATCH_COUNT], rz[BATCH_COUNT];
+    float ex[BATCH_COUNT], ey[BATCH_COUNT], ez[BATCH_COUNT];
+    float rs[BATCH_COUNT], es[BATCH_COUNT];
+    v3_soa a = {ax, ay, az};
+    v3_soa b = {bx, by, bz};
+    v3_soa result = {rx, ry, rz};
+    v3_soa expected = {ex, ey, ez};
+
+    fill_batch(a, BATCH_COUNT, 1u);
+    fill_batch(b, BATCH_COUNT, 2u);
+
+    // make one element zero length to exercise the degenerate normalize case
+    ax[5] = 0.0f;
+    ay[5] = 0.0f;
+    az[5] = 0.0f;
+
+    {
+        for (size_t i = 0; i < BATCH_COUNT; i++)
+        {
+            float pa[3] = {ax[i], ay[i], az[i]};
+            float pb[3] = {bx[i], by[i], bz[i]};
+            float out[3];
+            v3_from_points(out, pa, pb);
+            ex[i] = out[0]; ey[i] = out[1]; ez[i] = out[2];
+        }
+        v3_from_points_batch(result, a, b, BATCH_COUNT);
+        assert_batch_equals("v3_from_points_batch: matches scalar", expected, result, BATCH_COUNT);
+    }
+
+    {
+        for (size_t i = 0; i < BATCH_COUNT; i++)
+        {
+            float pa[3] = {ax[i], ay[i], az[i]};
+            float pb[3] = {bx[i], by[i], bz[i]};
+            float out[3];
+            v3_add(out, pa, pb);
+            ex[i] = out[0]; ey[i] = out[1]; ez[i] = out[2];
+        }
+        v3_add_batch(result, a, b, BATCH_COUNT);
+        assert_batch_equals("v3_add_batch: matches scalar", expected, result, BATCH_COUNT);
+    }
+
+    {
+        for (size_t i = 0; i < BATCH_COUNT; i++)
+        {
+            float pa[3] = {ax[i], ay[i], az[i]};
+            float pb[3] = {bx[i], by[i], bz[i]};
+            float out[3];
+            v3_subtract(out, pa, pb);
+            ex[i] = out[0]; ey[i] = out[1]; ez[i] = out[2];
+        }
+        v3_subtract_batch(result, a, b, BATCH_COUNT);
+        assert_batch_equals("v3_subtract_batch: matches scalar", expected, result, BATCH_COUNT);
+    }
+
+    {
+        for (size_t i = 0; i < BATCH_COUNT; i++)
+        {
+            float pa[3] = {ax[i], ay[i], az[i]};
+            float pb[3] = {bx[i], by[i], bz[i]};
+            es[i] = v3_dot_product(pa, pb);
+        }
+        v3_dot_product_batch(rs, a, b, BATCH_COUNT);
+        assert_batch_float_equals("v3_dot_product_batch: matches scalar", es, rs, BATCH_COUNT);
+    }
+
+    {
+        for (size_t i = 0; i < BATCH_COUNT; i++)
+        {
+            float pa[3] = {ax[i], ay[i], az[i]};
+            float pb[3] = {bx[i], by[i], bz[i]};
+            float out[3];
+            v3_cross_product(out, pa, pb);
+            ex[i] = out[0]; ey[i] = out[1]; ez[i] = out[2];
+        }
+        v3_cross_product_batch(result, a, b, BATCH_COUNT);
+        assert_batch_equals("v3_cross_product_batch: matches scalar", expected, result, BATCH_COUNT);
+    }
+
+    {
+        for (size_t i = 0; i < BATCH_COUNT; i++)
+        {
+            float out[3] = {ax[i], ay[i], az[i]};
+            v3_scale(out, -2.5f);
+            ex[i] = out[0]; ey[i] = out[1]; ez[i] = out[2];
+            rx[i] = ax[i]; ry[i] = ay[i]; rz[i] = az[i];
+        }
+        v3_scale_batch(result, -2.5f, BATCH_COUNT);
+        assert_batch_equals("v3_scale_batch: matches scalar", expected, result, BATCH_COUNT);
+    }
+
+    {
+        for (size_t i = 0; i < BATCH_COUNT; i++)
+        {
+            float pb[3] = {bx[i], by[i], bz[i]};
+            es[i] = v3_length(pb);
+        }
+        v3_length_batch(rs, b, BATCH_COUNT);
+        assert_batch_float_equals("v3_length_batch: matches scalar", es, rs, BATCH_COUNT);
+    }
+
+    {
+        for (size_t i = 0; i < BATCH_COUNT; i++)
+        {
+            float pa[3] = {ax[i], ay[i], az[i]};
+            float out[3];
+            v3_normalize(out, pa);
+            ex[i] = out[0]; ey[i] = out[1]; ez[i] = out[2];
+        }
+        v3_normalize_batch(result, a, BATCH_COUNT);
+        assert_batch_equals("v3_normalize_batch: matches scalar", expected, result, BATCH_COUNT);
+    }
+
+    // normals for reflect must be unit length
+    {
+        float nx[BATCH_COUNT], ny[BATCH_COUNT], nz[BATCH_COUNT];
+        v3_soa n = {nx, ny, nz};
+        v3_normalize_batch(n, b, BATCH_COUNT);
+        for (size_t i = 0; i < BATCH_COUNT; i++)
+        {
+            float pa[3] = {ax[i], ay[i], az[i]};
+            float pn[3] = {nx[i], ny[i], nz[i]};
+            float out[3];
+            v3_reflect(out, pa, pn);
+            ex[i] = out[0]; ey[i] = out[1]; ez[i] = out[2];
+        }
+        v3_reflect_batch(result, a, n, BATCH_COUNT);
+        assert_batch_equals("v3_reflect_batch: matches scalar", expected, result, BATCH_COUNT);
+    }
+
+    // dst = a
+    {
+        for (size_t i = 0; i < BATCH_COUNT; i++)
+        {
+            float pa[3] = {ax[i], ay[i], az[i]};
+            float pb[3] = {bx[i], by[i], bz[i]};
+            float out[3];
+            v3_cross_product(out, pa, pb);
+            ex[i] = out[0]; ey[i] = out[1]; ez[i] = out[2];
+            rx[i] = ax[i]; ry[i] = ay[i]; rz[i] = az[i];
+        }
+        v3_cross_product_batch(result, result, b, BATCH_COUNT);
+        assert_batch_equals("v3_cross_product_batch: overlapping dst=a", expected, result, BATCH_COUNT);
+    }
+}
+
+// test every supported instruction set path against the scalar kernels
+void test_v3_isa_dispatch()
+{
+    print_test_section("simd dispatch");
+
+    float ax[BATCH_COUNT], ay[BATCH_COUNT], az[BATCH_COUNT];
+    float bx[BATCH_COUNT], by[BATCH_COUNT], bz[BATCH_COUNT];
+    float nx[BATCH_COUNT], ny[BATCH_COUNT], nz[BATCH_COUNT];
+    float rx[BATCH_COUNT], ry[BATCH_COUNT], rz[BATCH_COUNT];
+    float ex[BATCH_COUNT], ey[BATCH_COUNT], ez[BATCH_COUNT];
+    float rs[BATCH_COUNT], es[BATCH_COUNT];
+    v3_soa a = {ax, ay, az};
+    v3_soa b = {bx, by, bz};
+    v3_soa n = {nx, ny, nz};
+    v3_soa result = {rx, ry, rz};
+    v3_soa expected = {ex, ey, ez};
+    char name[128];
+
+    fill_batch(a, BATCH_COUNT, 3u);
+    fill_batch(b, BATCH_COUNT, 4u);
+    ax[9] = 0.0f;
+    ay[9] = 0.0f;
+    az[9] = 0.0f;
+
+    v3_isa saved = v3_get_isa();
+    v3_set_isa(V3_ISA_SCALAR);
+    v3_normalize_batch(n, b, BATCH_COUNT);
+
+    for (int isa = V3_ISA_SCALAR + 1; isa < V3_ISA_COUNT; isa++)
+    {
+        if (!v3_isa_supported((v3_isa)isa))
+        {
+            printf(COLOR_YELLOW "SKIP" COLOR_RESET " %s not supported on this cpu\n", v3_isa_name((v3_isa)isa));
+            continue;
+        }
+
+        v3_set_isa(V3_ISA_SCALAR);
+        v3_dot_product_batch(es, a, b, BATCH_COUNT);
+        v3_set_isa((v3_isa)isa);
+        v3_dot_product_batch(rs, a, b, BATCH_COUNT);
+        snprintf(name, sizeof(name), "%s: dot product matches scalar", v3_isa_name((v3_isa)isa));
+        assert_batch_float_equals(name, es, rs, BATCH_COUNT);
+
+        v3_set_isa(V3_ISA_SCALAR);
+        v3_cross_product_batch(expected, a, b, BATCH_COUNT);
+        v3_set_isa((v3_isa)isa);
+        v3_cross_product_batch(result, a, b, BATCH_COUNT);
+        snprintf(name, sizeof(name), "%s: cross product matches scalar", v3_isa_name((v3_isa)isa));
+        assert_batch_equals(name, expected, result, BATCH_COUNT);
+
+        v3_set_isa(V3_ISA_SCALAR);
+        v3_normalize_batch(expected, a, BATCH_COUNT);
+        v3_set_isa((v3_isa)isa);
+        v3_normalize_batch(result, a, BATCH_COUNT);
+        snprintf(name, sizeof(name), "%s: normalize matches scalar", v3_isa_name((v3_isa)isa));
+        assert_batch_equals(name, expected, result, BATCH_COUNT);
+
+        v3_set_isa(V3_ISA_SCALAR);
+        v3_reflect_batch(expected, a, n, BATCH_COUNT);
+        v3_set_isa((v3_isa)isa);
+        v3_reflect_batch(result, a, n, BATCH_COUNT);
+        snprintf(name, sizeof(name), "%s: reflect matches scalar", v3_isa_name((v3_isa)isa));
+        assert_batch_equals(name, expected, result, BATCH_COUNT);
+    }
+
+    v3_set_isa(saved);
+}
+
+// helper for boolean checks
+void assert_true(const char *test_name, bool condition)
+{
+    current_test_num++;
+    if (condition)
+    {
+        printf(COLOR_GREEN "PASS" COLOR_RESET " [%d] %s\n", current_test_num, test_name);
+        tests_passed++;
+    }
+    else
+    {
+        printf(COLOR_RED "FAIL" COLOR_RESET " [%d] %s\n", current_test_num, test_name);
+        tests_failed++;
+    }
+}
+
+// number of vectors used to measure the fast path error bound
+#define ERROR_SWEEP_COUNT 4096
+
+// test fast rsqrt normalize and inverse length
+void test_v3_normalize_fast()
+{
+    print_test_section("v3_normalize_fast / v3_inv_length");
+
+    {
+        float v[3] = {3.0f, 4.0f, 0.0f};
+        float result[3];
+        float expected[3] = {0.6f, 0.8f, 0.0f};
+        bool valid = v3_normalize_fast(result, v);
+        assert_v3_equals("v3_normalize_fast: scale down", expected, result);
+        assert_true("v3_normalize_fast: nonzero vector is valid", valid);
+    }
+
+    {
+        float v[3] = {0.0f, 0.0f, 0.0f};
+        float result[3] = {1.0f, 1.0f, 1.0f};
+        float expected[3] = {0.0f, 0.0f, 0.0f};
+        bool valid = v3_normalize_fast(result, v);
+        assert_v3_equals("v3_normalize_fast: zero vector gives zero", expected, result);
+        assert_true("v3_normalize_fast: zero vector is invalid", !valid);
+    }
+
+    // dst = a
+    {
+        float v[3] = {3.0f, 4.0f, 0.0f};
+        float expected[3] = {0.6f, 0.8f, 0.0f};
+        v3_normalize_fast(v, v);
+        assert_v3_equals("v3_normalize_fast: overlapping dst=a", expected, v);
+    }
+
+    {
+        float v[3] = {3.0f, 4.0f, 0.0f};
+        assert_float_equals("v3_inv_length: 3-4-5 triangle", 0.2f, v3_inv_length(v));
+    }
+
+    {
+        float v[3] = {0.0f, 0.0f, 0.0f};
+        assert_float_equals("v3_inv_length: zero vector", 0.0f, v3_inv_length(v));
+    }
+
+    // sweep magnitudes from 2^-30 to 2^30 through every instruction set
+    float *x = (float *)malloc(ERROR_SWEEP_COUNT * sizeof(float));
+    float *y = (float *)malloc(ERROR_SWEEP_COUNT * sizeof(float));
+    float *z = (float *)malloc(ERROR_SWEEP_COUNT * sizeof(float));
+    float *nx = (float *)malloc(ERROR_SWEEP_COUNT * sizeof(float));
+    float *ny = (float *)malloc(ERROR_SWEEP_COUNT * sizeof(float));
+    float *nz = (float *)malloc(ERROR_SWEEP_COUNT * sizeof(float));
+    float *inv = (float *)malloc(ERROR_SWEEP_COUNT * sizeof(float));
+    uint8_t *valid = (uint8_t *)malloc(ERROR_SWEEP_COUNT);
+    v3_soa a = {x, y, z};
+    v3_soa n = {nx, ny, nz};
+    char name[128];
+
+    fill_batch(a, ERROR_SWEEP_COUNT, 5u);
+    for (size_t i = 0; i < ERROR_SWEEP_COUNT; i++)
+    {
+        float m = ldexpf(1.0f, (int)(i % 61) - 30);
+        x[i] *= m;
+        y[i] *= m;
+        z[i] *= m;
+    }
+    x[7] = y[7] = z[7] = 0.0f;
+    x[100] = y[100] = z[100] = 0.0f;
+
+    v3_isa saved = v3_get_isa();
+    for (int isa = V3_ISA_SCALAR; isa < V3_ISA_COUNT; isa++)
+    {
+        if (!v3_set_isa((v3_isa)isa))
+        {
+            continue;
+        }
+
+        v3_inv_length_batch(inv, a, ERROR_SWEEP_COUNT);
+        v3_normalize_fast_batch(n, a, valid, ERROR_SWEEP_COUNT);
+
+        double max_inv_error = 0.0;
+        double max_norm_error = 0.0;
+        bool mask_ok = true;
+        for (size_t i = 0; i < ERROR_SWEEP_COUNT; i++)
+        {
+            double len = sqrt((double)x[i] * x[i] + (double)y[i] * y[i] + (double)z[i] * z[i]);
+            bool nonzero = len >= V3_EPSILON;
+            mask_ok = mask_ok && valid[i] == (nonzero ? 1 : 0);
+            if (!nonzero)
+            {
+                mask_ok = mask_ok && inv[i] == 0.0f && nx[i] == 0.0f && ny[i] == 0.0f && nz[i] == 0.0f;
+                continue;
+            }
+
+            max_inv_error = fmax(max_inv_error, fabs(inv[i] * len - 1.0));
+            max_norm_error = fmax(max_norm_error, fabs(nx[i] - x[i] / len));
+            max_norm_error = fmax(max_norm_error, fabs(ny[i] - y[i] / len));
+            max_norm_error = fmax(max_norm_error, fabs(nz[i] - z[i] / len));
+        }
+
+        snprintf(name, sizeof(name), "%s: inv_length relative error %.3g within %.3g",
+                 v3_isa_name((v3_isa)isa), max_inv_error, V3_FAST_MAX_REL_ERROR);
+        assert_true(name, max_inv_error <= V3_FAST_MAX_REL_ERROR);
+        snprintf(name, sizeof(name), "%s: normalize_fast error %.3g within %.3g",
+                 v3_isa_name((v3_isa)isa), max_norm_error, V3_FAST_MAX_REL_ERROR);
+        assert_true(name, max_norm_error <= V3_FAST_MAX_REL_ERROR);
+        snprintf(name, sizeof(name), "%s: normalize_fast validity mask", v3_isa_name((v3_isa)isa));
+        assert_true(name, mask_ok);
+    }
+    v3_set_isa(saved);
+
+    free(x);
+    free(y);
+    free(z);
+    free(nx);
+    free(ny);
+    free(nz);
+    free(inv);
+    free(valid);
+}
+
+// distance in units in the last place between two finite floats
+double ulp_distance(float a, float b)
+{
+    int32_t ia, ib;
+    memcpy(&ia, &a, sizeof(ia));
+    memcpy(&ib, &b, sizeof(ib));
+
+    // map the sign-magnitude bit patterns onto one ordered integer line
+    int64_t oa = (ia < 0) ? (int64_t)INT32_MIN - ia : ia;
+    int64_t ob = (ib < 0) ? (int64_t)INT32_MIN - ib : ib;
+    return fabs((double)(oa - ob));
+}
+
+// cosines up to this magnitude keep angle errors meaningful in ulp; past it
+// acos amplifies the float rounding of the cosine and angles near 0 round to 0
+#define ANGLE_CONDITIONED 0.99
+
+// test the batch angle tiers and report their error against double precision
+void test_v3_angle_batch()
+{
+    print_test_section("v3_angle_batch");
+
+    v3_soa a = alloc_batch(ERROR_SWEEP_COUNT);
+    v3_soa b = alloc_batch(ERROR_SWEEP_COUNT);
+    float *angle = (float *)malloc(ERROR_SWEEP_COUNT * sizeof(float));
+    float *cosine = (float *)malloc(ERROR_SWEEP_COUNT * sizeof(float));
+    double *reference = (double *)malloc(ERROR_SWEEP_COUNT * sizeof(double));
+    char name[160];
+
+    // random pairs at magnitudes 2^-15 to 2^15, every 8th nearly parallel and
+    // every 8th nearly opposite, where the cosine is least well conditioned
+    fill_batch(a, ERROR_SWEEP_COUNT, 26u);
+    fill_batch(b, ERROR_SWEEP_COUNT, 27u);
+    for (size_t i = 0; i < ERROR_SWEEP_COUNT; i++)
+    {
+        float m = ldexpf(1.0f, (int)(i % 31) - 15);
+        float side = (i % 8 == 1) ? -1.0f : 1.0f;
+        if (i % 8 < 2)
+        {
+            b.x[i] = side * a.x[i] + 1e-3f * b.x[i];
+            b.y[i] = side * a.y[i] + 1e-3f * b.y[i];
+            b.z[i] = side * a.z[i] + 1e-3f * b.z[i];
+        }
+        b.x[i] *= m;
+        b.y[i] *= m;
+        b.z[i] *= m;
+
+        double dot = (double)a.x[i] * b.x[i] + (double)a.y[i] * b.y[i] + (double)a.z[i] * b.z[i];
+        double len_a = sqrt((double)a.x[i] * a.x[i] + (double)a.y[i] * a.y[i] + (double)a.z[i] * a.z[i]);
+        double len_b = sqrt((double)b.x[i] * b.x[i] + (double)b.y[i] * b.y[i] + (double)b.z[i] * b.z[i]);
+        reference[i] = fmin(fmax(dot / (len_a * len_b), -1.0), 1.0);
+    }
+
+    {
+        // the exact tier is v3_angle element by element
+        v3_angle_batch(angle, a, b, ERROR_SWEEP_COUNT, V3_ANGLE_EXACT);
+        bool same = true;
+        double max_error = 0.0;
+        double max_conditioned_ulp = 0.0;
+        for (size_t i = 0; i < ERROR_SWEEP_COUNT; i++)
+        {
+            float va[3] = {a.x[i], a.y[i], a.z[i]};
+            float vb[3] = {b.x[i], b.y[i], b.z[i]};
+            same = same && angle[i] == v3_angle(va, vb);
+            max_error = fmax(max_error, fabs(angle[i] - acos(reference[i])));
+            if (fabs(reference[i]) <= ANGLE_CONDITIONED)
+            {
+                max_conditioned_ulp = fmax(max_conditioned_ulp, ulp_distance(angle[i], (float)acos(reference[i])));
+            }
+        }
+        snprintf(name, sizeof(name), "exact: matches v3_angle, error %.3g rad (%.0f ulp where conditioned)",
+                 max_error, max_conditioned_ulp);
+        assert_true(name, same);
+    }
+
+    v3_isa saved = v3_get_isa();
+    for (int isa = V3_ISA_SCALAR; isa < V3_ISA_COUNT; isa++)
+    {
+        if (!v3_set_isa((v3_isa)isa))
+        {
+            continue;
+        }
+
+        v3_angle_batch(angle, a, b, ERROR_SWEEP_COUNT, V3_ANGLE_POLY);
+        v3_angle_batch(cosine, a, b, ERROR_SWEEP_COUNT, V3_ANGLE_COSINE);
+
+        // the polynomial against acos of the very cosine it was given, then
+        // both tiers against the double precision angle and cosine
+        double max_poly_error = 0.0;
+        double max_angle_error = 0.0;
+        double max_angle_ulp = 0.0;
+        double max_cosine_error = 0.0;
+        double max_cosine_ulp = 0.0;
+        for (size_t i = 0; i < ERROR_SWEEP_COUNT; i++)
+        {
+            max_poly_error = fmax(max_poly_error, fabs(angle[i] - acos((double)cosine[i])));
+            max_angle_error = fmax(max_angle_error, fabs(angle[i] - acos(reference[i])));
+            max_cosine_error = fmax(max_cosine_error, fabs(cosine[i] - reference[i]));
+            max_cosine_ulp = fmax(max_cosine_ulp, ulp_distance(cosine[i], (float)reference[i]));
+            if (fabs(reference[i]) <= ANGLE_CONDITIONED)
+            {
+                max_angle_ulp = fmax(max_angle_ulp, ulp_distance(angle[i], (float)acos(reference[i])));
+            }
+        }
+
+        snprintf(name, sizeof(name), "%s: poly acos error %.3g within %.3g",
+                 v3_isa_name((v3_isa)isa), max_poly_error, V3_ANGLE_POLY_MAX_ERROR);
+        assert_true(name, max_poly_error <= V3_ANGLE_POLY_MAX_ERROR);
+        snprintf(name, sizeof(name), "%s: cosine error %.3g within %.3g (%.0f ulp), poly error %.3g rad (%.0f ulp where conditioned)",
+                 v3_isa_name((v3_isa)isa), max_cosine_error, 2.0 * V3_FAST_MAX_REL_ERROR, max_cosine_ulp,
+                 max_angle_error, max_angle_ulp);
+        assert_true(name, max_cosine_error <= 2.0 * V3_FAST_MAX_REL_ERROR);
+    }
+    v3_set_isa(saved);
+
+    {
+        // zero length pairs give angle 0 and cosine 1, reported once per batch
+        v3_error_policy policy = v3_get_error_policy();
+        v3_set_error_policy(V3_ERROR_COUNT);
+        v3_reset_error_counts();
+        a.x[3] = a.y[3] = a.z[3] = 0.0f;
+        b.x[20] = b.y[20] = b.z[20] = 0.0f;
+        v3_angle_batch(angle, a, b, BATCH_COUNT, V3_ANGLE_EXACT);
+        bool exact = angle[3] == 0.0f && angle[20] == 0.0f;
+        v3_angle_batch(angle, a, b, BATCH_COUNT, V3_ANGLE_POLY);
+        bool poly = angle[3] == 0.0f && angle[20] == 0.0f;
+        v3_angle_batch(cosine, a, b, BATCH_COUNT, V3_ANGLE_COSINE);
+        bool cos_one = cosine[3] == 1.0f && cosine[20] == 1.0f;
+        assert_true("v3_angle_batch: zero length pairs in every tier",
+                    exact && poly && cos_one && v3_error_count(V3_SOURCE_ANGLE_BATCH) == 6);
+        v3_set_error_policy(policy);
+    }
+
+    free_batch(a);
+    free_batch(b);
+    free(angle);
+    free(cosine);
+    free(reference);
+}
+
+// state recorded by the test error callback
+static v3_error_source last_error_source = V3_SOURCE_COUNT;
+static uint64_t callback_error_count = 0;
+static uint64_t callback_report_count = 0;
+
+void record_error(v3_error_source source, const char *message, uint64_t count, void *user_data)
+{
+    (void)message;
+    (void)user_data;
+    last_error_source = source;
+    callback_error_count += count;
+    callback_report_count++;
+}
+
+// callbacks that check they receive the user data registered with them
+static int pair_tag_a = 0, pair_tag_b = 0;
+static uint64_t pair_mismatches = 0;
+
+void record_pair_a(v3_error_source source, const char *message, uint64_t count, void *user_data)
+{
+    (void)source;
+    (void)message;
+    (void)count;
+    if (user_data != &pair_tag_a)
+    {
+        __atomic_fetch_add(&pair_mismatches, 1, __ATOMIC_RELAXED);
+    }
+}
+
+void record_pair_b(v3_error_source source, const char *message, uint64_t count, void *user_data)
+{
+    (void)source;
+    (void)message;
+    (void)count;
+    if (user_data != &pair_tag_b)
+    {
+        __atomic_fetch_add(&pair_mismatches, 1, __ATOMIC_RELAXED);
+    }
+}
+
+// calls per thread in the error policy stress test
+#define STRESS_CALLS 200000
+#define STRESS_THREADS 4
+
+// normalize a zero length vector repeatedly, reporting an error every call
+void *stress_normalize(void *)
+{
+    float v[3] = {0.0f, 0.0f, 0.0f};
+    float result[3];
+    for (int i = 0; i < STRESS_CALLS; i++)
+    {
+        v3_normalize(result, v);
+        v3_angle_quick(v, v);
+    }
+    return NULL;
+}
+
+// run the stress worker on every thread
+void run_stress()
+{
+    pthread_t threads[STRESS_THREADS];
+    for (int i = 0; i < STRESS_THREADS; i++)
+    {
+        pthread_create(&threads[i], NULL, stress_normalize, NULL);
+    }
+    for (int i = 0; i < STRESS_THREADS; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+}
+
+// test the configurable error policy
+void test_v3_error_policy()
+{
+    print_test_section("error policy");
+
+    v3_error_policy saved = v3_get_error_policy();
+    float zero[3] = {0.0f, 0.0f, 0.0f};
+    float unit[3] = {1.0f, 0.0f, 0.0f};
+    float result[3];
+
+    {
+        v3_set_error_policy(V3_ERROR_SILENT);
+        errno = 0;
+        v3_normalize(result, zero);
+        assert_true("silent: errno untouched", errno == 0);
+    }
+
+    {
+        v3_set_error_policy(V3_ERROR_COUNT);
+        v3_reset_error_counts();
+        v3_normalize(result, zero);
+        v3_normalize(result, zero);
+        v3_angle(zero, unit);
+        v3_angle_quick(unit, zero);
+        bool counted = v3_error_count(V3_SOURCE_NORMALIZE) == 2 &&
+                       v3_error_count(V3_SOURCE_ANGLE) == 1 &&
+                       v3_error_count(V3_SOURCE_ANGLE_QUICK) == 1;
+        assert_true("count: per-function counters", counted);
+    }
+
+    {
+        float x[BATCH_COUNT] = {0}, y[BATCH_COUNT] = {0}, z[BATCH_COUNT] = {0};
+        v3_soa a = {x, y, z};
+        x[3] = 1.0f;
+        v3_reset_error_counts();
+        v3_normalize_batch(a, a, BATCH_COUNT);
+        assert_true("count: batch counts every zero element",
+                    v3_error_count(V3_SOURCE_NORMALIZE_BATCH) == BATCH_COUNT - 1);
+    }
+
+    {
+        v3_set_error_policy(V3_ERROR_CALLBACK);
+        v3_set_error_callback(record_error, NULL);
+        callback_error_count = 0;
+        v3_angle_quick(zero, unit);
+        assert_true("callback: receives source and count",
+                    last_error_source == V3_SOURCE_ANGLE_QUICK && callback_error_count == 1);
+        v3_set_error_callback(NULL, NULL);
+    }
+
+    // re-registering while other threads report never splits a callback from its data
+    {
+        v3_set_error_policy(V3_ERROR_CALLBACK);
+        v3_set_error_callback(record_pair_a, &pair_tag_a);
+        pair_mismatches = 0;
+        pthread_t threads[STRESS_THREADS];
+        for (int i = 0; i < STRESS_THREADS; i++)
+        {
+            pthread_create(&threads[i], NULL, stress_normalize, NULL);
+        }
+        for (int i = 0; i < 20000; i++)
+        {
+            v3_set_error_callback(record_pair_b, &pair_tag_b);
+            v3_set_error_callback(record_pair_a, &pair_tag_a);
+        }
+        for (int i = 0; i < STRESS_THREADS; i++)
+        {
+            pthread_join(threads[i], NULL);
+        }
+        v3_set_error_callback(NULL, NULL);
+        assert_true("callback: re-registered under contention, always called with its own user data",
+                    pair_mismatches == 0);
+    }
+
+    // with the default policy, degenerate inputs from many threads leave no trace
+    {
+        v3_set_error_policy(V3_ERROR_SILENT);
+        v3_set_error_callback(record_error, NULL);
+        v3_reset_error_counts();
+        callback_error_count = 0;
+        run_stress();
+        bool quiet = callback_error_count == 0;
+        for (int source = 0; source < V3_SOURCE_COUNT; source++)
+        {
+            quiet = quiet && v3_error_count((v3_error_source)source) == 0;
+        }
+        v3_set_error_callback(NULL, NULL);
+        char name[128];
+        snprintf(name, sizeof(name), "silent: %d threads of degenerate calls, no callbacks or counts",
+                 STRESS_THREADS);
+        assert_true(name, quiet);
+    }
+
+    {
+        v3_set_error_policy(V3_ERROR_COUNT);
+        v3_reset_error_counts();
+        run_stress();
+        assert_true("count: exact under contention",
+                    v3_error_count(V3_SOURCE_NORMALIZE) == (uint64_t)STRESS_THREADS * STRESS_CALLS);
+    }
+
+    v3_set_error_policy(saved);
+}
+
+// constant geometry folds at compile time through the c++ front end
+static_assert(dot_product(Vec3f(1.0f, 2.0f, 3.0f), Vec3f(4.0f, -5.0f, 6.0f)) == 12.0f,
+              "dot_product must be a constant expression");
+static_assert(equals(cross_product(Vec3f(1.0f, 0.0f, 0.0f), Vec3f(0.0f, 1.0f, 0.0f)),
+                     Vec3f(0.0f, 0.0f, 1.0f), 0.0f),
+              "cross_product must be a constant expression");
+static_assert(equals(reflect(Vec3f(1.0f, 1.0f, 0.0f), Vec3f(1.0f, 0.0f, 0.0f)),
+                     Vec3f(-1.0f, 1.0f, 0.0f), 0.0f),
+              "reflect must be a constant expression");
+
+// input pairs taken from the scalar test cases above
+static const float front_end_cases[][2][3] =
+{
+    {{0.0f, 0.0f, 0.0f}, {1.0f, 2.0f, 3.0f}},
+    {{1.0f, 2.0f, 3.0f}, {4.0f, 6.0f, 8.0f}},
+    {{-1.0f, -2.0f, -3.0f}, {1.0f, 1.0f, 1.0f}},
+    {{5.0f, 5.0f, 5.0f}, {5.0f, 5.0f, 5.0f}},
+    {{1.0f, -2.0f, 3.0f}, {-1.0f, 2.0f, -3.0f}},
+    {{0.1f, 0.2f, 0.3f}, {0.4f, 0.5f, 0.6f}},
+    {{1.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f}},
+    {{1.0f, 2.0f, 3.0f}, {2.0f, 4.0f, 6.0f}},
+    {{1.0f, 0.0f, 0.0f}, {-1.0f, 0.0f, 0.0f}},
+    {{1.0f, 2.0f, 3.0f}, {4.0f, -5.0f, 6.0f}},
+    {{1.0f, 0.0f, 0.0f}, {1.0f, 1.0f, 0.0f}},
+    {{1.0f, 0.0f, 0.0f}, {0.5f, 0.866025f, 0.0f}},
+    {{3.0f, 4.0f, 0.0f}, {5.0f, 12.0f, 13.0f}},
+    {{1.0f, 1.0f, 0.0f}, {1.0f, 0.0f, 0.0f}}
+};
+
+// helper to require bit-identical vector results from the two front ends
+bool same_v3(float *c_result, Vec3f cpp_result)
+{
+    return c_result[0] == cpp_result.x && c_result[1] == cpp_result.y && c_result[2] == cpp_result.z;
+}
+
+// run the scalar test inputs through both the c api and Vec3
+void test_vec3_front_end()
+{
+    print_test_section("Vec3 front end");
+
+    size_t case_count = sizeof(front_end_cases) / sizeof(front_end_cases[0]);
+    bool from_points_ok = true, add_ok = true, subtract_ok = true, dot_ok = true;
+    bool cross_ok = true, scale_ok = true, angle_ok = true, angle_quick_ok = true;
+    bool reflect_ok = true, length_ok = true, normalize_ok = true, equals_ok = true;
+
+    for (size_t i = 0; i < case_count; i++)
+    {
+        float a[3], b[3], n[3], out[3];
+        memcpy(a, front_end_cases[i][0], sizeof(a));
+        memcpy(b, front_end_cases[i][1], sizeof(b));
+        Vec3f va = Vec3f::load(a);
+        Vec3f vb = Vec3f::load(b);
+
+        v3_from_points(out, a, b);
+        from_points_ok = from_points_ok && same_v3(out, from_points(va, vb));
+        v3_add(out, a, b);
+        add_ok = add_ok && same_v3(out, add(va, vb));
+        v3_subtract(out, a, b);
+        subtract_ok = subtract_ok && same_v3(out, subtract(va, vb));
+        dot_ok = dot_ok && v3_dot_product(a, b) == dot_product(va, vb);
+        v3_cross_product(out, a, b);
+        cross_ok = cross_ok && same_v3(out, cross_product(va, vb));
+        memcpy(out, a, sizeof(out));
+        v3_scale(out, 0.5f);
+        scale_ok = scale_ok && same_v3(out, scale(va, 0.5f));
+        angle_ok = angle_ok && v3_angle(a, b) == angle(va, vb);
+        angle_quick_ok = angle_quick_ok && v3_angle_quick(a, b) == angle_quick(va, vb);
+        v3_normalize(n, b);
+        v3_reflect(out, a, n);
+        reflect_ok = reflect_ok && same_v3(out, reflect(va, Vec3f::load(n)));
+        length_ok = length_ok && v3_length(a) == length(va);
+        v3_normalize(out, a);
+        normalize_ok = normalize_ok && same_v3(out, normalize(va));
+        equals_ok = equals_ok && v3_equals(a, b, TEST_TOLERANCE) == equals(va, vb, TEST_TOLERANCE);
+    }
+
+    assert_true("Vec3 from_points: identical to c api", from_points_ok);
+    assert_true("Vec3 add: identical to c api", add_ok);
+    assert_true("Vec3 subtract: identical to c api", subtract_ok);
+    assert_true("Vec3 dot_product: identical to c api", dot_ok);
+    assert_true("Vec3 cross_product: identical to c api", cross_ok);
+    assert_true("Vec3 scale: identical to c api", scale_ok);
+    assert_true("Vec3 angle: identical to c api", angle_ok);
+    assert_true("Vec3 angle_quick: identical to c api", angle_quick_ok);
+    assert_true("Vec3 reflect: identical to c api", reflect_ok);
+    assert_true("Vec3 length: identical to c api", length_ok);
+    assert_true("Vec3 normalize: identical to c api", normalize_ok);
+    assert_true("Vec3 equals: identical to c api", equals_ok);
+
+    // both compare a nan component as equal, and the double form agrees
+    {
+        float a[3] = {1.0f, NAN, 3.0f};
+        float b[3] = {1.0f, 2.0f, 3.0f};
+        double da[3] = {1.0, NAN, 3.0};
+        double db[3] = {1.0, 2.0, 3.0};
+        assert_true("Vec3 equals: nan components agree with the c api",
+                    v3_equals(a, b, TEST_TOLERANCE) == equals(Vec3f::load(a), Vec3f::load(b), TEST_TOLERANCE) &&
+                    equals(Vec3f::load(a), Vec3f::load(b), TEST_TOLERANCE) && v3d_equals(da, db, V3D_TOLERANCE));
+    }
+}
+
+// test fused expression chains against the step-by-step c api
+void test_v3_expr()
+{
+    print_test_section("fused expressions");
+
+    // single vectors, chain from_points -> normalize -> reflect -> dot
+    {
+        float p[3] = {1.0f, 2.0f, 3.0f};
+        float q[3] = {4.0f, -2.0f, 7.0f};
+        float n[3] = {0.0f, 1.0f, 0.0f};
+        float light[3] = {0.6f, 0.8f, 0.0f};
+        float d[3];
+        v3_from_points(d, p, q);
+        v3_normalize(d, d);
+        v3_reflect(d, d, n);
+        float expected = v3_dot_product(d, light);
+
+        float fused = v3expr::evaluate(v3expr::dot(
+            v3expr::reflect(v3expr::normalize(v3expr::from_points(v3expr::vec(Vec3f::load(p)),
+                                                                  v3expr::vec(Vec3f::load(q)))),
+                            v3expr::vec(Vec3f::load(n))),
+            v3expr::vec(Vec3f::load(light))));
+        assert_float_equals("v3expr: single vector chain", expected, fused);
+    }
+
+    {
+        float a[3] = {1.0f, 2.0f, 3.0f};
+        float b[3] = {4.0f, 5.0f, 6.0f};
+        float expected[3];
+        v3_add(expected, a, b);
+        v3_cross_product(expected, expected, a);
+        v3_scale(expected, 0.5f);
+        Vec3f fused = v3expr::evaluate(v3expr::scale(
+            v3expr::cross_product(v3expr::add(v3expr::vec(Vec3f::load(a)), v3expr::vec(Vec3f::load(b))),
+                                  v3expr::vec(Vec3f::load(a))), 0.5f));
+        float result[3];
+        fused.store(result);
+        assert_v3_equals("v3expr: add -> cross -> scale", expected, result);
+    }
+
+    // batches, the same chain against the unfused batch calls
+    {
+        float px[BATCH_COUNT], py[BATCH_COUNT], pz[BATCH_COUNT];
+        float qx[BATCH_COUNT], qy[BATCH_COUNT], qz[BATCH_COUNT];
+        float nx[BATCH_COUNT], ny[BATCH_COUNT], nz[BATCH_COUNT];
+        float lx[BATCH_COUNT], ly[BATCH_COUNT], lz[BATCH_COUNT];
+        float dx[BATCH_COUNT], dy[BATCH_COUNT], dz[BATCH_COUNT];
+        float expected[BATCH_COUNT], result[BATCH_COUNT];
+        v3_soa p = {px, py, pz};
+        v3_soa q = {qx, qy, qz};
+        v3_soa n = {nx, ny, nz};
+        v3_soa l = {lx, ly, lz};
+        v3_soa d = {dx, dy, dz};
+        float light[3] = {0.6f, 0.0f, 0.8f};
+
+        fill_batch(p, BATCH_COUNT, 6u);
+        fill_batch(q, BATCH_COUNT, 7u);
+        fill_batch(n, BATCH_COUNT, 8u);
+        v3_normalize_batch(n, n, BATCH_COUNT);
+        for (size_t i = 0; i < BATCH_COUNT; i++)
+        {
+            lx[i] = light[0];
+            ly[i] = light[1];
+            lz[i] = light[2];
+        }
+
+        v3_from_points_batch(d, p, q, BATCH_COUNT);
+        v3_normalize_batch(d, d, BATCH_COUNT);
+        v3_reflect_batch(d, d, n, BATCH_COUNT);
+        v3_dot_product_batch(expected, d, l, BATCH_COUNT);
+
+        v3expr::assign(result, v3expr::dot(v3expr::reflect(v3expr::normalize(
+            v3expr::from_points(v3expr::soa(p), v3expr::soa(q))), v3expr::soa(n)),
+            v3expr::vec(Vec3f::load(light))), BATCH_COUNT);
+        assert_batch_float_equals("v3expr: fused batch chain matches unfused", expected, result, BATCH_COUNT);
+
+        // dst = p
+        v3_from_points_batch(d, p, q, BATCH_COUNT);
+        v3_normalize_batch(d, d, BATCH_COUNT);
+        v3expr::assign(p, v3expr::normalize(v3expr::from_points(v3expr::soa(p), v3expr::soa(q))), BATCH_COUNT);
+        assert_batch_equals("v3expr: fused batch overlapping dst=a", d, p, BATCH_COUNT);
+    }
+
+    // double expressions assign into double arrays without narrowing
+    {
+        double px[BATCH_COUNT], py[BATCH_COUNT], pz[BATCH_COUNT];
+        double rx[BATCH_COUNT], ry[BATCH_COUNT], rz[BATCH_COUNT];
+        for (size_t i = 0; i < BATCH_COUNT; i++)
+        {
+            px[i] = 1.0 + 1e-9 * (double)i;
+            py[i] = -2.0 * (double)i;
+            pz[i] = 0.5;
+        }
+        v3expr::assign(rx, ry, rz, v3expr::normalize(v3expr::soa<double>(px, py, pz)), BATCH_COUNT);
+
+        bool ok = true;
+        for (size_t i = 0; i < BATCH_COUNT; i++)
+        {
+            double v[3] = {px[i], py[i], pz[i]};
+            double r[3] = {rx[i], ry[i], rz[i]};
+            double expected[3];
+            v3d_normalize(expected, v);
+            ok = ok && memcmp(expected, r, sizeof(r)) == 0;
+        }
+        assert_true("v3expr: double expression assigned at double precision", ok);
+    }
+}
+
+// test double precision variants
+void test_v3_double()
+{
+    print_test_section("double precision");
+
+    {
+        double a[3] = {1.0, 2.0, 3.0};
+        double b[3] = {4.0, 5.0, 6.0};
+        double result[3];
+        double expected[3] = {-3.0, 6.0, -3.0};
+        v3d_cross_product(result, a, b);
+        assert_true("v3d_cross_product: general case", v3d_equals(expected, result, V3D_TOLERANCE));
+    }
+
+    // dst = a
+    {
+        double a[3] = {1.0, 2.0, 3.0};
+        double b[3] = {4.0, 6.0, 8.0};
+        double expected[3] = {3.0, 4.0, 5.0};
+        v3d_from_points(a, a, b);
+        assert_true("v3d_from_points: overlapping dst=a", v3d_equals(expected, a, V3D_TOLERANCE));
+    }
+
+    {
+        double a[3] = {1.0, 0.0, 0.0};
+        double b[3] = {1.0, 1.0, 0.0};
+        assert_true("v3d_angle: 45 degrees", fabs(v3d_angle(a, b) - PI / 4.0) < V3D_TOLERANCE);
+    }
+
+    {
+        double v[3] = {3.0, 4.0, 0.0};
+        double expected[3] = {0.6, 0.8, 0.0};
+        v3d_normalize(v, v);
+        assert_true("v3d_normalize: overlapping dst=a", v3d_equals(expected, v, V3D_TOLERANCE));
+    }
+
+    // 1e-8 is zero length for float but not for double
+    {
+        double v[3] = {1e-8, 0.0, 0.0};
+        double expected[3] = {1.0, 0.0, 0.0};
+        double result[3];
+        v3d_normalize(result, v);
+        assert_true("v3d_normalize: tiny vector above V3D_EPSILON", v3d_equals(expected, result, V3D_TOLERANCE));
+    }
+
+    {
+        double a[3] = {1.0, 2.0, 3.0};
+        double b[3] = {1.0 + 1e-13, 2.0, 3.0 - 1e-13};
+        double c[3] = {1.0 + 1e-9, 2.0, 3.0};
+        assert_true("v3d_equals: within and outside tolerance",
+                    v3d_equals(a, b, V3D_TOLERANCE) && !v3d_equals(a, c, V3D_TOLERANCE));
+    }
+
+    {
+        float fx[BATCH_COUNT], fy[BATCH_COUNT], fz[BATCH_COUNT], fl[BATCH_COUNT];
+        double dx[BATCH_COUNT], dy[BATCH_COUNT], dz[BATCH_COUNT], dl[BATCH_COUNT];
+        float back[BATCH_COUNT];
+        v3_soa f = {fx, fy, fz};
+        v3d_soa d = {dx, dy, dz};
+        fill_batch(f, BATCH_COUNT, 9u);
+        v3_float_to_double_batch(dx, fx, BATCH_COUNT);
+        v3_float_to_double_batch(dy, fy, BATCH_COUNT);
+        v3_float_to_double_batch(dz, fz, BATCH_COUNT);
+        v3_double_to_float_batch(back, dx, BATCH_COUNT);
+        assert_true("v3_double_to_float_batch: round trip exact", memcmp(back, fx, sizeof(back)) == 0);
+
+        v3_length_batch(fl, f, BATCH_COUNT);
+        v3d_length_batch(dl, d, BATCH_COUNT);
+        v3_double_to_float_batch(back, dl, BATCH_COUNT);
+        assert_batch_float_equals("v3d_length_batch: matches float", fl, back, BATCH_COUNT);
+    }
+
+    // the pair batches agree with the scalar functions, zero pairs reported once
+    {
+        float fx[BATCH_COUNT], fy[BATCH_COUNT], fz[BATCH_COUNT];
+        double ax[BATCH_COUNT], ay[BATCH_COUNT], az[BATCH_COUNT];
+        double bx[BATCH_COUNT], by[BATCH_COUNT], bz[BATCH_COUNT];
+        double cx[BATCH_COUNT], cy[BATCH_COUNT], cz[BATCH_COUNT];
+        double rx[BATCH_COUNT], ry[BATCH_COUNT], rz[BATCH_COUNT];
+        double angles[BATCH_COUNT];
+        v3_soa f = {fx, fy, fz};
+        v3d_soa a = {ax, ay, az}, b = {bx, by, bz}, c = {cx, cy, cz}, r = {rx, ry, rz};
+        fill_batch(f, BATCH_COUNT, 12u);
+        v3_float_to_double_batch(ax, fx, BATCH_COUNT);
+        v3_float_to_double_batch(ay, fy, BATCH_COUNT);
+        v3_float_to_double_batch(az, fz, BATCH_COUNT);
+        fill_batch(f, BATCH_COUNT, 13u);
+        v3_float_to_double_batch(bx, fx, BATCH_COUNT);
+        v3_float_to_double_batch(by, fy, BATCH_COUNT);
+        v3_float_to_double_batch(bz, fz, BATCH_COUNT);
+        ax[4] = ay[4] = az[4] = 0.0;
+
+        v3_error_policy policy = v3_get_error_policy();
+        v3_set_error_policy(V3_ERROR_COUNT);
+        v3_reset_error_counts();
+        v3d_normalize_batch(b, b, BATCH_COUNT);
+        v3d_cross_product_batch(c, a, b, BATCH_COUNT);
+        v3d_reflect_batch(r, a, b, BATCH_COUNT);
+        v3d_angle_batch(angles, a, b, BATCH_COUNT);
+        bool ok = v3_error_count(V3_SOURCE_ANGLE_BATCH) == 1 && angles[4] == 0.0;
+        v3_set_error_policy(policy);
+        for (size_t i = 0; i < BATCH_COUNT; i++)
+        {
+            double va[3] = {ax[i], ay[i], az[i]};
+            double vb[3] = {bx[i], by[i], bz[i]};
+            double vc[3] = {cx[i], cy[i], cz[i]};
+            double vr[3] = {rx[i], ry[i], rz[i]};
+            double cross[3], reflected[3];
+            v3d_cross_product(cross, va, vb);
+            v3d_reflect(reflected, va, vb);
+            ok = ok && v3d_equals(cross, vc, V3D_TOLERANCE) && v3d_equals(reflected, vr, V3D_TOLERANCE) &&
+                 (i == 4 || angles[i] == v3d_angle(va, vb));
+        }
+        assert_true("v3d_cross_product_batch, v3d_reflect_batch, v3d_angle_batch: match the scalar functions", ok);
+    }
+}
+
+// test half precision storage variants
+void test_v3_half()
+{
+    print_test_section("half precision");
+
+    // every half value survives a decode/encode round trip, nans stay nans
+    {
+        bool ok = true;
+        for (uint32_t h = 0; h < 0x10000u; h++)
+        {
+            float f = v3_half_to_float((v3_half)h);
+            v3_half back = v3_float_to_half(f);
+            bool is_nan = ((h & 0x7c00u) == 0x7c00u) && (h & 0x3ffu);
+            ok = ok && (is_nan ? (back & 0x7c00u) == 0x7c00u && (back & 0x3ffu) : back == h);
+        }
+        assert_true("v3_half: all 65536 values round trip", ok);
+    }
+
+    // software rounding agrees with the hardware conversion path
+    {
+        float src[ERROR_SWEEP_COUNT];
+        v3_half hw[ERROR_SWEEP_COUNT];
+        uint32_t seed = 10u;
+        for (size_t i = 0; i < ERROR_SWEEP_COUNT; i++)
+        {
+            seed = seed * 1664525u + 1013904223u;
+            src[i] = ldexpf((float)(seed >> 8) / 16777216.0f - 0.5f, (int)(i % 48) - 28);
+        }
+        v3_float_to_half_batch(hw, src, ERROR_SWEEP_COUNT);
+        bool ok = true;
+        for (size_t i = 0; i < ERROR_SWEEP_COUNT; i++)
+        {
+            ok = ok && hw[i] == v3_float_to_half(src[i]);
+        }
+        assert_true("v3_float_to_half_batch: matches scalar rounding", ok);
+    }
+
+    {
+        v3_half a[3], b[3], result[3];
+        float fa[3] = {1.0f, 2.0f, 3.0f};
+        float fb[3] = {4.0f, 5.0f, 6.0f};
+        float expected[3] = {-3.0f, 6.0f, -3.0f};
+        v3_half he[3];
+        v3_float_to_half_batch(a, fa, 3);
+        v3_float_to_half_batch(b, fb, 3);
+        v3_float_to_half_batch(he, expected, 3);
+        v3h_cross_product(result, a, b);
+        assert_true("v3h_cross_product: general case", v3h_equals(he, result, V3H_TOLERANCE));
+    }
+
+    // dst = a
+    {
+        float fv[3] = {3.0f, 4.0f, 0.0f};
+        float fe[3] = {0.6f, 0.8f, 0.0f};
+        v3_half v[3], expected[3];
+        v3_float_to_half_batch(v, fv, 3);
+        v3_float_to_half_batch(expected, fe, 3);
+        v3h_normalize(v, v);
+        assert_true("v3h_normalize: overlapping dst=a", v3h_equals(expected, v, V3H_TOLERANCE));
+    }
+
+    {
+        float fx[BATCH_COUNT], fy[BATCH_COUNT], fz[BATCH_COUNT];
+        float ex[BATCH_COUNT], ey[BATCH_COUNT], ez[BATCH_COUNT];
+        float rx[BATCH_COUNT], ry[BATCH_COUNT], rz[BATCH_COUNT];
+        v3_half hx[BATCH_COUNT], hy[BATCH_COUNT], hz[BATCH_COUNT];
+        v3_soa f = {fx, fy, fz};
+        v3_soa expected = {ex, ey, ez};
+        v3h_soa h = {hx, hy, hz};
+        fill_batch(f, BATCH_COUNT, 11u);
+
+        // the reference normalizes the half-rounded inputs in float
+        v3_float_to_half_batch(hx, fx, BATCH_COUNT);
+        v3_float_to_half_batch(hy, fy, BATCH_COUNT);
+        v3_float_to_half_batch(hz, fz, BATCH_COUNT);
+        v3_half_to_float_batch(fx, hx, BATCH_COUNT);
+        v3_half_to_float_batch(fy, hy, BATCH_COUNT);
+        v3_half_to_float_batch(fz, hz, BATCH_COUNT);
+        v3_normalize_batch(expected, f, BATCH_COUNT);
+
+        v3h_normalize_batch(h, h, BATCH_COUNT);
+        v3_half_to_float_batch(rx, hx, BATCH_COUNT);
+        v3_half_to_float_batch(ry, hy, BATCH_COUNT);
+        v3_half_to_float_batch(rz, hz, BATCH_COUNT);
+
+        bool ok = true;
+        for (size_t i = 0; i < BATCH_COUNT; i++)
+        {
+            float e[3] = {ex[i], ey[i], ez[i]};
+            float r[3] = {rx[i], ry[i], rz[i]};
+            ok = ok && v3_equals(e, r, V3H_TOLERANCE);
+        }
+        assert_true("v3h_normalize_batch: within V3H_TOLERANCE of float", ok);
+    }
+
+    {
+        // zero vectors in several of the float tiles still make one report
+        const size_t count = 1000;
+        v3_half hx[1000] = {}, hy[1000] = {}, hz[1000] = {};
+        v3h_soa h = {hx, hy, hz};
+        for (size_t i = 0; i < count; i++)
+        {
+            hx[i] = (i % 300 == 0 || i == count - 1) ? 0 : v3_float_to_half(1.0f);
+        }
+
+        v3_error_policy saved = v3_get_error_policy();
+        v3_set_error_policy(V3_ERROR_CALLBACK);
+        v3_set_error_callback(record_error, NULL);
+        callback_error_count = 0;
+        callback_report_count = 0;
+        v3h_normalize_batch(h, h, count);
+        assert_true("v3h_normalize_batch: zero vectors of every tile reported once",
+                    callback_report_count == 1 && callback_error_count == 5 &&
+                    last_error_source == V3_SOURCE_NORMALIZE_BATCH);
+        v3_set_error_callback(NULL, NULL);
+        v3_set_error_policy(saved);
+    }
+
+    // the remaining batches match float batches run on the half-rounded inputs
+    {
+        float ax[BATCH_COUNT], ay[BATCH_COUNT], az[BATCH_COUNT];
+        float bx[BATCH_COUNT], by[BATCH_COUNT], bz[BATCH_COUNT];
+        float ex[BATCH_COUNT], ey[BATCH_COUNT], ez[BATCH_COUNT];
+        float expected[BATCH_COUNT], result[BATCH_COUNT];
+        v3_half hax[BATCH_COUNT], hay[BATCH_COUNT], haz[BATCH_COUNT];
+        v3_half hbx[BATCH_COUNT], hby[BATCH_COUNT], hbz[BATCH_COUNT];
+        v3_half hrx[BATCH_COUNT], hry[BATCH_COUNT], hrz[BATCH_COUNT];
+        v3_soa fa = {ax, ay, az}, fb = {bx, by, bz}, fe = {ex, ey, ez};
+        v3h_soa ha = {hax, hay, haz}, hb = {hbx, hby, hbz}, hr = {hrx, hry, hrz};
+
+        // unit inputs keep every output within the half spacing of 1
+        fill_batch(fa, BATCH_COUNT, 14u);
+        fill_batch(fb, BATCH_COUNT, 15u);
+        v3_normalize_batch(fa, fa, BATCH_COUNT);
+        v3_normalize_batch(fb, fb, BATCH_COUNT);
+        ax[4] = ay[4] = az[4] = 0.0f;
+        v3_float_to_half_batch(hax, ax, BATCH_COUNT);
+        v3_float_to_half_batch(hay, ay, BATCH_COUNT);
+        v3_float_to_half_batch(haz, az, BATCH_COUNT);
+        v3_float_to_half_batch(hbx, bx, BATCH_COUNT);
+        v3_float_to_half_batch(hby, by, BATCH_COUNT);
+        v3_float_to_half_batch(hbz, bz, BATCH_COUNT);
+        v3_half_to_float_batch(ax, hax, BATCH_COUNT);
+        v3_half_to_float_batch(ay, hay, BATCH_COUNT);
+        v3_half_to_float_batch(az, haz, BATCH_COUNT);
+        v3_half_to_float_batch(bx, hbx, BATCH_COUNT);
+        v3_half_to_float_batch(by, hby, BATCH_COUNT);
+        v3_half_to_float_batch(bz, hbz, BATCH_COUNT);
+
+        v3_length_batch(expected, fa, BATCH_COUNT);
+        v3h_length_batch(result, ha, BATCH_COUNT);
+        bool length = memcmp(expected, result, sizeof(result)) == 0;
+
+        bool pairs = true;
+        for (int op = 0; op < 2; op++)
+        {
+            if (op == 0)
+            {
+                v3_cross_product_batch(fe, fa, fb, BATCH_COUNT);
+                v3h_cross_product_batch(hr, ha, hb, BATCH_COUNT);
+            }
+            else
+            {
+                v3_reflect_batch(fe, fa, fb, BATCH_COUNT);
+                v3h_reflect_batch(hr, ha, hb, BATCH_COUNT);
+            }
+            for (size_t i = 0; i < BATCH_COUNT; i++)
+            {
+                float e[3] = {ex[i], ey[i], ez[i]};
+                float r[3] = {v3_half_to_float(hrx[i]), v3_half_to_float(hry[i]), v3_half_to_float(hrz[i])};
+                pairs = pairs && v3_equals(e, r, V3H_TOLERANCE);
+            }
+        }
+
+        v3_error_policy saved = v3_get_error_policy();
+        v3_set_error_policy(V3_ERROR_COUNT);
+        v3_reset_error_counts();
+        bool angles = true;
+        for (int tier = V3_ANGLE_EXACT; tier <= V3_ANGLE_COSINE; tier++)
+        {
+            v3_angle_batch(expected, fa, fb, BATCH_COUNT, (v3_angle_accuracy)tier);
+            v3h_angle_batch(result, ha, hb, BATCH_COUNT, (v3_angle_accuracy)tier);
+            for (size_t i = 0; i < BATCH_COUNT; i++)
+            {
+                angles = angles && fabsf(expected[i] - result[i]) <= 1e-6f;
+            }
+        }
+        angles = angles && v3_error_count(V3_SOURCE_ANGLE_BATCH) == 6;
+        v3_set_error_policy(saved);
+
+        assert_true("v3h_length_batch, v3h_cross_product_batch, v3h_reflect_batch, v3h_angle_batch: match float",
+                    length && pairs && angles);
+    }
+}
+
+// vectors for the thread pool tests, above V3_POOL_MIN_PARALLEL and not a multiple of V3_POOL_ALIGN
+#define POOL_COUNT 100003
+
+// one counter per vector, incremented by every task that covers it
+static uint8_t pool_hits[POOL_COUNT];
+
+// task marking [begin, end) as covered, shifted by the offset in context
+void mark_hits(void *context, size_t begin, size_t end)
+{
+    size_t base = (context != NULL) ? *(size_t *)context : 0;
+    for (size_t i = begin; i < end; i++)
+    {
+        __atomic_fetch_add(&pool_hits[base + i], 1, __ATOMIC_RELAXED);
+    }
+}
+
+// task that makes a nested parallel call over its own range
+void mark_hits_nested(void *context, size_t begin, size_t end)
+{
+    (void)context;
+    v3_parallel_for(end - begin, V3_POOL_ALIGN, mark_hits, &begin);
+}
+
+// true when every vector of the range was covered exactly once
+bool hits_exactly_once(size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        if (pool_hits[i] != 1)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// bitwise comparison, the parallel path must not change a single result bit
+bool soa_identical(v3_soa a, v3_soa b, size_t count)
+{
+    return memcmp(a.x, b.x, count * sizeof(float)) == 0 &&
+           memcmp(a.y, b.y, count * sizeof(float)) == 0 &&
+           memcmp(a.z, b.z, count * sizeof(float)) == 0;
+}
+
+void test_v3_pool()
+{
+    print_test_section("thread pool");
+
+    v3_soa a = alloc_batch(POOL_COUNT);
+    v3_soa b = alloc_batch(POOL_COUNT);
+    v3_soa n = alloc_batch(POOL_COUNT);
+    v3_soa expected = alloc_batch(POOL_COUNT);
+    v3_soa result = alloc_batch(POOL_COUNT);
+    float *es = (float *)malloc(POOL_COUNT * sizeof(float));
+    float *rs = (float *)malloc(POOL_COUNT * sizeof(float));
+    uint8_t *ev = (uint8_t *)malloc(POOL_COUNT);
+    uint8_t *rv = (uint8_t *)malloc(POOL_COUNT);
+    char name[128];
+
+    fill_batch(a, POOL_COUNT, 12u);
+    fill_batch(b, POOL_COUNT, 13u);
+    size_t zeros = 0;
+    for (size_t i = 0; i < POOL_COUNT; i += 9973)
+    {
+        a.x[i] = a.y[i] = a.z[i] = 0.0f;
+        zeros++;
+    }
+    v3_normalize_batch(n, b, POOL_COUNT);
+
+    static const int thread_counts[] = {1, 2, 3, 8};
+    for (size_t t = 0; t < sizeof(thread_counts) / sizeof(thread_counts[0]); t++)
+    {
+        v3_pool_set_threads(thread_counts[t]);
+        bool ok = true;
+
+        v3_from_points_batch(expected, a, b, POOL_COUNT);
+        v3_from_points_batch_parallel(result, a, b, POOL_COUNT);
+        ok = ok && soa_identical(expected, result, POOL_COUNT);
+
+        v3_add_batch(expected, a, b, POOL_COUNT);
+        v3_add_batch_parallel(result, a, b, POOL_COUNT);
+        ok = ok && soa_identical(expected, result, POOL_COUNT);
+
+        v3_subtract_batch(expected, a, b, POOL_COUNT);
+        v3_subtract_batch_parallel(result, a, b, POOL_COUNT);
+        ok = ok && soa_identical(expected, result, POOL_COUNT);
+
+        v3_scale_batch(expected, 0.37f, POOL_COUNT);
+        v3_scale_batch_parallel(result, 0.37f, POOL_COUNT);
+        ok = ok && soa_identical(expected, result, POOL_COUNT);
+
+        v3_cross_product_batch(expected, a, b, POOL_COUNT);
+        v3_cross_product_batch_parallel(result, a, b, POOL_COUNT);
+        ok = ok && soa_identical(expected, result, POOL_COUNT);
+
+        v3_reflect_batch(expected, a, n, POOL_COUNT);
+        v3_reflect_batch_parallel(result, a, n, POOL_COUNT);
+        ok = ok && soa_identical(expected, result, POOL_COUNT);
+
+        v3_normalize_batch(expected, a, POOL_COUNT);
+        v3_normalize_batch_parallel(result, a, POOL_COUNT);
+        ok = ok && soa_identical(expected, result, POOL_COUNT);
+
+        v3_normalize_fast_batch(expected, a, ev, POOL_COUNT);
+        v3_normalize_fast_batch_parallel(result, a, rv, POOL_COUNT);
+        ok = ok && soa_identical(expected, result, POOL_COUNT) && memcmp(ev, rv, POOL_COUNT) == 0;
+
+        v3_dot_product_batch(es, a, b, POOL_COUNT);
+        v3_dot_product_batch_parallel(rs, a, b, POOL_COUNT);
+        ok = ok && memcmp(es, rs, POOL_COUNT * sizeof(float)) == 0;
+
+        v3_length_batch(es, a, POOL_COUNT);
+        v3_length_batch_parallel(rs, a, POOL_COUNT);
+        ok = ok && memcmp(es, rs, POOL_COUNT * sizeof(float)) == 0;
+
+        v3_inv_length_batch(es, a, POOL_COUNT);
+        v3_inv_length_batch_parallel(rs, a, POOL_COUNT);
+        ok = ok && memcmp(es, rs, POOL_COUNT * sizeof(float)) == 0;
+
+        snprintf(name, sizeof(name), "%d threads: every parallel batch operation bit-identical to sequential",
+                 thread_counts[t]);
+        assert_true(name, ok);
+    }
+
+    // tiny chunks force the threads to run dry and steal
+    {
+        v3_pool_set_threads(4);
+        memset(pool_hits, 0, sizeof(pool_hits));
+        v3_parallel_for(POOL_COUNT, 1, mark_hits, NULL);
+        assert_true("v3_parallel_for: every vector covered exactly once", hits_exactly_once(POOL_COUNT));
+    }
+
+    {
+        memset(pool_hits, 0, sizeof(pool_hits));
+        v3_parallel_for(POOL_COUNT, POOL_COUNT / 3, mark_hits_nested, NULL);
+        assert_true("v3_parallel_for: nested calls run inline", hits_exactly_once(POOL_COUNT));
+    }
+
+    {
+        size_t grain = v3_pool_grain(POOL_COUNT, 36);
+        assert_true("v3_pool_grain: aligned and at least 4 chunks per thread",
+                    grain % V3_POOL_ALIGN == 0 && grain * 4 * 4 <= POOL_COUNT + 4 * 4 * V3_POOL_ALIGN);
+    }
+
+    {
+        v3_error_policy saved = v3_get_error_policy();
+        v3_set_error_policy(V3_ERROR_COUNT);
+        v3_reset_error_counts();
+        v3_normalize_batch_parallel(result, a, POOL_COUNT);
+        assert_true("v3_normalize_batch_parallel: zero vectors counted once each",
+                    v3_error_count(V3_SOURCE_NORMALIZE_BATCH) == zeros);
+        v3_set_error_policy(saved);
+    }
+
+    {
+        v3_first_touch(result.x, POOL_COUNT, 9 * sizeof(float));
+        bool zeroed = true;
+        for (size_t i = 0; i < POOL_COUNT; i++)
+        {
+            zeroed = zeroed && result.x[i] == 0.0f;
+        }
+        assert_true("v3_first_touch: zeroes the whole range", zeroed);
+    }
+
+    v3_pool_set_threads(0);
+    free_batch(a);
+    free_batch(b);
+    free_batch(n);
+    free_batch(expected);
+    free_batch(result);
+    free(es);
+    free(rs);
+    free(ev);
+    free(rv);
+}
+
+void test_v3_ray()
+{
+    print_test_section("ray intersection");
+
+    float v0[3] = {-1.0f, -1.0f, 5.0f};
+    float v1[3] = {1.0f, -1.0f, 5.0f};
+    float v2[3] = {0.0f, 1.0f, 5.0f};
+    float center[3] = {0.0f, 0.0f, 10.0f};
+    float origin[3] = {0.0f, 0.0f, 0.0f};
+    float t;
+
+    {
+        float dir[3] = {0.0f, 0.0f, 1.0f};
+        bool hit = v3_ray_triangle(&t, origin, dir, v0, v1, v2);
+        assert_true("v3_ray_triangle: hit through the interior", hit && fabsf(t - 5.0f) < TEST_TOLERANCE);
+    }
+
+    {
+        float dir[3] = {0.0f, 0.0f, -1.0f};
+        float aside[3] = {3.0f, 0.0f, 1.0f};
+        float along[3] = {1.0f, 0.0f, 0.0f};
+        float start[3] = {-5.0f, 0.0f, 5.0f};
+        bool behind = v3_ray_triangle(&t, origin, dir, v0, v1, v2);
+        bool outside = v3_ray_triangle(&t, origin, aside, v0, v1, v2);
+        bool parallel = v3_ray_triangle(&t, start, along, v0, v1, v2);
+        assert_true("v3_ray_triangle: misses behind, outside and parallel",
+                    !behind && !outside && !parallel && t == V3_RAY_MISS);
+    }
+
+    {
+        float dir[3] = {0.0f, 0.0f, 2.0f};
+        bool hit = v3_ray_sphere(&t, origin, dir, center, 2.0f);
+        assert_true("v3_ray_sphere: nearest hit, unnormalized dir", hit && fabsf(t - 4.0f) < TEST_TOLERANCE);
+    }
+
+    {
+        float dir[3] = {1.0f, 0.0f, 0.0f};
+        bool hit = v3_ray_sphere(&t, center, dir, center, 2.0f);
+        assert_true("v3_ray_sphere: origin inside hits the exit point", hit && fabsf(t - 2.0f) < TEST_TOLERANCE);
+    }
+
+    {
+        float dir[3] = {0.0f, 1.0f, 0.0f};
+        float away[3] = {0.0f, 0.0f, -1.0f};
+        bool miss = v3_ray_sphere(&t, origin, dir, center, 2.0f);
+        bool behind = v3_ray_sphere(&t, origin, away, center, 2.0f);
+        assert_true("v3_ray_sphere: misses aside and behind", !miss && !behind && t == V3_RAY_MISS);
+    }
+
+    // packets on every instruction set agree bit for bit with the scalar functions
+    {
+        float ox[BATCH_COUNT], oy[BATCH_COUNT], oz[BATCH_COUNT];
+        float dx[BATCH_COUNT], dy[BATCH_COUNT], dz[BATCH_COUNT];
+        float expected_t[BATCH_COUNT], packet_t[BATCH_COUNT];
+        uint8_t expected_hit[BATCH_COUNT], packet_hit[BATCH_COUNT];
+        v3_soa o = {ox, oy, oz};
+        v3_soa d = {dx, dy, dz};
+        char name[128];
+
+        fill_batch(o, BATCH_COUNT, 14u);
+        fill_batch(d, BATCH_COUNT, 15u);
+        for (size_t i = 0; i < BATCH_COUNT; i++)
+        {
+            // aim roughly half the rays at the shapes
+            ox[i] *= 0.1f;
+            oy[i] *= 0.1f;
+            oz[i] = 0.0f;
+            dx[i] *= 0.05f;
+            dy[i] *= 0.05f;
+            dz[i] = (i % 2 == 0) ? 1.0f : dz[i];
+        }
+
+        v3_isa saved = v3_get_isa();
+        for (int isa = V3_ISA_SCALAR; isa < V3_ISA_COUNT; isa++)
+        {
+            if (!v3_set_isa((v3_isa)isa))
+            {
+                continue;
+            }
+
+            bool same = true;
+            size_t hits = 0;
+            v3_ray_triangle_batch(packet_t, packet_hit, o, d, BATCH_COUNT, v0, v1, v2);
+            for (size_t i = 0; i < BATCH_COUNT; i++)
+            {
+                float oi[3] = {ox[i], oy[i], oz[i]};
+                float di[3] = {dx[i], dy[i], dz[i]};
+                expected_hit[i] = v3_ray_triangle(&expected_t[i], oi, di, v0, v1, v2);
+                hits += expected_hit[i];
+            }
+            same = same && hits > 0 && hits < BATCH_COUNT &&
+                   memcmp(expected_t, packet_t, sizeof(expected_t)) == 0 &&
+                   memcmp(expected_hit, packet_hit, sizeof(expected_hit)) == 0;
+
+            hits = 0;
+            v3_ray_sphere_batch(packet_t, packet_hit, o, d, BATCH_COUNT, center, 2.0f);
+            for (size_t i = 0; i < BATCH_COUNT; i++)
+            {
+                float oi[3] = {ox[i], oy[i], oz[i]};
+                float di[3] = {dx[i], dy[i], dz[i]};
+                expected_hit[i] = v3_ray_sphere(&expected_t[i], oi, di, center, 2.0f);
+                hits += expected_hit[i];
+            }
+            same = same && hits > 0 && hits < BATCH_COUNT &&
+                   memcmp(expected_t, packet_t, sizeof(expected_t)) == 0 &&
+                   memcmp(expected_hit, packet_hit, sizeof(expected_hit)) == 0;
+
+            // one packet goes through the same kernel as the batch
+            uint32_t mask = v3_ray_sphere_packet(packet_t, o, d, center, 2.0f);
+            for (int lane = 0; lane < V3_RAY_PACKET; lane++)
+            {
+                same = same && ((mask >> lane) & 1u) == expected_hit[lane] &&
+                       memcmp(&packet_t[lane], &expected_t[lane], sizeof(float)) == 0;
+            }
+
+            snprintf(name, sizeof(name), "%s: ray packets bit-identical to scalar", v3_isa_name((v3_isa)isa));
+            assert_true(name, same);
+        }
+        v3_set_isa(saved);
+    }
+}
+
+// test matrix construction, composition and batch transforms
+void test_v3_mat()
+{
+    print_test_section("matrix transforms");
+
+    float p[3] = {1.0f, 2.0f, 3.0f};
+    float result[3];
+
+    {
+        v3_mat4 m;
+        v3_mat4_identity(&m);
+        v3_mat4_transform_point(result, &m, p);
+        assert_v3_equals("v3_mat4_identity: leaves points unchanged", p, result);
+    }
+
+    {
+        float t[3] = {10.0f, -5.0f, 0.5f};
+        float moved[3] = {11.0f, -3.0f, 3.5f};
+        float dx[1] = {p[0]}, dy[1] = {p[1]}, dz[1] = {p[2]};
+        v3_soa d = {dx, dy, dz};
+        v3_mat4 m;
+        v3_mat4_translation(&m, t);
+        v3_mat4_transform_point(result, &m, p);
+        v3_mat4_transform_directions_batch(d, &m, d, 1);
+        float direction[3] = {dx[0], dy[0], dz[0]};
+        assert_true("v3_mat4_translation: moves points but not directions",
+                    v3_equals(moved, result, TEST_TOLERANCE) && v3_equals(p, direction, 0.0f));
+    }
+
+    {
+        float axis[3] = {0.0f, 0.0f, 2.0f};
+        float zero[3] = {0.0f, 0.0f, 0.0f};
+        float x[3] = {1.0f, 0.0f, 0.0f};
+        float y[3] = {0.0f, 1.0f, 0.0f};
+        v3_mat4 m, degenerate;
+        bool valid = v3_mat4_rotation(&m, axis, (float)(PI / 2.0));
+        bool invalid = v3_mat4_rotation(&degenerate, zero, 1.0f);
+        v3_mat4_transform_direction(result, &m, x);
+        assert_true("v3_mat4_rotation: quarter turn about z, zero axis rejected",
+                    valid && !invalid && v3_equals(y, result, TEST_TOLERANCE) && degenerate.m[0] == 1.0f);
+    }
+
+    // one composed matrix gives the same points as applying each transform in turn
+    {
+        float axis[3] = {1.0f, 1.0f, 0.0f};
+        float s[3] = {2.0f, 0.5f, 3.0f};
+        float t[3] = {-1.0f, 4.0f, 2.0f};
+        v3_mat4 chain[3];
+        v3_mat4 composed;
+        v3_mat4_scaling(&chain[0], s);
+        v3_mat4_rotation(&chain[1], axis, 0.7f);
+        v3_mat4_translation(&chain[2], t);
+        v3_mat4_compose(&composed, chain, 3);
+
+        float sequential[3] = {p[0], p[1], p[2]};
+        for (int i = 0; i < 3; i++)
+        {
+            v3_mat4_transform_point(sequential, &chain[i], sequential);
+        }
+        v3_mat4_transform_point(result, &composed, p);
+        assert_v3_equals("v3_mat4_compose: matches sequential application", sequential, result);
+    }
+
+    // normals stay perpendicular to transformed tangents under non-uniform scale
+    {
+        float s[3] = {4.0f, 1.0f, 0.25f};
+        float zero[3] = {0.0f, 0.0f, 0.0f};
+        float tangent[3] = {1.0f, -1.0f, 0.0f};
+        float normal[3] = {1.0f, 1.0f, 1.0f};
+        float nx[1] = {normal[0]}, ny[1] = {normal[1]}, nz[1] = {normal[2]};
+        v3_soa n = {nx, ny, nz};
+        v3_mat4 m, singular;
+        v3_mat3 nm;
+        v3_mat4_scaling(&m, s);
+        v3_mat4_scaling(&singular, zero);
+
+        bool valid = v3_mat4_normal_matrix(&nm, &m);
+        bool invalid = v3_mat4_normal_matrix(&nm, &singular);
+        v3_mat4_transform_direction(result, &m, tangent);
+        v3_transform_normals_batch(n, &nm, n, 1);
+        float transformed[3] = {nx[0], ny[0], nz[0]};
+        assert_true("v3_mat4_normal_matrix: normals stay perpendicular and unit length",
+                    valid && !invalid && fabsf(v3_dot_product(transformed, result)) < TEST_TOLERANCE &&
+                    fabsf(v3_length(transformed) - 1.0f) < TEST_TOLERANCE);
+    }
+
+    // batch transforms on every instruction set match the scalar functions
+    {
+        float ax[BATCH_COUNT], ay[BATCH_COUNT], az[BATCH_COUNT];
+        float ex[BATCH_COUNT], ey[BATCH_COUNT], ez[BATCH_COUNT];
+        float rx[BATCH_COUNT], ry[BATCH_COUNT], rz[BATCH_COUNT];
+        v3_soa a = {ax, ay, az};
+        v3_soa expected = {ex, ey, ez};
+        v3_soa actual = {rx, ry, rz};
+        float axis[3] = {0.3f, -1.0f, 0.5f};
+        float s[3] = {1.5f, 0.2f, -2.0f};
+        float t[3] = {7.0f, 0.0f, -3.0f};
+        v3_mat4 chain[3];
+        v3_mat4 m;
+        v3_mat3 nm;
+        char name[128];
+
+        fill_batch(a, BATCH_COUNT, 16u);
+        v3_mat4_rotation(&chain[0], axis, 2.0f);
+        v3_mat4_scaling(&chain[1], s);
+        v3_mat4_translation(&chain[2], t);
+        v3_mat4_compose(&m, chain, 3);
+        v3_mat4_normal_matrix(&nm, &m);
+
+        v3_isa saved = v3_get_isa();
+        for (int isa = V3_ISA_SCALAR; isa < V3_ISA_COUNT; isa++)
+        {
+            if (!v3_set_isa((v3_isa)isa))
+            {
+                continue;
+            }
+
+            v3_mat4_transform_points_batch(actual, &m, a, BATCH_COUNT);
+            for (size_t i = 0; i < BATCH_COUNT; i++)
+            {
+                float v[3] = {ax[i], ay[i], az[i]};
+                v3_mat4_transform_point(v, &m, v);
+                ex[i] = v[0];
+                ey[i] = v[1];
+                ez[i] = v[2];
+            }
+            snprintf(name, sizeof(name), "%s: v3_mat4_transform_points_batch matches scalar", v3_isa_name((v3_isa)isa));
+            assert_batch_equals(name, expected, actual, BATCH_COUNT);
+
+            v3_transform_normals_batch(actual, &nm, a, BATCH_COUNT);
+            for (size_t i = 0; i < BATCH_COUNT; i++)
+            {
+                float v[3] = {ax[i], ay[i], az[i]};
+                v3_mat3_transform(v, &nm, v);
+                v3_normalize(v, v);
+                ex[i] = v[0];
+                ey[i] = v[1];
+                ez[i] = v[2];
+            }
+            snprintf(name, sizeof(name), "%s: v3_transform_normals_batch matches scalar", v3_isa_name((v3_isa)isa));
+            assert_batch_equals(name, expected, actual, BATCH_COUNT);
+        }
+        v3_set_isa(saved);
+    }
+}
+
+// test quaternion rotation against matrix rotation
+void test_v3_quat()
+{
+    print_test_section("quaternions");
+
+    float axis[3] = {1.0f, 2.0f, -2.0f};
+    float v[3] = {3.0f, -1.0f, 0.5f};
+    float expected[3];
+    float result[3];
+
+    {
+        bool same = true;
+        for (int i = -8; i <= 8; i++)
+        {
+            float angle = 0.4f * (float)i;
+            v3_quat q;
+            v3_mat4 m;
+            v3_quat_from_axis_angle(&q, axis, angle);
+            v3_mat4_rotation(&m, axis, angle);
+            v3_quat_rotate(result, &q, v);
+            v3_mat4_transform_direction(expected, &m, v);
+            same = same && v3_equals(expected, result, TEST_TOLERANCE * 10.0f);
+        }
+        assert_true("v3_quat_rotate: matches v3_mat4_rotation", same);
+    }
+
+    {
+        float zero[3] = {0.0f, 0.0f, 0.0f};
+        v3_quat q, degenerate;
+        v3_mat4 m;
+        v3_mat3 qm;
+        v3_quat_from_axis_angle(&q, axis, 1.3f);
+        v3_mat4_rotation(&m, axis, 1.3f);
+        v3_quat_to_mat3(&qm, &q);
+        bool invalid = v3_quat_from_axis_angle(&degenerate, zero, 1.0f);
+
+        bool same = !invalid && degenerate.w == 1.0f;
+        for (int row = 0; row < 3; row++)
+        {
+            for (int col = 0; col < 3; col++)
+            {
+                same = same && fabsf(qm.m[row * 3 + col] - m.m[row * 4 + col]) < TEST_TOLERANCE;
+            }
+        }
+        assert_true("v3_quat_to_mat3: matches v3_mat4_rotation, zero axis rejected", same);
+    }
+
+    // the product applies b first, like matrices
+    {
+        float other[3] = {0.0f, 1.0f, 0.0f};
+        v3_quat a, b, ab;
+        v3_quat_from_axis_angle(&a, axis, 0.9f);
+        v3_quat_from_axis_angle(&b, other, -2.1f);
+        v3_quat_multiply(&ab, &a, &b);
+        v3_quat_rotate(expected, &b, v);
+        v3_quat_rotate(expected, &a, expected);
+        v3_quat_rotate(result, &ab, v);
+        assert_v3_equals("v3_quat_multiply: a * b rotates by b then a", expected, result);
+    }
+
+    // a long chain of small steps stays a rotation when renormalized
+    {
+        v3_quat step, chain, total;
+        v3_quat_from_axis_angle(&step, axis, 0.01f);
+        v3_quat_identity(&chain);
+        for (int i = 0; i < 1000; i++)
+        {
+            v3_quat_multiply(&chain, &step, &chain);
+            v3_quat_normalize(&chain, &chain);
+        }
+        v3_quat_from_axis_angle(&total, axis, 10.0f);
+        v3_quat_rotate(expected, &total, v);
+        v3_quat_rotate(result, &chain, v);
+        assert_true("v3_quat_normalize: 1000 composed steps match one rotation",
+                    fabsf(v3_quat_dot(&chain, &chain) - 1.0f) < TEST_TOLERANCE &&
+                    v3_equals(expected, result, 1e-3f));
+    }
+
+    {
+        float z[3] = {0.0f, 0.0f, 1.0f};
+        v3_quat a, b, negated, quarter, half, mid, flipped, nmid, start;
+        v3_quat_identity(&a);
+        v3_quat_from_axis_angle(&b, z, (float)(PI / 2.0));
+        v3_quat_from_axis_angle(&quarter, z, (float)(PI / 8.0));
+        v3_quat_from_axis_angle(&half, z, (float)(PI / 4.0));
+        negated.x = -b.x;
+        negated.y = -b.y;
+        negated.z = -b.z;
+        negated.w = -b.w;
+
+        v3_quat_slerp(&start, &a, &b, 0.0f);
+        v3_quat_slerp(&mid, &a, &b, 0.25f);
+        v3_quat_slerp(&flipped, &a, &negated, 0.25f);
+        v3_quat_nlerp(&nmid, &a, &b, 0.5f);
+        assert_true("v3_quat_slerp: constant speed, shorter arc, nlerp agrees at the midpoint",
+                    fabsf(v3_quat_dot(&start, &a) - 1.0f) < TEST_TOLERANCE &&
+                    fabsf(v3_quat_dot(&mid, &quarter) - 1.0f) < TEST_TOLERANCE &&
+                    fabsf(v3_quat_dot(&flipped, &quarter) - 1.0f) < TEST_TOLERANCE &&
+                    fabsf(v3_quat_dot(&nmid, &half) - 1.0f) < TEST_TOLERANCE);
+    }
+
+    // batch rotation on every instruction set matches matrix rotation
+    {
+        float ax[BATCH_COUNT], ay[BATCH_COUNT], az[BATCH_COUNT];
+        float ex[BATCH_COUNT], ey[BATCH_COUNT], ez[BATCH_COUNT];
+        float rx[BATCH_COUNT], ry[BATCH_COUNT], rz[BATCH_COUNT];
+        v3_soa a = {ax, ay, az};
+        v3_soa e = {ex, ey, ez};
+        v3_soa r = {rx, ry, rz};
+        v3_quat q;
+        v3_mat4 m;
+        char name[128];
+
+        fill_batch(a, BATCH_COUNT, 17u);
+        v3_quat_from_axis_angle(&q, axis, -2.5f);
+        v3_mat4_rotation(&m, axis, -2.5f);
+
+        v3_isa saved = v3_get_isa();
+        for (int isa = V3_ISA_SCALAR; isa < V3_ISA_COUNT; isa++)
+        {
+            if (!v3_set_isa((v3_isa)isa))
+            {
+                continue;
+            }
+
+            v3_mat4_transform_directions_batch(e, &m, a, BATCH_COUNT);
+            v3_quat_rotate_batch(r, &q, a, BATCH_COUNT);
+            snprintf(name, sizeof(name), "%s: v3_quat_rotate_batch matches matrix rotation", v3_isa_name((v3_isa)isa));
+            assert_batch_equals(name, e, r, BATCH_COUNT);
+        }
+        v3_set_isa(saved);
+    }
+}
+
+// number of primitives in the bvh tests, enough for the build to go parallel
+#define BVH_COUNT 40000
+
+// check the depth-first layout: left child next, right child after it, children
+// inside their parent, and every primitive in exactly one leaf inside its box
+bool bvh_valid(const v3_bvh *bvh)
+{
+    uint8_t *covered = (uint8_t *)calloc(bvh->count, 1);
+    int floats = (bvh->kind == V3_BVH_POINTS) ? 3 : 9;
+    size_t leaves = 0;
+    bool valid = true;
+
+    for (size_t i = 0; i < bvh->node_count && valid; i++)
+    {
+        const v3_bvh_node *node = &bvh->nodes[i];
+        if (node->count == 0)
+        {
+            const v3_bvh_node *left = &bvh->nodes[i + 1];
+            const v3_bvh_node *right = &bvh->nodes[node->offset];
+            valid = node->offset > i + 1 && node->offset < bvh->node_count;
+            for (int k = 0; k < 3 && valid; k++)
+            {
+                valid = left->min[k] >= node->min[k] && left->max[k] <= node->max[k] &&
+                        right->min[k] >= node->min[k] && right->max[k] <= node->max[k];
+            }
+            continue;
+        }
+
+        leaves++;
+        valid = node->count <= V3_BVH_MAX_LEAF && node->offset + node->count <= bvh->count;
+        for (uint32_t j = node->offset; j < node->offset + node->count && valid; j++)
+        {
+            valid = !covered[j];
+            covered[j] = 1;
+            for (int f = 0; f < floats && valid; f++)
+            {
+                float v = bvh->data[(size_t)j * floats + f];
+                valid = v >= node->min[f % 3] && v <= node->max[f % 3];
+            }
+        }
+    }
+
+    for (size_t j = 0; j < bvh->count && valid; j++)
+    {
+        valid = covered[j];
+    }
+    free(covered);
+    return valid && bvh->node_count == 2 * leaves - 1;
+}
+
+// test the bvh against brute force queries
+void test_v3_bvh()
+{
+    print_test_section("bvh");
+
+    v3_soa points = alloc_batch(BVH_COUNT);
+    v3_soa v1 = alloc_batch(BVH_COUNT);
+    v3_soa v2 = alloc_batch(BVH_COUNT);
+    v3_soa queries = alloc_batch(BATCH_COUNT);
+    v3_soa dirs = alloc_batch(BATCH_COUNT);
+    fill_batch(points, BVH_COUNT, 18u);
+    fill_batch(v1, BVH_COUNT, 19u);
+    fill_batch(v2, BVH_COUNT, 20u);
+    fill_batch(queries, BATCH_COUNT, 21u);
+    fill_batch(dirs, BATCH_COUNT, 22u);
+
+    // small triangles scattered through the cube
+    for (size_t i = 0; i < BVH_COUNT; i++)
+    {
+        v1.x[i] = points.x[i] + 0.05f * v1.x[i];
+        v1.y[i] = points.y[i] + 0.05f * v1.y[i];
+        v1.z[i] = points.z[i] + 0.05f * v1.z[i];
+        v2.x[i] = points.x[i] + 0.05f * v2.x[i];
+        v2.y[i] = points.y[i] + 0.05f * v2.y[i];
+        v2.z[i] = points.z[i] + 0.05f * v2.z[i];
+    }
+
+    // build on several threads even on a single cpu
+    v3_bvh tree;
+    v3_bvh mesh;
+    v3_pool_set_threads(4);
+    bool built = v3_bvh_build_points(&tree, points, BVH_COUNT);
+    built = v3_bvh_build_triangles(&mesh, points, v1, v2, BVH_COUNT) && built;
+    v3_pool_set_threads(0);
+    assert_true("v3_bvh_build: depth-first layout covers every primitive", built && bvh_valid(&tree) && bvh_valid(&mesh));
+
+    {
+        bool same = true;
+        for (size_t q = 0; q < BATCH_COUNT; q++)
+        {
+            float query[3] = {queries.x[q], queries.y[q], queries.z[q]};
+            float best = INFINITY;
+            size_t best_index = 0;
+            for (size_t i = 0; i < BVH_COUNT; i++)
+            {
+                float p[3] = {points.x[i], points.y[i], points.z[i]};
+                float d[3];
+                v3_from_points(d, query, p);
+                if (v3_length(d) < best)
+                {
+                    best = v3_length(d);
+                    best_index = i;
+                }
+            }
+
+            size_t index;
+            float distance;
+            same = same && v3_bvh_nearest(&tree, query, &index, &distance) &&
+                   index == best_index && fabsf(distance - best) < TEST_TOLERANCE;
+        }
+        assert_true("v3_bvh_nearest: matches brute force", same);
+    }
+
+    {
+        bool same = true;
+        size_t hits = 0;
+        for (size_t q = 0; q < BATCH_COUNT; q++)
+        {
+            // rays from outside the cube towards points inside it
+            float origin[3] = {queries.x[q] * 2.0f, queries.y[q] * 2.0f, 25.0f};
+            float dir[3] = {dirs.x[q] * 0.5f - origin[0], dirs.y[q] * 0.5f - origin[1], dirs.z[q] * 0.5f - origin[2]};
+            float best = V3_RAY_MISS;
+            size_t best_index = 0;
+            for (size_t i = 0; i < BVH_COUNT; i++)
+            {
+                float a[3] = {points.x[i], points.y[i], points.z[i]};
+                float b[3] = {v1.x[i], v1.y[i], v1.z[i]};
+                float c[3] = {v2.x[i], v2.y[i], v2.z[i]};
+                float t;
+                if (v3_ray_triangle(&t, origin, dir, a, b, c) && t < best)
+                {
+                    best = t;
+                    best_index = i;
+                }
+            }
+
+            size_t index = 0;
+            float t;
+            bool hit = v3_bvh_intersect(&mesh, origin, dir, &index, &t);
+            hits += hit;
+            same = same && hit == (best != V3_RAY_MISS) && t == best && (!hit || index == best_index);
+        }
+        assert_true("v3_bvh_intersect: matches brute force", same && hits > 0);
+    }
+
+    // bins and bounds are exact, so the thread count cannot change the tree
+    {
+        v3_bvh single;
+        v3_pool_set_threads(1);
+        bool built_single = v3_bvh_build_triangles(&single, points, v1, v2, BVH_COUNT);
+        v3_pool_set_threads(0);
+        assert_true("v3_bvh_build: four threads build the same tree as one",
+                    built_single && single.node_count == mesh.node_count &&
+                    memcmp(single.nodes, mesh.nodes, mesh.node_count * sizeof(v3_bvh_node)) == 0 &&
+                    memcmp(single.indices, mesh.indices, BVH_COUNT * sizeof(uint32_t)) == 0);
+        v3_bvh_free(&single);
+    }
+
+    {
+        v3_bvh empty;
+        float query[3] = {0.0f, 0.0f, 0.0f};
+        float dir[3] = {0.0f, 0.0f, 1.0f};
+        size_t index;
+        float value;
+        bool built_empty = v3_bvh_build_points(&empty, points, 0);
+        bool found = v3_bvh_nearest(&empty, query, &index, &value);
+        v3_bvh_free(&empty);
+        built_empty = v3_bvh_build_triangles(&empty, points, v1, v2, 0) && built_empty;
+        bool hit = v3_bvh_intersect(&empty, query, dir, &index, &value);
+        assert_true("v3_bvh: empty trees find nothing", built_empty && !found && !hit && value == V3_RAY_MISS);
+        v3_bvh_free(&empty);
+    }
+
+    v3_bvh_free(&tree);
+    v3_bvh_free(&mesh);
+    free_batch(points);
+    free_batch(v1);
+    free_batch(v2);
+    free_batch(queries);
+    free_batch(dirs);
+}
+
+#define FILE_COUNT 10007
+
+// normalize a streamed chunk in place
+void normalize_chunk(void *context, v3_soa chunk, size_t begin, size_t count)
+{
+    (void)begin;
+    size_t *visited = (size_t *)context;
+    v3_normalize_batch(chunk, chunk, count);
+    *visited += count;
+}
+
+// test the mapped file format and its streaming walk
+void test_v3_file()
+{
+    print_test_section("file");
+
+    char path[64];
+    char text_path[64];
+    snprintf(path, sizeof(path), "/tmp/v3test_%d.v3", (int)getpid());
+    snprintf(text_path, sizeof(text_path), "/tmp/v3test_%d.txt", (int)getpid());
+
+    v3_soa input = alloc_batch(FILE_COUNT);
+    v3_soa expected = alloc_batch(FILE_COUNT);
+    v3_soa actual = alloc_batch(FILE_COUNT);
+    fill_batch(input, FILE_COUNT, 23u);
+    v3_normalize_batch(expected, input, FILE_COUNT);
+
+    for (int layout = V3_FILE_AOS; layout <= V3_FILE_SOA; layout++)
+    {
+        bool soa = layout == V3_FILE_SOA;
+        v3_file file;
+        bool ok = v3_file_create(&file, path, (v3_file_layout)layout, FILE_COUNT);
+        if (ok && soa)
+        {
+            v3_soa data = v3_file_soa(&file);
+            ok = ((uintptr_t)data.x | (uintptr_t)data.y | (uintptr_t)data.z) % V3_FILE_ALIGN == 0;
+            memcpy(data.x, input.x, FILE_COUNT * sizeof(float));
+            memcpy(data.y, input.y, FILE_COUNT * sizeof(float));
+            memcpy(data.z, input.z, FILE_COUNT * sizeof(float));
+        }
+        else if (ok)
+        {
+            float *data = v3_file_aos(&file);
+            for (size_t i = 0; i < FILE_COUNT; i++)
+            {
+                data[i * 3] = input.x[i];
+                data[i * 3 + 1] = input.y[i];
+                data[i * 3 + 2] = input.z[i];
+            }
+        }
+        if (ok)
+        {
+            v3_file_close(&file);
+        }
+
+        // the chunk size does not divide the count, so the last chunk is short
+        size_t visited = 0;
+        ok = ok && v3_file_open(&file, path, true) && v3_file_count(&file) == FILE_COUNT &&
+             v3_file_stream(&file, 1000, normalize_chunk, &visited) && visited == FILE_COUNT;
+        if (ok)
+        {
+            v3_file_close(&file);
+        }
+
+        // reopen read-only to check the writes reached the file
+        ok = ok && v3_file_open(&file, path, false);
+        if (ok && soa)
+        {
+            v3_soa data = v3_file_soa(&file);
+            memcpy(actual.x, data.x, FILE_COUNT * sizeof(float));
+            memcpy(actual.y, data.y, FILE_COUNT * sizeof(float));
+            memcpy(actual.z, data.z, FILE_COUNT * sizeof(float));
+        }
+        else if (ok)
+        {
+            const float *data = v3_file_aos(&file);
+            for (size_t i = 0; i < FILE_COUNT; i++)
+            {
+                actual.x[i] = data[i * 3];
+                actual.y[i] = data[i * 3 + 1];
+                actual.z[i] = data[i * 3 + 2];
+            }
+        }
+        if (ok)
+        {
+            v3_file_close(&file);
+        }
+
+        assert_true(soa ? "v3_file_stream: soa file opens and streams" : "v3_file_stream: aos file opens and streams", ok);
+        assert_batch_equals(soa ? "v3_file_stream: soa normalize in place matches batch"
+                                : "v3_file_stream: aos normalize in place matches batch",
+                            expected, actual, FILE_COUNT);
+    }
+
+    {
+        // corrupt the magic of the last file written
+        FILE *f = fopen(path, "r+b");
+        bool written = f != NULL && fwrite("V3BROKEN", 1, 8, f) == 8;
+        if (f != NULL)
+        {
+            fclose(f);
+        }
+        v3_file file;
+        errno = 0;
+        bool opened = v3_file_open(&file, path, false);
+        assert_true("v3_file_open: rejects a bad header with EINVAL", written && !opened && errno == EINVAL);
+    }
+
+    {
+        FILE *f = fopen(text_path, "w");
+        if (f != NULL)
+        {
+            fputs("# x y z\n1 2 3\n\n  4.5, -5, 6e1\r\n7\t8\t9", f);
+            fclose(f);
+        }
+        v3_file file;
+        bool ok = f != NULL && v3_file_convert_text(text_path, path, V3_FILE_SOA) &&
+                  v3_file_open(&file, path, false);
+        if (ok)
+        {
+            v3_soa data = v3_file_soa(&file);
+            ok = v3_file_count(&file) == 3 && data.x[0] == 1.0f && data.y[0] == 2.0f && data.z[0] == 3.0f &&
+                 data.x[1] == 4.5f && data.y[1] == -5.0f && data.z[1] == 60.0f &&
+                 data.x[2] == 7.0f && data.y[2] == 8.0f && data.z[2] == 9.0f;
+            v3_file_close(&file);
+        }
+        assert_true("v3_file_convert_text: skips comments and accepts commas", ok);
+    }
+
+    {
+        FILE *f = fopen(text_path, "w");
+        if (f != NULL)
+        {
+            fputs("1 2 3\n4 5\n", f);
+            fclose(f);
+        }
+        errno = 0;
+        bool converted = v3_file_convert_text(text_path, path, V3_FILE_AOS);
+        assert_true("v3_file_convert_text: rejects a malformed line with EINVAL", f != NULL && !converted && errno == EINVAL);
+    }
+
+    {
+        v3_file file;
+        size_t visited = 0;
+        bool ok = v3_file_create(&file, path, V3_FILE_AOS, 0);
+        if (ok)
+        {
+            v3_file_close(&file);
+        }
+        ok = ok && v3_file_open(&file, path, false) && v3_file_count(&file) == 0 &&
+             v3_file_stream(&file, 0, normalize_chunk, &visited) && visited == 0;
+        if (ok)
+        {
+            v3_file_close(&file);
+        }
+        assert_true("v3_file: empty file round-trips", ok);
+    }
+
+    remove(path);
+    remove(text_path);
+    free_batch(input);
+    free_batch(expected);
+    free_batch(actual);
+}
+
+// record the calling thread's arena
+void *thread_arena_address(void *result)
+{
+    *(v3_arena **)result = v3_thread_arena();
+    return NULL;
+}
+
+bool is_aligned(const void *p)
+{
+    return (uintptr_t)p % V3_ARENA_ALIGN == 0;
+}
+
+// test the arena allocator and the scratch space the library borrows from it
+void test_v3_arena()
+{
+    print_test_section("arena");
+
+    v3_arena arena;
+    v3_arena_init(&arena, 4096);
+
+    {
+        bool aligned = true;
+        unsigned char *previous = NULL;
+        for (size_t bytes = 1; bytes < 300; bytes += 37)
+        {
+            unsigned char *p = (unsigned char *)v3_arena_alloc(&arena, bytes);
+            aligned = aligned && p != NULL && is_aligned(p) && (previous == NULL || p >= previous + 64);
+            memset(p, 0xab, bytes);
+            previous = p;
+        }
+        v3_soa soa;
+        bool allocated = v3_arena_alloc_soa(&arena, &soa, BATCH_COUNT);
+        aligned = aligned && allocated && is_aligned(soa.x) && is_aligned(soa.y) && is_aligned(soa.z) &&
+                  soa.y >= soa.x + BATCH_COUNT && soa.z >= soa.y + BATCH_COUNT;
+        assert_true("v3_arena_alloc: 64 byte aligned, soa arrays padded apart", aligned);
+    }
+
+    {
+        // a reset hands out the same memory again without new blocks
+        v3_arena_reset(&arena);
+        void *first = v3_arena_alloc(&arena, 100);
+        v3_arena_block *blocks = arena.first;
+        v3_arena_reset(&arena);
+        void *again = v3_arena_alloc(&arena, 100);
+        assert_true("v3_arena_reset: reuses the kept blocks", first == again && arena.first == blocks);
+    }
+
+    {
+        // larger than a block, then back to small allocations after a restore
+        float *kept = v3_arena_alloc_aos(&arena, 4);
+        kept[0] = 1.0f;
+        v3_arena_mark mark = v3_arena_mark_position(&arena);
+        float *big = (float *)v3_arena_alloc(&arena, 3 * 4096);
+        float *small = (float *)v3_arena_alloc(&arena, 64);
+        bool ok = big != NULL && small != NULL && is_aligned(big);
+        big[3 * 1024 - 1] = 2.0f;
+        v3_arena_restore(&arena, mark);
+        float *after = v3_arena_alloc_aos(&arena, 1);
+        assert_true("v3_arena_restore: rolls back to the mark only", ok && kept[0] == 1.0f && after == kept + 16);
+
+        v3_arena_free(&arena);
+        assert_true("v3_arena_free: leaves an empty arena", arena.first == NULL && arena.current == NULL);
+    }
+
+    {
+        v3_arena *other = NULL;
+        pthread_t thread;
+        pthread_create(&thread, NULL, thread_arena_address, &other);
+        pthread_join(thread, NULL);
+        assert_true("v3_thread_arena: one per thread", other != NULL && other != v3_thread_arena() &&
+                    v3_thread_arena() == v3_thread_arena());
+    }
+
+    {
+        // kernels give the same results on arena buffers
+        v3_arena *thread = v3_thread_arena();
+        v3_arena_mark mark = v3_arena_mark_position(thread);
+        v3_soa a = alloc_batch(BATCH_COUNT);
+        v3_soa expected = alloc_batch(BATCH_COUNT);
+        v3_soa in;
+        v3_soa out;
+        bool allocated = v3_arena_alloc_soa(thread, &in, BATCH_COUNT) && v3_arena_alloc_soa(thread, &out, BATCH_COUNT);
+        fill_batch(a, BATCH_COUNT, 24u);
+        v3_normalize_batch(expected, a, BATCH_COUNT);
+        if (allocated)
+        {
+            memcpy(in.x, a.x, BATCH_COUNT * sizeof(float));
+            memcpy(in.y, a.y, BATCH_COUNT * sizeof(float));
+            memcpy(in.z, a.z, BATCH_COUNT * sizeof(float));
+            v3_normalize_batch(out, in, BATCH_COUNT);
+        }
+        assert_true("v3_normalize_batch: identical on arena buffers", allocated && soa_identical(expected, out, BATCH_COUNT));
+        v3_arena_restore(thread, mark);
+        free_batch(a);
+        free_batch(expected);
+    }
+
+    {
+        // the bvh build borrows scratch from the thread arena and gives it back
+        v3_arena *thread = v3_thread_arena();
+        float *before = v3_arena_alloc_aos(thread, 1);
+        v3_soa points = alloc_batch(BATCH_COUNT);
+        fill_batch(points, BATCH_COUNT, 25u);
+        v3_bvh tree;
+        bool built = v3_bvh_build_points(&tree, points, BATCH_COUNT);
+        float *after = v3_arena_alloc_aos(thread, 1);
+        assert_true("v3_thread_arena: library scratch is released", built && after == before + 16);
+        v3_bvh_free(&tree);
+        free_batch(points);
+        v3_arena_reset(thread);
+    }
+}
+
+// vectors in the reduction tests, enough for a running float sum to drift
+#define REDUCE_COUNT ((1u << 22) + 13u)
+
+// every reduction of a, b and w in one record, compared bit for bit
+typedef struct
+{
+    float sum[2][3];
+    float weighted[2][3];
+    float dot[2];
+    float min[3];
+    float max[3];
+    v3_mat3 covariance[2];
+} reduce_results;
+
+static void run_reductions(reduce_results *r, v3_soa a, v3_soa b, const float *w, size_t count)
+{
+    memset(r, 0, sizeof(*r));
+    for (int mode = V3_REDUCE_FAST; mode <= V3_REDUCE_KAHAN; mode++)
+    {
+        v3_sum(r->sum[mode], a, count, (v3_reduce_mode)mode);
+        v3_weighted_sum(r->weighted[mode], a, w, count, (v3_reduce_mode)mode);
+        v3_dot_sum(&r->dot[mode], a, b, count, (v3_reduce_mode)mode);
+        v3_covariance(&r->covariance[mode], a, count, (v3_reduce_mode)mode);
+    }
+    v3_bounds(r->min, r->max, a, count);
+}
+
+static double relative_error(float actual, double expected)
+{
+    return fabs(actual - expected) / fmax(fabs(expected), 1e-30);
+}
+
+void test_v3_reduce()
+{
+    print_test_section("reductions");
+
+    v3_soa a = alloc_batch(REDUCE_COUNT);
+    v3_soa b = alloc_batch(REDUCE_COUNT);
+    float *w = (float *)malloc(REDUCE_COUNT * sizeof(float));
+    char name[160];
+
+    // points around (1000, -500, 2) with spread 10, so sums reach ~4e9 and the
+    // covariance is small next to the squared mean
+    fill_batch(a, REDUCE_COUNT, 28u);
+    fill_batch(b, REDUCE_COUNT, 29u);
+    for (size_t i = 0; i < REDUCE_COUNT; i++)
+    {
+        a.x[i] += 1000.0f;
+        a.y[i] -= 500.0f;
+        a.z[i] += 2.0f;
+        w[i] = 0.5f + 0.05f * b.z[i];
+    }
+
+    double sum[3] = {0.0, 0.0, 0.0}, weighted[3] = {0.0, 0.0, 0.0}, dot = 0.0;
+    float running = 0.0f;
+    for (size_t i = 0; i < REDUCE_COUNT; i++)
+    {
+        sum[0] += a.x[i];
+        sum[1] += a.y[i];
+        sum[2] += a.z[i];
+        weighted[0] += (double)w[i] * a.x[i];
+        weighted[1] += (double)w[i] * a.y[i];
+        weighted[2] += (double)w[i] * a.z[i];
+        dot += (double)a.x[i] * b.x[i] + (double)a.y[i] * b.y[i] + (double)a.z[i] * b.z[i];
+        running += a.x[i];
+    }
+    double mean[3] = {sum[0] / REDUCE_COUNT, sum[1] / REDUCE_COUNT, sum[2] / REDUCE_COUNT};
+    double covariance[9] = {0.0};
+    for (size_t i = 0; i < REDUCE_COUNT; i++)
+    {
+        double d[3] = {a.x[i] - mean[0], a.y[i] - mean[1], a.z[i] - mean[2]};
+        for (int k = 0; k < 9; k++)
+        {
+            covariance[k] += d[k / 3] * d[k % 3];
+        }
+    }
+
+    reduce_results single;
+    v3_pool_set_threads(1);
+    run_reductions(&single, a, b, w, REDUCE_COUNT);
+
+    {
+        double fast = 0.0, kahan = 0.0;
+        for (int k = 0; k < 3; k++)
+        {
+            fast = fmax(fast, relative_error(single.sum[V3_REDUCE_FAST][k], sum[k]));
+            kahan = fmax(kahan, relative_error(single.sum[V3_REDUCE_KAHAN][k], sum[k]));
+        }
+        snprintf(name, sizeof(name), "v3_sum: fast %.2g, kahan %.2g relative error (running float sum %.2g)",
+                 fast, kahan, relative_error(running, sum[0]));
+        assert_true(name, fast < 1e-5 && kahan < 5e-7);
+    }
+
+    {
+        float centroid[3];
+        bool ok = v3_mean(centroid, a, REDUCE_COUNT, V3_REDUCE_KAHAN);
+        double weighted_error = 0.0;
+        for (int k = 0; k < 3; k++)
+        {
+            ok = ok && relative_error(centroid[k], mean[k]) < 5e-7;
+            weighted_error = fmax(weighted_error, relative_error(single.weighted[V3_REDUCE_KAHAN][k], weighted[k]));
+        }
+        double dot_error = relative_error(single.dot[V3_REDUCE_KAHAN], dot);
+        snprintf(name, sizeof(name), "v3_mean, v3_weighted_sum, v3_dot_sum: kahan within %.2g, %.2g of double",
+                 weighted_error, dot_error);
+        assert_true(name, ok && weighted_error < 1e-6 && dot_error < 1e-5);
+    }
+
+    {
+        float lo[3] = {a.x[0], a.y[0], a.z[0]};
+        float hi[3] = {a.x[0], a.y[0], a.z[0]};
+        for (size_t i = 0; i < REDUCE_COUNT; i++)
+        {
+            float v[3] = {a.x[i], a.y[i], a.z[i]};
+            for (int k = 0; k < 3; k++)
+            {
+                lo[k] = fminf(lo[k], v[k]);
+                hi[k] = fmaxf(hi[k], v[k]);
+            }
+        }
+        assert_true("v3_bounds: exact box", memcmp(lo, single.min, sizeof(lo)) == 0 &&
+                    memcmp(hi, single.max, sizeof(hi)) == 0);
+    }
+
+    {
+        double error = 0.0;
+        bool symmetric = true;
+        for (int k = 0; k < 9; k++)
+        {
+            double scale = sqrt(covariance[(k / 3) * 4] * covariance[(k % 3) * 4]);
+            error = fmax(error, fabs(single.covariance[V3_REDUCE_KAHAN].m[k] - covariance[k] / REDUCE_COUNT) /
+                                    (scale / REDUCE_COUNT));
+            symmetric = symmetric && single.covariance[V3_REDUCE_FAST].m[k] ==
+                                         single.covariance[V3_REDUCE_FAST].m[(k % 3) * 3 + k / 3];
+        }
+        snprintf(name, sizeof(name), "v3_covariance: symmetric, within %.2g of double about a large mean", error);
+        assert_true(name, symmetric && error < 1e-5);
+    }
+
+    {
+        static const int thread_counts[] = {2, 3, 8};
+        bool same = true;
+        for (size_t t = 0; t < sizeof(thread_counts) / sizeof(thread_counts[0]); t++)
+        {
+            reduce_results threaded;
+            v3_pool_set_threads(thread_counts[t]);
+            run_reductions(&threaded, a, b, w, REDUCE_COUNT);
+            same = same && memcmp(&single, &threaded, sizeof(single)) == 0;
+        }
+        assert_true("2, 3 and 8 threads: every reduction bit-identical to 1 thread", same);
+    }
+
+    {
+        // dot_sum aside, whose products are fused on some instruction sets
+        v3_isa saved = v3_get_isa();
+        bool same = true;
+        for (int isa = V3_ISA_SCALAR; isa < V3_ISA_COUNT; isa++)
+        {
+            if (!v3_set_isa((v3_isa)isa))
+            {
+                continue;
+            }
+            reduce_results other;
+            run_reductions(&other, a, b, w, REDUCE_COUNT);
+            other.dot[0] = single.dot[0];
+            other.dot[1] = single.dot[1];
+            same = same && memcmp(&single, &other, sizeof(single)) == 0;
+        }
+        v3_set_isa(saved);
+        assert_true("every instruction set: reductions bit-identical", same);
+    }
+
+    {
+        reduce_results empty;
+        run_reductions(&empty, a, b, w, 0);
+        float centroid[3] = {1.0f, 1.0f, 1.0f};
+        v3_mean(centroid, a, 0, V3_REDUCE_FAST);
+        assert_true("count 0: zero sums, mean and covariance, inverted bounds",
+                    empty.sum[0][0] == 0.0f && empty.dot[1] == 0.0f && empty.covariance[1].m[4] == 0.0f &&
+                    centroid[0] == 0.0f && empty.min[0] == INFINITY && empty.max[2] == -INFINITY);
+    }
+
+    v3_pool_set_threads(0);
+    free_batch(a);
+    free_batch(b);
+    free(w);
+}
+
+// directions in the octahedral tests
+#define OCT_COUNT 100003
+
+// angle in radians between two unit vectors, from atan2 so tiny angles stay accurate
+static double angle_between(const float *a, const float *b)
+{
+    double cx = (double)a[1] * b[2] - (double)a[2] * b[1];
+    double cy = (double)a[2] * b[0] - (double)a[0] * b[2];
+    double cz = (double)a[0] * b[1] - (double)a[1] * b[0];
+    double dot = (double)a[0] * b[0] + (double)a[1] * b[1] + (double)a[2] * b[2];
+    return atan2(sqrt(cx * cx + cy * cy + cz * cz), dot);
+}
+
+void test_v3_oct()
+{
+    print_test_section("octahedral encoding");
+
+    v3_soa a = alloc_batch(OCT_COUNT);
+    v3_soa v = alloc_batch(OCT_COUNT);
+    v3_soa decoded = alloc_batch(OCT_COUNT);
+    v3_soa result = alloc_batch(OCT_COUNT);
+    v3_oct16 *codes16 = (v3_oct16 *)malloc(OCT_COUNT * sizeof(v3_oct16));
+    v3_oct8 *codes8 = (v3_oct8 *)malloc(OCT_COUNT * sizeof(v3_oct8));
+    v3_oct16 *expected16 = (v3_oct16 *)malloc(OCT_COUNT * sizeof(v3_oct16));
+    v3_oct8 *expected8 = (v3_oct8 *)malloc(OCT_COUNT * sizeof(v3_oct8));
+    float *dots = (float *)malloc(OCT_COUNT * sizeof(float));
+    char name[160];
+
+    // random directions, every 16th pushed onto the folded seam x = 0 or y = 0 of the lower half
+    fill_batch(a, OCT_COUNT, 30u);
+    fill_batch(v, OCT_COUNT, 31u);
+    for (size_t i = 0; i < OCT_COUNT; i++)
+    {
+        if (i % 16 == 0)
+        {
+            a.x[i] = 0.0f;
+            a.z[i] = -fabsf(a.z[i]);
+        }
+        else if (i % 16 == 1)
+        {
+            a.y[i] = 0.0f;
+            a.z[i] = -fabsf(a.z[i]);
+        }
+    }
+    v3_normalize_batch(a, a, OCT_COUNT);
+
+    {
+        static const float axes[6][3] = {{1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1}};
+        bool ok = true;
+        for (int k = 0; k < 6; k++)
+        {
+            float axis[3] = {axes[k][0], axes[k][1], axes[k][2]};
+            float d16[3], d8[3];
+            v3_oct16_decode(d16, v3_oct16_encode(axis));
+            v3_oct8_decode(d8, v3_oct8_encode(axis));
+            ok = ok && v3_equals(axis, d16, 1e-6f) && v3_equals(axis, d8, 1e-6f);
+        }
+        float zero[3] = {0.0f, 0.0f, 0.0f};
+        float up[3] = {0.0f, 0.0f, 1.0f};
+        float d[3];
+        v3_oct16_decode(d, v3_oct16_encode(zero));
+        assert_true("v3_oct16, v3_oct8: axes round trip, zero decodes to +z", ok && v3_equals(up, d, 1e-6f));
+    }
+
+    v3_isa saved = v3_get_isa();
+    v3_set_isa(V3_ISA_SCALAR);
+    v3_oct16_encode_batch(expected16, a, OCT_COUNT);
+    v3_oct8_encode_batch(expected8, a, OCT_COUNT);
+
+    {
+        double max16 = 0.0, max8 = 0.0;
+        v3_oct16_decode_batch(decoded, expected16, OCT_COUNT);
+        for (size_t i = 0; i < OCT_COUNT; i++)
+        {
+            float n[3] = {a.x[i], a.y[i], a.z[i]};
+            float d[3] = {decoded.x[i], decoded.y[i], decoded.z[i]};
+            max16 = fmax(max16, angle_between(n, d));
+        }
+        v3_oct8_decode_batch(decoded, expected8, OCT_COUNT);
+        for (size_t i = 0; i < OCT_COUNT; i++)
+        {
+            float n[3] = {a.x[i], a.y[i], a.z[i]};
+            float d[3] = {decoded.x[i], decoded.y[i], decoded.z[i]};
+            max8 = fmax(max8, angle_between(n, d));
+        }
+        snprintf(name, sizeof(name), "angular error: 16 bits %.3g rad, 8 bits %.3g rad, within the documented bounds",
+                 max16, max8);
+        assert_true(name, max16 <= V3_OCT16_MAX_ERROR && max8 <= V3_OCT8_MAX_ERROR);
+    }
+
+    for (int isa = V3_ISA_SCALAR; isa < V3_ISA_COUNT; isa++)
+    {
+        if (!v3_set_isa((v3_isa)isa))
+        {
+            continue;
+        }
+
+        v3_oct16_encode_batch(codes16, a, OCT_COUNT);
+        v3_oct8_encode_batch(codes8, a, OCT_COUNT);
+        bool same = memcmp(codes16, expected16, OCT_COUNT * sizeof(v3_oct16)) == 0 &&
+                    memcmp(codes8, expected8, OCT_COUNT * sizeof(v3_oct8)) == 0;
+        snprintf(name, sizeof(name), "%s: encode bit-identical to scalar", v3_isa_name((v3_isa)isa));
+        assert_true(name, same);
+
+        // the packed kernels against decoding first and using the float batch functions
+        bool ok = true;
+        for (int bits = 8; bits <= 16; bits += 8)
+        {
+            if (bits == 16)
+            {
+                v3_oct16_decode_batch(decoded, codes16, OCT_COUNT);
+                v3_oct16_dot_product_batch(dots, codes16, v, OCT_COUNT);
+                v3_oct16_reflect_batch(result, v, codes16, OCT_COUNT);
+            }
+            else
+            {
+                v3_oct8_decode_batch(decoded, codes8, OCT_COUNT);
+                v3_oct8_dot_product_batch(dots, codes8, v, OCT_COUNT);
+                v3_oct8_reflect_batch(result, v, codes8, OCT_COUNT);
+            }
+            for (size_t i = 0; i < OCT_COUNT; i++)
+            {
+                float d[3] = {decoded.x[i], decoded.y[i], decoded.z[i]};
+                float vi[3] = {v.x[i], v.y[i], v.z[i]};
+                float r[3] = {result.x[i], result.y[i], result.z[i]};
+                float expected[3];
+                v3_reflect(expected, vi, d);
+                ok = ok && fabsf(v3_length(d) - 1.0f) < 1e-6f && fabsf(dots[i] - v3_dot_product(d, vi)) < 1e-5f &&
+                     v3_equals(expected, r, 1e-4f);
+            }
+        }
+        snprintf(name, sizeof(name), "%s: unit decode, packed dot and reflect match the float path",
+                 v3_isa_name((v3_isa)isa));
+        assert_true(name, ok);
+    }
+    v3_set_isa(saved);
+
+    {
+        v3_oct16_reflect_batch(decoded, v, expected16, OCT_COUNT);
+        v3_oct16_reflect_batch(v, v, expected16, OCT_COUNT);
+        assert_true("v3_oct16_reflect_batch: overlapping dst=v", soa_identical(decoded, v, OCT_COUNT));
+    }
+
+    free_batch(a);
+    free_batch(v);
+    free_batch(decoded);
+    free_batch(result);
+    free(codes16);
+    free(codes8);
+    free(expected16);
+    free(expected8);
+    free(dots);
+}
+
+// threads and calls per thread of the instrumentation test
+#define INSTRUMENT_THREADS 4
+#define INSTRUMENT_CALLS 1000
+
+static void *instrument_add(void *)
+{
+    float a[3] = {1.0f, 2.0f, 3.0f};
+    for (int i = 0; i < INSTRUMENT_CALLS; i++)
+    {
+        v3_add(a, a, a);
+    }
+    return NULL;
+}
+
+// sum of the cycle histogram, which must match the calls
+static uint64_t histogram_total(const v3_probe_stats *s)
+{
+    uint64_t total = 0;
+    for (int k = 0; k < V3_INSTRUMENT_BUCKETS; k++)
+    {
+        total += s->histogram[k];
+    }
+    return total;
+}
+
+// test the instrumentation counters, or that nothing is recorded without them
+void test_v3_instrument()
+{
+    print_test_section("instrumentation");
+
+    bool enabled = v3_instrument_enabled();
+    v3_probe_stats normalize, dot, reflect;
+
+    {
+        float zero[3] = {0.0f, 0.0f, 0.0f};
+        float a[3] = {3.0f, 4.0f, 0.0f};
+        float n[3] = {0.0f, 1.0f, 0.0f};
+        float dst[3];
+        v3_instrument_reset();
+        v3_normalize(dst, zero);
+        v3_normalize(dst, a);
+        v3_dot_product(a, n);
+        v3_reflect(dst, a, n);
+        v3_instrument_read(V3_PROBE_NORMALIZE, &normalize);
+        v3_instrument_read(V3_PROBE_DOT_PRODUCT, &dot);
+        v3_instrument_read(V3_PROBE_REFLECT, &reflect);
+
+        // reflect computes its own dot product, which is not a caller's call
+        bool ok = enabled ? normalize.calls == 2 && normalize.elements == 2 && normalize.degenerate == 1 &&
+                            histogram_total(&normalize) == 2 && dot.calls == 1 && reflect.calls == 1
+                          : normalize.calls == 0 && dot.calls == 0 && reflect.calls == 0;
+        assert_true(enabled ? "scalar calls, degenerate inputs and cycle histogram counted"
+                            : "nothing recorded without V3_INSTRUMENT", ok);
+    }
+
+    {
+        v3_soa a = alloc_batch(BATCH_COUNT);
+        v3_soa dst = alloc_batch(BATCH_COUNT);
+        float *angles = (float *)malloc(BATCH_COUNT * sizeof(float));
+        fill_batch(a, BATCH_COUNT, 40u);
+        for (size_t i = 0; i < BATCH_COUNT; i += 100)
+        {
+            a.x[i] = a.y[i] = a.z[i] = 0.0f;
+        }
+        size_t zeros = (BATCH_COUNT + 99) / 100;
+
+        v3_probe_stats angle;
+        v3_instrument_reset();
+        v3_normalize_batch(dst, a, BATCH_COUNT);
+        v3_normalize_batch(dst, a, BATCH_COUNT);
+        v3_angle_batch(angles, a, dst, BATCH_COUNT, V3_ANGLE_POLY);
+        v3_instrument_read(V3_PROBE_NORMALIZE_BATCH, &normalize);
+        v3_instrument_read(V3_PROBE_ANGLE_BATCH, &angle);
+        bool ok = enabled ? normalize.calls == 2 && normalize.elements == 2 * BATCH_COUNT &&
+                            normalize.degenerate == 2 * zeros && angle.calls == 1 && angle.degenerate == zeros
+                          : normalize.calls == 0 && angle.calls == 0;
+        assert_true(enabled ? "batch elements and degenerate inputs counted" : "batch calls not recorded", ok);
+
+        free(angles);
+        free_batch(dst);
+        free_batch(a);
+    }
+
+    {
+        // module entry points count themselves; the direct kernel calls of the
+        // parallel normalize count as v3_normalize_batch, covariance as neither a sum nor a mean
+        v3_soa a = alloc_batch(BATCH_COUNT);
+        v3_soa dst = alloc_batch(BATCH_COUNT);
+        fill_batch(a, BATCH_COUNT, 41u);
+        a.x[5] = a.y[5] = a.z[5] = 0.0f;
+        v3_mat3 m;
+        v3_mat3_identity(&m);
+        float total[3];
+
+        v3_probe_stats normals, sum, cov, mean;
+        v3_instrument_reset();
+        v3_transform_normals_batch(dst, &m, a, BATCH_COUNT);
+        v3_normalize_batch_parallel(dst, a, BATCH_COUNT);
+        v3_sum(total, a, BATCH_COUNT, V3_REDUCE_FAST);
+        v3_covariance(&m, a, BATCH_COUNT, V3_REDUCE_FAST);
+        v3_instrument_read(V3_PROBE_TRANSFORM_NORMALS_BATCH, &normals);
+        v3_instrument_read(V3_PROBE_NORMALIZE_BATCH, &normalize);
+        v3_instrument_read(V3_PROBE_SUM, &sum);
+        v3_instrument_read(V3_PROBE_COVARIANCE, &cov);
+        v3_instrument_read(V3_PROBE_MEAN, &mean);
+        bool ok = enabled ? normals.calls == 1 && normals.elements == BATCH_COUNT && normals.degenerate == 1 &&
+                            normalize.elements == BATCH_COUNT && normalize.degenerate == 1 && sum.calls == 1 &&
+                            cov.calls == 1 && mean.calls == 0
+                          : normals.calls == 0 && normalize.calls == 0 && sum.calls == 0 && cov.calls == 0;
+        assert_true(enabled ? "module entry points and direct kernel calls counted" : "module calls not recorded",
+                    ok);
+        assert_true("module probes named after their functions",
+                    strcmp(v3_probe_name(V3_PROBE_TRANSFORM_NORMALS_BATCH), "v3_transform_normals_batch") == 0 &&
+                    strcmp(v3_probe_name(V3_PROBE_CAMERA_RAYS), "v3_camera_rays") == 0);
+
+        free_batch(dst);
+        free_batch(a);
+    }
+
+    {
+        // counts of finished threads stay in the totals
+        pthread_t threads[INSTRUMENT_THREADS];
+        v3_probe_stats add;
+        v3_instrument_reset();
+        for (int i = 0; i < INSTRUMENT_THREADS; i++)
+        {
+            pthread_create(&threads[i], NULL, instrument_add, NULL);
+        }
+        for (int i = 0; i < INSTRUMENT_THREADS; i++)
+        {
+            pthread_join(threads[i], NULL);
+        }
+        v3_instrument_read(V3_PROBE_ADD, &add);
+        uint64_t expected = enabled ? INSTRUMENT_THREADS * INSTRUMENT_CALLS : 0;
+        assert_true("per-thread counters summed over finished threads", add.calls == expected &&
+                    histogram_total(&add) == expected);
+    }
+}
+
+// element-wise batch functions and their scalar and restrict forms
+typedef void (*scalar_writer)(float *dst, float *a, float *b);
+typedef void (*restrict_writer)(float *V3_RESTRICT dst, float *V3_RESTRICT a, float *V3_RESTRICT b);
+typedef void (*batch_writer)(v3_soa dst, v3_soa a, v3_soa b, size_t count);
+
+// fill expected with op applied one vector at a time
+static void scalar_reference(v3_soa expected, scalar_writer op, v3_soa a, v3_soa b, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        float va[3] = {a.x[i], a.y[i], a.z[i]};
+        float vb[3] = {b.x[i], b.y[i], b.z[i]};
+        float r[3];
+        op(r, va, vb);
+        expected.x[i] = r[0];
+        expected.y[i] = r[1];
+        expected.z[i] = r[2];
+    }
+}
+
+// copy count vectors from src to dst
+static void copy_batch(v3_soa dst, v3_soa src, size_t count)
+{
+    memcpy(dst.x, src.x, count * sizeof(float));
+    memcpy(dst.y, src.y, count * sizeof(float));
+    memcpy(dst.z, src.z, count * sizeof(float));
+}
+
+// test the restrict forms and the overlap dispatch of the batches
+void test_v3_restrict()
+{
+    print_test_section("restrict forms");
+
+    v3_soa a = alloc_batch(BATCH_COUNT);
+    v3_soa b = alloc_batch(BATCH_COUNT);
+    v3_soa dst = alloc_batch(BATCH_COUNT);
+    v3_soa work = alloc_batch(BATCH_COUNT);
+    v3_soa expected = alloc_batch(BATCH_COUNT);
+    fill_batch(a, BATCH_COUNT, 50u);
+    fill_batch(b, BATCH_COUNT, 51u);
+
+    {
+        static const scalar_writer staged[4] = {v3_from_points, v3_add, v3_subtract, v3_cross_product};
+        static const restrict_writer direct[4] = {v3_from_points_restrict, v3_add_restrict, v3_subtract_restrict,
+                                                  v3_cross_product_restrict};
+        bool ok = true;
+        for (size_t i = 0; i < BATCH_COUNT; i++)
+        {
+            float va[3] = {a.x[i], a.y[i], a.z[i]};
+            float vb[3] = {b.x[i], b.y[i], b.z[i]};
+            float x[3], y[3];
+            for (int k = 0; k < 4; k++)
+            {
+                staged[k](x, va, vb);
+                direct[k](y, va, vb);
+                ok = ok && memcmp(x, y, sizeof(x)) == 0;
+            }
+
+            float n[3];
+            v3_normalize(n, vb);
+            v3_reflect(x, va, n);
+            v3_reflect_restrict(y, va, n);
+            ok = ok && memcmp(x, y, sizeof(x)) == 0;
+            v3_normalize(x, va);
+            v3_normalize_restrict(y, va);
+            ok = ok && memcmp(x, y, sizeof(x)) == 0;
+        }
+
+        float zero[3] = {0.0f, 0.0f, 0.0f};
+        float r[3] = {1.0f, 1.0f, 1.0f};
+        v3_normalize_restrict(r, zero);
+        assert_true("scalar restrict forms bit-identical to the staged forms, zero normalizes to zero",
+                    ok && r[0] == 0.0f && r[1] == 0.0f && r[2] == 0.0f);
+    }
+
+    static const scalar_writer ops[3] = {v3_from_points, v3_add, v3_subtract};
+    static const batch_writer batches[3] = {v3_from_points_batch, v3_add_batch, v3_subtract_batch};
+    static const batch_writer restricted[3] = {v3_from_points_batch_restrict, v3_add_batch_restrict,
+                                               v3_subtract_batch_restrict};
+
+    {
+        bool ok = true;
+        for (int k = 0; k < 3; k++)
+        {
+            scalar_reference(expected, ops[k], a, b, BATCH_COUNT);
+            batches[k](dst, a, b, BATCH_COUNT);
+            ok = ok && soa_identical(expected, dst, BATCH_COUNT);
+            restricted[k](dst, a, b, BATCH_COUNT);
+            ok = ok && soa_identical(expected, dst, BATCH_COUNT);
+        }
+        assert_true("disjoint batches and restrict batches match the scalar functions", ok);
+    }
+
+    {
+        // dst = a and dst = b take the one vector at a time path
+        bool ok = true;
+        for (int k = 0; k < 3; k++)
+        {
+            scalar_reference(expected, ops[k], a, b, BATCH_COUNT);
+            copy_batch(work, a, BATCH_COUNT);
+            batches[k](work, work, b, BATCH_COUNT);
+            ok = ok && soa_identical(expected, work, BATCH_COUNT);
+            copy_batch(work, b, BATCH_COUNT);
+            batches[k](work, a, work, BATCH_COUNT);
+            ok = ok && soa_identical(expected, work, BATCH_COUNT);
+        }
+        assert_true("in-place batches with dst = a and dst = b keep their results", ok);
+    }
+
+    free_batch(a);
+    free_batch(b);
+    free_batch(dst);
+    free_batch(work);
+    free_batch(expected);
+}
+
+// test operation graphs against the batch calls they fuse
+void test_v3_graph()
+{
+    print_test_section("operation graphs");
+
+    v3_soa eye = alloc_batch(POOL_COUNT);
+    v3_soa p = alloc_batch(POOL_COUNT);
+    v3_soa q = alloc_batch(POOL_COUNT);
+    v3_soa n = alloc_batch(POOL_COUNT);
+    v3_soa expected = alloc_batch(POOL_COUNT);
+    v3_soa result = alloc_batch(POOL_COUNT);
+    float *es = (float *)malloc(POOL_COUNT * sizeof(float));
+    float *rs = (float *)malloc(POOL_COUNT * sizeof(float));
+    float *el = (float *)malloc(POOL_COUNT * sizeof(float));
+    float *rl = (float *)malloc(POOL_COUNT * sizeof(float));
+
+    static const float eye_position[3] = {0.5f, 2.0f, -3.0f};
+    static const float light[3] = {0.267261f, 0.534522f, 0.801784f};
+    fill_batch(p, POOL_COUNT, 60u);
+    fill_batch(q, POOL_COUNT, 61u);
+    fill_batch(n, POOL_COUNT, 62u);
+    v3_normalize_batch(n, n, POOL_COUNT);
+    size_t zeros = 0;
+    for (size_t i = 0; i < POOL_COUNT; i++)
+    {
+        eye.x[i] = eye_position[0];
+        eye.y[i] = eye_position[1];
+        eye.z[i] = eye_position[2];
+        if (i % 7919 == 0)
+        {
+            p.x[i] = eye_position[0];
+            p.y[i] = eye_position[1];
+            p.z[i] = eye_position[2];
+            zeros++;
+        }
+    }
+
+    {
+        // staged: one pass over memory per operation
+        v3_soa lights = alloc_batch(POOL_COUNT);
+        for (size_t i = 0; i < POOL_COUNT; i++)
+        {
+            lights.x[i] = light[0];
+            lights.y[i] = light[1];
+            lights.z[i] = light[2];
+        }
+        v3_from_points_batch(expected, eye, p, POOL_COUNT);
+        v3_normalize_batch(expected, expected, POOL_COUNT);
+        v3_reflect_batch(expected, expected, n, POOL_COUNT);
+        v3_dot_product_batch(es, expected, lights, POOL_COUNT);
+        free_batch(lights);
+
+        v3_error_policy saved = v3_get_error_policy();
+        v3_set_error_policy(V3_ERROR_COUNT);
+        static const int thread_counts[] = {1, 3};
+        bool ok = true;
+        for (size_t t = 0; t < sizeof(thread_counts) / sizeof(thread_counts[0]); t++)
+        {
+            v3_pool_set_threads(thread_counts[t]);
+            v3_reset_error_counts();
+
+            v3_graph g;
+            v3_graph_init(&g);
+            int d = v3_graph_from_points(&g, v3_graph_constant(&g, eye_position), v3_graph_input(&g, p));
+            int r = v3_graph_reflect(&g, v3_graph_normalize(&g, d), v3_graph_input(&g, n));
+            v3_graph_store(&g, r, result);
+            v3_graph_store_scalars(&g, v3_graph_dot_product(&g, r, v3_graph_constant(&g, light)), rs);
+            ok = ok && v3_graph_run(&g, POOL_COUNT);
+            ok = ok && soa_identical(expected, result, POOL_COUNT);
+            ok = ok && memcmp(es, rs, POOL_COUNT * sizeof(float)) == 0;
+            ok = ok && v3_error_count(V3_SOURCE_NORMALIZE_BATCH) == zeros;
+        }
+        v3_pool_set_threads(0);
+        v3_set_error_policy(saved);
+        assert_true("from_points, normalize, reflect, dot graph bit-identical to the batch calls, 1 and 3 threads",
+                    ok);
+    }
+
+    {
+        // every other operation, scratch tiles reused, the result stored over an input
+        v3_soa sum = alloc_batch(POOL_COUNT);
+        v3_add_batch(sum, p, q, POOL_COUNT);
+        v3_scale_batch(sum, 0.5f, POOL_COUNT);
+        v3_subtract_batch(expected, p, q, POOL_COUNT);
+        v3_cross_product_batch(expected, sum, expected, POOL_COUNT);
+        v3_length_batch(el, expected, POOL_COUNT);
+        free_batch(sum);
+
+        v3_soa work = alloc_batch(POOL_COUNT);
+        memcpy(work.x, p.x, POOL_COUNT * sizeof(float));
+        memcpy(work.y, p.y, POOL_COUNT * sizeof(float));
+        memcpy(work.z, p.z, POOL_COUNT * sizeof(float));
+
+        v3_graph g;
+        v3_graph_init(&g);
+        int a = v3_graph_input(&g, work);
+        int b = v3_graph_input(&g, q);
+        int half = v3_graph_scale(&g, v3_graph_add(&g, a, b), 0.5f);
+        int c = v3_graph_cross_product(&g, half, v3_graph_subtract(&g, a, b));
+        v3_graph_length(&g, half);
+        v3_graph_store(&g, c, work);
+        v3_graph_store_scalars(&g, v3_graph_length(&g, c), rl);
+        bool ok = v3_graph_run(&g, POOL_COUNT);
+        assert_true("add, subtract, scale, cross, length graph stored in place matches the batch calls",
+                    ok && soa_identical(expected, work, POOL_COUNT) &&
+                    memcmp(el, rl, POOL_COUNT * sizeof(float)) == 0);
+        free_batch(work);
+    }
+
+    {
+        v3_graph g;
+        v3_graph_init(&g);
+        int a = v3_graph_input(&g, p);
+        int s = v3_graph_length(&g, a);
+        bool scalar_operand = v3_graph_normalize(&g, s) == -1 && errno == EINVAL;
+        bool sticky = v3_graph_normalize(&g, a) == -1 && !v3_graph_run(&g, 16) && errno == EINVAL;
+
+        v3_graph_init(&g);
+        a = v3_graph_input(&g, p);
+        bool store_input = !v3_graph_store(&g, a, result) && errno == EINVAL;
+
+        v3_graph_init(&g);
+        a = v3_graph_input(&g, p);
+        bool nothing_stored = v3_graph_normalize(&g, a) >= 0 && !v3_graph_run(&g, 16) && errno == EINVAL;
+
+        v3_graph_init(&g);
+        int last = v3_graph_input(&g, p);
+        for (int i = 1; i < V3_GRAPH_MAX_NODES; i++)
+        {
+            last = v3_graph_normalize(&g, last);
+        }
+        bool full = last >= 0 && v3_graph_normalize(&g, last) == -1 && errno == ENOSPC;
+        assert_true("graph recording rejects scalar operands, stored inputs and overflow, and run fails after",
+                    scalar_operand && sticky && store_input && nothing_stored && full);
+    }
+
+    free_batch(eye);
+    free_batch(p);
+    free_batch(q);
+    free_batch(n);
+    free_batch(expected);
+    free_batch(result);
+    free(es);
+    free(rs);
+    free(el);
+    free(rl);
+}
+
+// load positions x and velocities v into particles
+static void load_particles(v3_particles *particles, v3_soa x, v3_soa v)
+{
+    memcpy(particles->position.x, x.x, particles->count * sizeof(float));
+    memcpy(particles->position.y, x.y, particles->count * sizeof(float));
+    memcpy(particles->position.z, x.z, particles->count * sizeof(float));
+    memcpy(particles->velocity.x, v.x, particles->count * sizeof(float));
+    memcpy(particles->velocity.y, v.y, particles->count * sizeof(float));
+    memcpy(particles->velocity.z, v.z, particles->count * sizeof(float));
+}
+
+// whether a collision left particle i of x, v as the contract says: particles
+// inside moved onto the surface point p with normal n, velocities into it
+// reflected, everything else untouched
+static bool collided_as_documented(const v3_particles *after, v3_soa x, v3_soa v, size_t i, bool inside,
+                                   float *p, float *n)
+{
+    float x1[3] = {after->position.x[i], after->position.y[i], after->position.z[i]};
+    float v0[3] = {v.x[i], v.y[i], v.z[i]};
+    float v1[3] = {after->velocity.x[i], after->velocity.y[i], after->velocity.z[i]};
+    if (!inside)
+    {
+        return x1[0] == x.x[i] && x1[1] == x.y[i] && x1[2] == x.z[i] && memcmp(v0, v1, sizeof(v0)) == 0;
+    }
+
+    float expected[3] = {v0[0], v0[1], v0[2]};
+    if (v3_dot_product(v0, n) < 0.0f)
+    {
+        v3_reflect(expected, v0, n);
+    }
+    return v3_equals(x1, p, 1e-4f) && v3_equals(v1, expected, 1e-4f);
+}
+
+// test particle integration and collision response
+void test_v3_particle()
+{
+    print_test_section("particles");
+
+    v3_soa x = alloc_batch(POOL_COUNT);
+    v3_soa v = alloc_batch(POOL_COUNT);
+    v3_soa ex = alloc_batch(POOL_COUNT);
+    v3_soa ev = alloc_batch(POOL_COUNT);
+    fill_batch(x, POOL_COUNT, 70u);
+    fill_batch(v, POOL_COUNT, 71u);
+    v3_particles particles;
+    bool allocated = v3_particles_init(&particles, POOL_COUNT);
+    static const float gravity[3] = {0.25f, -9.81f, 0.0f};
+    const float dt = 1.0f / 64.0f;
+
+    {
+        bool ok = allocated;
+        static const int thread_counts[] = {1, 3};
+        for (size_t t = 0; t < sizeof(thread_counts) / sizeof(thread_counts[0]) && allocated; t++)
+        {
+            v3_pool_set_threads(thread_counts[t]);
+            load_particles(&particles, x, v);
+            copy_batch(ex, x, POOL_COUNT);
+            copy_batch(ev, v, POOL_COUNT);
+            for (int step = 0; step < 4; step++)
+            {
+                v3_particles_euler(&particles, gravity, dt);
+                v3_particles_verlet(&particles, gravity, dt);
+                float *axes_x[3] = {ex.x, ex.y, ex.z};
+                float *axes_v[3] = {ev.x, ev.y, ev.z};
+                for (int k = 0; k < 3; k++)
+                {
+                    float dv = gravity[k] * dt;
+                    float half = 0.5f * dv;
+                    for (size_t i = 0; i < POOL_COUNT; i++)
+                    {
+                        axes_v[k][i] += dv;
+                        axes_x[k][i] += axes_v[k][i] * dt;
+                        axes_x[k][i] += (axes_v[k][i] + half) * dt;
+                        axes_v[k][i] += dv;
+                    }
+                }
+            }
+            ok = ok && soa_identical(ex, particles.position, POOL_COUNT) &&
+                 soa_identical(ev, particles.velocity, POOL_COUNT);
+        }
+        v3_pool_set_threads(0);
+
+        // one second of free fall from rest: verlet lands on -g/2, euler g dt / 2 lower
+        v3_particles one, two;
+        ok = ok && v3_particles_init(&one, 1) && v3_particles_init(&two, 1);
+        for (int step = 0; step < 64 && ok; step++)
+        {
+            v3_particles_verlet(&one, gravity, dt);
+            v3_particles_euler(&two, gravity, dt);
+        }
+        ok = ok && fabsf(one.position.y[0] + 4.905f) < 1e-5f && fabsf(one.velocity.y[0] + 9.81f) < 1e-5f &&
+             fabsf(two.position.y[0] + 4.905f + 9.81f * dt / 2.0f) < 1e-5f;
+        v3_particles_free(&one);
+        v3_particles_free(&two);
+        assert_true("euler and verlet steps match per-particle loops for 1 and 3 threads, verlet exact in free fall",
+                    ok);
+    }
+
+    {
+        float n[3] = {1.0f, 2.0f, 3.0f};
+        v3_normalize(n, n);
+        const float d = 0.5f;
+        bool ok = allocated;
+        size_t behind = 0, hits = 0;
+        if (allocated)
+        {
+            load_particles(&particles, x, v);
+            hits = v3_particles_collide_plane(&particles, n, d, 1.0f);
+        }
+        for (size_t i = 0; i < POOL_COUNT && allocated; i++)
+        {
+            float xi[3] = {x.x[i], x.y[i], x.z[i]};
+            float depth = d - v3_dot_product(xi, n);
+            bool inside = depth > 0.0f;
+            float p[3] = {xi[0] + depth * n[0], xi[1] + depth * n[1], xi[2] + depth * n[2]};
+            behind += inside ? 1 : 0;
+            ok = ok && collided_as_documented(&particles, x, v, i, inside, p, n);
+        }
+
+        // restitution 0.5 keeps half the normal speed
+        v3_particles floor;
+        float up[3] = {0.0f, 1.0f, 0.0f};
+        ok = ok && v3_particles_init(&floor, 1);
+        if (ok)
+        {
+            floor.position.y[0] = -0.5f;
+            floor.velocity.x[0] = 1.0f;
+            floor.velocity.y[0] = -2.0f;
+            ok = v3_particles_collide_plane(&floor, up, 0.0f, 0.5f) == 1 && floor.position.y[0] == 0.0f &&
+                 floor.velocity.x[0] == 1.0f && floor.velocity.y[0] == 1.0f;
+            v3_particles_free(&floor);
+        }
+        assert_true("plane collision moves particles behind onto the plane and reflects those moving in",
+                    ok && hits == behind && behind > 0 && behind < POOL_COUNT);
+    }
+
+    {
+        float center[3] = {1.0f, 2.0f, 3.0f};
+        const float radius = 4.0f;
+        bool ok = allocated;
+        size_t inside_count = 0, hits = 0;
+        if (allocated)
+        {
+            x.x[7] = center[0];
+            x.y[7] = center[1];
+            x.z[7] = center[2];
+            load_particles(&particles, x, v);
+            v3_pool_set_threads(3);
+            hits = v3_particles_collide_sphere(&particles, center, radius, 1.0f);
+            v3_pool_set_threads(0);
+        }
+        for (size_t i = 0; i < POOL_COUNT && allocated; i++)
+        {
+            float q[3] = {x.x[i] - center[0], x.y[i] - center[1], x.z[i] - center[2]};
+            bool inside = v3_dot_product(q, q) < radius * radius;
+            inside_count += inside ? 1 : 0;
+            float n[3] = {0.0f, 0.0f, 0.0f};
+            if (i != 7)
+            {
+                v3_normalize(n, q);
+            }
+            float p[3] = {center[0] + radius * n[0], center[1] + radius * n[1], center[2] + radius * n[2]};
+            ok = ok && collided_as_documented(&particles, x, v, i, inside, p, n);
+        }
+        assert_true("sphere collision moves particles inside to the surface, the center one stays",
+                    ok && hits == inside_count && inside_count > 0 && particles.position.x[7] == center[0] &&
+                    particles.velocity.x[7] == v.x[7]);
+    }
+
+    {
+        // one particle a hair off the center leaves along its offset, the one
+        // exactly at the center stays; both are reported once for the call
+        float center[3] = {1.0f, 2.0f, 3.0f};
+        v3_particles near;
+        bool ok = v3_particles_init(&near, 3);
+        if (ok)
+        {
+            float offsets[3] = {3e-7f, 0.0f, 5.0f};
+            for (size_t i = 0; i < 3; i++)
+            {
+                near.position.x[i] = center[0];
+                near.position.y[i] = center[1] + offsets[i];
+                near.position.z[i] = center[2];
+            }
+            v3_error_policy saved = v3_get_error_policy();
+            v3_set_error_policy(V3_ERROR_COUNT);
+            v3_reset_error_counts();
+            size_t hits = v3_particles_collide_sphere(&near, center, 2.0f, 1.0f);
+            ok = hits == 2 && v3_error_count(V3_SOURCE_NORMALIZE_BATCH) == 2 &&
+                 near.position.x[0] == center[0] && near.position.y[0] == center[1] + 2.0f &&
+                 near.position.z[0] == center[2] && near.position.y[1] == center[1] &&
+                 near.position.y[2] == center[1] + 5.0f;
+            v3_set_error_policy(saved);
+            v3_particles_free(&near);
+        }
+        assert_true("sphere collision pushes a particle near the center out, reports the short offsets once", ok);
+    }
+
+    v3_particles_free(&particles);
+    free_batch(x);
+    free_batch(v);
+    free_batch(ex);
+    free_batch(ev);
+}
+
+// pixels of the shading tests, not a multiple of any simd width
+#define SHADE_COUNT 4099
+
+// the per-pixel chain of scalar calls the shade kernel replaces; terminator
+// gets the smallest |n . l|, where the kernel and the chain may disagree on
+// whether a light faces the surface
+static void shade_chain(float *diffuse, float *specular, float *p, float *n, float *v, const v3_light *lights,
+                        int light_count, int shininess, v3_shade_model model, float *terminator)
+{
+    float nn[3], vv[3];
+    v3_normalize(nn, n);
+    v3_normalize(vv, v);
+    *terminator = INFINITY;
+    for (int k = 0; k < 3; k++)
+    {
+        diffuse[k] = specular[k] = 0.0f;
+    }
+
+    for (int j = 0; j < light_count; j++)
+    {
+        float l[3];
+        v3_from_points(l, p, (float *)lights[j].position);
+        v3_normalize(l, l);
+        float ndl = v3_dot_product(nn, l);
+        *terminator = fminf(*terminator, fabsf(ndl));
+        if (ndl <= 0.0f)
+        {
+            continue;
+        }
+
+        float s = 0.0f;
+        if (model == V3_SHADE_PHONG)
+        {
+            float incident[3] = {-l[0], -l[1], -l[2]};
+            float r[3];
+            v3_reflect(r, incident, nn);
+            s = v3_dot_product(r, vv);
+        }
+        else if (model == V3_SHADE_BLINN_PHONG)
+        {
+            float h[3];
+            v3_add(h, l, vv);
+            v3_normalize(h, h);
+            s = v3_dot_product(nn, h);
+        }
+        float term = (model == V3_SHADE_LAMBERT) ? 0.0f : powf(fmaxf(s, 0.0f), (float)shininess);
+        for (int k = 0; k < 3; k++)
+        {
+            diffuse[k] += ndl * lights[j].color[k];
+            specular[k] += term * lights[j].color[k];
+        }
+    }
+}
+
+// test the shade kernel against the scalar chain
+void test_v3_shade()
+{
+    print_test_section("shading");
+
+    v3_gbuffer g = {alloc_batch(POOL_COUNT), alloc_batch(POOL_COUNT), alloc_batch(POOL_COUNT), SHADE_COUNT};
+    v3_soa diffuse = alloc_batch(POOL_COUNT);
+    v3_soa specular = alloc_batch(POOL_COUNT);
+    v3_soa expected_diffuse = alloc_batch(POOL_COUNT);
+    v3_soa expected_specular = alloc_batch(POOL_COUNT);
+    fill_batch(g.position, POOL_COUNT, 80u);
+    fill_batch(g.normal, POOL_COUNT, 81u);
+    fill_batch(g.view, POOL_COUNT, 82u);
+    static const v3_light lights[3] = {{{0.0f, 20.0f, 0.0f}, {1.0f, 0.9f, 0.8f}},
+                                       {{15.0f, 5.0f, -10.0f}, {0.2f, 0.4f, 0.9f}},
+                                       {{-12.0f, -8.0f, 6.0f}, {0.5f, 0.5f, 0.5f}}};
+    static const v3_shade_model models[3] = {V3_SHADE_LAMBERT, V3_SHADE_PHONG, V3_SHADE_BLINN_PHONG};
+    char name[160];
+
+    v3_isa saved = v3_get_isa();
+    for (int isa = V3_ISA_SCALAR; isa < V3_ISA_COUNT; isa++)
+    {
+        if (!v3_set_isa((v3_isa)isa))
+        {
+            continue;
+        }
+
+        bool ok = true;
+        size_t skipped = 0;
+        for (int m = 0; m < 3; m++)
+        {
+            v3_shade_batch(diffuse, specular, &g, lights, 3, 32, models[m]);
+            for (size_t i = 0; i < SHADE_COUNT; i++)
+            {
+                float p[3] = {g.position.x[i], g.position.y[i], g.position.z[i]};
+                float n[3] = {g.normal.x[i], g.normal.y[i], g.normal.z[i]};
+                float v[3] = {g.view.x[i], g.view.y[i], g.view.z[i]};
+                float d[3] = {diffuse.x[i], diffuse.y[i], diffuse.z[i]};
+                float s[3] = {specular.x[i], specular.y[i], specular.z[i]};
+                float ed[3], es[3], terminator;
+                shade_chain(ed, es, p, n, v, lights, 3, 32, models[m], &terminator);
+                if (terminator < 1e-4f)
+                {
+                    skipped++;
+                    continue;
+                }
+                for (int k = 0; k < 3; k++)
+                {
+                    ok = ok && fabsf(d[k] - ed[k]) <= 1e-5f * (1.0f + ed[k]) &&
+                         fabsf(s[k] - es[k]) <= 1e-4f * (1.0f + es[k]);
+                }
+            }
+        }
+        snprintf(name, sizeof(name), "%s: lambert, phong and blinn-phong match the scalar chain (%zu at the terminator)",
+                 v3_isa_name((v3_isa)isa), skipped);
+        assert_true(name, ok && skipped < 3 * SHADE_COUNT / 100);
+    }
+    v3_set_isa(saved);
+
+    {
+        g.count = POOL_COUNT;
+        v3_pool_set_threads(1);
+        v3_shade_batch(expected_diffuse, expected_specular, &g, lights, 3, 16, V3_SHADE_BLINN_PHONG);
+        v3_pool_set_threads(3);
+        v3_shade_batch(diffuse, specular, &g, lights, 3, 16, V3_SHADE_BLINN_PHONG);
+        v3_pool_set_threads(0);
+        g.count = SHADE_COUNT;
+        assert_true("v3_shade_batch: bit-identical for 1 and 3 threads",
+                    soa_identical(expected_diffuse, diffuse, POOL_COUNT) &&
+                    soa_identical(expected_specular, specular, POOL_COUNT));
+    }
+
+    {
+        // pixel 0 faces away from the light, pixel 1 has a zero normal, pixel 2 a
+        // zero view and pixel 3 sits on the light; the rest are lit head on
+        v3_light above = {{0.0f, 10.0f, 0.0f}, {1.0f, 1.0f, 1.0f}};
+        for (size_t i = 0; i < 20; i++)
+        {
+            g.position.x[i] = g.position.y[i] = g.position.z[i] = 0.0f;
+            g.normal.x[i] = g.normal.z[i] = 0.0f;
+            g.normal.y[i] = 2.0f;
+            g.view.x[i] = g.view.z[i] = 0.0f;
+            g.view.y[i] = 1.0f;
+        }
+        g.normal.y[0] = -1.0f;
+        g.normal.y[1] = 0.0f;
+        g.view.y[2] = 0.0f;
+        g.position.y[3] = 10.0f;
+        g.count = 20;
+
+        bool finite = true;
+        for (int m = 0; m < 3; m++)
+        {
+            v3_shade_batch(diffuse, specular, &g, &above, 1, 8, models[m]);
+            for (size_t i = 0; i < 20; i++)
+            {
+                finite = finite && isfinite(diffuse.y[i]) && isfinite(specular.y[i]);
+            }
+        }
+        bool blinn = diffuse.y[0] == 0.0f && specular.y[0] == 0.0f && diffuse.y[1] == 0.0f &&
+                     specular.y[1] == 0.0f && diffuse.y[3] == 0.0f && fabsf(diffuse.y[4] - 1.0f) < 1e-5f &&
+                     fabsf(specular.y[4] - 1.0f) < 1e-5f && fabsf(diffuse.y[2] - 1.0f) < 1e-5f;
+        v3_shade_batch(diffuse, specular, &g, &above, 1, 8, V3_SHADE_LAMBERT);
+        bool lambert = specular.x[4] == 0.0f && specular.y[19] == 0.0f;
+        v3_shade_batch(diffuse, specular, &g, NULL, 0, 8, V3_SHADE_PHONG);
+        bool dark = diffuse.y[4] == 0.0f && specular.y[4] == 0.0f;
+        g.count = SHADE_COUNT;
+        assert_true("back-facing lights, zero normals and lambert give zero terms, degenerate pixels stay finite",
+                    finite && blinn && lambert && dark);
+    }
+
+    free_batch(g.position);
+    free_batch(g.normal);
+    free_batch(g.view);
+    free_batch(diffuse);
+    free_batch(specular);
+    free_batch(expected_diffuse);
+    free_batch(expected_specular);
+}
+
+// image of the camera tests, cut tiles on the right and at the bottom
+#define CAMERA_WIDTH 37
+#define CAMERA_HEIGHT 23
+
+// pixel coordinates where the ray dir meets the image plane of camera
+static void camera_pixel_of(float *x, float *y, const v3_camera *camera, float *dir)
+{
+    float corner[3] = {camera->corner[0], camera->corner[1], camera->corner[2]};
+    float right[3] = {camera->right[0], camera->right[1], camera->right[2]};
+    float down[3] = {camera->down[0], camera->down[1], camera->down[2]};
+    float n[3], q[3];
+    v3_cross_product(n, right, down);
+    float t = v3_dot_product(corner, n) / v3_dot_product(dir, n);
+    for (int k = 0; k < 3; k++)
+    {
+        q[k] = t * dir[k] - corner[k];
+    }
+    *x = v3_dot_product(q, right) / v3_dot_product(right, right);
+    *y = v3_dot_product(q, down) / v3_dot_product(down, down);
+}
+
+// test camera ray generation against the scalar chain
+void test_v3_camera()
+{
+    print_test_section("camera rays");
+
+    static const float eye[3] = {1.0f, 2.0f, 3.0f};
+    static const float target[3] = {0.0f, 0.0f, -5.0f};
+    static const float up[3] = {0.0f, 1.0f, 0.0f};
+    v3_camera camera;
+    v3_camera_look_at(&camera, eye, target, up, 1.0f, CAMERA_WIDTH, CAMERA_HEIGHT);
+    size_t count = v3_camera_ray_count(&camera, 4);
+    v3_soa dir = alloc_batch(POOL_COUNT);
+    v3_soa expected = alloc_batch(POOL_COUNT);
+    uint32_t pixel[CAMERA_WIDTH * CAMERA_HEIGHT * 4];
+    int visits[CAMERA_WIDTH * CAMERA_HEIGHT];
+    char name[160];
+
+    v3_isa saved = v3_get_isa();
+    for (int isa = V3_ISA_SCALAR; isa < V3_ISA_COUNT; isa++)
+    {
+        if (!v3_set_isa((v3_isa)isa))
+        {
+            continue;
+        }
+
+        // pixel centers through v3_from_points and v3_normalize, every pixel once
+        bool centered = true;
+        memset(visits, 0, sizeof(visits));
+        v3_camera_rays(dir, pixel, &camera, 1, false, 0u);
+        for (size_t i = 0; i < CAMERA_WIDTH * CAMERA_HEIGHT; i++)
+        {
+            size_t x = pixel[i] % CAMERA_WIDTH, y = pixel[i] / CAMERA_WIDTH;
+            float origin[3] = {eye[0], eye[1], eye[2]};
+            float point[3], d[3];
+            for (int k = 0; k < 3; k++)
+            {
+                point[k] = eye[k] + camera.corner[k] + (float)x * camera.right[k] + (float)y * camera.down[k];
+            }
+            v3_from_points(d, origin, point);
+            v3_normalize(d, d);
+            visits[pixel[i]]++;
+            centered = centered && fabsf(dir.x[i] - d[0]) < 1e-5f && fabsf(dir.y[i] - d[1]) < 1e-5f &&
+                       fabsf(dir.z[i] - d[2]) < 1e-5f;
+        }
+
+        // jittered samples stay inside their pixel and spread across it
+        bool inside = true;
+        float spread = 0.0f;
+        v3_camera_rays(dir, pixel, &camera, 4, true, 7u);
+        for (size_t i = 0; i < count; i++)
+        {
+            float d[3] = {dir.x[i], dir.y[i], dir.z[i]};
+            float x, y;
+            camera_pixel_of(&x, &y, &camera, d);
+            float dx = fabsf(x - (float)(pixel[i] % CAMERA_WIDTH)), dy = fabsf(y - (float)(pixel[i] / CAMERA_WIDTH));
+            visits[pixel[i]]--;
+            inside = inside && dx <= 0.501f && dy <= 0.501f && fabsf(v3_length(d) - 1.0f) < 1e-6f;
+            spread = fmaxf(spread, fmaxf(dx, dy));
+        }
+        bool once = true;
+        for (size_t p = 0; p < CAMERA_WIDTH * CAMERA_HEIGHT; p++)
+        {
+            once = once && visits[p] == -3;
+        }
+
+        snprintf(name, sizeof(name), "%s: centered rays match the scalar chain, jittered rays stay in their pixel",
+                 v3_isa_name((v3_isa)isa));
+        assert_true(name, centered && inside && once && spread > 0.4f);
+
+        // the jittered rays of every set against the scalar kernel: sse4.1 makes the
+        // same roundings, the others differ by fused multiply-adds and, for
+        // avx-512, the reciprocal square root estimate
+        bool agree = true;
+        float tolerance = (isa == V3_ISA_SCALAR || isa == V3_ISA_SSE41) ? 0.0f : 5e-7f;
+        if (isa == V3_ISA_SCALAR)
+        {
+            copy_batch(expected, dir, count);
+        }
+        for (size_t i = 0; i < count; i++)
+        {
+            agree = agree && fabsf(dir.x[i] - expected.x[i]) <= tolerance &&
+                    fabsf(dir.y[i] - expected.y[i]) <= tolerance && fabsf(dir.z[i] - expected.z[i]) <= tolerance;
+        }
+
+        // a column gives the same rays inside a full vector and alone at the end of a row
+        bool same = true;
+        const v3_kernels *kernels = v3_get_kernels();
+        kernels->camera(dir, camera.corner, 0, 5, 16, 1, CAMERA_WIDTH, 2, 9u, 1);
+        for (size_t c = 0; c < 16; c++)
+        {
+            float x[2], y[2], z[2];
+            v3_soa alone = {x, y, z};
+            kernels->camera(alone, camera.corner, c, 5, 1, 1, CAMERA_WIDTH, 2, 9u, 1);
+            for (size_t s = 0; s < 2; s++)
+            {
+                same = same && x[s] == dir.x[s * 16 + c] && y[s] == dir.y[s * 16 + c] && z[s] == dir.z[s * 16 + c];
+            }
+        }
+        snprintf(name, sizeof(name), "%s: jittered rays agree with the scalar kernel, row tails match full vectors",
+                 v3_isa_name((v3_isa)isa));
+        assert_true(name, agree && same);
+    }
+    v3_set_isa(saved);
+
+    {
+        // 300x200 is large enough for the pool to split the tiles
+        v3_camera big;
+        v3_camera_look_at(&big, eye, target, up, 1.0f, 300, 200);
+        size_t rays = v3_camera_ray_count(&big, 1);
+        size_t i = 0;
+        for (size_t ty = 0; ty < (200 + V3_CAMERA_TILE - 1) / V3_CAMERA_TILE; ty++)
+        {
+            for (size_t tx = 0; tx < (300 + V3_CAMERA_TILE - 1) / V3_CAMERA_TILE; tx++)
+            {
+                v3_soa at = {expected.x + i, expected.y + i, expected.z + i};
+                i += v3_camera_tile(at, NULL, &big, tx, ty, 1, true, 3u);
+            }
+        }
+        v3_pool_set_threads(1);
+        v3_camera_rays(dir, NULL, &big, 1, true, 3u);
+        bool one = soa_identical(dir, expected, rays);
+        v3_pool_set_threads(3);
+        v3_camera_rays(dir, NULL, &big, 1, true, 3u);
+        bool three = soa_identical(dir, expected, rays);
+        v3_pool_set_threads(0);
+        v3_camera_rays(dir, NULL, &big, 1, true, 4u);
+        bool reseeded = !soa_identical(dir, expected, rays);
+        assert_true("v3_camera_rays: the tiles in order, bit-identical for 1 and 3 threads, seeded jitter",
+                    i == rays && one && three && reseeded);
+    }
+
+    {
+        // 90 degrees over 5 pixels: pixel centers at -0.8, -0.4, 0, 0.4 and 0.8
+        static const float origin[3] = {0.0f, 0.0f, 0.0f};
+        static const float ahead[3] = {0.0f, 0.0f, -1.0f};
+        v3_camera square;
+        bool made = v3_camera_look_at(&square, origin, ahead, up, (float)M_PI / 2.0f, 5, 5);
+        size_t written = v3_camera_tile(dir, NULL, &square, 0, 0, 1, false, 0u);
+        float center[3] = {dir.x[12], dir.y[12], dir.z[12]};
+        float top[3] = {dir.x[2], dir.y[2], dir.z[2]};
+        float right[3] = {dir.x[14], dir.y[14], dir.z[14]};
+        float expected_center[3] = {0.0f, 0.0f, -1.0f};
+        float expected_top[3] = {0.0f, 0.8f, -1.0f};
+        float expected_right[3] = {0.8f, 0.0f, -1.0f};
+        v3_normalize(expected_top, expected_top);
+        v3_normalize(expected_right, expected_right);
+        bool basis = made && written == 25 && v3_equals(center, expected_center, 1e-5f) &&
+                     v3_equals(top, expected_top, 1e-5f) && v3_equals(right, expected_right, 1e-5f);
+
+        // eye on the target, up along the view, no field of view, empty image
+        errno = 0;
+        bool rejected = !v3_camera_look_at(&square, origin, origin, up, 1.0f, 5, 5) && errno == EINVAL &&
+                        !v3_camera_look_at(&square, origin, up, up, 1.0f, 5, 5) &&
+                        !v3_camera_look_at(&square, origin, ahead, up, 0.0f, 5, 5) &&
+                        !v3_camera_look_at(&square, origin, ahead, up, (float)M_PI, 5, 5) &&
+                        !v3_camera_look_at(&square, origin, ahead, up, 1.0f, 0, 5);
+        assert_true("v3_camera_look_at: center, top and right rays, degenerate cameras fail with EINVAL",
+                    basis && rejected);
+    }
+
+    free_batch(dir);
+    free_batch(expected);
+}
+
 // main test runner
 int main(int argc, char **argv) 
 {
@@ -613,6 +4253,30 @@ int main(int argc, char **argv)
     test_v3_length();
     test_v3_normalize();
     test_v3_equals();
+    test_v3_batch();
+    test_v3_isa_dispatch();
+    test_v3_normalize_fast();
+    test_v3_angle_batch();
+    test_v3_error_policy();
+    test_vec3_front_end();
+    test_v3_expr();
+    test_v3_double();
+    test_v3_half();
+    test_v3_pool();
+    test_v3_ray();
+    test_v3_mat();
+    test_v3_quat();
+    test_v3_bvh();
+    test_v3_file();
+    test_v3_arena();
+    test_v3_reduce();
+    test_v3_oct();
+    test_v3_instrument();
+    test_v3_restrict();
+    test_v3_graph();
+    test_v3_particle();
+    test_v3_shade();
+    test_v3_camera();
 
     printf("Total tests: %d\n", tests_passed + tests_failed);
 
@@ -0,0 +1,161 @@
+#ifndef V3VEC_H
+#define V3VEC_H
+
+// library inclusions
+#include "v3math.h"
+
+// header-only vector type with inline versions of every v3math operation
+// the operations that need no square root are constexpr, so constant
+// geometry folds at compile time; results match the c api
+template <typename T>
+struct Vec3
+{
+    T x;
+    T y;
+    T z;
+
+    constexpr Vec3() : x(0), y(0), z(0) {}
+    constexpr Vec3(T x_, T y_, T z_) : x(x_), y(y_), z(z_) {}
+
+    // load from and store to the float[3] layout used by the c api
+    static Vec3 load(const T *p) { return Vec3(p[0], p[1], p[2]); }
+    void store(T *p) const { p[0] = x; p[1] = y; p[2] = z; }
+};
+
+// square root and inverse cosine for each supported element type
+inline float v3_sqrt(float v) { return sqrtf(v); }
+inline double v3_sqrt(double v) { return sqrt(v); }
+inline float v3_acos(float v) { return acosf(v); }
+inline double v3_acos(double v) { return acos(v); }
+
+// zero length threshold, V3_EPSILON for float and V3D_EPSILON for double
+template <typename T>
+constexpr T v3_epsilon() { return (T)V3_EPSILON; }
+
+template <>
+constexpr double v3_epsilon<double>() { return V3D_EPSILON; }
+
+// form vector from point a to point b
+// returns: b - a
+template <typename T>
+constexpr Vec3<T> from_points(const Vec3<T> &a, const Vec3<T> &b)
+{
+    return Vec3<T>(b.x - a.x, b.y - a.y, b.z - a.z);
+}
+
+// add two vectors
+// returns: a + b
+template <typename T>
+constexpr Vec3<T> add(const Vec3<T> &a, const Vec3<T> &b)
+{
+    return Vec3<T>(a.x + b.x, a.y + b.y, a.z + b.z);
+}
+
+// subtract vector b from vector a
+// returns: a - b
+template <typename T>
+constexpr Vec3<T> subtract(const Vec3<T> &a, const Vec3<T> &b)
+{
+    return Vec3<T>(a.x - b.x, a.y - b.y, a.z - b.z);
+}
+
+// calculate dot product of two vectors
+// returns: a.x * b.x + a.y * b.y + a.z * b.z
+template <typename T>
+constexpr T dot_product(const Vec3<T> &a, const Vec3<T> &b)
+{
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+// calculate cross product of two vectors
+// returns: a x b
+template <typename T>
+constexpr Vec3<T> cross_product(const Vec3<T> &a, const Vec3<T> &b)
+{
+    return Vec3<T>(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+}
+
+// scale a vector by scalar s
+// returns: a * s
+template <typename T>
+constexpr Vec3<T> scale(const Vec3<T> &a, T s)
+{
+    return Vec3<T>(a.x * s, a.y * s, a.z * s);
+}
+
+// reflect vector v across normal n, assumes n is normalized
+// returns: v - 2(v * n)n
+template <typename T>
+constexpr Vec3<T> reflect(const Vec3<T> &v, const Vec3<T> &n)
+{
+    return Vec3<T>(v.x - (T)2 * dot_product(v, n) * n.x,
+                   v.y - (T)2 * dot_product(v, n) * n.y,
+                   v.z - (T)2 * dot_product(v, n) * n.z);
+}
+
+// calculate length/magnitude of a vector
+// returns: sqrt(a * a)
+template <typename T>
+inline T length(const Vec3<T> &a)
+{
+    return v3_sqrt(dot_product(a, a));
+}
+
+// normalize a vector to unit length
+// returns: a / ||a||, or zero for zero length vectors (no error is reported)
+template <typename T>
+inline Vec3<T> normalize(const Vec3<T> &a)
+{
+    // computed unconditionally and selected so fused loops stay branch-free
+    T len = length(a);
+    Vec3<T> r = scale(a, (T)1 / len);
+    bool zero = len < v3_epsilon<T>();
+    return Vec3<T>(zero ? (T)0 : r.x, zero ? (T)0 : r.y, zero ? (T)0 : r.z);
+}
+
+// clamped cosine of the angle between two vectors, zero_value for zero length vectors
+template <typename T>
+inline T clamped_cosine(const Vec3<T> &a, const Vec3<T> &b, T zero_value)
+{
+    T len_a = length(a);
+    T len_b = length(b);
+    if (len_a < v3_epsilon<T>() || len_b < v3_epsilon<T>())
+    {
+        return zero_value;
+    }
+
+    T cos_angle = dot_product(a, b) / (len_a * len_b);
+    return cos_angle > (T)1 ? (T)1 : (cos_angle < (T)-1 ? (T)-1 : cos_angle);
+}
+
+// calculate cosine of the angle between two vectors
+// returns: 1 for zero length vectors, like v3_angle_quick
+template <typename T>
+inline T angle_quick(const Vec3<T> &a, const Vec3<T> &b)
+{
+    return clamped_cosine(a, b, (T)1);
+}
+
+// calculate angle between two vectors in radians
+// returns: angle in range [0, pi], 0 for zero length vectors like v3_angle
+template <typename T>
+inline T angle(const Vec3<T> &a, const Vec3<T> &b)
+{
+    // acos(1) = 0 covers the zero length case
+    return v3_acos(clamped_cosine(a, b, (T)1));
+}
+
+// check if two vectors are equal within tolerance
+// a nan difference is not greater than tolerance, so it compares equal like v3_equals
+template <typename T>
+constexpr bool equals(const Vec3<T> &a, const Vec3<T> &b, T tolerance)
+{
+    return (a.x == b.x || !((a.x > b.x ? a.x - b.x : b.x - a.x) > tolerance)) &&
+           (a.y == b.y || !((a.y > b.y ? a.y - b.y : b.y - a.y) > tolerance)) &&
+           (a.z == b.z || !((a.z > b.z ? a.z - b.z : b.z - a.z) > tolerance));
+}
+
+typedef Vec3<float> Vec3f;
+typedef Vec3<double> Vec3d;
+
+#endif